@@ -0,0 +1,94 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <functional>
+#include <Utils/StopWatch.hh>
+
+#include <Algorithms/GradientDescent.hh>
+#include <Algorithms/AcceleratedGradientDescent.hh>
+#include <Algorithms/BarzilaiBorwein.hh>
+#include <Utils/OptimizationStatistic.hh>
+#include <Utils/RandomNumberGenerator.hh>
+#include <MassSpringSystemT.hh>
+
+/* Compares plain gradient descent with Nesterov's accelerated gradient and
+ * Barzilai-Borwein gradient descent on the same mass spring system and start point. */
+int main(int _argc, const char* _argv[]) {
+    if(_argc != 6) {
+        std::cout << "Usage: input should be 'function index(0: f without length, 1: f with length),"
+                     "constrained spring scenario  (1 or 2 )"
+                     "number of grid in x, number of grid in y, max iteration', e.g. "
+                     "./AcceleratedGradient 1 1 20 20 100000" << std::endl;
+        return -1;
+    }
+
+    //read the input parameters
+    int func_index, scenario, n_grid_x, n_grid_y, max_iter;
+    func_index = atoi(_argv[1]);
+    scenario = atoi(_argv[2]);
+    n_grid_x = atoi(_argv[3]);
+    n_grid_y = atoi(_argv[4]);
+    max_iter = atoi(_argv[5]);
+
+    //construct mass spring system
+    AOPT::MassSpringSystemT<AOPT::MassSpringProblem2DSparse> mss(n_grid_x, n_grid_y, func_index);
+    //attach spring graph nodes to certain positions
+    mss.add_constrained_spring_elements(scenario);
+
+    //statistic instance
+    auto opt_st = std::make_unique<AOPT::OptimizationStatistic>(mss.get_problem().get());
+
+    //start point
+    AOPT::RandomNumberGenerator rng(-10., 10.);
+    AOPT::GradientDescent::Vec start_pt = rng.get_random_nd_vector(opt_st->n_unknowns());
+
+    using Solver = std::function<AOPT::GradientDescent::Vec()>;
+    const double eps = 1e-4;
+    std::vector<std::pair<std::string, Solver>> solvers = {
+        {"GD", [&]() { return AOPT::GradientDescent::solve(opt_st.get(), start_pt, eps, max_iter); }},
+        {"Nesterov", [&]() { return AOPT::AcceleratedGradientDescent::solve(opt_st.get(), start_pt, eps, max_iter,
+                                                                           AOPT::AcceleratedGradientDescent::NO_RESTART); }},
+        {"Nesterov (f restart)", [&]() { return AOPT::AcceleratedGradientDescent::solve(opt_st.get(), start_pt, eps, max_iter,
+                                                                                       AOPT::AcceleratedGradientDescent::FUNCTION_RESTART); }},
+        {"Nesterov (g restart)", [&]() { return AOPT::AcceleratedGradientDescent::solve(opt_st.get(), start_pt, eps, max_iter,
+                                                                                       AOPT::AcceleratedGradientDescent::GRADIENT_RESTART); }},
+        {"BB1 (Grippo)", [&]() { return AOPT::BarzilaiBorwein::solve(opt_st.get(), start_pt, eps, max_iter,
+                                                                    AOPT::BarzilaiBorwein::BB1, AOPT::BarzilaiBorwein::GRIPPO); }},
+        {"BB2 (Grippo)", [&]() { return AOPT::BarzilaiBorwein::solve(opt_st.get(), start_pt, eps, max_iter,
+                                                                    AOPT::BarzilaiBorwein::BB2, AOPT::BarzilaiBorwein::GRIPPO); }},
+        {"BB1/BB2 (Zhang-Hager)", [&]() { return AOPT::BarzilaiBorwein::solve(opt_st.get(), start_pt, eps, max_iter,
+                                                                             AOPT::BarzilaiBorwein::ALTERNATING, AOPT::BarzilaiBorwein::ZHANG_HAGER); }}
+    };
+
+    struct Result {
+        double f, g2, time;
+        int n_f, n_g;
+    };
+    std::vector<Result> results;
+
+    AOPT::StopWatch<> sw;
+    for(auto& solver : solvers) {
+        opt_st->start_recording();
+        sw.start();
+        auto x = solver.second();
+        double time = sw.stop();
+        int n_f = opt_st->n_eval_f(), n_g = opt_st->n_eval_gradient();
+
+        AOPT::GradientDescent::Vec g;
+        opt_st->eval_gradient(x, g);
+        results.push_back({opt_st->eval_f(x), g.squaredNorm(), time, n_f, n_g});
+    }
+
+    std::cout << "\n######## First-order methods (" << opt_st->n_unknowns() << " unknowns) ########" << std::endl;
+    std::cout << std::setw(24) << "method" << std::setw(12) << "time [ms]" << std::setw(10) << "#eval_f"
+              << std::setw(10) << "#eval_g" << std::setw(18) << "obj" << std::setw(14) << "||g||^2" << std::endl;
+    for(size_t i = 0; i < solvers.size(); ++i) {
+        std::cout << std::setw(24) << solvers[i].first << std::setw(12) << results[i].time
+                  << std::setw(10) << results[i].n_f << std::setw(10) << results[i].n_g
+                  << std::setw(18) << std::setprecision(10) << results[i].f
+                  << std::setw(14) << std::setprecision(3) << results[i].g2 << std::endl;
+    }
+
+    return 0;
+}
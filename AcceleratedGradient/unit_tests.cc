@@ -0,0 +1,130 @@
+#include <iostream>
+#include <Utils/StopWatch.hh>
+#include <MassSpringSystemT.hh>
+#include <Functions/ConstrainedSpringElement2D.hh>
+#include <Functions/FunctionQuadraticND.hh>
+#include <FunctionBase/ParametricFunctionWrapper.hh>
+#include <Algorithms/AcceleratedGradientDescent.hh>
+#include <Algorithms/BarzilaiBorwein.hh>
+
+#include "gtest/gtest.h"
+
+
+using namespace AOPT;
+
+/** Those unit tests basically checks individual parts of your implementation.
+ * They generally work by either
+ * 1. comparing your results with ours
+ * 2. comparing your results with manually obtained ones
+ *    (when it's a simple problem solvable by hand)
+ *
+ * Feel free to modify the tests but ONLY to output intermediary values/results BUT
+ * do not modify it in any way that would change its result.
+ *
+ * For more details about googletest, please visit
+ * https://github.com/Macaulay2/googletest-1/blob/master/googletest/docs/Primer.md
+**/
+
+
+FunctionQuadraticND get_quadratic_problem() {
+    const int dim(5);
+
+    FunctionQuadraticND::Mat A(dim, dim);
+    A <<    246.652,  107.143,  117.078, -125.157,  21.0117,
+            107.143,  244.831, -34.6749, -3.39497,  105.168,
+            117.078, -34.6749,  114.209, -57.6975,  14.9266,
+           -125.157, -3.39497, -57.6975,  129.647,   99.809,
+            21.0117,  105.168,  14.9266,   99.809,  222.531;
+
+    FunctionQuadraticND::Vec b(dim);
+    b << 0.832402, -9.81436,  9.98931, -9.74196,  6.84995;
+
+    return FunctionQuadraticND(A, b, 0.);
+}
+
+
+/** Checks that the nonmonotone line search accepts an increase of f
+ * as long as it stays below the reference value */
+TEST(LineSearch, CheckNonmonotoneBackTrackingLineSearch){
+    using Vec = FunctionQuadraticND::Vec;
+
+    //f(x) = x^2
+    FunctionQuadraticND::Mat A(1, 1);
+    A << 2.;
+    Vec b(1);
+    b << 0.;
+    FunctionQuadraticND func(A, b, 0.);
+
+    Vec x(1), g(1);
+    x << 1.;
+    func.eval_gradient(x, g);
+
+    //f(x - 1.5*g) = 4 > f(x) = 1
+    ASSERT_DOUBLE_EQ(LineSearch::nonmonotone_backtracking_line_search(&func, x, g, -g, 10., 1.5), 1.5);
+    ASSERT_DOUBLE_EQ(LineSearch::nonmonotone_backtracking_line_search(&func, x, g, -g, func.eval_f(x), 1.5), 0.75);
+}
+
+
+/** Checks that all restart schemes find the minimum of a quadratic problem */
+TEST(AcceleratedGradientDescent, SimpleQuadraticProblem){
+    auto func = get_quadratic_problem();
+
+    FunctionQuadraticND::Vec init_x(5), expected_result(5);
+    init_x << -1, 5, 4, 3, 5;
+    expected_result << 0.854001, -0.123255,  -0.33051,   1.18085, -0.560632;
+
+    for(auto restart : {AcceleratedGradientDescent::NO_RESTART,
+                        AcceleratedGradientDescent::FUNCTION_RESTART,
+                        AcceleratedGradientDescent::GRADIENT_RESTART}) {
+        auto result = AcceleratedGradientDescent::solve(&func, init_x, 1e-6, 100000, restart);
+        ASSERT_LT((result - expected_result).norm(), 1e-5);
+    }
+}
+
+
+/** Checks that all step sizes and reference values find the minimum of a quadratic problem */
+TEST(BarzilaiBorwein, SimpleQuadraticProblem){
+    auto func = get_quadratic_problem();
+
+    FunctionQuadraticND::Vec init_x(5), expected_result(5);
+    init_x << -1, 5, 4, 3, 5;
+    expected_result << 0.854001, -0.123255,  -0.33051,   1.18085, -0.560632;
+
+    for(auto step : {BarzilaiBorwein::BB1, BarzilaiBorwein::BB2, BarzilaiBorwein::ALTERNATING})
+        for(auto reference : {BarzilaiBorwein::GRIPPO, BarzilaiBorwein::ZHANG_HAGER}) {
+            auto result = BarzilaiBorwein::solve(&func, init_x, 1e-6, 100000, step, reference);
+            ASSERT_LT((result - expected_result).norm(), 1e-5);
+        }
+}
+
+
+/** Checks both methods on a constrained spring element */
+TEST(AcceleratedGradientDescent, CheckAlgorithmsOnConstrainedSpringElement){
+
+    using Vec = ConstrainedSpringElement2D::Vec;
+
+    ConstrainedSpringElement2D csel;
+    Vec coeffs(3);
+    Eigen::VectorXd desired_location(2);
+    desired_location<<-1, 1;
+    coeffs<<10, desired_location[0], desired_location[1];
+
+    ParametricFunctionWrapper<ConstrainedSpringElement2D> non_param_csel(csel, coeffs);
+
+
+    Vec start_pt(2);
+    start_pt << 10, 10;
+
+    Vec result = AcceleratedGradientDescent::solve(&non_param_csel, start_pt);
+    ASSERT_NEAR((result-desired_location).norm(), 0, 1e-4);
+
+    result = BarzilaiBorwein::solve(&non_param_csel, start_pt);
+    ASSERT_NEAR((result-desired_location).norm(), 0, 1e-4);
+}
+
+int main(int _argc, char** _argv){
+
+    testing::InitGoogleTest(&_argc, _argv);
+    return RUN_ALL_TESTS();
+
+}
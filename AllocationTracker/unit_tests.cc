@@ -0,0 +1,47 @@
+#include <vector>
+#include <Eigen/Core>
+// counts the heap allocations of this test program
+#define AOPT_ALLOCATION_TRACKER_IMPLEMENTATION
+#include <Utils/AllocationTracker.hh>
+
+#include "gtest/gtest.h"
+
+
+using namespace AOPT;
+
+
+TEST(AllocationTracker, CountsHeapAllocations){
+    ASSERT_TRUE(AllocationTracker::installed());
+    if(!AllocationTracker::tracks_malloc())
+        GTEST_SKIP() << "the allocations of Eigen are only counted with glibc";
+
+    AllocationTracker::Scope scope;
+    {
+        // Eigen allocates with malloc, std::vector with operator new
+        Eigen::VectorXd v(100);
+        v.setRandom();
+        std::vector<double> w(v.data(), v.data() + v.size());
+        EXPECT_EQ(w[7], v[7]);
+    }
+    const AllocationTracker::Counts counts = scope.counts();
+    EXPECT_EQ(counts.allocations, 2u);
+    EXPECT_EQ(counts.deallocations, 2u);
+    EXPECT_EQ(counts.bytes, 2 * 100 * sizeof(double));
+}
+
+
+/** The counts of nested scopes only contain their own allocations */
+TEST(AllocationTracker, NestedScopes){
+    if(!AllocationTracker::tracks_malloc())
+        GTEST_SKIP() << "the allocations of Eigen are only counted with glibc";
+    AllocationTracker::Scope outer;
+    Eigen::VectorXd v(10);
+    {
+        AllocationTracker::Scope inner;
+        Eigen::VectorXd w(20);
+        EXPECT_EQ(inner.counts().allocations, 1u);
+        EXPECT_EQ(inner.counts().bytes, 20 * sizeof(double));
+    }
+    EXPECT_EQ(outer.counts().allocations, 2u);
+    EXPECT_EQ(outer.counts().deallocations, 1u);
+}
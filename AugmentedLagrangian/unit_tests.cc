@@ -257,6 +257,58 @@ TEST(AugmentedLagrangianProblem, CheckFunctionsWithBoundaryConstraintsA_lowDimPr
 
 
 
+/** constant hessians (objective without rest length, circle constraints) are only
+ * evaluated once, also when nu and mu are updated */
+TEST(AugmentedLagrangianProblem, CachesConstantHessians){
+
+    using Vec  = AugmentedLagrangianProblem::Vec;
+    using SMat = AugmentedLagrangianProblem::SMat;
+    const int dim(2);
+
+    AOPT::MassSpringSystemT<AOPT::MassSpringProblem2DSparse> mss(dim, dim, 0);
+    mss.add_boundary_constraints();
+
+    const int n = mss.get_problem()->n_unknowns();
+    auto constraints = mss.get_constraints();
+    const int m = constraints.size();
+
+    AOPT::OptimizationStatistic obj_st(mss.get_problem().get());
+    std::vector<AOPT::OptimizationStatistic> constraint_st;
+    constraint_st.reserve(m);
+    std::vector<FunctionBaseSparse*> st_constraints;
+    for(auto* c : constraints) {
+        constraint_st.emplace_back(c);
+        st_constraints.push_back(&constraint_st.back());
+    }
+
+    Vec nu(m);
+    nu.setConstant(0.1);
+    AugmentedLagrangianProblem problem(&obj_st, st_constraints, mss.get_constraints_squared(), nu, 0.5);
+    EXPECT_FALSE(problem.has_constant_hessian());
+
+    Vec x(n), y(n);
+    x.setZero();
+    y.setLinSpaced(-1., 2.);
+
+    SMat H(n, n);
+    problem.eval_hessian(x, H);
+    nu.setConstant(0.3);
+    problem.set_nu(nu);
+    problem.set_mu(2.);
+    problem.eval_hessian(y, H);
+
+    AugmentedLagrangianProblem fresh(mss.get_problem().get(), constraints, mss.get_constraints_squared(), nu, 2.);
+    SMat H_fresh(n, n);
+    fresh.eval_hessian(y, H_fresh);
+
+    EXPECT_NEAR((H - H_fresh).norm(), 0., 1e-10);
+    EXPECT_EQ(obj_st.n_eval_hessian(), 1);
+    for(auto& st : constraint_st)
+        EXPECT_EQ(st.n_eval_hessian(), 1);
+}
+
+
+
 TEST(AugmentedLagrangianProblem, CheckFunctionsWithBoundaryConstraintsA_higherDimProblem){
 
     using Vec  = AugmentedLagrangianProblem::Vec;
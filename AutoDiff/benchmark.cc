@@ -0,0 +1,239 @@
+#include <Utils/StopWatch.hh>
+#include <Utils/RandomNumberGenerator.hh>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <Functions/SpringElement2D.hh>
+#include <Functions/SpringElement2DWithLength.hh>
+#include <Functions/ConstrainedSpringElement2D.hh>
+#include <Functions/CircleConstraint2D.hh>
+#include <Functions/AreaConstraint2D.hh>
+#include <Functions/SpringElement2DAutoDiff.hh>
+#include <Functions/SpringElement2DWithLengthAutoDiff.hh>
+#include <Functions/ConstrainedSpringElement2DAutoDiff.hh>
+#include <Functions/CircleConstraint2DAutoDiff.hh>
+#include <Functions/AreaConstraint2DAutoDiff.hh>
+#include <Functions/MassSpringProblem2DSparse.hh>
+
+using Vec = AOPT::ParametricFunctionBase::Vec;
+using Mat = AOPT::ParametricFunctionBase::Mat;
+using SMat = AOPT::FunctionBaseSparse::SMat;
+
+// sum of all outputs, printed at the end so that no evaluation is optimized away
+double checksum = 0.;
+
+/** \return the time of _f() in nanoseconds per evaluation */
+template <class F>
+double time_ns(F&& _f, const long _n_evals) {
+    AOPT::StopWatch<std::chrono::microseconds> sw;
+    sw.start();
+    _f();
+    return 1e3 * sw.stop() / _n_evals;
+}
+
+void print_row(const std::string& _name, const std::string& _what, const double _t_hand, const double _t_ad) {
+    std::cout << std::setw(28) << _name << std::setw(10) << _what
+              << std::setw(16) << std::setprecision(4) << _t_hand << std::setw(16) << _t_ad
+              << std::setw(10) << std::setprecision(3) << _t_ad / _t_hand << std::endl;
+}
+
+/** element functions, through the virtual interface of ParametricFunctionBase,
+ * and the fused eval_local() of the automatically differentiated element */
+template <class AD>
+void bench_element(const std::string& _name, AOPT::ParametricFunctionBase& _hand, AD& _ad,
+                   const Vec& _coeffs, const std::vector<Vec>& _points, const int _n_reps) {
+    const int n = _hand.n_unknowns();
+    const long n_evals = (long)_n_reps * _points.size();
+    Vec g(n);
+    Mat H(n, n);
+
+    auto run = [&](AOPT::ParametricFunctionBase& _func, const int _order) {
+        return time_ns([&]() {
+            for(int r = 0; r < _n_reps; ++r)
+                for(const auto& x : _points) {
+                    if(_order == 0)
+                        checksum += _func.eval_f(x, _coeffs);
+                    else if(_order == 1) {
+                        _func.eval_gradient(x, _coeffs, g);
+                        checksum += g[0];
+                    } else {
+                        _func.eval_hessian(x, _coeffs, H);
+                        checksum += H(0, 0);
+                    }
+                }
+        }, n_evals);
+    };
+
+    print_row(_name, "f", run(_hand, 0), run(_ad, 0));
+    print_row(_name, "g", run(_hand, 1), run(_ad, 1));
+    print_row(_name, "H", run(_hand, 2), run(_ad, 2));
+
+    // f, g and H at once
+    std::vector<typename AD::LocalVec> local(_points.size());
+    for(size_t i = 0; i < _points.size(); ++i)
+        local[i] = _points[i];
+    typename AD::LocalVec gl;
+    typename AD::LocalMat Hl;
+    double t_hand = time_ns([&]() {
+        for(int r = 0; r < _n_reps; ++r)
+            for(const auto& x : _points) {
+                checksum += _hand.eval_f(x, _coeffs);
+                _hand.eval_gradient(x, _coeffs, g);
+                _hand.eval_hessian(x, _coeffs, H);
+                checksum += g[0] + H(0, 0);
+            }
+    }, n_evals);
+    double t_ad = time_ns([&]() {
+        for(int r = 0; r < _n_reps; ++r)
+            for(const auto& x : local) {
+                checksum += _ad.eval_local(x, _coeffs, &gl, &Hl);
+                checksum += gl[0] + Hl(0, 0);
+            }
+    }, n_evals);
+    print_row(_name, "f+g+H", t_hand, t_ad);
+}
+
+/** functions of FunctionBaseSparse that only depend on a few unknowns */
+void bench_sparse(const std::string& _name, AOPT::FunctionBaseSparse& _hand, AOPT::FunctionBaseSparse& _ad,
+                  const std::vector<Vec>& _points, const int _n_reps) {
+    const int n = _hand.n_unknowns();
+    const long n_evals = (long)_n_reps * _points.size();
+    Vec g(n);
+    SMat H(n, n);
+
+    auto run = [&](AOPT::FunctionBaseSparse& _func, const int _order) {
+        return time_ns([&]() {
+            for(int r = 0; r < _n_reps; ++r)
+                for(const auto& x : _points) {
+                    if(_order == 0)
+                        checksum += _func.eval_f(x);
+                    else if(_order == 1) {
+                        _func.eval_gradient(x, g);
+                        checksum += g[0];
+                    } else {
+                        _func.eval_hessian(x, H);
+                        checksum += H.sum();
+                    }
+                }
+        }, n_evals);
+    };
+
+    print_row(_name, "f", run(_hand, 0), run(_ad, 0));
+    print_row(_name, "g", run(_hand, 1), run(_ad, 1));
+    print_row(_name, "H", run(_hand, 2), run(_ad, 2));
+}
+
+/** assembly of a whole mass spring problem, a n x n grid with diagonal springs
+ * and the four corners attached */
+void bench_problem(const std::string& _name, AOPT::ParametricFunctionBase& _hand, AOPT::ParametricFunctionBase& _ad,
+                   const int _n_grid, const int _n_reps) {
+    const int n_nodes = (_n_grid + 1) * (_n_grid + 1);
+    auto setup = [&](AOPT::MassSpringProblem2DSparse& _p) {
+        auto v = [&](int _i, int _j) { return _i * (_n_grid + 1) + _j; };
+        for(int i = 0; i <= _n_grid; ++i)
+            for(int j = 0; j <= _n_grid; ++j) {
+                if(j < _n_grid) _p.add_spring_element(v(i, j), v(i, j+1), 1., 1.);
+                if(i < _n_grid) _p.add_spring_element(v(i, j), v(i+1, j), 1., 1.);
+                if(i < _n_grid && j < _n_grid) _p.add_spring_element(v(i, j), v(i+1, j+1), 1., std::sqrt(2.));
+            }
+        _p.add_constrained_spring_element(v(0, 0), 1e5, 0., 0.);
+        _p.add_constrained_spring_element(v(0, _n_grid), 1e5, 0., _n_grid);
+        _p.add_constrained_spring_element(v(_n_grid, 0), 1e5, _n_grid, 0.);
+        _p.add_constrained_spring_element(v(_n_grid, _n_grid), 1e5, _n_grid, _n_grid);
+    };
+
+    AOPT::MassSpringProblem2DSparse hand(_hand, 2 * n_nodes), ad(_ad, 2 * n_nodes);
+    setup(hand);
+    setup(ad);
+
+    AOPT::RandomNumberGenerator rng(-0.3, 0.3);
+    Vec x(2 * n_nodes);
+    for(int i = 0; i <= _n_grid; ++i)
+        for(int j = 0; j <= _n_grid; ++j) {
+            x[2 * (i * (_n_grid + 1) + j)] = i;
+            x[2 * (i * (_n_grid + 1) + j) + 1] = j;
+        }
+    x += rng.get_random_nd_vector(2 * n_nodes);
+
+    Vec g(2 * n_nodes);
+    SMat H(2 * n_nodes, 2 * n_nodes);
+    auto run = [&](AOPT::MassSpringProblem2DSparse& _p, const int _order) {
+        return time_ns([&]() {
+            for(int r = 0; r < _n_reps; ++r) {
+                if(_order == 1) {
+                    _p.eval_gradient(x, g);
+                    checksum += g[0];
+                } else {
+                    _p.eval_hessian(x, H);
+                    checksum += H.coeff(0, 0);
+                }
+            }
+        }, _n_reps);
+    };
+
+    print_row(_name, "g [us]", 1e-3 * run(hand, 1), 1e-3 * run(ad, 1));
+    print_row(_name, "H [us]", 1e-3 * run(hand, 2), 1e-3 * run(ad, 2));
+}
+
+/* Compares the elements with hand written derivatives to the ones differentiated
+ * automatically (Utils/AutoDiff.hh), for single element evaluations and for the
+ * assembly of a mass spring problem. */
+int main(int _argc, const char* _argv[]) {
+    if(_argc > 1 && std::string(_argv[1]) == "-h") {
+        std::cout << "Usage: input should be 'number of points (optional, default 1000), repetitions (optional, default 1000), "
+                     "number of grid for the problem assembly (optional, default 200)', e.g. "
+                     "./AutoDiff-benchmark 1000 1000 200" << std::endl;
+        return -1;
+    }
+
+    //read the input parameters
+    int n_points = _argc > 1 ? atoi(_argv[1]) : 1000;
+    int n_reps = _argc > 2 ? atoi(_argv[2]) : 1000;
+    int n_grid = _argc > 3 ? atoi(_argv[3]) : 200;
+
+    AOPT::RandomNumberGenerator rng(-2., 2.);
+    std::vector<Vec> points2(n_points), points4(n_points), points12(n_points);
+    for(int i = 0; i < n_points; ++i) {
+        points2[i] = rng.get_random_nd_vector(2);
+        points4[i] = rng.get_random_nd_vector(4);
+        points12[i] = rng.get_random_nd_vector(12);
+    }
+
+    std::cout << "\n######## automatic differentiation benchmark (" << n_points << " points x "
+              << n_reps << " repetitions) ########" << std::endl;
+    std::cout << std::setw(28) << "function" << std::setw(10) << "eval"
+              << std::setw(16) << "hand [ns]" << std::setw(16) << "autodiff [ns]" << std::setw(10) << "ratio" << std::endl;
+
+    Vec coeffs(3);
+    coeffs << 2., 1.5, 0.5;
+
+    AOPT::SpringElement2D se;
+    AOPT::SpringElement2DAutoDiff se_ad;
+    bench_element("SpringElement2D", se, se_ad, coeffs, points4, n_reps);
+
+    AOPT::SpringElement2DWithLength sewl;
+    AOPT::SpringElement2DWithLengthAutoDiff sewl_ad;
+    bench_element("SpringElement2DWithLength", sewl, sewl_ad, coeffs, points4, n_reps);
+
+    AOPT::ConstrainedSpringElement2D cse;
+    AOPT::ConstrainedSpringElement2DAutoDiff cse_ad;
+    bench_element("ConstrainedSpringElement2D", cse, cse_ad, coeffs, points2, n_reps);
+
+    // on 6 nodes, the Hessian includes the assembly of a sparse matrix
+    AOPT::CircleConstraint2D cc(12, 2, 0.5, -0.5, 1.);
+    AOPT::CircleConstraint2DAutoDiff cc_ad(12, 2, 0.5, -0.5, 1.);
+    bench_sparse("CircleConstraint2D", cc, cc_ad, points12, n_reps / 10);
+
+    AOPT::AreaConstraint2D ac(12, 1, 3, 4);
+    AOPT::AreaConstraint2DAutoDiff ac_ad(12, 1, 3, 4);
+    bench_sparse("AreaConstraint2D", ac, ac_ad, points12, n_reps / 10);
+
+    std::cout << "\n######## mass spring problem assembly (" << n_grid << "x" << n_grid << " grid) ########" << std::endl;
+    bench_problem("MassSpringProblem2DSparse", se, se_ad, n_grid, 10);
+    bench_problem("... with length", sewl, sewl_ad, n_grid, 10);
+
+    std::cout << "\nchecksum: " << checksum << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,217 @@
+#include <cmath>
+#include <Utils/AutoDiff.hh>
+#include <Utils/RandomNumberGenerator.hh>
+#include <Functions/SpringElement2D.hh>
+#include <Functions/SpringElement2DWithLength.hh>
+#include <Functions/ConstrainedSpringElement2D.hh>
+#include <Functions/CircleConstraint2D.hh>
+#include <Functions/AreaConstraint2D.hh>
+#include <Functions/SpringElement2DAutoDiff.hh>
+#include <Functions/SpringElement2DWithLengthAutoDiff.hh>
+#include <Functions/ConstrainedSpringElement2DAutoDiff.hh>
+#include <Functions/CircleConstraint2DAutoDiff.hh>
+#include <Functions/AreaConstraint2DAutoDiff.hh>
+#include <Functions/MassSpringProblem2DSparse.hh>
+
+#include "gtest/gtest.h"
+
+using namespace AOPT;
+
+using Vec = Eigen::VectorXd;
+using Mat = Eigen::MatrixXd;
+
+
+/** f(x, y) = x y / (1 + x^2) + sin(x) log(y) + y^1.5 + exp(x - y) - sqrt(x^2 + y) + cos(y) / x */
+template <class S>
+S test_function(const S& _x, const S& _y) {
+    using std::sin; using std::cos; using std::log; using std::exp; using std::sqrt; using std::pow;
+    return _x * _y / (1. + _x * _x) + sin(_x) * log(_y) + pow(_y, 1.5) + exp(_x - _y) - sqrt(_x * _x + _y) + cos(_y) / _x;
+}
+
+/** checks the derivatives of a function using all operations against finite differences */
+TEST(AutoDiff, DualNumbers) {
+    const double x = 0.7, y = 1.3;
+
+    const Dual<2> d = test_function(Dual<2>::variable(x, 0), Dual<2>::variable(y, 1));
+    const HyperDual<2> hd = test_function(HyperDual<2>::variable(x, 0), HyperDual<2>::variable(y, 1));
+
+    EXPECT_DOUBLE_EQ(d.v, test_function(x, y));
+    EXPECT_DOUBLE_EQ(hd.v, test_function(x, y));
+
+    const double h = 1e-5;
+    Eigen::Vector2d g_fd((test_function(x + h, y) - test_function(x - h, y)) / (2 * h),
+                         (test_function(x, y + h) - test_function(x, y - h)) / (2 * h));
+    EXPECT_NEAR((d.gradient() - g_fd).norm(), 0., 1e-8);
+    EXPECT_NEAR((hd.gradient() - d.gradient()).norm(), 0., 1e-14);
+
+    // columns of the Hessian from differences of the gradient
+    auto grad = [](const double _x, const double _y) {
+        return test_function(Dual<2>::variable(_x, 0), Dual<2>::variable(_y, 1)).gradient();
+    };
+    Eigen::Matrix2d H_fd;
+    H_fd.col(0) = (grad(x + h, y) - grad(x - h, y)) / (2 * h);
+    H_fd.col(1) = (grad(x, y + h) - grad(x, y - h)) / (2 * h);
+    EXPECT_NEAR((hd.hessian() - H_fd).norm(), 0., 1e-7);
+    EXPECT_DOUBLE_EQ(hd.hessian()(0, 1), hd.hessian()(1, 0));
+
+    // exact for polynomials
+    const HyperDual<2> p = pow(HyperDual<2>::variable(x, 0), 3.) * HyperDual<2>::variable(y, 1);
+    EXPECT_DOUBLE_EQ(p.g[0], 3 * x * x * y);
+    EXPECT_DOUBLE_EQ(p.hessian()(0, 0), 6 * x * y);
+    EXPECT_DOUBLE_EQ(p.hessian()(0, 1), 3 * x * x);
+    EXPECT_DOUBLE_EQ(p.hessian()(1, 1), 0.);
+}
+
+
+/** pow is finite at 0 wherever the power and its derivatives are */
+TEST(AutoDiff, PowAtZero) {
+    const HyperDual<1> x = HyperDual<1>::variable(0., 0);
+
+    const HyperDual<1> p1 = pow(x, 1.);
+    EXPECT_EQ(p1.v, 0.);
+    EXPECT_EQ(p1.g[0], 1.);
+    EXPECT_EQ(p1.h[0], 0.);
+
+    const HyperDual<1> p15 = pow(x, 1.5);
+    EXPECT_EQ(p15.v, 0.);
+    EXPECT_EQ(p15.g[0], 0.);
+
+    const HyperDual<1> p3 = pow(x, 3.);
+    EXPECT_EQ(p3.v, 0.);
+    EXPECT_EQ(p3.g[0], 0.);
+    EXPECT_EQ(p3.h[0], 0.);
+
+    const Dual<1> d = pow(Dual<1>::variable(0., 0), 1.5);
+    EXPECT_EQ(d.v, 0.);
+    EXPECT_EQ(d.g[0], 0.);
+}
+
+
+/** compares the value, gradient and Hessian of two elements at random points */
+void compare_elements(ParametricFunctionBase& _hand, ParametricFunctionBase& _ad, const Vec& _coeffs) {
+    const int n = _hand.n_unknowns();
+    ASSERT_EQ(_ad.n_unknowns(), n);
+
+    RandomNumberGenerator rng(-2., 2.);
+    Vec g0(n), g1(n);
+    Mat H0(n, n), H1(n, n);
+    for(int i = 0; i < 20; ++i) {
+        Vec x = rng.get_random_nd_vector(n);
+        EXPECT_NEAR(_hand.eval_f(x, _coeffs), _ad.eval_f(x, _coeffs), 1e-12);
+
+        _hand.eval_gradient(x, _coeffs, g0);
+        _ad.eval_gradient(x, _coeffs, g1);
+        EXPECT_NEAR((g0 - g1).norm(), 0., 1e-12 * std::max(1., g0.norm()));
+
+        _hand.eval_hessian(x, _coeffs, H0);
+        _ad.eval_hessian(x, _coeffs, H1);
+        EXPECT_NEAR((H0 - H1).norm(), 0., 1e-12 * std::max(1., H0.norm()));
+    }
+}
+
+TEST(AutoDiff, SpringElements) {
+    Vec coeffs(2);
+    coeffs << 2., 1.5;
+
+    SpringElement2D se;
+    SpringElement2DAutoDiff se_ad;
+    compare_elements(se, se_ad, coeffs);
+
+    SpringElement2DWithLength sewl;
+    SpringElement2DWithLengthAutoDiff sewl_ad;
+    compare_elements(sewl, sewl_ad, coeffs);
+
+    Vec ccoeffs(3);
+    ccoeffs << 1e5, 0.5, -1.;
+    ConstrainedSpringElement2D cse;
+    ConstrainedSpringElement2DAutoDiff cse_ad;
+    compare_elements(cse, cse_ad, ccoeffs);
+}
+
+/** the fused evaluation gives the same as the separate ones */
+TEST(AutoDiff, EvalLocal) {
+    Vec coeffs(2);
+    coeffs << 2., 1.5;
+    SpringElement2DWithLengthAutoDiff sewl_ad;
+
+    Vec x(4);
+    x << 0.1, -0.3, 1.2, 0.8;
+    SpringElement2DWithLengthAutoDiff::LocalVec xl = x, gl;
+    SpringElement2DWithLengthAutoDiff::LocalMat Hl;
+
+    Vec g(4);
+    Mat H(4, 4);
+    sewl_ad.eval_gradient(x, coeffs, g);
+    sewl_ad.eval_hessian(x, coeffs, H);
+
+    EXPECT_DOUBLE_EQ(sewl_ad.eval_local(xl, coeffs), sewl_ad.eval_f(x, coeffs));
+    EXPECT_DOUBLE_EQ(sewl_ad.eval_local(xl, coeffs, &gl), sewl_ad.eval_f(x, coeffs));
+    EXPECT_EQ((gl - g).norm(), 0.);
+    gl.setZero();
+    EXPECT_DOUBLE_EQ(sewl_ad.eval_local(xl, coeffs, &gl, &Hl), sewl_ad.eval_f(x, coeffs));
+    EXPECT_EQ((gl - g).norm(), 0.);
+    EXPECT_EQ((Hl - H).norm(), 0.);
+}
+
+
+/** compares two functions of FunctionBaseSparse at random points */
+void compare_sparse(FunctionBaseSparse& _hand, FunctionBaseSparse& _ad) {
+    const int n = _hand.n_unknowns();
+    ASSERT_EQ(_ad.n_unknowns(), n);
+
+    RandomNumberGenerator rng(-2., 2.);
+    Vec g0(n), g1(n);
+    FunctionBaseSparse::SMat H0(n, n), H1(n, n);
+    for(int i = 0; i < 20; ++i) {
+        Vec x = rng.get_random_nd_vector(n);
+        EXPECT_NEAR(_hand.eval_f(x), _ad.eval_f(x), 1e-12);
+
+        _hand.eval_gradient(x, g0);
+        _ad.eval_gradient(x, g1);
+        EXPECT_NEAR((g0 - g1).norm(), 0., 1e-12);
+
+        _hand.eval_hessian(x, H0);
+        _ad.eval_hessian(x, H1);
+        EXPECT_NEAR((Mat(H0) - Mat(H1)).norm(), 0., 1e-12);
+    }
+}
+
+TEST(AutoDiff, Constraints) {
+    CircleConstraint2D cc(10, 3, 0.5, -0.5, 1.);
+    CircleConstraint2DAutoDiff cc_ad(10, 3, 0.5, -0.5, 1.);
+    compare_sparse(cc, cc_ad);
+
+    AreaConstraint2D ac(10, 4, 0, 2, 1e-3);
+    AreaConstraint2DAutoDiff ac_ad(10, 4, 0, 2, 1e-3);
+    compare_sparse(ac, ac_ad);
+}
+
+
+/** the elements can be used in a mass spring problem */
+TEST(AutoDiff, MassSpringProblem) {
+    SpringElement2DWithLength sewl;
+    SpringElement2DWithLengthAutoDiff sewl_ad;
+    MassSpringProblem2DSparse msp(sewl, 8), msp_ad(sewl_ad, 8);
+    for(auto* p : {&msp, &msp_ad}) {
+        p->add_spring_element(0, 1, 1., 1.);
+        p->add_spring_element(1, 2, 1., 1.);
+        p->add_spring_element(2, 3, 2., 1.);
+        p->add_spring_element(3, 0, 1., 1.);
+        p->add_spring_element(0, 2, 1., std::sqrt(2.));
+        p->add_constrained_spring_element(0, 10., 0., 0.);
+    }
+
+    Vec x(8);
+    x << 0.1, 0., 1.2, 0.1, 0.9, 1.1, -0.1, 0.8;
+    EXPECT_NEAR(msp.eval_f(x), msp_ad.eval_f(x), 1e-12);
+
+    Vec g0(8), g1(8);
+    msp.eval_gradient(x, g0);
+    msp_ad.eval_gradient(x, g1);
+    EXPECT_NEAR((g0 - g1).norm(), 0., 1e-12);
+
+    FunctionBaseSparse::SMat H0, H1;
+    msp.eval_hessian(x, H0);
+    msp_ad.eval_hessian(x, H1);
+    EXPECT_NEAR((Mat(H0) - Mat(H1)).norm(), 0., 1e-12);
+}
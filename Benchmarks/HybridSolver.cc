@@ -0,0 +1,43 @@
+#include "HybridSolver.hh"
+#include <unsupported/Eigen/NonLinearOptimization>
+
+//== NAMESPACES ===============================================================
+
+namespace AOPT {
+
+    namespace {
+        // the functor interface of hybrj
+        struct HybridFunctor {
+            int operator()(const Eigen::VectorXd& _x, Eigen::VectorXd& _fvec) {
+                F(_x, _fvec);
+                return 0;
+            }
+
+            int df(const Eigen::VectorXd& _x, Eigen::MatrixXd& _fjac) {
+                jacobian(_x, _fjac);
+                return 0;
+            }
+
+            const std::function<void(const Eigen::VectorXd&, Eigen::VectorXd&)>& F;
+            const std::function<void(const Eigen::VectorXd&, Eigen::MatrixXd&)>& jacobian;
+        };
+    }
+
+    HybridSolverResult hybrid_solve(const std::function<void(const Eigen::VectorXd&, Eigen::VectorXd&)>& _F,
+                                    const std::function<void(const Eigen::VectorXd&, Eigen::MatrixXd&)>& _jacobian,
+                                    Eigen::VectorXd& _x, const double _tol, const int _max_evals) {
+        HybridFunctor functor{_F, _jacobian};
+        Eigen::HybridNonLinearSolver<HybridFunctor> solver(functor);
+        solver.parameters.xtol = _tol;
+        solver.parameters.maxfev = _max_evals;
+
+        HybridSolverResult result;
+        result.status = solver.solve(_x);
+        result.iterations = (int)solver.iter;
+        result.n_eval_F = (int)solver.nfev;
+        result.n_eval_jacobian = (int)solver.njev;
+        return result;
+    }
+
+//=============================================================================
+}
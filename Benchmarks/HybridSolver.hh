@@ -0,0 +1,35 @@
+#pragma once
+
+#include <functional>
+#include <Eigen/Dense>
+
+//== NAMESPACES ===============================================================
+
+namespace AOPT {
+
+    /* Eigen's HybridNonLinearSolver (Powell's hybrid method of MINPACK) for a root of
+     * F(x) = 0, e.g. the gradient of a function.
+     *
+     * It is compiled in HybridSolver.cc, because unsupported/Eigen/NonLinearOptimization
+     * and unsupported/Eigen/LevenbergMarquardt both define Eigen::LevenbergMarquardt and
+     * cannot be included in the same translation unit. */
+    struct HybridSolverResult {
+        // status of the solver, 1 if the relative error is below the tolerance
+        int status = 0;
+        int iterations = 0;
+        // evaluations of F and of its (dense) Jacobian
+        int n_eval_F = 0;
+        int n_eval_jacobian = 0;
+    };
+
+    /** \param _F evaluates F(_x)
+     * \param _jacobian evaluates the Jacobian of F at _x
+     * \param _x the start point, replaced by the root found
+     * \param _tol relative error between two iterates under which the solver stops
+     * \param _max_evals maximum number of evaluations of F */
+    HybridSolverResult hybrid_solve(const std::function<void(const Eigen::VectorXd&, Eigen::VectorXd&)>& _F,
+                                    const std::function<void(const Eigen::VectorXd&, Eigen::MatrixXd&)>& _jacobian,
+                                    Eigen::VectorXd& _x, const double _tol, const int _max_evals);
+
+//=============================================================================
+}
@@ -0,0 +1,73 @@
+#!/usr/bin/env python3
+"""Compares two result files of aopt_bench, e.g.
+
+    ./aopt_bench --json=current.json
+    python3 compare.py baseline.json current.json --threshold 0.15
+
+and prints the change of each benchmark. A benchmark is a regression if it is more
+than --threshold slower (relative to the baseline), the script then exits with 1.
+The benchmarks that are only in one of the files are listed but do not fail."""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        data = json.load(f)
+    return {b["name"]: b for b in data["benchmarks"]}
+
+
+def format_time(ns):
+    for unit, scale in (("s", 1e9), ("ms", 1e6), ("us", 1e3)):
+        if ns >= scale:
+            return "%.2f %s" % (ns / scale, unit)
+    return "%.2f ns" % ns
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compares two result files of aopt_bench.")
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=0.15,
+                        help="relative slowdown reported as a regression (default 0.15)")
+    parser.add_argument("--metric", default="median_time", choices=("median_time", "real_time", "min_time"),
+                        help="time compared (default median_time)")
+    args = parser.parse_args()
+
+    baseline = load(args.baseline)
+    current = load(args.current)
+
+    regressions = []
+    print("%-52s %14s %14s %9s" % ("benchmark", "baseline", "current", "change"))
+    for name, b in baseline.items():
+        if name not in current:
+            continue
+        old = b[args.metric]
+        new = current[name][args.metric]
+        change = (new - old) / old if old > 0 else 0.
+        status = ""
+        if change > args.threshold:
+            status = "  REGRESSION"
+            regressions.append(name)
+        elif change < -args.threshold:
+            status = "  improvement"
+        print("%-52s %14s %14s %+8.1f%%%s" % (name, format_time(old), format_time(new), 100. * change, status))
+
+    missing = [name for name in baseline if name not in current]
+    added = [name for name in current if name not in baseline]
+    if missing:
+        print("\nNot in %s: %s" % (args.current, ", ".join(missing)))
+    if added:
+        print("\nNot in %s: %s" % (args.baseline, ", ".join(added)))
+
+    if regressions:
+        print("\n%d regression(s) above %.0f%%: %s" % (len(regressions), 100. * args.threshold, ", ".join(regressions)))
+        return 1
+    print("\nNo regression above %.0f%%" % (100. * args.threshold))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
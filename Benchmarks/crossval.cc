@@ -0,0 +1,374 @@
+#include <cmath>
+#include <memory>
+#include <unsupported/Eigen/IterativeSolvers>
+#include <unsupported/Eigen/LevenbergMarquardt>
+#include <Utils/Benchmark.hh>
+#include <Algorithms/NewtonMethods.hh>
+#include <Algorithms/LBFGS.hh>
+#include <Algorithms/LevenbergMarquardt.hh>
+#include <Algorithms/MatrixFreeGaussNewton.hh>
+#include <Algorithms/LineSearch.hh>
+#include <Functions/FunctionQuadraticND.hh>
+#include <MassSpringSystemT.hh>
+#include "HybridSolver.hh"
+
+/* Runs the same problems through the solvers of AOPT and through the solvers of
+ * Eigen's unsupported modules, to see where AOPT stands:
+ *   - mass spring systems with springs with length, of 10^2 to 10^5 nodes, with Newton's
+ *     method, LBFGS, Gauss-Newton (assembled and matrix-free) and Levenberg-Marquardt
+ *     of AOPT, and with Newton's method with MINRES or GMRES steps, the
+ *     HybridNonLinearSolver on the gradient and the sparse LevenbergMarquardt of Eigen,
+ *   - random convex quadratic functions of 10 to 1000 unknowns, with the solvers that
+ *     do not need a least squares problem.
+ * Each solver runs until convergence (or its maximum number of iterations). Besides the
+ * time, the evaluations of f, the gradient, the Hessian, the residuals and the Jacobian,
+ * the final objective f and gradient norm are reported.
+ * The options are the ones of Utils/Benchmark.hh, e.g.
+ *     ./aopt_crossval --filter=springs/ --json=crossval.json
+ *
+ * Note that the stopping criteria differ: Newton's method of AOPT stops on the Newton
+ * decrement, the other AOPT solvers and the Newton-Krylov adapters on the gradient norm,
+ * and the Eigen solvers on their relative step and reduction tolerances. */
+
+using namespace AOPT;
+
+using Vec = FunctionBaseSparse::Vec;
+using SMat = FunctionBaseSparse::SMat;
+
+static const double eps = 1e-4;
+
+// numbers of nodes of the mass spring systems and of unknowns of the quadratic functions
+static const std::vector<long> node_counts = {100, 1000, 10000, 100000};
+static const std::vector<long> quadratic_sizes = {10, 100, 1000};
+
+// the dense Jacobian of the HybridNonLinearSolver and the sparse QR factorizations of the
+// LevenbergMarquardt of Eigen are only practical for small problems
+static const int max_dense_unknowns = 2500;
+static const int max_sparse_qr_unknowns = 1000;
+
+
+/* Counts the evaluations of a problem, and gives a dense function, e.g.
+ * FunctionQuadraticND, the sparse interface of the solvers.
+ * The least squares interface is forwarded too, it is only instantiated for the
+ * problems that have one. */
+template <class Problem>
+class CountingProblem : public FunctionBaseSparse {
+public:
+    CountingProblem(Problem* _base) : base_(_base) {}
+
+    virtual int n_unknowns() override { return base_->n_unknowns(); }
+
+    // so that the solvers take the same fast paths as on the problem itself
+    virtual bool is_quadratic() override { return base_->is_quadratic(); }
+
+    virtual bool has_constant_hessian() override { return base_->has_constant_hessian(); }
+
+    virtual double eval_f(const Vec &_x) override {
+        ++n_eval_f_;
+        return base_->eval_f(_x);
+    }
+
+    virtual void eval_gradient(const Vec &_x, Vec &_g) override {
+        ++n_eval_gradient_;
+        base_->eval_gradient(_x, _g);
+    }
+
+    virtual void eval_hessian(const Vec &_x, SMat &_H) override {
+        ++n_eval_hessian_;
+        hessian(base_, _x, _H);
+    }
+
+    int n_residuals() const { return base_->n_residuals(); }
+
+    void eval_r(const Vec &_x, Vec &_r) {
+        ++n_eval_r_;
+        base_->eval_r(_x, _r);
+    }
+
+    void eval_jacobian(const Vec &_x, SMat &_J) {
+        ++n_eval_jacobian_;
+        base_->eval_jacobian(_x, _J);
+    }
+
+    void eval_r_and_jacobian(const Vec &_x, Vec &_r, SMat &_J) {
+        ++n_eval_r_;
+        ++n_eval_jacobian_;
+        base_->eval_r_and_jacobian(_x, _r, _J);
+    }
+
+    void eval_jacobian_product(const Vec &_x, const Vec &_v, Vec &_jv) {
+        ++n_jacobian_products_;
+        base_->eval_jacobian_product(_x, _v, _jv);
+    }
+
+    void eval_jacobian_transpose_product(const Vec &_x, const Vec &_w, Vec &_jtw) {
+        ++n_jacobian_products_;
+        base_->eval_jacobian_transpose_product(_x, _w, _jtw);
+    }
+
+    void eval_jacobian_column_norms(const Vec &_x, Vec &_c) {
+        ++n_eval_jacobian_;
+        base_->eval_jacobian_column_norms(_x, _c);
+    }
+
+    void reset() { n_eval_f_ = n_eval_gradient_ = n_eval_hessian_ = n_eval_r_ = n_eval_jacobian_ = n_jacobian_products_ = 0; }
+
+    // the evaluations since the last reset(), the ones that were not used are left out
+    void set_counters(Benchmark::State& _state) const {
+        const std::pair<const char*, int> counts[] = {
+                {"n_f", n_eval_f_}, {"n_gradient", n_eval_gradient_}, {"n_hessian", n_eval_hessian_},
+                {"n_residual", n_eval_r_}, {"n_jacobian", n_eval_jacobian_}, {"n_jacobian_products", n_jacobian_products_}};
+        for(const auto& c : counts)
+            if(c.second > 0)
+                _state.set_counter(c.first, c.second);
+    }
+
+private:
+    static void hessian(FunctionBaseSparse* _problem, const Vec &_x, SMat &_H) { _problem->eval_hessian(_x, _H); }
+
+    static void hessian(FunctionBase* _function, const Vec &_x, SMat &_H) {
+        FunctionBase::Mat H(_function->n_unknowns(), _function->n_unknowns());
+        _function->eval_hessian(_x, H);
+        _H = H.sparseView();
+    }
+
+    Problem* base_;
+    int n_eval_f_ = 0, n_eval_gradient_ = 0, n_eval_hessian_ = 0;
+    int n_eval_r_ = 0, n_eval_jacobian_ = 0, n_jacobian_products_ = 0;
+};
+
+
+/* Newton's method whose steps are solved by an iterative solver of Eigen, e.g.
+ * MINRES or GMRES, to the relative residual min(0.5, sqrt(||g||)), with the backtracking
+ * line search of AOPT. A step that is not a descent direction is replaced by -g. */
+template <class KrylovSolver, class Problem>
+static Vec newton_krylov(Problem* _problem, const Vec& _initial_x, const double _eps, const int _max_iters, int& _n_inner) {
+    Vec x = _initial_x, g(_problem->n_unknowns()), dx;
+    SMat H;
+    KrylovSolver solver;
+    LineSearch::Workspace workspace;
+    _n_inner = 0;
+
+    for(int iter = 0; iter < _max_iters; ++iter) {
+        _problem->eval_gradient(x, g);
+        const double g_norm = g.norm();
+        if(g_norm <= _eps)
+            break;
+
+        _problem->eval_hessian(x, H);
+        solver.compute(H);
+        solver.setTolerance(std::min(0.5, std::sqrt(g_norm)));
+        dx = solver.solve(-g);
+        _n_inner += (int)solver.iterations();
+        if(solver.info() == Eigen::NumericalIssue || !dx.allFinite() || g.dot(dx) >= 0.)
+            dx = -g;
+
+        const double t = LineSearch::backtracking_line_search(_problem, x, g, dx, 1., workspace);
+        if(t * dx.norm() < 1e-16)
+            break;
+        x += t * dx;
+    }
+    return x;
+}
+
+
+// the residuals of a least squares problem for the sparse LevenbergMarquardt of Eigen
+template <class Problem>
+struct LeastSquaresFunctor : Eigen::SparseFunctor<double, int> {
+    LeastSquaresFunctor(Problem* _problem)
+            : Eigen::SparseFunctor<double, int>(_problem->n_unknowns(), _problem->n_residuals()), problem(_problem) {}
+
+    int operator()(const Vec& _x, Vec& _r) {
+        problem->eval_r(_x, _r);
+        return 0;
+    }
+
+    int df(const Vec& _x, SMat& _J) {
+        problem->eval_jacobian(_x, _J);
+        return 0;
+    }
+
+    Problem* problem;
+};
+
+
+// the root of the gradient found by the HybridNonLinearSolver, with the Hessian as Jacobian
+template <class Problem>
+static Vec hybrid_minimize(Problem* _problem, const Vec& _initial_x, Benchmark::State& _state) {
+    Vec x = _initial_x;
+    SMat H;
+    const HybridSolverResult result = hybrid_solve(
+            [&](const Vec& _x, Vec& _g) { _problem->eval_gradient(_x, _g); },
+            [&](const Vec& _x, Eigen::MatrixXd& _J) {
+                _problem->eval_hessian(_x, H);
+                // the Hessians of the problems hold both triangles
+                _J = Eigen::MatrixXd(H);
+            },
+            x, 1e-10, 10000);
+    _state.set_counter("iterations", result.iterations);
+    _state.set_counter("status", result.status);
+    return x;
+}
+
+
+// the objective and the gradient norm at the solution, the same for all the solvers of a problem
+template <class Problem>
+static void set_objective(Benchmark::State& _state, Problem* _problem, const Vec& _x) {
+    Vec g(_problem->n_unknowns());
+    _problem->eval_gradient(_x, g);
+    _state.set_counter("f", _problem->eval_f(_x));
+    _state.set_counter("gradient_norm", g.norm());
+}
+
+
+// a square mass spring system of springs with length with about _n_nodes nodes, as a
+// sparse problem with a positive semi-definite Hessian and as a least squares problem,
+// started from the same perturbed grid
+struct SpringGrid {
+    SpringGrid(const long _n_nodes)
+            : n_grid(std::max(1, (int)std::lround(std::sqrt((double)_n_nodes)) - 1)),
+              mss(n_grid, n_grid, 2), mss_ls(n_grid, n_grid, 1, true) {
+        mss.add_constrained_spring_elements();
+        mss_ls.add_constrained_spring_elements();
+        // the generator is not seeded, the start is the same for every run
+        RandomNumberGenerator rng(-0.1, 0.1);
+        x = mss.get_spring_graph_points() + rng.get_random_nd_vector(mss.get_problem()->n_unknowns());
+    }
+
+    int n_grid;
+    MassSpringSystemT<MassSpringProblem2DSparse> mss;
+    MassSpringSystemT<MassSpringProblem2DLeastSquare> mss_ls;
+    Vec x;
+};
+
+
+// registers a solver on the mass spring systems, _solve(problem, least squares problem, x0, state)
+template <class Solve>
+static void add_springs(Benchmark& _bench, const std::string& _name, Solve _solve) {
+    _bench.add("springs/" + _name, [_solve](Benchmark::State& _state) {
+        SpringGrid grid(_state.size());
+        CountingProblem<MassSpringProblem2DSparse> problem(grid.mss.get_problem().get());
+        CountingProblem<MassSpringProblem2DLeastSquare> ls_problem(grid.mss_ls.get_problem().get());
+        Vec x;
+        while(_state.keep_running()) {
+            problem.reset();
+            ls_problem.reset();
+            x = _solve(problem, ls_problem, grid.x, _state);
+        }
+        _state.set_counter("unknowns", grid.x.size());
+        problem.set_counters(_state);
+        ls_problem.set_counters(_state);
+        set_objective(_state, grid.mss.get_problem().get(), x);
+    }, node_counts);
+}
+
+
+// registers a solver on the quadratic functions, _solve(problem, x0, state)
+template <class Solve>
+static void add_quadratic(Benchmark& _bench, const std::string& _name, Solve _solve) {
+    _bench.add("quadratic/" + _name, [_solve](Benchmark::State& _state) {
+        FunctionQuadraticND func((int)_state.size());
+        CountingProblem<FunctionQuadraticND> problem(&func);
+        RandomNumberGenerator rng(-10., 10.);
+        const Vec x0 = rng.get_random_nd_vector(func.n_unknowns());
+        Vec x;
+        while(_state.keep_running()) {
+            problem.reset();
+            x = _solve(problem, x0, _state);
+        }
+        _state.set_counter("unknowns", x0.size());
+        problem.set_counters(_state);
+        set_objective(_state, &func, x);
+    }, quadratic_sizes);
+}
+
+
+int main(int _argc, const char* _argv[]) {
+    using SpringProblem = CountingProblem<MassSpringProblem2DSparse>;
+    using LeastSquaresProblem = CountingProblem<MassSpringProblem2DLeastSquare>;
+    using QuadraticProblem = CountingProblem<FunctionQuadraticND>;
+    using MINRES = Eigen::MINRES<SMat, Eigen::Lower | Eigen::Upper, Eigen::DiagonalPreconditioner<double>>;
+    using GMRES = Eigen::GMRES<SMat, Eigen::DiagonalPreconditioner<double>>;
+
+    Benchmark bench;
+
+    //------------------------------------------------------------------ mass springs
+    add_springs(bench, "aopt/Newton", [](SpringProblem& _p, LeastSquaresProblem&, const Vec& _x0, Benchmark::State&) {
+        return NewtonMethods::solve(&_p, _x0, eps, 100);
+    });
+    add_springs(bench, "aopt/LBFGS", [](SpringProblem& _p, LeastSquaresProblem&, const Vec& _x0, Benchmark::State&) {
+        LBFGS lbfgs(10);
+        return lbfgs.solve(&_p, _x0, eps, 2000);
+    });
+    // Newton's method with the Gauss-Newton Hessian J^TJ of the least squares problem
+    add_springs(bench, "aopt/GaussNewton", [](SpringProblem&, LeastSquaresProblem& _ls, const Vec& _x0, Benchmark::State&) {
+        return NewtonMethods::solve(&_ls, _x0, eps, 100);
+    });
+    add_springs(bench, "aopt/MatrixFreeGaussNewton", [](SpringProblem&, LeastSquaresProblem& _ls, const Vec& _x0, Benchmark::State&) {
+        return MatrixFreeGaussNewton::solve(&_ls, _x0, eps, 100, MatrixFreeGaussNewton::LSQR);
+    });
+    add_springs(bench, "aopt/LevenbergMarquardt", [](SpringProblem&, LeastSquaresProblem& _ls, const Vec& _x0, Benchmark::State& _state) {
+        LevenbergMarquardt lm;
+        Vec x = lm.solve(&_ls, _x0, eps, 100);
+        _state.set_counter("factorizations", lm.n_factorizations());
+        return x;
+    });
+    add_springs(bench, "eigen/MINRES-Newton", [](SpringProblem& _p, LeastSquaresProblem&, const Vec& _x0, Benchmark::State& _state) {
+        int n_inner(0);
+        Vec x = newton_krylov<MINRES>(&_p, _x0, eps, 100, n_inner);
+        _state.set_counter("krylov_iterations", n_inner);
+        return x;
+    });
+    add_springs(bench, "eigen/GMRES-Newton", [](SpringProblem& _p, LeastSquaresProblem&, const Vec& _x0, Benchmark::State& _state) {
+        int n_inner(0);
+        Vec x = newton_krylov<GMRES>(&_p, _x0, eps, 100, n_inner);
+        _state.set_counter("krylov_iterations", n_inner);
+        return x;
+    });
+    add_springs(bench, "eigen/HybridNonLinearSolver", [](SpringProblem& _p, LeastSquaresProblem&, const Vec& _x0, Benchmark::State& _state) {
+        if(_x0.size() > max_dense_unknowns) {
+            _state.skip("dense Jacobian of " + std::to_string(_x0.size()) + " unknowns");
+            return _x0;
+        }
+        return hybrid_minimize(&_p, _x0, _state);
+    });
+    add_springs(bench, "eigen/LevenbergMarquardt", [](SpringProblem&, LeastSquaresProblem& _ls, const Vec& _x0, Benchmark::State& _state) {
+        if(_x0.size() > max_sparse_qr_unknowns) {
+            _state.skip("sparse QR of " + std::to_string(_x0.size()) + " unknowns");
+            return _x0;
+        }
+        LeastSquaresFunctor<LeastSquaresProblem> functor(&_ls);
+        Eigen::LevenbergMarquardt<LeastSquaresFunctor<LeastSquaresProblem>> lm(functor);
+        lm.setMaxfev(1000);
+        Vec x = _x0;
+        _state.set_counter("status", lm.minimize(x));
+        _state.set_counter("iterations", lm.iterations());
+        return x;
+    });
+
+    //------------------------------------------------------------------ quadratic functions
+    add_quadratic(bench, "aopt/Newton", [](QuadraticProblem& _p, const Vec& _x0, Benchmark::State&) {
+        return NewtonMethods::solve(&_p, _x0, eps, 100);
+    });
+    add_quadratic(bench, "aopt/LBFGS", [](QuadraticProblem& _p, const Vec& _x0, Benchmark::State&) {
+        LBFGS lbfgs(10);
+        return lbfgs.solve(&_p, _x0, eps, 2000);
+    });
+    add_quadratic(bench, "eigen/MINRES-Newton", [](QuadraticProblem& _p, const Vec& _x0, Benchmark::State& _state) {
+        int n_inner(0);
+        Vec x = newton_krylov<MINRES>(&_p, _x0, eps, 100, n_inner);
+        _state.set_counter("krylov_iterations", n_inner);
+        return x;
+    });
+    add_quadratic(bench, "eigen/GMRES-Newton", [](QuadraticProblem& _p, const Vec& _x0, Benchmark::State& _state) {
+        int n_inner(0);
+        Vec x = newton_krylov<GMRES>(&_p, _x0, eps, 100, n_inner);
+        _state.set_counter("krylov_iterations", n_inner);
+        return x;
+    });
+    add_quadratic(bench, "eigen/HybridNonLinearSolver", [](QuadraticProblem& _p, const Vec& _x0, Benchmark::State& _state) {
+        return hybrid_minimize(&_p, _x0, _state);
+    });
+
+    return bench.run(_argc, _argv);
+}
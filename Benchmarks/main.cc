@@ -0,0 +1,281 @@
+#include <cmath>
+#include <memory>
+#include <Eigen/SparseLU>
+#include <Utils/Benchmark.hh>
+#include <Utils/RefactorizableLLT.hh>
+#include <Algorithms/GradientDescent.hh>
+#include <Algorithms/NewtonMethods.hh>
+#include <Algorithms/LBFGS.hh>
+#include <Algorithms/GridSearch.hh>
+#include <Algorithms/ConvexityTest.hh>
+#include <Functions/FunctionQuadratic2D.hh>
+#include <Functions/FunctionQuadraticND.hh>
+#include <MassSpringSystemT.hh>
+
+/* The benchmarks of the library, from the spring elements up to the solvers on mass
+ * spring systems of 10^2 to 10^6 nodes, see Utils/Benchmark.hh for the options, e.g.
+ *     ./aopt_bench --json=current.json
+ *     ./aopt_bench --max-size=1000000 --filter=solver/
+ * The results are compared with Benchmarks/baseline.json by
+ *     python3 Benchmarks/compare.py Benchmarks/baseline.json current.json */
+
+using namespace AOPT;
+
+using Vec = FunctionBaseSparse::Vec;
+using SMat = FunctionBaseSparse::SMat;
+
+// numbers of nodes of the mass spring systems
+static const std::vector<long> node_counts = {100, 1000, 10000, 100000, 1000000};
+// the fill of the sparse factors of 10^6 nodes takes more memory than most machines have
+static const std::vector<long> factorized_node_counts = {100, 1000, 10000, 100000};
+
+// a square mass spring system with about _n_nodes nodes, started from a perturbed grid
+struct SpringGrid {
+    SpringGrid(const long _n_nodes, const int _spring_element_type)
+            : n_grid(std::max(1, (int)std::lround(std::sqrt((double)_n_nodes)) - 1)),
+              mss(n_grid, n_grid, _spring_element_type) {
+        mss.add_constrained_spring_elements();
+        problem = mss.get_problem();
+        // the generator is not seeded, the start is the same for every run
+        RandomNumberGenerator rng(-0.1, 0.1);
+        x = mss.get_spring_graph_points() + rng.get_random_nd_vector(problem->n_unknowns());
+    }
+
+    void set_counters(Benchmark::State& _state) const {
+        _state.set_counter("nodes", (n_grid + 1) * (n_grid + 1));
+        _state.set_counter("unknowns", problem->n_unknowns());
+    }
+
+    int n_grid;
+    MassSpringSystemT<MassSpringProblem2DSparse> mss;
+    std::shared_ptr<MassSpringProblem2DSparse> problem;
+    Vec x;
+};
+
+
+// evaluations of a single spring element, 1000 per iteration
+template <class Element>
+static void element_kernels(Benchmark& _bench, const std::string& _name) {
+    const int n_calls = 1000;
+
+    _bench.add("element/" + _name + "/eval_f", [](Benchmark::State& _state) {
+        Element element;
+        Vec x(4), coeffs(2);
+        x << 0., 0., 1.1, 0.3;
+        coeffs << 1., 1.;
+        double sum = 0.;
+        while(_state.keep_running())
+            for(int i = 0; i < n_calls; ++i) {
+                x[0] = 1e-6 * i;
+                sum += element.eval_f(x, coeffs);
+            }
+        _state.set_counter("calls_per_iteration", n_calls);
+        _state.set_counter("checksum", sum);
+    });
+
+    _bench.add("element/" + _name + "/eval_gradient", [](Benchmark::State& _state) {
+        Element element;
+        Vec x(4), coeffs(2), g(4);
+        x << 0., 0., 1.1, 0.3;
+        coeffs << 1., 1.;
+        double sum = 0.;
+        while(_state.keep_running())
+            for(int i = 0; i < n_calls; ++i) {
+                x[0] = 1e-6 * i;
+                element.eval_gradient(x, coeffs, g);
+                sum += g[0];
+            }
+        _state.set_counter("calls_per_iteration", n_calls);
+        _state.set_counter("checksum", sum);
+    });
+
+    _bench.add("element/" + _name + "/eval_hessian", [](Benchmark::State& _state) {
+        Element element;
+        Vec x(4), coeffs(2);
+        FunctionBase::Mat H(4, 4);
+        x << 0., 0., 1.1, 0.3;
+        coeffs << 1., 1.;
+        double sum = 0.;
+        while(_state.keep_running())
+            for(int i = 0; i < n_calls; ++i) {
+                x[0] = 1e-6 * i;
+                element.eval_hessian(x, coeffs, H);
+                sum += H(0, 0);
+            }
+        _state.set_counter("calls_per_iteration", n_calls);
+        _state.set_counter("checksum", sum);
+    });
+}
+
+
+// evaluation of a whole problem
+static void assembly(Benchmark& _bench) {
+    _bench.add("assembly/eval_f", [](Benchmark::State& _state) {
+        SpringGrid grid(_state.size(), 1);
+        double f = 0.;
+        while(_state.keep_running())
+            f = grid.problem->eval_f(grid.x);
+        grid.set_counters(_state);
+        _state.set_counter("f", f);
+    }, node_counts);
+
+    _bench.add("assembly/eval_gradient", [](Benchmark::State& _state) {
+        SpringGrid grid(_state.size(), 1);
+        Vec g(grid.problem->n_unknowns());
+        while(_state.keep_running())
+            grid.problem->eval_gradient(grid.x, g);
+        grid.set_counters(_state);
+        _state.set_counter("gradient_norm", g.norm());
+    }, node_counts);
+
+    _bench.add("assembly/eval_hessian", [](Benchmark::State& _state) {
+        SpringGrid grid(_state.size(), 1);
+        SMat H;
+        while(_state.keep_running())
+            grid.problem->eval_hessian(grid.x, H);
+        grid.set_counters(_state);
+        _state.set_counter("nnz", H.nonZeros());
+    }, node_counts);
+}
+
+
+// factorizations of the positive semi-definite Hessian of the springs with length
+static void factorization(Benchmark& _bench) {
+    _bench.add("factorization/SimplicialLLT", [](Benchmark::State& _state) {
+        SpringGrid grid(_state.size(), 2);
+        SMat H;
+        grid.problem->eval_hessian(grid.x, H);
+        Eigen::SimplicialLLT<SMat> solver;
+        while(_state.keep_running())
+            solver.compute(H);
+        grid.set_counters(_state);
+        _state.set_counter("nnz", H.nonZeros());
+        _state.set_counter("success", solver.info() == Eigen::Success);
+    }, factorized_node_counts);
+
+    // the numeric factorization only, as in the iterations of Newton's method
+    _bench.add("factorization/RefactorizableLLT", [](Benchmark::State& _state) {
+        SpringGrid grid(_state.size(), 2);
+        SMat H;
+        grid.problem->eval_hessian(grid.x, H);
+        RefactorizableLLT<SMat> solver;
+        solver.compute(H);
+        while(_state.keep_running())
+            solver.compute(H);
+        grid.set_counters(_state);
+        _state.set_counter("nnz", H.nonZeros());
+        _state.set_counter("success", solver.info() == Eigen::Success);
+    }, factorized_node_counts);
+
+    _bench.add("factorization/SparseLU", [](Benchmark::State& _state) {
+        SpringGrid grid(_state.size(), 2);
+        SMat H;
+        grid.problem->eval_hessian(grid.x, H);
+        // SparseLU needs both triangles
+        SMat A = H.selfadjointView<Eigen::Lower>();
+        Eigen::SparseLU<SMat> solver;
+        while(_state.keep_running())
+            solver.compute(A);
+        grid.set_counters(_state);
+        _state.set_counter("nnz", A.nonZeros());
+        _state.set_counter("success", solver.info() == Eigen::Success);
+    }, factorized_node_counts);
+}
+
+
+// the solvers for a fixed number of iterations, the final objective tells whether
+// a change also changed the iterates
+static void solvers(Benchmark& _bench) {
+    _bench.add("solver/GradientDescent", [](Benchmark::State& _state) {
+        SpringGrid grid(_state.size(), 1);
+        Vec x;
+        while(_state.keep_running())
+            x = GradientDescent::solve(grid.problem.get(), grid.x, 1e-4, 20);
+        grid.set_counters(_state);
+        _state.set_counter("max_iters", 20);
+        _state.set_counter("f", grid.problem->eval_f(x));
+    }, node_counts);
+
+    _bench.add("solver/LBFGS", [](Benchmark::State& _state) {
+        SpringGrid grid(_state.size(), 1);
+        Vec x;
+        while(_state.keep_running()) {
+            LBFGS lbfgs(10);
+            x = lbfgs.solve(grid.problem.get(), grid.x, 1e-4, 20);
+        }
+        grid.set_counters(_state);
+        _state.set_counter("max_iters", 20);
+        _state.set_counter("f", grid.problem->eval_f(x));
+    }, node_counts);
+
+    _bench.add("solver/Newton", [](Benchmark::State& _state) {
+        SpringGrid grid(_state.size(), 2);
+        Vec x;
+        while(_state.keep_running())
+            x = NewtonMethods::solve(grid.problem.get(), grid.x, 1e-4, 5);
+        grid.set_counters(_state);
+        _state.set_counter("max_iters", 5);
+        _state.set_counter("f", grid.problem->eval_f(x));
+    }, factorized_node_counts);
+
+    _bench.add("solver/ProjectedNewton", [](Benchmark::State& _state) {
+        SpringGrid grid(_state.size(), 1);
+        Vec x;
+        while(_state.keep_running())
+            x = NewtonMethods::solve_with_projected_hessian(grid.problem.get(), grid.x, 10., 1e-4, 5);
+        grid.set_counters(_state);
+        _state.set_counter("max_iters", 5);
+        _state.set_counter("f", grid.problem->eval_f(x));
+    }, factorized_node_counts);
+}
+
+
+// the sampling algorithms, the size is the number of grid cells per dimension
+static void sampling(Benchmark& _bench) {
+    _bench.add("grid_search/2d", [](Benchmark::State& _state) {
+        FunctionQuadratic2D func(1.);
+        Vec x_l(2), x_u(2);
+        x_l << -10., -10.;
+        x_u << 10., 10.;
+        GridSearch gs((int)_state.size());
+        double f_min = 0.;
+        while(_state.keep_running())
+            gs.grid_search_2d(&func, x_l, x_u, f_min);
+        _state.set_counter("evaluations", std::pow(_state.size() + 1., 2));
+        _state.set_counter("f_min", f_min);
+    }, {100, 1000});
+
+    _bench.add("grid_search/nd", [](Benchmark::State& _state) {
+        FunctionQuadraticND func(3);
+        Vec x_l = Vec::Constant(3, -10.), x_u = Vec::Constant(3, 10.);
+        GridSearch gs((int)_state.size());
+        double f_min = 0.;
+        while(_state.keep_running())
+            gs.grid_search_nd(&func, x_l, x_u, f_min);
+        _state.set_counter("evaluations", std::pow(_state.size() + 1., 3));
+        _state.set_counter("f_min", f_min);
+    }, {10, 100});
+
+    // 10^6 sampled pairs, the size is the number of points checked between two of them
+    _bench.add("convexity_test/quadratic_2d", [](Benchmark::State& _state) {
+        FunctionQuadratic2D func(1.);
+        bool convex = false;
+        while(_state.keep_running())
+            convex = ConvexityTest::isConvex(&func, -10., 10., (int)_state.size());
+        _state.set_counter("convex", convex);
+    }, {2, 10});
+}
+
+
+int main(int _argc, const char* _argv[]) {
+    Benchmark bench;
+    element_kernels<SpringElement2D>(bench, "SpringElement2D");
+    element_kernels<SpringElement2DWithLength>(bench, "SpringElement2DWithLength");
+    element_kernels<SpringElement2DWithLengthPSDHess>(bench, "SpringElement2DWithLengthPSDHess");
+    assembly(bench);
+    factorization(bench);
+    solvers(bench);
+    sampling(bench);
+
+    return bench.run(_argc, _argv);
+}
@@ -17,11 +17,18 @@ void testQuadraticND(int n) {
     AOPT::ConvexityTest::isConvex(&function);
 }
 
+void testQuadraticNDSecondOrder(int n) {
+    AOPT::FunctionQuadraticND function(n);
+    std::cout << "Checking the convexity of a "<<n<<"-D function with its hessian ..." << std::endl;
+    AOPT::ConvexityTest::isConvexSecondOrder(&function);
+}
+
 int main(int argc, const char* argv[] ) {
     if (argc < 2) {
         std::cout << "usage:\n" << argv[0] << " option [dimension=3]\n"
                   << "1. test Nonconvex 2d function\n"
-                  << "2. test QuadraticND function\n";
+                  << "2. test QuadraticND function\n"
+                  << "3. test QuadraticND function with its hessian\n";
 
         return -1;
     }
@@ -35,6 +42,9 @@ int main(int argc, const char* argv[] ) {
         case 2:
             testQuadraticND(n);
             break;
+        case 3:
+            testQuadraticNDSecondOrder(n);
+            break;
         default:
             std::cout << "option " << opt << " not handled by any case" << std::endl;
     }
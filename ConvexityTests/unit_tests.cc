@@ -1,9 +1,15 @@
 #include <iostream>
+#include <set>
+#include <thread>
 #include <Utils/StopWatch.hh>
 #include <Algorithms/ConvexityTest.hh>
 #include <Functions/FunctionQuadratic2D.hh>
 #include <Functions/FunctionQuadraticND.hh>
 #include <Functions/FunctionNonConvex2D.hh>
+#include <Functions/MassSpringProblem2DSparse.hh>
+#include <Functions/SpringElement2D.hh>
+#include <Functions/SpringElement2DWithLength.hh>
+#include <Utils/LanczosEigenSolver.hh>
 
 #include "gtest/gtest.h"
 
@@ -105,6 +111,227 @@ TEST(ConvexityTest, NonConvex2DIsNonConvexOnYetAnotherInterval){
 }
 
 
+TEST(ConvexityTest, HaltonSamplingDetectsNonConvexity){
+
+    AOPT::FunctionNonConvex2D function;
+
+    const double min(-10), max(10);
+    const int n_evals(10);
+    ASSERT_FALSE(AOPT::ConvexityTest::isConvex(&function, min, max, n_evals, AOPT::ConvexityTest::HALTON));
+
+    AOPT::FunctionQuadraticND quadratic(6);
+    ASSERT_TRUE(AOPT::ConvexityTest::isConvex(&quadratic, min, max, n_evals, AOPT::ConvexityTest::HALTON));
+}
+
+
+TEST(ConvexityTest, ViolationDoesNotDependOnThreads){
+
+    AOPT::FunctionNonConvex2D function;
+
+    const double min(-10), max(10);
+    const int n_evals(10);
+    for (auto sampling : {AOPT::ConvexityTest::RANDOM, AOPT::ConvexityTest::HALTON}) {
+        AOPT::ConvexityTest::Violation serial, parallel;
+        ASSERT_FALSE(AOPT::ConvexityTest::isConvex(&function, min, max, n_evals, sampling, 1, 7, &serial));
+        ASSERT_FALSE(AOPT::ConvexityTest::isConvex(&function, min, max, n_evals, sampling, 4, 7, &parallel));
+
+        EXPECT_EQ(serial.pair, parallel.pair);
+        EXPECT_EQ(serial.t, parallel.t);
+        EXPECT_EQ(serial.p1, parallel.p1);
+        EXPECT_EQ(serial.p2, parallel.p2);
+
+        // the reported path does violate the property
+        const double t = serial.t;
+        AOPT::FunctionBase::Vec p = (1. - t) * serial.p1 + t * serial.p2;
+        EXPECT_GT(function.eval_f(p), (1. - t) * function.eval_f(serial.p1) + t * function.eval_f(serial.p2));
+    }
+}
+
+
+/** a quadratic that records the threads evaluating it, without opting in to
+ * concurrent evaluations */
+class ThreadRecordingFunction final : public AOPT::FunctionBase {
+public:
+    ThreadRecordingFunction(const int _n) : func_(_n) {}
+
+    inline virtual int n_unknowns() { return func_.n_unknowns(); }
+
+    inline virtual double eval_f(const Vec &_x) {
+        threads_.insert(std::this_thread::get_id());
+        return func_.eval_f(_x);
+    }
+
+    inline virtual void eval_gradient(const Vec &_x, Vec &_g) { func_.eval_gradient(_x, _g); }
+
+    inline virtual void eval_hessian(const Vec &_x, Mat &_H) {
+        threads_.insert(std::this_thread::get_id());
+        func_.eval_hessian(_x, _H);
+    }
+
+    std::set<std::thread::id> threads_;
+
+private:
+    AOPT::FunctionQuadraticND func_;
+};
+
+
+TEST(ConvexityTest, NotThreadSafeFunctionUsesOneThread){
+
+    ThreadRecordingFunction function(5);
+    ASSERT_TRUE(AOPT::ConvexityTest::isConvex(&function, -10, 10, 10, AOPT::ConvexityTest::RANDOM, 4));
+    EXPECT_EQ(function.threads_.size(), 1u);
+
+    function.threads_.clear();
+    AOPT::ConvexityTest::isConvexSecondOrder(&function, -10, 10, 1000, AOPT::ConvexityTest::RANDOM, 4);
+    EXPECT_EQ(function.threads_.size(), 1u);
+}
+
+
+TEST(ConvexityTest, CounterRandomNumbersAreReproducible){
+
+    AOPT::CounterRandomNumberGenerator rng(-2., 3., 42);
+    AOPT::FunctionBase::Vec v(1000), w(1000);
+    rng.get_random_nd_vector(5, v);
+    rng.get_random_nd_vector(5, w);
+    EXPECT_EQ(v, w);
+
+    // another stream is different
+    rng.get_random_nd_vector(6, w);
+    EXPECT_NE(v, w);
+
+    EXPECT_GE(v.minCoeff(), -2.);
+    EXPECT_LT(v.maxCoeff(), 3.);
+    EXPECT_NEAR(v.mean(), 0.5, 0.2);
+}
+
+
+TEST(ConvexityTest, LanczosSmallestEigenvalue){
+
+    const int n(60);
+    AOPT::CounterRandomNumberGenerator rng(-1., 1., 3);
+    AOPT::FunctionBase::Mat A(n, n);
+    for (int j = 0; j < n; ++j)
+        for (int i = 0; i <= j; ++i)
+            A(i, j) = A(j, i) = rng.get(j, i);
+
+    Eigen::SelfAdjointEigenSolver<AOPT::FunctionBase::Mat> solver(A);
+
+    AOPT::LanczosEigenSolver lanczos;
+    AOPT::FunctionBase::Vec v;
+    const double lambda = lanczos.smallest_eigenvalue([&](const AOPT::FunctionBase::Vec& _v, AOPT::FunctionBase::Vec& _w) {
+        _w = A * _v;
+    }, n, v);
+
+    EXPECT_NEAR(lambda, solver.eigenvalues()[0], 1e-8);
+    EXPECT_NEAR(v.norm(), 1., 1e-12);
+    EXPECT_LT((A * v - lambda * v).norm(), 1e-6);
+}
+
+
+TEST(ConvexityTest, NonConvex2DDerivatives){
+
+    AOPT::FunctionNonConvex2D function;
+
+    // central differences of f and of the gradient
+    AOPT::RandomNumberGenerator rng(0., 1.);
+    AOPT::FunctionBase::Vec x(2), g(2), g_p(2), g_m(2), e(2);
+    AOPT::FunctionBase::Mat H(2, 2);
+    const double h(1e-6);
+    for (int i = 0; i < 100; ++i) {
+        x = 4. * rng.get_random_nd_vector(2) - AOPT::FunctionBase::Vec::Constant(2, 2.);
+        function.eval_gradient(x, g);
+        function.eval_hessian(x, H);
+        for (int j = 0; j < 2; ++j) {
+            e = h * AOPT::FunctionBase::Vec::Unit(2, j);
+            EXPECT_NEAR(g[j], (function.eval_f(x + e) - function.eval_f(x - e)) / (2 * h), 1e-5 * (1 + std::abs(g[j])));
+            function.eval_gradient(x + e, g_p);
+            function.eval_gradient(x - e, g_m);
+            for (int k = 0; k < 2; ++k)
+                EXPECT_NEAR(H(k, j), (g_p[k] - g_m[k]) / (2 * h), 1e-5 * (1 + std::abs(H(k, j))));
+        }
+    }
+
+    // the interval bounds contain the hessian of every point of the box
+    AOPT::FunctionBase::Vec x_l(2), x_u(2);
+    x_l << -0.5, 0.2;
+    x_u << 0.3, 0.9;
+    AOPT::FunctionBase::Mat H_l, H_u;
+    ASSERT_TRUE(function.eval_hessian_bounds(x_l, x_u, H_l, H_u));
+
+    for (int i = 0; i < 1000; ++i) {
+        x = x_l + (x_u - x_l).cwiseProduct(rng.get_random_nd_vector(2));
+        function.eval_hessian(x, H);
+        EXPECT_TRUE((H.array() >= H_l.array()).all() && (H.array() <= H_u.array()).all());
+    }
+}
+
+
+TEST(ConvexityTest, SecondOrderQuadraticND){
+
+    const int n(8);
+    AOPT::FunctionQuadraticND convex(n);
+    ASSERT_TRUE(AOPT::ConvexityTest::isConvexSecondOrder(&convex, -20, 20));
+
+    AOPT::FunctionQuadraticND non_convex(n, false);
+    AOPT::ConvexityTest::CurvatureViolation violation;
+    ASSERT_FALSE(AOPT::ConvexityTest::isConvexSecondOrder(&non_convex, -20, 20, 10000, AOPT::ConvexityTest::RANDOM,
+                                                          0, 0, &violation));
+
+    // the direction is one of negative curvature
+    AOPT::FunctionBase::Mat A(n, n);
+    non_convex.eval_hessian(violation.x, A);
+    EXPECT_NEAR(violation.d.dot(A * violation.d), violation.lambda, 1e-8);
+    EXPECT_LT(violation.lambda, 0.);
+}
+
+
+TEST(ConvexityTest, SecondOrderNonConvex2D){
+
+    AOPT::FunctionNonConvex2D function;
+
+    // the interval considered convex by NonConvex2DIsConvexOnCertainInterval is proven so
+    AOPT::FunctionBase::Vec x_l = AOPT::FunctionBase::Vec::Constant(2, 1.0);
+    AOPT::FunctionBase::Vec x_u = AOPT::FunctionBase::Vec::Constant(2, 1.001);
+    EXPECT_EQ(AOPT::ConvexityTest::certifyConvexity(&function, x_l, x_u), AOPT::ConvexityTest::CONVEX);
+    EXPECT_TRUE(AOPT::ConvexityTest::isConvexSecondOrder(&function, 1.0, 1.001));
+
+    for (auto sampling : {AOPT::ConvexityTest::RANDOM, AOPT::ConvexityTest::HALTON}) {
+        AOPT::ConvexityTest::CurvatureViolation serial, parallel;
+        ASSERT_FALSE(AOPT::ConvexityTest::isConvexSecondOrder(&function, -10, 10, 10000, sampling, 1, 0, &serial));
+        ASSERT_FALSE(AOPT::ConvexityTest::isConvexSecondOrder(&function, -10, 10, 10000, sampling, 4, 0, &parallel));
+        EXPECT_EQ(serial.sample, parallel.sample);
+        EXPECT_EQ(serial.x, parallel.x);
+
+        AOPT::FunctionBase::Mat H(2, 2);
+        function.eval_hessian(serial.x, H);
+        EXPECT_LT(serial.d.dot(H * serial.d), 0.);
+    }
+}
+
+
+TEST(ConvexityTest, SecondOrderMassSpring){
+
+    // a chain of 10 nodes
+    const int n_nodes(10);
+    AOPT::SpringElement2D spring;
+    AOPT::SpringElement2DWithLength spring_with_length;
+    AOPT::MassSpringProblem2DSparse convex(spring, 2 * n_nodes), non_convex(spring_with_length, 2 * n_nodes);
+    for (int i = 0; i + 1 < n_nodes; ++i) {
+        convex.add_spring_element(i, i + 1, 1., 1.);
+        non_convex.add_spring_element(i, i + 1, 1., 1.);
+    }
+
+    EXPECT_TRUE(AOPT::ConvexityTest::isConvexSecondOrder(&convex, -10, 10));
+
+    AOPT::ConvexityTest::CurvatureViolation violation;
+    ASSERT_FALSE(AOPT::ConvexityTest::isConvexSecondOrder(&non_convex, -1, 1, 100, 0, &violation));
+    AOPT::FunctionBaseSparse::SMat H(2 * n_nodes, 2 * n_nodes);
+    non_convex.eval_hessian(violation.x, H);
+    EXPECT_NEAR(violation.d.dot(H * violation.d), violation.lambda, 1e-8);
+    EXPECT_LT(violation.lambda, 0.);
+}
+
+
 int main(int _argc, char** _argv){
 
     testing::InitGoogleTest(&_argc, _argv);
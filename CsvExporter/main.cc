@@ -1,4 +1,4 @@
-#include <Utils/CSVExporter.hh>
+#include <Utils/FieldExporter.hh>
 #include <Functions/FunctionNonConvex2D.hh>
 #include <Functions/FunctionQuadratic2D.hh>
 
@@ -7,7 +7,7 @@ int main(int _argc, const char* _argv[]) {
     if (_argc != 9) {
         std::cout
                 << "Usage: input should be 'output filename, function index(0: non-convex, 1: 2d quadratic), lower bound x, lower bound y, upper bound x, upper bound y, grid number in x, grid number in y.', e.g. "
-                   "./CsvExporter /home/func0.csv 0 -10 -10 10 10 20 20" << std::endl;
+                   "./CsvExporter /home/func0.csv 0 -10 -10 10 10 20 20 (or func0.npy for a binary numpy file)" << std::endl;
         return -1;
     }
 
@@ -27,10 +27,9 @@ int main(int _argc, const char* _argv[]) {
 
     std::string filename(_argv[1]);
 
-    //export data
-    AOPT::CSVExporter csvexp;
-    AOPT::CSVExporter::Mat mt(n_grid_x + 1, n_grid_y + 1);
-    AOPT::CSVExporter::Vec vec_x(n_grid_x + 1), vec_y(n_grid_y + 1);
+    //export data, as .npy if the file name ends with .npy
+    AOPT::FieldExporter exporter;
+    AOPT::FieldExporter::Vec vec_x(n_grid_x + 1), vec_y(n_grid_y + 1);
 
     if (func_index == 0 || func_index == 1) {
         for (int i = 0; i <= n_grid_x; ++i)
@@ -40,29 +39,12 @@ int main(int _argc, const char* _argv[]) {
 
         AOPT::FunctionNonConvex2D fnc2d;
         AOPT::FunctionQuadratic2D fq2d(-1.);
-        AOPT::FunctionQuadratic2D::Vec x(2);
-        if (func_index == 0) {
-            for (int i = 0; i <= n_grid_x; ++i)
-                for (int j = 0; j <= n_grid_y; ++j) {
-                    x[0] = vec_x[i];
-                    x[1] = vec_y[j];
-                    mt(i, j) = fnc2d.eval_f(x);
-                }
-        } else {
-            for (int i = 0; i <= n_grid_x; ++i)
-                for (int j = 0; j <= n_grid_y; ++j) {
-                    x[0] = vec_x[i];
-                    x[1] = vec_y[j];
-                    mt(i, j) = fq2d.eval_f(x);
-                }
-        }
+        AOPT::FunctionBase* func = func_index == 0 ? (AOPT::FunctionBase*)&fnc2d : &fq2d;
+
+        //sample and write the field by tiles of rows
+        return exporter.export_function2d(func, vec_x, vec_y, filename, AOPT::FieldExporter::format_of(filename));
     } else {
         std::cout << "Error: Function index is from 0 to 1." << std::endl;
         return -1;
     }
-
-
-    csvexp.export_function2d(mt, vec_x, vec_y, filename);
-
-    return 0;
 }
@@ -0,0 +1,160 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cmath>
+#include <limits>
+#include <Utils/FieldExporter.hh>
+#include <Utils/CSVExporter.hh>
+#include <Utils/RandomNumberGenerator.hh>
+#include <Functions/FunctionNonConvex2D.hh>
+#include <Functions/FunctionQuadratic2D.hh>
+
+#include "gtest/gtest.h"
+
+
+using namespace AOPT;
+
+namespace {
+
+    std::string read_file(const std::string& _filename) {
+        std::ifstream file(_filename, std::ios::binary);
+        std::stringstream ss;
+        ss << file.rdbuf();
+        return ss.str();
+    }
+
+    // the grid of the tests, with a number of rows that is not a multiple of the tiles
+    void setup_grid(FieldExporter::Vec& _x, FieldExporter::Vec& _y) {
+        _x = FieldExporter::Vec::LinSpaced(37, -2., 2.);
+        _y = FieldExporter::Vec::LinSpaced(23, -1.5, 3.);
+    }
+
+}
+
+
+TEST(FieldExporter, WriteDoubleRoundTrips){
+    std::vector<double> values{0., -0., 1., -1., 0.1, 1. / 3., 1e-310, 5e-324, 1e300, -2.5e-8,
+                               std::numeric_limits<double>::max(), std::numeric_limits<double>::min()};
+    RandomNumberGenerator rng(-300., 300.);
+    for (int i = 0; i < 10000; ++i) {
+        const FunctionBase::Vec v = rng.get_random_nd_vector(2);
+        values.push_back(v[0] * std::pow(10., v[1]));
+    }
+
+    char buf[FieldExporter::max_chars + 1];
+    for (double v : values) {
+        char* end = FieldExporter::write_double(buf, v);
+        ASSERT_LE(end - buf, FieldExporter::max_chars);
+        *end = '\0';
+        ASSERT_EQ(std::strtod(buf, nullptr), v) << buf;
+    }
+
+    // shortest representation
+    *FieldExporter::write_double(buf, 0.1) = '\0';
+    EXPECT_STREQ(buf, "0.1");
+}
+
+
+TEST(FieldExporter, CsvMatchesFunction){
+    FieldExporter::Vec x, y;
+    setup_grid(x, y);
+    FunctionNonConvex2D func;
+    const std::string filename = testing::TempDir() + "field.csv";
+    ASSERT_EQ(FieldExporter().export_function2d(&func, x, y, filename), 0);
+
+    std::ifstream file(filename);
+    std::string line, cell;
+
+    // first line: the x coordinates
+    std::getline(file, line);
+    std::stringstream header(line);
+    std::getline(header, cell, ',');
+    EXPECT_EQ(cell, "");
+    for (int i = 0; i < x.size(); ++i) {
+        ASSERT_TRUE(std::getline(header, cell, ','));
+        EXPECT_EQ(std::stod(cell), x[i]);
+    }
+
+    FunctionBase::Vec p(2);
+    for (int j = 0; j < y.size(); ++j) {
+        ASSERT_TRUE(std::getline(file, line));
+        std::stringstream row(line);
+        std::getline(row, cell, ',');
+        EXPECT_EQ(std::stod(cell), y[j]);
+        for (int i = 0; i < x.size(); ++i) {
+            ASSERT_TRUE(std::getline(row, cell, ','));
+            p << x[i], y[j];
+            EXPECT_NEAR(std::stod(cell), func.eval_f(p), 1e-12 * (1 + std::abs(func.eval_f(p))));
+        }
+        EXPECT_FALSE(std::getline(row, cell, ','));
+    }
+    EXPECT_FALSE(std::getline(file, line));
+}
+
+
+TEST(FieldExporter, NpyMatchesCsv){
+    FieldExporter::Vec x, y;
+    setup_grid(x, y);
+    FunctionQuadratic2D func(-1.);
+    const std::string filename = testing::TempDir() + "field.npy";
+    ASSERT_EQ(FieldExporter::format_of(filename), FieldExporter::NPY);
+    ASSERT_EQ(FieldExporter().export_function2d(&func, x, y, filename, FieldExporter::NPY), 0);
+
+    const std::string data = read_file(filename);
+    ASSERT_GT(data.size(), 10u);
+    EXPECT_EQ(data.substr(0, 6), "\x93NUMPY");
+    EXPECT_EQ(data[6], 1);
+    EXPECT_EQ(data[7], 0);
+    const std::size_t header_len = (unsigned char)data[8] + 256 * (unsigned char)data[9];
+    EXPECT_EQ((10 + header_len) % 64, 0u);
+    const std::string header = data.substr(10, header_len);
+    EXPECT_NE(header.find("'descr': '<f8'"), std::string::npos);
+    EXPECT_NE(header.find("'fortran_order': False"), std::string::npos);
+    EXPECT_NE(header.find("'shape': (23, 37)"), std::string::npos);
+    EXPECT_EQ(header.back(), '\n');
+
+    ASSERT_EQ(data.size(), 10 + header_len + x.size() * y.size() * sizeof(double));
+    FunctionBase::Vec p(2);
+    for (int j = 0; j < y.size(); ++j)
+        for (int i = 0; i < x.size(); ++i) {
+            double v;
+            std::memcpy(&v, data.data() + 10 + header_len + (j * x.size() + i) * sizeof(double), sizeof(double));
+            p << x[i], y[j];
+            EXPECT_EQ(v, func.eval_f(p));
+        }
+}
+
+
+TEST(FieldExporter, OutputDoesNotDependOnThreadsAndTiles){
+    FieldExporter::Vec x, y;
+    setup_grid(x, y);
+    FunctionNonConvex2D func;
+    const std::string dir = testing::TempDir();
+    for (auto format : {FieldExporter::CSV, FieldExporter::NPY}) {
+        ASSERT_EQ(FieldExporter(1, 1).export_function2d(&func, x, y, dir + "serial", format), 0);
+        ASSERT_EQ(FieldExporter(4, 5).export_function2d(&func, x, y, dir + "parallel", format), 0);
+        EXPECT_EQ(read_file(dir + "serial"), read_file(dir + "parallel"));
+    }
+}
+
+
+TEST(FieldExporter, SameAsCSVExporter){
+    FieldExporter::Vec x, y;
+    setup_grid(x, y);
+    FunctionNonConvex2D func;
+
+    CSVExporter::Mat mt(x.size(), y.size());
+    FunctionBase::Vec f;
+    FunctionBase::Mat X(2, y.size());
+    X.row(1) = y.transpose();
+    for (int i = 0; i < x.size(); ++i) {
+        X.row(0).setConstant(x[i]);
+        func.eval_f_batch(X, f);
+        mt.row(i) = f.transpose();
+    }
+
+    const std::string dir = testing::TempDir();
+    CSVExporter().export_function2d(mt, x, y, dir + "matrix.csv");
+    ASSERT_EQ(FieldExporter().export_function2d(&func, x, y, dir + "function.csv"), 0);
+    EXPECT_EQ(read_file(dir + "matrix.csv"), read_file(dir + "function.csv"));
+}
@@ -3,6 +3,7 @@
 #include <Utils/StopWatch.hh>
 #include <Utils/RandomNumberGenerator.hh>
 #include <Utils/OptimizationStatistic.hh>
+#include <Utils/Profiler.hh>
 
 #include <Functions/FunctionQuadratic2D.hh>
 #include <Functions/FunctionQuadraticND.hh>
@@ -123,6 +124,33 @@ TEST(MassSpringSystemWithEqualityConstraints, CheckMinimum){
 
 
 
+/** The KKT matrix of the equality constrained Newton method and its LU factors are recorded */
+TEST(MassSpringSystemWithEqualityConstraints, MemoryFootprint){
+    AOPT::MassSpringSystemT<AOPT::MassSpringProblem2DSparse> mss(5, 7, 0);
+    SMat A;
+    Vec b;
+    mss.setup_linear_equality_constraints(A, b);
+    const int n = mss.get_problem()->n_unknowns();
+
+    Vec start_pts(n);
+    for(int i(0); i<start_pts.size();i++)
+        start_pts[i] = i;
+
+    AOPT::Profiler& profiler = AOPT::Profiler::instance();
+    profiler.start();
+    AOPT::NewtonMethods::solve_equality_constrained(mss.get_problem().get(), start_pts, A, b, 1e-7, 2);
+    profiler.stop();
+
+    const std::string solve = "NewtonMethods::solve_equality_constrained";
+    SMat H;
+    mss.get_problem()->eval_hessian(start_pts, H);
+    EXPECT_EQ(profiler.value(solve + "/kkt_assembly", "kkt_rows"), n + A.rows());
+    EXPECT_EQ(profiler.memory(solve + "/kkt_assembly", "kkt").nnz, H.nonZeros() + 2 * A.nonZeros());
+    EXPECT_EQ(profiler.memory(solve + "/kkt_assembly", "kkt_triplets").nnz, H.nonZeros() + 2 * A.nonZeros());
+    EXPECT_GT(profiler.memory(solve + "/factorization", "factor").nnz, 0);
+    EXPECT_GT(profiler.value(solve + "/factorization", "factor_fill"), 1.);
+}
+
 
 int main(int _argc, char** _argv){
 
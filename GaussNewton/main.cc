@@ -1,14 +1,18 @@
 #include <Utils/StopWatch.hh>
 #include <iostream>
 #include <Algorithms/NewtonMethods.hh>
+#include <Algorithms/LevenbergMarquardt.hh>
+#include <Algorithms/MatrixFreeGaussNewton.hh>
 #include <Functions/MassSpringProblem2DLeastSquare.hh>
 #include <Utils/OptimizationStatistic.hh>
 #include <MassSpringSystemT.hh>
 
 int main(int _argc, const char* _argv[]) {
-    if(_argc != 6) {
-        std::cout << "Usage: input should be 'function index(0: f without length, 1: f with length), number of grid in x, number of grid in y, max iteration, filename', e.g. "
-                     "./GaussNewton 1 20 20 10000 /usr/spring" << std::endl;
+    if(_argc != 6 && _argc != 7) {
+        std::cout << "Usage: input should be 'function index(0: f without length, 1: f with length), number of grid in x, number of grid in y, max iteration, filename, "
+                     "[solver(0: Newton, 1: Levenberg-Marquardt, 2: Levenberg-Marquardt with geodesic acceleration, "
+                     "3: matrix-free Gauss-Newton with LSQR, 4: matrix-free Gauss-Newton with CGLS)]', e.g. "
+                     "./GaussNewton 1 20 20 10000 /usr/spring 1" << std::endl;
         return -1;
     }
 
@@ -20,6 +24,7 @@ int main(int _argc, const char* _argv[]) {
     max_iter = atoi(_argv[4]);
 
     std::string filename(_argv[5]);
+    int solver = _argc == 7 ? atoi(_argv[6]) : 0;
 
     //construct mass spring system
     AOPT::MassSpringSystemT<AOPT::MassSpringProblem2DLeastSquare> mss(n_grid_x, n_grid_y, func_index, true);
@@ -45,8 +50,20 @@ int main(int _argc, const char* _argv[]) {
 
     filename += "_opt";
 
-    AOPT::NewtonMethods::Vec x = AOPT::NewtonMethods::solve(opt_st.get(), start_pts, 1e-4, max_iter);
-    opt_st->print_statistics();
+    AOPT::NewtonMethods::Vec x;
+    if(solver == 0) {
+        x = AOPT::NewtonMethods::solve(opt_st.get(), start_pts, 1e-4, max_iter);
+        opt_st->print_statistics();
+    } else if(solver >= 3) {
+        //J is never assembled, only products with J and J^T are evaluated
+        auto linear_solver = solver == 3 ? AOPT::MatrixFreeGaussNewton::LSQR : AOPT::MatrixFreeGaussNewton::CGLS;
+        x = AOPT::MatrixFreeGaussNewton::solve(mss.get_problem().get(), start_pts, 1e-4, max_iter, linear_solver);
+    } else {
+        //the least squares interface is not forwarded by OptimizationStatistic,
+        //the solver counts its own evaluations
+        AOPT::LevenbergMarquardt lm(solver == 2);
+        x = lm.solve(mss.get_problem().get(), start_pts, 1e-4, max_iter);
+    }
 
     mss.set_spring_graph_points(x);
     std::cout<<"Saving optimized spring graph to "<<filename<<"_*.csv"<<std::endl;
@@ -9,11 +9,14 @@
 #include <Functions/ConstrainedSpringElement2DLeastSquare.hh>
 #include <Functions/MassSpringProblem2DLeastSquare.hh>
 #include <Functions/MassSpringProblem2DSparse.hh>
+#include <Functions/MassSpringResidualProblem.hh>
 #include <Functions/SpringElement2DLeastSquare.hh>
 #include <Functions/SpringElement2DWithLengthLeastSquare.hh>
 #include <Functions/ConstrainedSpringElement2DLeastSquare.hh>
 
 #include <Algorithms/NewtonMethods.hh>
+#include <Algorithms/LevenbergMarquardt.hh>
+#include <Algorithms/MatrixFreeGaussNewton.hh>
 
 #include <MassSpringSystemT.hh>
 
@@ -260,6 +263,191 @@ TEST(MassSpringProblemWithLengthLeastSquares, convergesToSolution){
 }
 
 
+TEST(MassSpringProblem2DLeastSquare, FusedResidualAndJacobian){
+
+    for(int spring_type(0); spring_type < 2; ++spring_type) {
+        AOPT::MassSpringSystemT<AOPT::MassSpringProblem2DLeastSquare> mss(4, 5, spring_type, true);
+        mss.add_constrained_spring_elements();
+        auto problem = mss.get_problem();
+
+        RandomNumberGenerator rng(-3., 3.);
+        FunctionBase::Vec x = rng.get_random_nd_vector(problem->n_unknowns());
+
+        FunctionBaseSparse::Vec r(problem->n_residuals()), r_fused;
+        FunctionBaseSparse::SMat J(problem->n_residuals(), problem->n_unknowns()), J_fused;
+        problem->eval_r(x, r);
+        problem->eval_jacobian(x, J);
+        problem->eval_r_and_jacobian(x, r_fused, J_fused);
+
+        ASSERT_NEAR((r - r_fused).norm(), 0.0, 1e-10);
+        ASSERT_NEAR(FunctionBaseSparse::SMat(J - J_fused).norm(), 0.0, 1e-10);
+
+        //the gradient of 1/2 ||r||^2 is J^T r
+        FunctionBase::Vec g(problem->n_unknowns());
+        problem->eval_gradient(x, g);
+        ASSERT_NEAR((g - J.transpose() * r).norm(), 0.0, 1e-8);
+    }
+}
+
+
+TEST(LevenbergMarquardt, convergesToSolution){
+
+    int grid_x(5), grid_y(3), spring_type(1);
+
+    AOPT::MassSpringSystemT<AOPT::MassSpringProblem2DLeastSquare> mss(grid_x, grid_y, spring_type, true);
+    mss.add_constrained_spring_elements();
+
+    FunctionBase::Vec points(2*mss.n_grid_points());
+    for(int i(0); i<points.size()/2; i++){
+        points[2*i]   = (i % (grid_x + 2));
+        points[2*i+1] = (i % (grid_y + 3));
+    }
+
+    const double expected_final_energy(324.44395657791779);
+
+    for(bool geodesic : {false, true}) {
+        LevenbergMarquardt lm(geodesic);
+        auto x_min = lm.solve(mss.get_problem().get(), points, 1e-5);
+
+        ASSERT_NEAR(mss.get_problem()->eval_f(x_min), expected_final_energy, 1e-7);
+        //r and J are evaluated at most once per trial point
+        ASSERT_LE(lm.n_eval_r_and_jacobian(), lm.n_factorizations() + 1);
+    }
+}
+
+
+TEST(MassSpringProblem2DLeastSquare, MatrixFreeJacobianProducts){
+
+    for(int spring_type(0); spring_type < 2; ++spring_type) {
+        AOPT::MassSpringSystemT<AOPT::MassSpringProblem2DLeastSquare> mss(4, 5, spring_type, true);
+        mss.add_constrained_spring_elements();
+        auto problem = mss.get_problem();
+
+        RandomNumberGenerator rng(-3., 3.);
+        FunctionBase::Vec x = rng.get_random_nd_vector(problem->n_unknowns());
+        FunctionBase::Vec v = rng.get_random_nd_vector(problem->n_unknowns());
+        FunctionBase::Vec w = rng.get_random_nd_vector(problem->n_residuals());
+
+        FunctionBaseSparse::SMat J(problem->n_residuals(), problem->n_unknowns());
+        problem->eval_jacobian(x, J);
+
+        FunctionBase::Vec jv, jtw, c;
+        problem->eval_jacobian_product(x, v, jv);
+        problem->eval_jacobian_transpose_product(x, w, jtw);
+        problem->eval_jacobian_column_norms(x, c);
+
+        ASSERT_NEAR((jv - J * v).norm(), 0.0, 1e-8);
+        ASSERT_NEAR((jtw - J.transpose() * w).norm(), 0.0, 1e-8);
+        for(int i = 0; i < J.cols(); ++i)
+            ASSERT_NEAR(c[i], J.col(i).norm(), 1e-8);
+    }
+}
+
+
+TEST(MatrixFreeGaussNewton, convergesToSolution){
+
+    int grid_x(5), grid_y(3), spring_type(1);
+
+    AOPT::MassSpringSystemT<AOPT::MassSpringProblem2DLeastSquare> mss(grid_x, grid_y, spring_type, true);
+    mss.add_constrained_spring_elements();
+
+    FunctionBase::Vec points(2*mss.n_grid_points());
+    for(int i(0); i<points.size()/2; i++){
+        points[2*i]   = (i % (grid_x + 2));
+        points[2*i+1] = (i % (grid_y + 3));
+    }
+
+    const double expected_final_energy(324.44395657791779);
+
+    for(auto linear_solver : {MatrixFreeGaussNewton::LSQR, MatrixFreeGaussNewton::CGLS})
+        for(bool column_scaling : {false, true}) {
+            auto x_min = MatrixFreeGaussNewton::solve(mss.get_problem().get(), points, 1e-5, 1000,
+                                                      linear_solver, column_scaling);
+            ASSERT_NEAR(mss.get_problem()->eval_f(x_min), expected_final_energy, 1e-7);
+        }
+}
+
+
+TEST(MassSpringResidualProblem, SameAsMassSpringProblem2DLeastSquare){
+
+    for(int spring_type(0); spring_type < 2; ++spring_type) {
+        AOPT::MassSpringSystemT<AOPT::MassSpringProblem2DLeastSquare> mss(6, 5, spring_type, true);
+        mss.add_constrained_spring_elements();
+        AOPT::MassSpringSystemT<AOPT::MassSpringResidualProblem> mss_blocks(6, 5, spring_type, true);
+        mss_blocks.add_constrained_spring_elements();
+
+        auto problem = mss.get_problem();
+        auto blocks = mss_blocks.get_problem();
+        ASSERT_EQ(problem->n_residuals(), blocks->n_residuals());
+
+        RandomNumberGenerator rng(-3., 3.);
+        FunctionBase::Vec x = rng.get_random_nd_vector(problem->n_unknowns());
+        FunctionBase::Vec v = rng.get_random_nd_vector(problem->n_unknowns());
+        FunctionBase::Vec w = rng.get_random_nd_vector(problem->n_residuals());
+
+        FunctionBaseSparse::Vec r, g, jv, jtw, c;
+        FunctionBaseSparse::SMat J, H;
+        problem->eval_r_and_jacobian(x, r, J);
+        problem->eval_gradient(x, g);
+        problem->eval_hessian(x, H);
+
+        //serial and threaded assembly
+        for(int n_threads : {1, 3}) {
+            blocks->set_n_threads(n_threads);
+
+            FunctionBaseSparse::Vec rb, gb;
+            FunctionBaseSparse::SMat Jb, Hb;
+            blocks->eval_r_and_jacobian(x, rb, Jb);
+            blocks->eval_gradient(x, gb);
+            blocks->eval_hessian(x, Hb);
+
+            ASSERT_NEAR(problem->eval_f(x), blocks->eval_f(x), 1e-8);
+            ASSERT_NEAR((r - rb).norm(), 0.0, 1e-10);
+            ASSERT_NEAR(FunctionBaseSparse::SMat(J - Jb).norm(), 0.0, 1e-10);
+            ASSERT_NEAR((g - gb).norm(), 0.0, 1e-8);
+            ASSERT_NEAR(FunctionBaseSparse::SMat(H - Hb).norm(), 0.0, 1e-8);
+
+            //values only are written into a Jacobian with the same pattern
+            blocks->eval_r_and_jacobian(2. * x, rb, Jb);
+            blocks->eval_jacobian(x, Jb);
+            ASSERT_NEAR(FunctionBaseSparse::SMat(J - Jb).norm(), 0.0, 1e-10);
+
+            blocks->eval_jacobian_product(x, v, jv);
+            blocks->eval_jacobian_transpose_product(x, w, jtw);
+            blocks->eval_jacobian_column_norms(x, c);
+            ASSERT_NEAR((jv - J * v).norm(), 0.0, 1e-8);
+            ASSERT_NEAR((jtw - J.transpose() * w).norm(), 0.0, 1e-8);
+            for(int i = 0; i < J.cols(); ++i)
+                ASSERT_NEAR(c[i], J.col(i).norm(), 1e-8);
+        }
+    }
+}
+
+
+TEST(MassSpringResidualProblem, convergesToSolution){
+
+    int grid_x(5), grid_y(3), spring_type(1);
+
+    AOPT::MassSpringSystemT<AOPT::MassSpringResidualProblem> mss(grid_x, grid_y, spring_type, true);
+    mss.add_constrained_spring_elements();
+
+    FunctionBase::Vec points(2*mss.n_grid_points());
+    for(int i(0); i<points.size()/2; i++){
+        points[2*i]   = (i % (grid_x + 2));
+        points[2*i+1] = (i % (grid_y + 3));
+    }
+
+    const double expected_final_energy(324.44395657791779);
+
+    auto x_newton = AOPT::NewtonMethods::solve(mss.get_problem().get(), points, 1e-5);
+    ASSERT_NEAR(mss.get_problem()->eval_f(x_newton), expected_final_energy, 1e-7);
+
+    LevenbergMarquardt lm;
+    auto x_lm = lm.solve(mss.get_problem().get(), points, 1e-5);
+    ASSERT_NEAR(mss.get_problem()->eval_f(x_lm), expected_final_energy, 1e-7);
+}
+
+
 
 
 int main(int _argc, char** _argv){
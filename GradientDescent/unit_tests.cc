@@ -4,10 +4,16 @@
 #include <Functions/ConstrainedSpringElement2D.hh>
 #include <Functions/FunctionQuadratic2D.hh>
 #include <Functions/FunctionNonConvex2D.hh>
+#include <Functions/SpringElement2DWithLength.hh>
+#include <Functions/MassSpringProblem2DSparse.hh>
 #include <FunctionBase/ParametricFunctionWrapper.hh>
 #include <Utils/RandomNumberGenerator.hh>
 #include <Utils/DerivativeChecker.hh>
 #include <Algorithms/GradientDescent.hh>
+#include <SpringGrid.hh>
+// counts the heap allocations of this test program
+#define AOPT_ALLOCATION_TRACKER_IMPLEMENTATION
+#include <Utils/AllocationTracker.hh>
 
 #include "gtest/gtest.h"
 
@@ -246,6 +252,31 @@ TEST(GradientDescent, CheckAlgorithmOnConstrainedSpringElement){
     ASSERT_NEAR((result-desired_location).norm(), 0, 1e-4);
 }
 
+/** Once the buffers are set up, the iterations of the gradient descent do not
+ * allocate, i.e. a solve of 6 iterations allocates as much as one of 3 */
+TEST(GradientDescent, IterationsDoNotAllocate){
+    ASSERT_TRUE(AllocationTracker::installed());
+    if(!AllocationTracker::tracks_malloc())
+        GTEST_SKIP() << "the allocations of Eigen are only counted with glibc";
+
+    const int n = 6;
+    SpringElement2DWithLength spring;
+    MassSpringProblem2DSparse problem(spring, 2 * n * n);
+    Eigen::VectorXd start;
+    setup_spring_grid(problem, n, start);
+
+    auto allocations = [&](const int _iters) {
+        AllocationTracker::Scope scope;
+        GradientDescent::solve(&problem, start, 1e-12, _iters);
+        return scope.counts().allocations;
+    };
+
+    allocations(1);
+    const auto a3 = allocations(3);
+    EXPECT_EQ(allocations(6), a3);
+    EXPECT_EQ(allocations(20), a3);
+}
+
 int main(int _argc, char** _argv){
 
     testing::InitGoogleTest(&_argc, _argv);
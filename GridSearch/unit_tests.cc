@@ -1,6 +1,10 @@
 #include <iostream>
 #include <Utils/StopWatch.hh>
 #include <Algorithms/GridSearch.hh>
+#include <atomic>
+#include <Utils/RandomNumberGenerator.hh>
+#include <Utils/VectorizedMath.hh>
+#include <Functions/FunctionQuadratic2D.hh>
 
 #include "gtest/gtest.h"
 
@@ -159,6 +163,238 @@ TEST(GridSearchTests, Grid7dFunction7dGridSearch) {
     ASSERT_FLOAT_EQ(f_min, -24.62245);
 }
 
+/** the incremental evaluation of a quadratic follows eval_f along a walk, and
+ * two walks with their own states do not interfere */
+TEST(FunctionsTest, QuadraticFunctionNdIncremental){
+    const int n(6);
+    FunctionQuadraticND func(n, false);
+
+    FunctionQuadraticND::Vec x = FunctionQuadraticND::Vec::LinSpaced(n, -1., 2.), y = -x;
+    FunctionBase::IncrementalState state_x, state_y;
+    ASSERT_DOUBLE_EQ(func.eval_f_start(x, state_x), func.eval_f(x));
+    ASSERT_DOUBLE_EQ(func.eval_f_start(y, state_y), func.eval_f(y));
+
+    for(int i = 0; i < 100; ++i) {
+        const int j = (7 * i) % n;
+        const double dx = 0.1 * ((i % 5) - 2);
+        x[j] += dx;
+        y[n - 1 - j] -= dx;
+        const double fx = func.eval_f_step(x, j, dx, state_x);
+        const double fy = func.eval_f_step(y, n - 1 - j, -dx, state_y);
+        ASSERT_NEAR(fx, func.eval_f(x), 1e-10 * std::max(1., std::abs(fx)));
+        ASSERT_NEAR(fy, func.eval_f(y), 1e-10 * std::max(1., std::abs(fy)));
+    }
+}
+
+
+/** the batched evaluation of a quadratic, incremental for points that differ in
+ * one coordinate, gives the same as eval_f */
+TEST(FunctionsTest, QuadraticFunctionNdBatch){
+    const int n(6);
+    FunctionQuadraticND func(n, false);
+
+    // a walk that moves one coordinate at a time, with some larger jumps
+    FunctionQuadraticND::Mat X(n, 100);
+    X.col(0) = FunctionQuadraticND::Vec::LinSpaced(n, -1., 2.);
+    for(int i = 1; i < X.cols(); ++i) {
+        X.col(i) = X.col(i-1);
+        X((7 * i) % n, i) += 0.1 * ((i % 5) - 2);
+        if(i % 17 == 0)
+            X.col(i) *= -0.5;
+    }
+
+    FunctionQuadraticND::Vec f;
+    func.eval_f_batch(X, f);
+    ASSERT_EQ(f.size(), X.cols());
+    for(int i = 0; i < X.cols(); ++i) {
+        FunctionQuadraticND::Vec x = X.col(i);
+        ASSERT_NEAR(f[i], func.eval_f(x), 1e-10 * std::max(1., std::abs(f[i])));
+    }
+}
+
+
+/** the batched evaluations of the functions give the same as eval_f */
+TEST(FunctionsTest, BatchEvaluations){
+    RandomNumberGenerator rng(-10., 10.);
+    const int m(1000);
+    FunctionBase::Mat X2(2, m);
+    for(int i = 0; i < m; ++i)
+        X2.col(i) = rng.get_random_nd_vector(2);
+
+    // random points are evaluated by blocks of A X
+    const int n(9);
+    FunctionQuadraticND func_nd(n, false);
+    FunctionBase::Mat Xn(n, m);
+    for(int i = 0; i < m; ++i)
+        Xn.col(i) = rng.get_random_nd_vector(n);
+
+    FunctionQuadratic2D func_q2d(1.5);
+    FunctionNonConvex2D func_nc2d;
+    std::vector<std::pair<FunctionBase*, FunctionBase::Mat*>> cases{{&func_q2d, &X2}, {&func_nc2d, &X2}, {&func_nd, &Xn}};
+    for(auto& c : cases) {
+        FunctionBase::Vec f, x;
+        c.first->eval_f_batch(*c.second, f);
+        ASSERT_EQ(f.size(), m);
+        for(int i = 0; i < m; ++i) {
+            x = c.second->col(i);
+            ASSERT_NEAR(f[i], c.first->eval_f(x), 1e-12 * std::max(1., std::abs(f[i])));
+        }
+    }
+}
+
+
+/** cos_batch follows std::cos, also for large arguments */
+TEST(FunctionsTest, VectorizedCos){
+    const int m(10000);
+    std::vector<double> x(m), y(m);
+    for(int i = 0; i < m; ++i)
+        x[i] = (i - m / 2) * 0.0123 * (1 + i % 7);
+    x[0] = 1e9;
+    x[1] = -3e12;
+    cos_batch(x.data(), y.data(), m);
+    for(int i = 0; i < m; ++i)
+        ASSERT_NEAR(y[i], std::cos(x[i]), 1e-15) << " at x = " << x[i];
+}
+
+
+/** evaluates a function point by point and counts the evaluations */
+class CountingFunction final : public FunctionBase {
+public:
+    CountingFunction(FunctionBase& _func) : func_(_func) {}
+
+    inline virtual int n_unknowns() { return func_.n_unknowns(); }
+
+    inline virtual double eval_f(const Vec &_x) {
+        ++n_evals_;
+        return func_.eval_f(_x);
+    }
+
+    inline virtual void eval_gradient(const Vec &_x, Vec &_g) { func_.eval_gradient(_x, _g); }
+
+    inline virtual void eval_hessian(const Vec &_x, Mat &_H) { func_.eval_hessian(_x, _H); }
+
+    inline virtual double eval_lower_bound(const Vec &_x_l, const Vec &_x_u) { return func_.eval_lower_bound(_x_l, _x_u); }
+
+    // n_evals_ is atomic
+    inline virtual bool is_thread_safe() { return func_.is_thread_safe(); }
+
+    std::atomic<long> n_evals_{0};
+
+private:
+    FunctionBase& func_;
+};
+
+
+/** the parallel Gray code walk visits every grid point once and finds the same
+ * minima as evaluating each point from scratch, for any number of threads */
+TEST(GridSearchTests, ParallelGridSearch) {
+    const int grid_n(9);
+    const int func_n(5);
+
+    FunctionQuadraticND func(func_n, false);
+    CountingFunction counting(func);
+
+    FunctionQuadraticND::Vec x_l = -2 * FunctionQuadraticND::Vec::Ones(func_n);
+    FunctionQuadraticND::Vec x_u =  3 * FunctionQuadraticND::Vec::Ones(func_n);
+
+    std::vector<GridSearch::GridPoint> minima_1, minima_4, minima_counting;
+    GridSearch(grid_n, 1).grid_search_nd(&func, x_l, x_u, 5, minima_1);
+    GridSearch(grid_n, 4).grid_search_nd(&func, x_l, x_u, 5, minima_4);
+    GridSearch(grid_n, 4).grid_search_nd(&counting, x_l, x_u, 5, minima_counting);
+
+    ASSERT_EQ(counting.n_evals_, std::pow(grid_n + 1, func_n));
+    ASSERT_EQ(minima_1.size(), 5u);
+    ASSERT_EQ(minima_4.size(), 5u);
+    ASSERT_EQ(minima_counting.size(), 5u);
+    for(int i = 0; i < 5; ++i) {
+        EXPECT_EQ(minima_1[i].f, minima_4[i].f);
+        EXPECT_EQ(minima_1[i].x, minima_4[i].x);
+        EXPECT_NEAR(minima_1[i].f, minima_counting[i].f, 1e-9 * std::abs(minima_counting[i].f));
+        EXPECT_NEAR(minima_1[i].f, func.eval_f(minima_1[i].x), 1e-9 * std::abs(minima_1[i].f));
+        if(i > 0) {
+            EXPECT_LE(minima_1[i-1].f, minima_1[i].f);
+        }
+    }
+}
+
+
+/** grids with more than 2^64 points are rejected */
+TEST(GridSearchTests, GridSizeOverflow) {
+    const int func_n(20);
+    FunctionQuadraticND func(func_n);
+    FunctionQuadraticND::Vec x_l = -FunctionQuadraticND::Vec::Ones(func_n);
+    FunctionQuadraticND::Vec x_u =  FunctionQuadraticND::Vec::Ones(func_n);
+
+    double f_min;
+    ASSERT_EQ(GridSearch(10).grid_search_nd(&func, x_l, x_u, f_min), -1);
+}
+
+/** the lower bound of a quadratic holds at random points of random boxes */
+TEST(FunctionsTest, QuadraticFunctionNdLowerBound){
+    const int n(5);
+    RandomNumberGenerator rng(-3., 3.);
+    for(bool convex : {true, false}) {
+        FunctionQuadraticND func(n, convex);
+        for(int i = 0; i < 20; ++i) {
+            FunctionQuadraticND::Vec a = rng.get_random_nd_vector(n), b = rng.get_random_nd_vector(n);
+            FunctionQuadraticND::Vec x_l = a.cwiseMin(b), x_u = a.cwiseMax(b);
+            const double lb = func.eval_lower_bound(x_l, x_u);
+            for(int k = 0; k < 50; ++k) {
+                FunctionQuadraticND::Vec t = 0.5 * (rng.get_random_nd_vector(n) / 3. + FunctionQuadraticND::Vec::Ones(n));
+                FunctionQuadraticND::Vec x = x_l + (x_u - x_l).cwiseProduct(t);
+                ASSERT_LE(lb, func.eval_f(x) + 1e-9);
+            }
+        }
+    }
+}
+
+
+/** branch and bound finds the minimum of the dense grid with much fewer evaluations */
+TEST(GridSearchTests, BranchAndBoundQuadratic) {
+    const int grid_n(10);
+    const int func_n(6);
+    GridSearch grid(grid_n);
+
+    for(bool convex : {true, false}) {
+        FunctionQuadraticND func(func_n, convex);
+        CountingFunction counting(func);
+
+        FunctionQuadraticND::Vec x_l = -3 * FunctionQuadraticND::Vec::Ones(func_n);
+        FunctionQuadraticND::Vec x_u =  3 * FunctionQuadraticND::Vec::Ones(func_n);
+
+        double f_grid, f_bb;
+        FunctionQuadraticND::Vec x_bb;
+        grid.grid_search_nd(&func, x_l, x_u, f_grid);
+        ASSERT_EQ(grid.branch_and_bound_nd(&counting, x_l, x_u, f_bb, x_bb), 0);
+
+        EXPECT_NEAR(f_bb, f_grid, 1e-9 * (1. + std::abs(f_grid)));
+        EXPECT_DOUBLE_EQ(func.eval_f(x_bb), f_bb);
+        EXPECT_LT(counting.n_evals_, std::pow(grid_n + 1, func_n) / 100);
+    }
+}
+
+
+/** without a lower bound of the function, the cells are bounded with a Lipschitz constant */
+TEST(GridSearchTests, BranchAndBoundLipschitz) {
+    const int grid_n(200);
+    GridSearch grid(grid_n);
+    FunctionNonConvex2D func;
+    CountingFunction counting(func);
+
+    FunctionNonConvex2D::Vec x_l(2), x_u(2);
+    x_l << -2, -2;
+    x_u << 2, 2;
+
+    double f_grid, f_bb;
+    FunctionNonConvex2D::Vec x_bb;
+    grid.grid_search_2d(&func, x_l, x_u, f_grid);
+    ASSERT_EQ(grid.branch_and_bound_nd(&counting, x_l, x_u, f_bb, x_bb), 0);
+
+    EXPECT_DOUBLE_EQ(f_bb, f_grid);
+    EXPECT_LT(counting.n_evals_, (grid_n + 1) * (grid_n + 1));
+}
+
+
 int main(int _argc, char** _argv){
 
     testing::InitGoogleTest(&_argc, _argv);
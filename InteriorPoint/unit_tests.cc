@@ -4,6 +4,7 @@
 #include <MassSpringSystemT.hh>
 #include <Algorithms/InteriorPoint.hh>
 #include <Functions/AreaConstraint2D.hh>
+#include <Utils/OptimizationStatistic.hh>
 
 #include "gtest/gtest.h"
 
@@ -169,6 +170,50 @@ TEST(InteriorPointProblem, CheckFunctions){
 }
 
 
+/** the constant hessians of the area constraints are only evaluated once */
+TEST(InteriorPointProblem, CachesConstantHessians){
+
+    typedef InteriorPointProblem::Vec Vec;
+    typedef InteriorPointProblem::SMat SMat;
+
+    const int n(8);
+
+    std::vector<AreaConstraint2D> areas{AreaConstraint2D(n, 0, 1, 3), AreaConstraint2D(n, 2, 3, 1),
+                                        AreaConstraint2D(n, 3, 0, 2), AreaConstraint2D(n, 0, 1, 2)};
+    std::vector<OptimizationStatistic> stats;
+    stats.reserve(areas.size());
+    for(auto& a : areas)
+        stats.emplace_back(&a);
+
+    std::vector<FunctionBaseSparse*> constraints, stat_constraints;
+    for(auto i = 0u; i < areas.size(); ++i) {
+        constraints.push_back(&areas[i]);
+        stat_constraints.push_back(&stats[i]);
+        EXPECT_TRUE(stats[i].has_constant_hessian());
+    }
+
+    FunctionQuadratic2DSparse obj(n);
+    InteriorPointProblem cached(&obj, stat_constraints);
+
+    Vec x(n), y(n);
+    x << 0, 0, 1, 0, 1, 1, 0, 1;
+    y << 0.1, -0.1, 1.2, 0.1, 0.9, 1.1, -0.2, 0.8;
+
+    SMat H(n, n);
+    cached.eval_hessian(x, H);
+    cached.eval_hessian(y, H);
+
+    // a new problem evaluates the hessians at y
+    InteriorPointProblem fresh(&obj, constraints);
+    SMat H_fresh(n, n);
+    fresh.eval_hessian(y, H_fresh);
+
+    EXPECT_NEAR((H - H_fresh).norm(), 0., 1e-12);
+    for(auto& s : stats)
+        EXPECT_EQ(s.n_eval_hessian(), 1);
+}
+
+
 
 
 TEST(InteriorPointMethod, CheckMinimum){
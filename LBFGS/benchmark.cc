@@ -0,0 +1,77 @@
+#include <Utils/StopWatch.hh>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <Algorithms/LBFGS.hh>
+#include <MassSpringSystemT.hh>
+
+/* Compares the two-loop recursion with the compact representation of LBFGS
+ * on a large mass spring system, for several history sizes m.
+ * Both variants compute the same iterates up to rounding, so the difference in timing is only
+ * due to the computation of the search direction. */
+int main(int _argc, const char* _argv[]) {
+    if(_argc < 4) {
+        std::cout << "Usage: input should be 'function index(0: f without length, 1: f with length), number of grid in x, number of grid in y, "
+                     "max iteration (optional, default 100), m values (optional, default 5 10 20 50)', e.g. "
+                     "./LBFGS-benchmark 1 706 706 100 5 10 20 50" << std::endl;
+        return -1;
+    }
+
+    //read the input parameters
+    int func_index = atoi(_argv[1]);
+    int n_grid_x = atoi(_argv[2]);
+    int n_grid_y = atoi(_argv[3]);
+    int max_iter = _argc > 4 ? atoi(_argv[4]) : 100;
+
+    std::vector<int> ms;
+    for(int i = 5; i < _argc; ++i)
+        ms.push_back(atoi(_argv[i]));
+    if(ms.empty())
+        ms = {5, 10, 20, 50};
+
+    AOPT::MassSpringSystemT<AOPT::MassSpringProblem2DSparse> mss(n_grid_x, n_grid_y, func_index);
+    mss.add_constrained_spring_elements();
+    auto problem = mss.get_problem();
+
+    //start from a perturbed grid
+    AOPT::RandomNumberGenerator rng(-0.5, 0.5);
+    AOPT::LBFGS::Vec start_pts = mss.get_spring_graph_points() + rng.get_random_nd_vector(problem->n_unknowns());
+
+    std::cout << "Benchmarking LBFGS on " << problem->n_unknowns() << " unknowns with "
+              << max_iter << " iterations" << std::endl;
+
+    AOPT::StopWatch<> sw;
+    std::vector<double> t_two_loop, t_compact;
+    std::vector<double> f_two_loop, f_compact;
+
+    for(int m : ms) {
+        //each solver owns 2*n*m doubles of history, release them before the next run
+        {
+            AOPT::LBFGS lbfgs(m);
+            sw.start();
+            auto x = lbfgs.solve(problem.get(), start_pts, 1e-4, max_iter);
+            t_two_loop.push_back(sw.stop());
+            f_two_loop.push_back(problem->eval_f(x));
+        }
+        {
+            AOPT::LBFGS lbfgs(m, true);
+            sw.start();
+            auto x = lbfgs.solve(problem.get(), start_pts, 1e-4, max_iter);
+            t_compact.push_back(sw.stop());
+            f_compact.push_back(problem->eval_f(x));
+        }
+    }
+
+    std::cout << "\n######## LBFGS benchmark (" << problem->n_unknowns() << " unknowns, "
+              << max_iter << " iterations) ########" << std::endl;
+    std::cout << std::setw(6) << "m" << std::setw(16) << "two-loop [ms]" << std::setw(16) << "compact [ms]"
+              << std::setw(12) << "speedup" << std::setw(20) << "obj two-loop" << std::setw(20) << "obj compact" << std::endl;
+    for(size_t i = 0; i < ms.size(); ++i) {
+        std::cout << std::setw(6) << ms[i] << std::setw(16) << t_two_loop[i] << std::setw(16) << t_compact[i]
+                  << std::setw(12) << std::setprecision(3) << t_two_loop[i] / t_compact[i]
+                  << std::setw(20) << std::setprecision(10) << f_two_loop[i]
+                  << std::setw(20) << f_compact[i] << std::endl;
+    }
+
+    return 0;
+}
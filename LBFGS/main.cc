@@ -5,9 +5,10 @@
 #include <MassSpringSystemT.hh>
 
 int main(int _argc, const char* _argv[]) {
-    if(_argc != 7) {
-        std::cout << "Usage: input should be 'function index(0: f without length, 1: f with length), number of grid in x, number of grid in y, m, max iteration, filename', e.g. "
-                     "./LBFGS 1 20 20 10 10000 /usr/spring" << std::endl;
+    if(_argc != 7 && _argc != 8) {
+        std::cout << "Usage: input should be 'function index(0: f without length, 1: f with length), number of grid in x, number of grid in y, m, max iteration, filename, "
+                     "preconditioner (optional, 0: none, 1: diagonal, 2: 2x2 node blocks)', e.g. "
+                     "./LBFGS 1 20 20 10 10000 /usr/spring 2" << std::endl;
         return -1;
     }
 
@@ -20,6 +21,7 @@ int main(int _argc, const char* _argv[]) {
     max_iter = atoi(_argv[5]);
 
     std::string filename(_argv[6]);
+    int precond = _argc == 8 ? atoi(_argv[7]) : 0;
 
     //initial energy
     AOPT::MassSpringSystemT<AOPT::MassSpringProblem2DSparse> mss(n_grid_x, n_grid_y, func_index);
@@ -47,6 +49,12 @@ int main(int _argc, const char* _argv[]) {
     filename += "_opt";
 
     AOPT::LBFGS lbfgs(m);
+    if(precond > 0) {
+        auto problem = mss.get_problem();
+        lbfgs.set_block_preconditioner([problem](const AOPT::LBFGS::Vec& _x, AOPT::LBFGS::Vec& _blocks) {
+            problem->eval_block_diagonal(_x, _blocks);
+        }, 2, precond == 1);
+    }
     AOPT::LBFGS::Vec x = lbfgs.solve(opt_st.get(), start_pts, 1e-4, max_iter);
 
     opt_st->print_statistics();
@@ -5,8 +5,15 @@
 
 #include <Functions/FunctionQuadratic2D.hh>
 #include <Functions/FunctionQuadraticND.hh>
+#include <Functions/SpringElement2DWithLength.hh>
+#include <Functions/MassSpringProblem2DSparse.hh>
 
 #include <Algorithms/LBFGS.hh>
+#include <Utils/Profiler.hh>
+#include <SpringGrid.hh>
+// counts the heap allocations of this test program
+#define AOPT_ALLOCATION_TRACKER_IMPLEMENTATION
+#include <Utils/AllocationTracker.hh>
 
 
 #include "gtest/gtest.h"
@@ -108,7 +115,164 @@ TEST(LBFGS, AnotherSimpleQuadraticProblem){
 }
 
 
+TEST(LBFGS, CompactRepresentationMatchesTwoLoopRecursion){
 
+    const int dim(5);
+
+
+    LBFGS::Mat A(dim, dim);
+    A <<    246.652,  107.143,  117.078, -125.157,  21.0117,
+            107.143,  244.831, -34.6749, -3.39497,  105.168,
+            117.078, -34.6749,  114.209, -57.6975,  14.9266,
+           -125.157, -3.39497, -57.6975,  129.647,   99.809,
+            21.0117,  105.168,  14.9266,   99.809,  222.531;
+
+    LBFGS::Vec b(dim);
+    b << 0.832402, -9.81436,  9.98931, -9.74196,  6.84995;
+
+    FunctionQuadraticND func(A, b, 0.);
+
+    LBFGS::Vec init_x(dim);
+    init_x<<-1, 5, 4,3,5;
+
+    //same iterates after a few steps, i.e. with and without a full history
+    for(int max_iters : {1, 2, 3, 5, 8}) {
+        LBFGS lbfgs(3), lbfgs_compact(3, true);
+
+        auto result = lbfgs.solve(&func, init_x, 1e-4, max_iters);
+        auto result_compact = lbfgs_compact.solve(&func, init_x, 1e-4, max_iters);
+
+        ASSERT_LT((result - result_compact).norm(), 1e-8);
+    }
+
+    LBFGS lbfgs_compact(3, true);
+    auto result = lbfgs_compact.solve(&func, init_x);
+
+    LBFGS::Vec expected_result(dim);
+    expected_result<<0.854001, -0.123255,  -0.33051,   1.18085, -0.560632;
+
+    ASSERT_LT((result - expected_result).norm(), 1e-5);
+}
+
+
+
+TEST(LBFGS, DiagonalPreconditionerOnBadlyScaledProblem){
+
+    const int dim(4);
+
+    //curvature spans six orders of magnitude
+    LBFGS::Vec diag(dim);
+    diag << 1., 1e2, 1e4, 1e6;
+    LBFGS::Mat A = diag.asDiagonal();
+
+    LBFGS::Vec b(dim);
+    b << 1., -2., 3., -4.;
+
+    FunctionQuadraticND func(A, b, 0.);
+
+    LBFGS::Vec init_x(dim);
+    init_x << 1, 1, 1, 1;
+
+    LBFGS::Vec expected_result = -b.cwiseQuotient(diag);
+
+    //with the exact diagonal as preconditioner, every step is a Newton step
+    //up to the line search, while the scalar H_0 needs many more iterations
+    LBFGS lbfgs(3), lbfgs_precond(3);
+    lbfgs_precond.set_block_preconditioner([&diag](const LBFGS::Vec& /*_x*/, LBFGS::Vec& _blocks) {
+        _blocks = diag;
+    }, 1);
+
+    auto result = lbfgs.solve(&func, init_x, 1e-4, 10);
+    auto result_precond = lbfgs_precond.solve(&func, init_x, 1e-4, 10);
+
+    ASSERT_LT((result_precond - expected_result).norm(), 1e-8);
+    ASSERT_LE((result_precond - expected_result).norm(), (result - expected_result).norm());
+}
+
+
+TEST(LBFGS, PreconditionedSimpleQuadraticProblem){
+
+    const int dim(5);
+
+
+    LBFGS::Mat A(dim, dim);
+    A <<    246.652,  107.143,  117.078, -125.157,  21.0117,
+            107.143,  244.831, -34.6749, -3.39497,  105.168,
+            117.078, -34.6749,  114.209, -57.6975,  14.9266,
+           -125.157, -3.39497, -57.6975,  129.647,   99.809,
+            21.0117,  105.168,  14.9266,   99.809,  222.531;
+
+    LBFGS::Vec b(dim);
+    b << 0.832402, -9.81436,  9.98931, -9.74196,  6.84995;
+
+    FunctionQuadraticND func(A, b, 0.);
+
+    LBFGS::Vec init_x(dim);
+    init_x<<-1, 5, 4,3,5;
+
+    LBFGS lbfgs(3);
+    lbfgs.set_block_preconditioner([&A](const LBFGS::Vec& /*_x*/, LBFGS::Vec& _blocks) {
+        _blocks = A.diagonal();
+    }, 1);
+    auto result = lbfgs.solve(&func, init_x);
+
+    LBFGS::Vec expected_result(dim);
+    expected_result<<0.854001, -0.123255,  -0.33051,   1.18085, -0.560632;
+
+    ASSERT_LT((result - expected_result).norm(), 1e-5);
+}
+
+
+/** Once its storage is set up, the iterations of LBFGS do not allocate,
+ * i.e. a solve of 6 iterations allocates as much as one of 3 */
+TEST(LBFGS, IterationsDoNotAllocate){
+    ASSERT_TRUE(AllocationTracker::installed());
+    if(!AllocationTracker::tracks_malloc())
+        GTEST_SKIP() << "the allocations of Eigen are only counted with glibc";
+
+    const int n = 6;
+    SpringElement2DWithLength spring;
+    MassSpringProblem2DSparse problem(spring, 2 * n * n);
+    Eigen::VectorXd start;
+    setup_spring_grid(problem, n, start);
+
+    LBFGS lbfgs(5);
+    auto allocations = [&](const int _iters) {
+        AllocationTracker::Scope scope;
+        lbfgs.solve(&problem, start, 1e-12, _iters);
+        return scope.counts().allocations;
+    };
+
+    // sets up the storage of the solver and the problem
+    allocations(1);
+    const auto a3 = allocations(3);
+    EXPECT_EQ(allocations(6), a3);
+    EXPECT_EQ(allocations(20), a3);
+}
+
+
+/** The history of LBFGS takes 2 n m doubles, and m x m matrices more in the compact representation */
+TEST(LBFGS, MemoryFootprint){
+    const int n = 6, m = 5;
+    SpringElement2DWithLength spring;
+    MassSpringProblem2DSparse problem(spring, 2 * n * n);
+    Eigen::VectorXd start;
+    setup_spring_grid(problem, n, start);
+
+    for(bool compact : {false, true}) {
+        LBFGS lbfgs(m, compact);
+        Profiler& profiler = Profiler::instance();
+        profiler.start();
+        lbfgs.solve(&problem, start, 1e-12, 3);
+        profiler.stop();
+
+        const auto history = profiler.memory("LBFGS::solve", "history");
+        EXPECT_EQ(history.nnz, 2 * 2 * n * n * m);
+        EXPECT_EQ(history.bytes, 8 * history.nnz);
+        EXPECT_EQ(profiler.memory("LBFGS::solve", "compact_history").bytes, compact ? 4 * m * m * 8 : 0);
+        EXPECT_EQ(profiler.memory("LBFGS::solve", "vectors").nnz, 4 * 2 * n * n);
+    }
+}
 
 int main(int _argc, char** _argv){
 
@@ -0,0 +1,149 @@
+#include <iostream>
+
+#include <Utils/StopWatch.hh>
+#include <Utils/RandomNumberGenerator.hh>
+#include <Utils/Profiler.hh>
+
+#include <Functions/FunctionQuadraticND.hh>
+
+#include <Algorithms/LBFGSB.hh>
+
+
+#include "gtest/gtest.h"
+
+
+using namespace AOPT;
+
+/** Those unit tests basically checks individual parts of your implementation.
+ * They generally work by either
+ * 1. comparing your results with ours
+ * 2. comparing your results with manually obtained ones
+ *    (when it's a simple problem solvable by hand)
+ *
+ * Feel free to modify the tests but ONLY to output intermediary values/results BUT
+ * do not modify it in any way that would change its result.
+ *
+ * For more details about googletest, please visit
+ * https://github.com/Macaulay2/googletest-1/blob/master/googletest/docs/Primer.md
+**/
+
+
+
+
+TEST(LBFGSB, SeparableProblemWithActiveBounds){
+
+    const int dim(2);
+
+    //f(x, y) = (x - 2)^2 + (y + 1)^2 + const
+    LBFGSB::Mat A = 2. * LBFGSB::Mat::Identity(dim, dim);
+    LBFGSB::Vec b(dim);
+    b << -4., 2.;
+
+    FunctionQuadraticND func(A, b, 0.);
+
+    LBFGSB::Vec lower(dim), upper(dim), init_x(dim);
+    lower << 0., 0.;
+    upper << 1., 1.;
+    init_x << 0.5, 0.5;
+
+    LBFGSB lbfgsb(3);
+    auto result = lbfgsb.solve(&func, init_x, lower, upper);
+
+    LBFGSB::Vec expected_result(dim);
+    expected_result << 1., 0.;
+
+    ASSERT_LT((result - expected_result).norm(), 1e-8);
+}
+
+
+TEST(LBFGSB, InactiveBoundsGiveUnconstrainedMinimum){
+
+    const int dim(5);
+
+
+    LBFGSB::Mat A(dim, dim);
+    A <<    246.652,  107.143,  117.078, -125.157,  21.0117,
+            107.143,  244.831, -34.6749, -3.39497,  105.168,
+            117.078, -34.6749,  114.209, -57.6975,  14.9266,
+           -125.157, -3.39497, -57.6975,  129.647,   99.809,
+            21.0117,  105.168,  14.9266,   99.809,  222.531;
+
+    LBFGSB::Vec b(dim);
+    b << 0.832402, -9.81436,  9.98931, -9.74196,  6.84995;
+
+    FunctionQuadraticND func(A, b, 0.);
+
+    LBFGSB::Vec init_x(dim);
+    init_x<<-1, 5, 4,3,5;
+
+    LBFGSB::Vec lower = LBFGSB::Vec::Constant(dim, -10.);
+    LBFGSB::Vec upper = LBFGSB::Vec::Constant(dim, 10.);
+
+    LBFGSB lbfgsb(3);
+    auto result = lbfgsb.solve(&func, init_x, lower, upper, 1e-6);
+
+    LBFGSB::Vec expected_result(dim);
+    expected_result<<0.854001, -0.123255,  -0.33051,   1.18085, -0.560632;
+
+    ASSERT_LT((result - expected_result).norm(), 1e-5);
+}
+
+
+TEST(LBFGSB, RandomBoundsSatisfyOptimalityConditions){
+
+    const int dim(20);
+
+    //the first-order optimality conditions of a convex problem with bounds are
+    //feasibility and a vanishing projected gradient
+    FunctionQuadraticND func(dim);
+    RandomNumberGenerator rng(-1., 0.);
+
+    for(int i = 0; i < 5; ++i) {
+        LBFGSB::Vec lower = rng.get_random_nd_vector(dim);
+        LBFGSB::Vec upper = lower + LBFGSB::Vec::Constant(dim, 1.);
+        LBFGSB::Vec init_x = LBFGSB::Vec::Zero(dim);
+
+        LBFGSB lbfgsb(5);
+        auto result = lbfgsb.solve(&func, init_x, lower, upper, 1e-8);
+
+        LBFGSB::Vec g(dim);
+        func.eval_gradient(result, g);
+
+        ASSERT_TRUE((result.array() >= lower.array()).all());
+        ASSERT_TRUE((result.array() <= upper.array()).all());
+        ASSERT_LT(LBFGSB::projected_gradient_norm(result, g, lower, upper), 1e-6);
+    }
+}
+
+
+/** Besides the 2 n m doubles of the history, LBFGS-B stores m x m matrices for the
+ * bounds and n entries per vector of the Cauchy point computation */
+TEST(LBFGSB, MemoryFootprint){
+
+    const int dim(20), m(5);
+    FunctionQuadraticND func(dim);
+    LBFGSB::Vec lower = LBFGSB::Vec::Constant(dim, -1.), upper = LBFGSB::Vec::Constant(dim, 1.);
+
+    LBFGSB lbfgsb(m);
+    Profiler& profiler = Profiler::instance();
+    profiler.start();
+    lbfgsb.solve(&func, LBFGSB::Vec::Zero(dim), lower, upper, 1e-12, 3);
+    profiler.stop();
+
+    EXPECT_EQ(profiler.memory("LBFGSB::solve", "history").nnz, 2 * dim * m);
+    EXPECT_EQ(profiler.memory("LBFGSB::solve", "bound_history").nnz, 2 * m * m + 2 * m);
+    EXPECT_EQ(profiler.memory("LBFGSB::solve", "cauchy_point").nnz, 3 * dim);
+    EXPECT_GE(profiler.memory("LBFGSB::solve", "cauchy_point").bytes,
+              dim * (3 * 8 + (int)sizeof(std::pair<double, int>) + (int)sizeof(int)));
+    EXPECT_EQ(profiler.memory("LBFGSB::solve", "vectors").nnz, 7 * dim);
+}
+
+
+
+
+int main(int _argc, char** _argv){
+
+    testing::InitGoogleTest(&_argc, _argv);
+    return RUN_ALL_TESTS();
+
+}
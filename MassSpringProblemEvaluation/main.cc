@@ -1,5 +1,6 @@
 #include <iostream>
 #include <Utils/StopWatch.hh>
+#include <Utils/Profiler.hh>
 #include <MassSpringSystemT.hh>
 #include <Utils/RandomNumberGenerator.hh>
 #include <Utils/DerivativeChecker.hh>
@@ -72,6 +73,12 @@ int main(int _argc, const char* _argv[]) {
         mss.get_problem()->eval_gradient(points, gradient);
         std::cout<<"MassSpring system gradient norm is "<<gradient.norm()<<std::endl;
 
+        //split the hessian evaluation into the triplet building and setFromTriplets,
+        //with hardware counters where they are available
+        auto& profiler = AOPT::Profiler::instance();
+        const bool hardware_counters = profiler.enable_hardware_counters();
+        profiler.start();
+
         sw.start();
 
         AOPT::MassSpringSystemT<AOPT::MassSpringProblem2DSparse>::SMat sh(n_unknowns, n_unknowns);
@@ -79,6 +86,13 @@ int main(int _argc, const char* _argv[]) {
         std::cout<<"MassSpring system hessian norm is "<<sh.norm()<<std::endl;
 
         std::cout<<"Evaluating on SPARSE hessian takes: "<<sw.stop()/1000.<<"s"<< std::endl;
+
+        profiler.stop();
+        const std::string hessian = "MassSpringProblem2DSparse::eval_hessian";
+        std::cout<<"  building the triplets: "<<profiler.total_ms(hessian) - profiler.total_ms(hessian + "/set_from_triplets")<<"ms"
+                 <<", setFromTriplets: "<<profiler.total_ms(hessian + "/set_from_triplets")<<"ms"<<std::endl;
+        if(hardware_counters)
+            profiler.print_hardware_counters(std::cout);
     }
 
 
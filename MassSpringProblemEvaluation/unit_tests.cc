@@ -1,8 +1,15 @@
 #include <iostream>
+#include <mutex>
+#include <set>
+#include <thread>
 #include <Utils/StopWatch.hh>
 #include <MassSpringSystemT.hh>
 #include <Utils/RandomNumberGenerator.hh>
 #include <Utils/DerivativeChecker.hh>
+#include <Utils/OptimizationStatistic.hh>
+#include <Utils/MemoryFootprint.hh>
+#include <Utils/SparseFiniteDifferences.hh>
+#include <FunctionBase/FiniteDifferenceHessianWrapper.hh>
 
 #include "gtest/gtest.h"
 
@@ -218,6 +225,306 @@ TEST(MassSpringProblem, MassSpringProblem2DSparseCheckDerivative){
 
 
 
+/** Checks that the block diagonal of the sparse MSP matches the 2x2 diagonal
+ * blocks of its full Hessian, with and without constrained spring elements */
+TEST(MassSpringProblem, MassSpringProblem2DSparseBlockDiagonal){
+    typedef MassSpringProblem2DSparse::Vec Vec;
+    typedef MassSpringProblem2DSparse::SMat SMat;
+
+    for(int func_index : {0, 1}) {
+        AOPT::MassSpringSystemT<AOPT::MassSpringProblem2DSparse> mss(5, 7, func_index);
+        mss.add_constrained_spring_elements();
+        mss.add_constrained_spring_element_for_center_spring_node();
+        auto problem = mss.get_problem();
+        int n = problem->n_unknowns();
+
+        RandomNumberGenerator rng(-10, 10);
+        Vec x = rng.get_random_nd_vector(n);
+
+        SMat H;
+        problem->eval_hessian(x, H);
+        Vec blocks;
+        problem->eval_block_diagonal(x, blocks);
+
+        ASSERT_EQ(blocks.size(), 2 * n);
+        for(int i = 0; i < n / 2; ++i) {
+            ASSERT_NEAR(blocks[4*i],   H.coeff(2*i,   2*i),   1e-8);
+            ASSERT_NEAR(blocks[4*i+1], H.coeff(2*i,   2*i+1), 1e-8);
+            ASSERT_NEAR(blocks[4*i+2], H.coeff(2*i+1, 2*i),   1e-8);
+            ASSERT_NEAR(blocks[4*i+3], H.coeff(2*i+1, 2*i+1), 1e-8);
+        }
+    }
+}
+
+
+/** Checks that the block diagonal of the dense MSP matches the 2x2 diagonal
+ * blocks of its full Hessian */
+TEST(MassSpringProblem, MassSpringProblem2DDenseBlockDiagonal){
+    typedef MassSpringProblem2DDense::Vec Vec;
+    typedef MassSpringProblem2DDense::Mat Mat;
+
+    for(int func_index : {0, 1}) {
+        AOPT::MassSpringSystemT<AOPT::MassSpringProblem2DDense> mss(5, 7, func_index);
+        auto problem = mss.get_problem();
+        int n = problem->n_unknowns();
+
+        RandomNumberGenerator rng(-10, 10);
+        Vec x = rng.get_random_nd_vector(n);
+
+        Mat H;
+        problem->eval_hessian(x, H);
+        Vec blocks;
+        problem->eval_block_diagonal(x, blocks);
+
+        ASSERT_EQ(blocks.size(), 2 * n);
+        for(int i = 0; i < n / 2; ++i) {
+            ASSERT_NEAR(blocks[4*i],   H(2*i,   2*i),   1e-8);
+            ASSERT_NEAR(blocks[4*i+1], H(2*i,   2*i+1), 1e-8);
+            ASSERT_NEAR(blocks[4*i+2], H(2*i+1, 2*i),   1e-8);
+            ASSERT_NEAR(blocks[4*i+3], H(2*i+1, 2*i+1), 1e-8);
+        }
+    }
+}
+
+
+/** Checks the colorings on the hessian pattern of a mass spring system */
+TEST(SparseFiniteDifferences, Colorings){
+    typedef Eigen::SparseMatrix<double> SMat;
+
+    AOPT::MassSpringSystemT<AOPT::MassSpringProblem2DSparse> mss(10, 10, 1);
+    SMat P = mss.hessian_sparsity_pattern();
+    const int n = P.cols();
+
+    //column coloring: no two columns of a color share a row
+    std::vector<int> colors;
+    int n_colors = GraphColoring::column_coloring(P, colors);
+    Eigen::SparseMatrix<double, Eigen::RowMajor> rows = P;
+    for(int i = 0; i < n; ++i) {
+        std::vector<int> seen(n_colors, 0);
+        for(decltype(rows)::InnerIterator it(rows, i); it; ++it)
+            ASSERT_EQ(seen[colors[it.col()]]++, 0);
+    }
+
+    //star coloring: at least a distance-1 coloring
+    int n_star = GraphColoring::star_coloring(P, colors);
+    for(int j = 0; j < n; ++j)
+        for(SMat::InnerIterator it(P, j); it; ++it)
+            if(it.row() != j) {
+                ASSERT_NE(colors[it.row()], colors[j]);
+            }
+
+    std::cout << "n = " << n << ", #colors CPR: " << n_colors << ", star: " << n_star << std::endl;
+    ASSERT_LE(n_colors, 20);
+    ASSERT_LE(n_star, 20);
+}
+
+
+/** Compares the finite difference hessian (from gradients only) with the analytic one */
+TEST(SparseFiniteDifferences, HessianFromGradients){
+    typedef MassSpringProblem2DSparse::Vec Vec;
+    typedef MassSpringProblem2DSparse::SMat SMat;
+
+    for(int func_index : {0, 1}) {
+        AOPT::MassSpringSystemT<AOPT::MassSpringProblem2DSparse> mss(8, 6, func_index);
+        mss.add_constrained_spring_elements();
+        auto problem = mss.get_problem();
+        int n = problem->n_unknowns();
+
+        OptimizationStatistic counted(problem.get());
+        FiniteDifferenceHessianWrapper fd(counted, mss.hessian_sparsity_pattern());
+
+        RandomNumberGenerator rng(-10, 10);
+        Vec x = rng.get_random_nd_vector(n);
+
+        SMat H, H_fd;
+        problem->eval_hessian(x, H);
+        fd.eval_hessian(x, H_fd);
+
+        ASSERT_NEAR(SMat(H - H_fd).norm() / H.norm(), 0.0, 1e-7);
+        ASSERT_EQ(counted.n_eval_gradient(), 2 * fd.n_colors());
+        std::vector<int> colors;
+        ASSERT_LE(fd.n_colors(), GraphColoring::column_coloring(mss.hessian_sparsity_pattern(), colors));
+        ASSERT_LT(2 * fd.n_colors(), n);
+    }
+}
+
+
+/** Compares the finite difference Jacobian of the residuals with the analytic one */
+TEST(SparseFiniteDifferences, JacobianFromResiduals){
+    typedef MassSpringProblem2DLeastSquare::Vec Vec;
+    typedef MassSpringProblem2DLeastSquare::SMat SMat;
+
+    for(int func_index : {0, 1}) {
+        AOPT::MassSpringSystemT<AOPT::MassSpringProblem2DLeastSquare> mss(8, 6, func_index, true);
+        mss.add_constrained_spring_elements();
+        auto problem = mss.get_problem();
+
+        RandomNumberGenerator rng(-10, 10);
+        Vec x = rng.get_random_nd_vector(problem->n_unknowns());
+
+        SMat J, J_fd;
+        problem->eval_jacobian(x, J);
+
+        int n_evals(0);
+        for(bool central : {false, true}) {
+            SparseJacobianFD fd(J, central);
+            fd.eval([&](const Vec& _x, Vec& _r) { problem->eval_r(_x, _r); ++n_evals; }, x, J_fd);
+
+            ASSERT_NEAR(SMat(J - J_fd).norm() / J.norm(), 0.0, central ? 1e-9 : 1e-6);
+        }
+        std::cout << "#evaluations of r: " << n_evals << " for " << problem->n_unknowns() << " unknowns" << std::endl;
+    }
+}
+
+
+/** MassSpringProblem2DSparse with a wrong gradient or hessian entry */
+class MassSpringProblem2DSparseWithError : public MassSpringProblem2DSparse {
+public:
+    using MassSpringProblem2DSparse::MassSpringProblem2DSparse;
+
+    virtual void eval_gradient(const Vec &_x, Vec &_g) override {
+        MassSpringProblem2DSparse::eval_gradient(_x, _g);
+        if(gradient_error)
+            _g[7] += 1.;
+    }
+
+    virtual void eval_hessian(const Vec &_x, SMat &_h) override {
+        MassSpringProblem2DSparse::eval_hessian(_x, _h);
+        if(hessian_error)
+            _h.coeffRef(6, 7) += 1.;
+    }
+
+    bool gradient_error = false;
+    bool hessian_error = false;
+};
+
+
+/** The sparse checks pass on a problem with a large number of unknowns */
+TEST(DerivativeChecker, SparseChecksLargeProblem){
+    AOPT::MassSpringSystemT<AOPT::MassSpringProblem2DSparse> mss(150, 150, 1);
+    mss.add_constrained_spring_elements();
+    auto problem = mss.get_problem();
+
+    DerivativeChecker checker;
+    checker.config().x_min = -10;
+    checker.config().x_max = 10;
+    checker.config().relativeEps = 1e-6;
+    checker.config().n_threads = 4;
+    ASSERT_TRUE(checker.check_all_sparse(*problem));
+}
+
+
+/** The sparse checks find a wrong gradient component and a wrong hessian entry */
+TEST(DerivativeChecker, SparseChecksFindErrors){
+    AOPT::MassSpringSystemT<MassSpringProblem2DSparseWithError> mss(10, 10, 1);
+    auto problem = mss.get_problem();
+
+    DerivativeChecker checker;
+    checker.config().relativeEps = 1e-6;
+    checker.config().n_threads = 3;
+    ASSERT_TRUE(checker.check_all_sparse(*problem));
+
+    problem->gradient_error = true;
+    ASSERT_FALSE(checker.check_d1_directional(*problem).ok());
+    problem->gradient_error = false;
+
+    //the entry (6,7) is in the pattern, (7,6) is correct
+    problem->hessian_error = true;
+    ASSERT_FALSE(checker.check_d2_directional(*problem).ok());
+
+    MassSpringProblem2DSparse::SMat errors;
+    auto report = checker.check_d2_pattern(*problem, &errors);
+    ASSERT_EQ(report.n_errors, 1);
+    ASSERT_EQ(report.worst_row, 6);
+    ASSERT_EQ(report.worst_col, 7);
+    ASSERT_GT(errors.coeff(6, 7), 1e-3);
+    ASSERT_LT(errors.coeff(7, 6), 1e-6);
+}
+
+
+/** forwards to a problem and records the threads that evaluate it */
+class ThreadRecordingProblem : public FunctionBaseSparse {
+public:
+    explicit ThreadRecordingProblem(FunctionBaseSparse& _func) : func_(_func) {}
+
+    virtual int n_unknowns() override { return func_.n_unknowns(); }
+
+    virtual bool is_thread_safe() override { return func_.is_thread_safe(); }
+
+    virtual double eval_f(const Vec &_x) override {
+        record();
+        return func_.eval_f(_x);
+    }
+
+    virtual void eval_gradient(const Vec &_x, Vec &_g) override {
+        record();
+        func_.eval_gradient(_x, _g);
+    }
+
+    virtual void eval_hessian(const Vec &_x, SMat &_h) override {
+        record();
+        func_.eval_hessian(_x, _h);
+    }
+
+    std::set<std::thread::id> threads;
+
+private:
+    void record() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        threads.insert(std::this_thread::get_id());
+    }
+
+    FunctionBaseSparse& func_;
+    std::mutex mutex_;
+};
+
+
+/** MassSpringProblem2DSparse is checked in several threads, and as the probe directions
+ * do not depend on the threads, neither does the report */
+TEST(DerivativeChecker, SparseChecksIndependentOfThreads){
+    AOPT::MassSpringSystemT<MassSpringProblem2DSparseWithError> mss(10, 10, 1);
+    auto problem = mss.get_problem();
+    ASSERT_TRUE(problem->is_thread_safe());
+    problem->gradient_error = true;
+
+    DerivativeChecker::Report reports[2];
+    const int n_threads[2] = {1, 4};
+    for(int i = 0; i < 2; ++i) {
+        ThreadRecordingProblem recorded(*problem);
+        DerivativeChecker checker;
+        checker.config().relativeEps = 1e-6;
+        checker.config().n_threads = n_threads[i];
+        reports[i] = checker.check_d1_directional(recorded);
+        // one thread per chunk of probes, the first one is the calling thread
+        EXPECT_EQ(recorded.threads.size(), (size_t)n_threads[i]);
+    }
+
+    ASSERT_FALSE(reports[0].ok());
+    EXPECT_EQ(reports[0].n_errors, reports[1].n_errors);
+    EXPECT_EQ(reports[0].max_relative_error, reports[1].max_relative_error);
+    EXPECT_EQ(reports[0].worst_row, reports[1].worst_row);
+}
+
+
+/** The wrapped problem of a FiniteDifferenceHessianWrapper writes to its buffers, hence
+ * the sparse checks evaluate it in one thread only */
+TEST(DerivativeChecker, SparseChecksFiniteDifferenceHessian){
+    AOPT::MassSpringSystemT<AOPT::MassSpringProblem2DSparse> mss(10, 10, 1);
+    mss.add_constrained_spring_elements();
+    auto problem = mss.get_problem();
+
+    ThreadRecordingProblem recorded(*problem);
+    FiniteDifferenceHessianWrapper fd(recorded, mss.hessian_sparsity_pattern());
+    ASSERT_FALSE(fd.is_thread_safe());
+
+    DerivativeChecker checker;
+    checker.config().relativeEps = 1e-5;
+    checker.config().n_threads = 4;
+    ASSERT_TRUE(checker.check_all_sparse(fd));
+    EXPECT_EQ(recorded.threads.size(), 1u);
+}
+
+
 /** Compares your MSS's energy computation's results with ours */
 TEST(MassSpringSystem, EnergyComputation){
     int n_grid_x(20), n_grid_y(20);
@@ -242,6 +549,33 @@ TEST(MassSpringSystem, EnergyComputation){
 
 
 
+/** The dry run gives the exact hessian and triplet sizes, and the factor size within 15% */
+TEST(MassSpringSystem, EstimateMemory){
+    typedef MassSpringProblem2DSparse::SMat SMat;
+
+    for(int n_grid : {20, 31, 70}) {
+        const auto estimate = AOPT::MassSpringSystemT<AOPT::MassSpringProblem2DSparse>::estimate_memory(n_grid, n_grid);
+
+        AOPT::MassSpringSystemT<AOPT::MassSpringProblem2DSparse> mss(n_grid, n_grid, 2);
+        mss.add_constrained_spring_elements();
+        auto problem = mss.get_problem();
+        ASSERT_EQ(estimate.n_unknowns, problem->n_unknowns());
+
+        SMat H;
+        problem->eval_hessian(mss.get_spring_graph_points(), H);
+        EXPECT_EQ(estimate.hessian.nnz, H.nonZeros());
+        EXPECT_EQ(estimate.triplets.nnz, 16 * (std::int64_t)mss.n_edges() + 4 * 4);
+
+        Eigen::SimplicialLLT<SMat> llt(H);
+        const auto factor = AOPT::MemoryFootprint::of(llt);
+        EXPECT_NEAR(double(estimate.factor.nnz) / factor.nnz, 1., 0.15) << n_grid;
+        EXPECT_NEAR(double(estimate.factor.bytes) / factor.bytes, 1., 0.15) << n_grid;
+        EXPECT_EQ(estimate.lbfgs_history.bytes, 2 * 10 * 8 * estimate.n_unknowns);
+        EXPECT_GT(estimate.newton_bytes(), estimate.hessian.bytes + estimate.factor.bytes);
+    }
+}
+
+
 /** Runs the same problem in both Dense and Sparse form and checks that
  * the Sparse version is (much) faster than the Dense one, as expected */
 TEST(MassSpringSystem, DenseVersusSparseSpeedComparison){
@@ -18,6 +18,7 @@
 #include <Functions/CircleConstraintSquared2D.hh>
 #include <Functions/AreaConstraint2D.hh>
 
+#include <Utils/MemoryFootprint.hh>
 #include <Utils/RandomNumberGenerator.hh>
 
 #include <memory>
@@ -93,6 +94,18 @@ namespace AOPT {
 
         const std::vector<FunctionBaseSparse*>& get_constraints_squared() const;
 
+        //sparsity pattern of the hessian of the spring energy, known from the spring graph
+        SMat hessian_sparsity_pattern() const;
+
+        /** dry run: the memory a sparse system of this size takes in NewtonMethods::solve and
+         * LBFGS::solve, estimated without building it. The hessian and triplet sizes are
+         * exact, the size of the Cholesky factor is a fit to factorizations of such grids
+         * \param _n_constrained_springs number of constrained spring elements, 4 for the
+         *        first scenario of add_constrained_spring_elements()
+         * \param _lbfgs_m history size of LBFGS */
+        static MemoryFootprint::Estimate estimate_memory(const int _n_grid_x, const int _n_grid_y,
+                                                         const int _n_constrained_springs = 4, const int _lbfgs_m = 10);
+
 
     private:
         void setup_problem(const int _spring_element_type, const bool _least_square = false);
@@ -4,16 +4,19 @@
 
 #include <Algorithms/NewtonMethods.hh>
 #include <Utils/OptimizationStatistic.hh>
+#include <Utils/Profiler.hh>
 #include <Utils/RandomNumberGenerator.hh>
 #include <MassSpringSystemT.hh>
 
 
 
 int main(int _argc, const char* _argv[]) {
-    if(_argc != 7) {
-        std::cout << "Usage: input should be 'newton's method(0: standard newton, 1: projected hessian),"
+    if(_argc != 7 && _argc != 8) {
+        std::cout << "Usage: input should be 'newton's method(0: standard newton, 1: projected hessian,"
+                     " 3: dry run, prints the estimated memory of the solve without building the system),"
                      "function index(0: f without length, 1: f with length, 2: f with length with positive local hessian),"
-                     " number of grid in x, number of grid in y, max iteration, filename', e.g. "
+                     " number of grid in x, number of grid in y, max iteration, filename"
+                     " [, profile filename: writes the phases of the solve to profile.json, profile.csv and profile.trace.json]', e.g. "
                      "./NewtonMethods 0 0 2 2 10000 /usr/spring" << std::endl;
         return -1;
     }
@@ -28,6 +31,10 @@ int main(int _argc, const char* _argv[]) {
 
     std::string filename(_argv[6]);
 
+    if(newton_index == 3) {
+        AOPT::MassSpringSystemT<AOPT::MassSpringProblem2DSparse>::estimate_memory(n_grid_x, n_grid_y).print(std::cout);
+        return 0;
+    }
 
     //construct mass spring system
     AOPT::MassSpringSystemT<AOPT::MassSpringProblem2DSparse> mss(n_grid_x, n_grid_y, func_index);
@@ -53,6 +60,10 @@ int main(int _argc, const char* _argv[]) {
 
     AOPT::NewtonMethods::Vec x;
 
+    //profile the solve
+    if(_argc == 8)
+        AOPT::Profiler::instance().start(true);
+
     if(newton_index == 0 || newton_index == 2) {
         opt_st->start_recording();
         x = AOPT::NewtonMethods::solve(opt_st.get(), start_pts, 1e-4, max_iter);
@@ -63,6 +74,16 @@ int main(int _argc, const char* _argv[]) {
         opt_st->print_statistics();
     }
 
+    if(_argc == 8) {
+        auto& profiler = AOPT::Profiler::instance();
+        profiler.stop();
+        std::string profile(_argv[7]);
+        std::cout<<"Saving solver profile to "<<profile<<".json, .csv and .trace.json"<<std::endl;
+        if(profiler.save_json(profile + ".json") != 0 || profiler.save_csv(profile + ".csv") != 0
+           || profiler.save_chrome_trace(profile + ".trace.json") != 0)
+            return -1;
+    }
+
     //set points after optimization
     mss.set_spring_graph_points(x);
 
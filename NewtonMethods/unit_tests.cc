@@ -1,9 +1,19 @@
 #include <iostream>
+#include <sstream>
 #include <Functions/SpringElement2DWithLengthPSDHess.hh>
 #include <Functions/SpringElement2D.hh>
 #include <Functions/SpringElement2DWithLength.hh>
 #include <Functions/ConstrainedSpringElement2D.hh>
 #include <FunctionBase/DenseFunctionWrapper.hh>
+#include <Functions/MassSpringProblem2DSparse.hh>
+#include <Utils/MemoryFootprint.hh>
+#include <Utils/OptimizationStatistic.hh>
+#include <Utils/Profiler.hh>
+#include <Utils/RandomNumberGenerator.hh>
+#include <SpringGrid.hh>
+// counts the heap allocations of this test program
+#define AOPT_ALLOCATION_TRACKER_IMPLEMENTATION
+#include <Utils/AllocationTracker.hh>
 
 #include <Algorithms/NewtonMethods.hh>
 
@@ -254,6 +264,150 @@ TEST(ProjectedNewton, CheckAlgorithmOnNonConvexFunction){
 }
 
 
+/** a mass spring system without rest lengths is quadratic: its hessian is only
+ * evaluated once and the full Newton step reaches the minimum */
+TEST(StandardNewton, QuadraticProblemInOneStep){
+    using Vec = MassSpringProblem2DSparse::Vec;
+
+    SpringElement2D se;
+    MassSpringProblem2DSparse msp(se, 8);
+    msp.add_spring_element(0, 1, 1.);
+    msp.add_spring_element(1, 2, 2.);
+    msp.add_spring_element(2, 3, 1.);
+    msp.add_spring_element(3, 0, 3.);
+    msp.add_spring_element(0, 2, 1.);
+    msp.add_constrained_spring_element(0, 10., 0., 0.);
+    msp.add_constrained_spring_element(2, 10., 1., 1.);
+
+    OptimizationStatistic stat(&msp);
+    ASSERT_TRUE(stat.is_quadratic());
+
+    Vec start_pt(8);
+    start_pt << 5, -3, 2, 7, -1, 4, 0, 9;
+
+    Vec result = NewtonMethods::solve(&stat, start_pt, 1e-8);
+    EXPECT_EQ(stat.n_eval_hessian(), 1);
+    // one step and one check
+    EXPECT_EQ(stat.n_eval_gradient(), 2);
+
+    Vec g(8);
+    msp.eval_gradient(result, g);
+    EXPECT_NEAR(g.norm(), 0., 1e-10);
+
+    // same with the projected hessian
+    stat.start_recording();
+    Vec result_projected = NewtonMethods::solve_with_projected_hessian(&stat, start_pt, 10., 1e-8);
+    EXPECT_EQ(stat.n_eval_hessian(), 1);
+    EXPECT_NEAR((result_projected - result).norm(), 0., 1e-10);
+}
+
+
+/** Checks the scopes and counters of the projected newton method on a non-convex function */
+TEST(NewtonMethods, ProfileProjectedNewton){
+    using Vec = FunctionQuadraticNDSparse::Vec;
+
+    Vec start_pt(2);
+    start_pt << 2, 2;
+    FunctionNonConvex2DSparse func;
+
+    Profiler& profiler = Profiler::instance();
+    profiler.start();
+    NewtonMethods::solve_with_projected_hessian(&func, start_pt);
+    profiler.stop();
+
+    const std::string solve = "NewtonMethods::solve_with_projected_hessian";
+    EXPECT_EQ(profiler.calls(solve), 1);
+    const auto iterations = profiler.counter(solve, "iterations");
+    EXPECT_GT(iterations, 1);
+    EXPECT_EQ(profiler.calls(solve + "/eval_gradient"), iterations);
+    EXPECT_EQ(profiler.calls(solve + "/eval_hessian"), iterations);
+    // one factorization per hessian plus the retries with a shifted hessian
+    EXPECT_EQ(profiler.counter(solve, "factorizations"), profiler.calls(solve + "/factorization"));
+    EXPECT_EQ(profiler.calls(solve + "/factorization"), iterations + profiler.counter(solve, "psd_retries"));
+    EXPECT_GT(profiler.calls(solve + "/LineSearch::backtracking"), 0);
+}
+
+
+/** Once the hessian pattern is analyzed in the first iteration, the iterations of the Newton
+ * methods do not allocate, i.e. a solve of 6 iterations allocates as much as one of 3 */
+TEST(AllocationTracker, NewtonIterationsDoNotAllocate){
+    if(!AllocationTracker::tracks_malloc())
+        GTEST_SKIP() << "the allocations of Eigen are only counted with glibc";
+    const int n = 6;
+    SpringElement2DWithLengthPSDHess spring;
+    MassSpringProblem2DSparse problem(spring, 2 * n * n);
+    Eigen::VectorXd start;
+    setup_spring_grid(problem, n, start);
+
+    auto allocations = [&](const int _iters, const bool _projected) {
+        AllocationTracker::Scope scope;
+        if(_projected)
+            NewtonMethods::solve_with_projected_hessian(&problem, start, 10., 1e-12, _iters);
+        else
+            NewtonMethods::solve(&problem, start, 1e-12, _iters);
+        return scope.counts().allocations;
+    };
+
+    for(bool projected : {false, true}) {
+        // sets up the buffers of the problem
+        allocations(1, projected);
+        const auto a3 = allocations(3, projected);
+        EXPECT_GT(a3, 0u);
+        EXPECT_EQ(allocations(6, projected), a3) << (projected ? "projected hessian" : "newton");
+    }
+
+    // the profiler counts the allocations of its scopes
+    Profiler& profiler = Profiler::instance();
+    profiler.start();
+    NewtonMethods::solve(&problem, start, 1e-12, 6);
+    profiler.stop();
+    EXPECT_GT(profiler.allocations("NewtonMethods::solve").allocations, 0u);
+    EXPECT_EQ(profiler.allocations("NewtonMethods::solve/back_substitution").allocations, 0u);
+    std::stringstream json;
+    profiler.write_json(json);
+    EXPECT_NE(json.str().find("\"heap\": {\"allocations\": "), std::string::npos);
+}
+
+
+/** A Newton solve records the sizes of the hessian, its triplets and its factor */
+TEST(MemoryFootprint, NewtonSolve){
+    const int n = 9;
+    SpringElement2DWithLengthPSDHess spring;
+    MassSpringProblem2DSparse problem(spring, 2 * n * n);
+    Eigen::VectorXd start;
+    setup_spring_grid(problem, n, start);
+
+    FunctionBaseSparse::SMat H;
+    problem.eval_hessian(start, H);
+    Eigen::SimplicialLLT<FunctionBaseSparse::SMat> llt(H);
+
+    Profiler& profiler = Profiler::instance();
+    profiler.start();
+    NewtonMethods::solve(&problem, start, 1e-12, 3);
+    profiler.stop();
+
+    const std::string solve = "NewtonMethods::solve";
+    const auto hessian = profiler.memory(solve + "/eval_hessian", "hessian");
+    EXPECT_EQ(hessian.nnz, H.nonZeros());
+    EXPECT_GE(hessian.bytes, 12 * hessian.nnz);
+    EXPECT_EQ(hessian.peak_bytes, hessian.bytes);
+
+    // 16 per spring and 4 per constrained spring
+    const int n_springs = 2 * n * (n - 1) + (n - 1) * (n - 1);
+    const auto triplets = profiler.memory(solve + "/eval_hessian/MassSpringProblem2DSparse::eval_hessian/set_from_triplets",
+                                          "triplets");
+    EXPECT_EQ(triplets.nnz, 16 * n_springs + 2 * 4);
+    EXPECT_GE(triplets.bytes, triplets.nnz * (std::int64_t)sizeof(FunctionBaseSparse::T));
+
+    const auto factor = profiler.memory(solve + "/factorization", "factor");
+    EXPECT_EQ(factor.nnz, MemoryFootprint::of(llt).nnz);
+    EXPECT_EQ(profiler.memory(solve + "/factorization", "matrix").nnz, H.nonZeros());
+    // the fill of the factor on the lower triangle of H
+    const double fill = profiler.value(solve + "/factorization", "factor_fill");
+    EXPECT_GT(fill, 1.);
+    EXPECT_NEAR(fill, double(factor.nnz) / ((H.nonZeros() + H.rows()) / 2), 1e-12);
+}
+
 
 int main(int _argc, char** _argv){
 
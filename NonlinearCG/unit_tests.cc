@@ -0,0 +1,112 @@
+#include <iostream>
+
+#include <Utils/StopWatch.hh>
+#include <Utils/RandomNumberGenerator.hh>
+
+#include <Functions/FunctionQuadraticND.hh>
+#include <Functions/SpringElement2DWithLength.hh>
+#include <FunctionBase/ParametricFunctionWrapper.hh>
+
+#include <Algorithms/NonlinearConjugateGradient.hh>
+
+
+#include "gtest/gtest.h"
+
+
+using namespace AOPT;
+
+/** Those unit tests basically checks individual parts of your implementation.
+ * They generally work by either
+ * 1. comparing your results with ours
+ * 2. comparing your results with manually obtained ones
+ *    (when it's a simple problem solvable by hand)
+ *
+ * Feel free to modify the tests but ONLY to output intermediary values/results BUT
+ * do not modify it in any way that would change its result.
+ *
+ * For more details about googletest, please visit
+ * https://github.com/Macaulay2/googletest-1/blob/master/googletest/docs/Primer.md
+**/
+
+
+/** Checks that a stricter curvature constant is honoured by the strong Wolfe search */
+TEST(LineSearch, CheckStrongWolfeCurvatureConstant){
+    using Vec = FunctionQuadraticND::Vec;
+
+    FunctionQuadraticND func(10);
+
+    Vec x = Vec::Constant(10, 1.), g(10), gt(10);
+    func.eval_gradient(x, g);
+
+    for(double c2 : {0.9, 0.1}) {
+        double t = LineSearch::wolfe_line_search(&func, x, g, -g, 1e-4, 100., c2);
+        func.eval_gradient(x - t * g, gt);
+
+        ASSERT_LE(func.eval_f(x - t * g), func.eval_f(x) - 1e-4 * t * g.squaredNorm());
+        ASSERT_LE(std::abs(gt.dot(g)), c2 * g.squaredNorm());
+    }
+}
+
+
+/** Checks that all variants find the minimum of a quadratic problem */
+TEST(NonlinearConjugateGradient, SimpleQuadraticProblem){
+
+    const int dim(5);
+
+
+    FunctionQuadraticND::Mat A(dim, dim);
+    A <<    246.652,  107.143,  117.078, -125.157,  21.0117,
+            107.143,  244.831, -34.6749, -3.39497,  105.168,
+            117.078, -34.6749,  114.209, -57.6975,  14.9266,
+           -125.157, -3.39497, -57.6975,  129.647,   99.809,
+            21.0117,  105.168,  14.9266,   99.809,  222.531;
+
+    FunctionQuadraticND::Vec b(dim);
+    b << 0.832402, -9.81436,  9.98931, -9.74196,  6.84995;
+
+    FunctionQuadraticND func(A, b, 0.);
+
+    FunctionQuadraticND::Vec init_x(dim), expected_result(dim);
+    init_x << -1, 5, 4, 3, 5;
+    expected_result << 0.854001, -0.123255,  -0.33051,   1.18085, -0.560632;
+
+    for(auto variant : {NonlinearConjugateGradient::PR_PLUS, NonlinearConjugateGradient::HS,
+                        NonlinearConjugateGradient::DY, NonlinearConjugateGradient::HYBRID}) {
+        auto result = NonlinearConjugateGradient::solve(&func, init_x, 1e-6, 1000, variant);
+        ASSERT_LT((result - expected_result).norm(), 1e-5);
+    }
+}
+
+
+/** Checks that all variants bring a (nonconvex) spring element to rest length */
+TEST(NonlinearConjugateGradient, SpringElementWithLength){
+
+    using Vec = SpringElement2DWithLength::Vec;
+
+    SpringElement2DWithLength selw;
+    Vec coeffs(2);
+    coeffs<<1, 5;
+
+    ParametricFunctionWrapper<SpringElement2DWithLength> non_param_selw(selw, coeffs);
+
+
+    Vec start_pt(4);
+    start_pt << 10, 0, -10, 1;
+
+    for(auto variant : {NonlinearConjugateGradient::PR_PLUS, NonlinearConjugateGradient::HS,
+                        NonlinearConjugateGradient::DY, NonlinearConjugateGradient::HYBRID}) {
+        Vec result = NonlinearConjugateGradient::solve(&non_param_selw, start_pt, 1e-6, 1000, variant);
+
+        //The energy should be 0 at rest length
+        ASSERT_NEAR(non_param_selw.eval_f(result), 0, 1e-10);
+    }
+}
+
+
+
+int main(int _argc, char** _argv){
+
+    testing::InitGoogleTest(&_argc, _argv);
+    return RUN_ALL_TESTS();
+
+}
@@ -0,0 +1,178 @@
+#include <iostream>
+#include <cmath>
+#include <sstream>
+#include <Utils/Profiler.hh>
+#include <Utils/PerfCounters.hh>
+
+#include "gtest/gtest.h"
+
+
+using namespace AOPT;
+
+
+/** Checks the tree of scopes, the counters and that nothing is recorded when the profiler is off */
+TEST(Profiler, NestedScopesAndCounters){
+    Profiler& profiler = Profiler::instance();
+    profiler.start();
+    for(int i = 0; i < 3; ++i) {
+        AOPT_PROFILE_SCOPE("outer");
+        AOPT_PROFILE_COUNT("iterations");
+        {
+            AOPT_PROFILE_SCOPE("inner");
+            AOPT_PROFILE_COUNT_N("items", 2);
+        }
+        AOPT_PROFILE_SCOPE("inner");
+    }
+    profiler.stop();
+
+    {
+        // ignored
+        AOPT_PROFILE_SCOPE("outer");
+        AOPT_PROFILE_COUNT("iterations");
+    }
+
+    EXPECT_EQ(profiler.calls("outer"), 3);
+    EXPECT_EQ(profiler.calls("outer/inner"), 6);
+    EXPECT_EQ(profiler.calls("inner"), 0);
+    EXPECT_EQ(profiler.counter("outer", "iterations"), 3);
+    EXPECT_EQ(profiler.counter("outer/inner", "items"), 6);
+    EXPECT_GE(profiler.total_ms("outer"), profiler.total_ms("outer/inner"));
+
+    std::stringstream csv;
+    profiler.write_csv(csv);
+    EXPECT_NE(csv.str().find("outer/inner,calls,6\n"), std::string::npos);
+    EXPECT_NE(csv.str().find("outer,iterations,3\n"), std::string::npos);
+}
+
+
+/** Checks the scopes in the json output and the timeline of the trace */
+TEST(Profiler, JsonAndTrace){
+    Profiler& profiler = Profiler::instance();
+    profiler.start(true);
+    {
+        AOPT_PROFILE_SCOPE("solve");
+        for(int i = 0; i < 4; ++i) {
+            AOPT_PROFILE_COUNT("iterations");
+            AOPT_PROFILE_SCOPE("factorization");
+        }
+    }
+    profiler.stop();
+
+    std::stringstream json, trace;
+    profiler.write_json(json);
+    EXPECT_NE(json.str().find("{\"name\": \"factorization\", \"calls\": 4"), std::string::npos);
+    profiler.write_chrome_trace(trace);
+    EXPECT_NE(trace.str().find("\"name\": \"factorization\", \"cat\": \"aopt\", \"ph\": \"X\""), std::string::npos);
+    EXPECT_NE(trace.str().find("\"name\": \"solve/iterations\", \"cat\": \"aopt\", \"ph\": \"C\""), std::string::npos);
+    EXPECT_EQ(profiler.n_dropped_events(), 0u);
+}
+
+
+/** The hardware counters are either counted or reported as not available, e.g. inside a container */
+TEST(PerfCounters, CountsOrDegrades){
+    PerfCounters perf;
+    PerfCounters::Values before, after;
+    if(!perf.available()) {
+        std::cerr << "hardware counters not available: " << perf.error() << std::endl;
+        EXPECT_FALSE(perf.error().empty());
+        EXPECT_FALSE(perf.read(before));
+        EXPECT_EQ(before.mask, 0u);
+        EXPECT_TRUE(std::isnan(before.ipc()));
+        return;
+    }
+
+    ASSERT_TRUE(perf.read(before));
+    volatile double sum = 0.;
+    for(int i = 0; i < 1000000; ++i)
+        sum = sum + 1e-3 * i;
+    ASSERT_TRUE(perf.read(after));
+
+    const PerfCounters::Values d = after - before;
+    if(d.has(PerfCounters::INSTRUCTIONS)) {
+        EXPECT_GT(d[PerfCounters::INSTRUCTIONS], 1e6);
+    }
+    if(d.has(PerfCounters::CYCLES)) {
+        EXPECT_GT(d[PerfCounters::CYCLES], 0.);
+    }
+}
+
+
+TEST(PerfCounters, RatesAndPrint){
+    PerfCounters::Values v;
+    v.counts = {{1000., 1500., 100., 25., 200., 4.}};
+    v.mask = (1u << PerfCounters::N_EVENTS) - 1;
+    EXPECT_DOUBLE_EQ(v.ipc(), 1.5);
+    EXPECT_DOUBLE_EQ(v.llc_miss_rate(), 0.25);
+    EXPECT_DOUBLE_EQ(v.llc_mpki(), 1000. * 25. / 1500.);
+    EXPECT_DOUBLE_EQ(v.branch_miss_rate(), 0.02);
+
+    std::stringstream ss;
+    v.print(ss);
+    EXPECT_EQ(ss.str(), "IPC 1.50, LLC misses 25.00 % (16.67 per 1k instr.), branch misses 2.00 %");
+
+    // without the cache events
+    v.mask &= ~(1u << PerfCounters::LLC_MISSES);
+    ss.str("");
+    v.print(ss);
+    EXPECT_EQ(ss.str(), "IPC 1.50, LLC misses n/a (n/a per 1k instr.), branch misses 2.00 %");
+}
+
+
+/** the profiler times the scopes whether the hardware counters are available or not */
+TEST(Profiler, HardwareCounters){
+    Profiler& profiler = Profiler::instance();
+    const bool available = profiler.enable_hardware_counters();
+    EXPECT_EQ(profiler.has_hardware_counters(), available);
+    profiler.start();
+    {
+        AOPT_PROFILE_SCOPE("solve");
+        volatile double sum = 0.;
+        for(int i = 0; i < 100000; ++i)
+            sum = sum + 1e-3 * i;
+    }
+    profiler.stop();
+    profiler.enable_hardware_counters(false);
+
+    EXPECT_EQ(profiler.calls("solve"), 1);
+    const PerfCounters::Values counts = profiler.hardware_counters("solve");
+    if(available) {
+        EXPECT_NE(counts.mask, 0u);
+    } else {
+        EXPECT_EQ(counts.mask, 0u);
+    }
+
+    std::stringstream ss;
+    profiler.print_hardware_counters(ss);
+    EXPECT_EQ(ss.str().find("solve: IPC "), 0u);
+}
+
+
+/** Checks the current and peak sizes and the values recorded in the scopes */
+TEST(Profiler, MemoryRecords){
+    Profiler& profiler = Profiler::instance();
+    profiler.start();
+    {
+        AOPT_PROFILE_SCOPE("solve");
+        profiler.record_memory("buffer", 100, 10);
+        profiler.record_memory("buffer", 40, 4);
+        AOPT_PROFILE_VALUE("fill", 2.5);
+    }
+    profiler.record_memory("input", 8);
+    profiler.stop();
+
+    EXPECT_EQ(profiler.memory("solve", "buffer").bytes, 40);
+    EXPECT_EQ(profiler.memory("solve", "buffer").peak_bytes, 100);
+    EXPECT_EQ(profiler.memory("solve", "buffer").nnz, 4);
+    EXPECT_EQ(profiler.memory("solve", "other").peak_bytes, 0);
+    EXPECT_EQ(profiler.value("solve", "fill"), 2.5);
+
+    std::stringstream json, csv;
+    profiler.write_json(json);
+    EXPECT_NE(json.str().find("\"memory\": {\"buffer\": {\"bytes\": 40, \"peak_bytes\": 100, \"nnz\": 4}}, \"values\": {\"fill\": 2.5}"),
+              std::string::npos);
+    EXPECT_NE(json.str().find("\"memory\": {\"input\": {\"bytes\": 8"), std::string::npos);
+    profiler.write_csv(csv);
+    EXPECT_NE(csv.str().find("solve,buffer_peak_bytes,100\n"), std::string::npos);
+    EXPECT_NE(csv.str().find("solve,fill,2.5\n"), std::string::npos);
+    EXPECT_NE(csv.str().find("total,input_bytes,8\n"), std::string::npos);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cmath>
+#include <Functions/MassSpringProblem2DSparse.hh>
+#include <Utils/RandomNumberGenerator.hh>
+
+//== NAMESPACES ===============================================================
+
+namespace AOPT {
+
+    /** a grid of _n x _n nodes connected by springs with rest length, with two pinned
+     * corners, to check the allocations and the memory of the solvers in the unit tests.
+     * Unlike MassSpringSystemT, it does not need the MassSpringSystem library.
+     * Node (i, j) has the index i _n + j. The start point is the grid with random
+     * displacements of the nodes.
+     * \param _problem a problem with 2 _n^2 unknowns and no elements yet
+     * \param _start output, the start point */
+    inline void setup_spring_grid(MassSpringProblem2DSparse& _problem, const int _n, Eigen::VectorXd& _start) {
+        auto node = [_n](const int _i, const int _j) { return _i * _n + _j; };
+        for(int i = 0; i < _n; ++i)
+            for(int j = 0; j < _n; ++j) {
+                if(i + 1 < _n)
+                    _problem.add_spring_element(node(i, j), node(i + 1, j), 1., 1.);
+                if(j + 1 < _n)
+                    _problem.add_spring_element(node(i, j), node(i, j + 1), 1., 1.);
+                if(i + 1 < _n && j + 1 < _n)
+                    _problem.add_spring_element(node(i, j), node(i + 1, j + 1), 1., std::sqrt(2.));
+            }
+        _problem.add_constrained_spring_element(node(0, 0), 100., 0., 0.);
+        _problem.add_constrained_spring_element(node(_n - 1, _n - 1), 100., _n - 1., _n - 1.);
+
+        RandomNumberGenerator rng(-0.3, 0.3);
+        _start = rng.get_random_nd_vector(2 * _n * _n);
+        for(int i = 0; i < _n; ++i)
+            for(int j = 0; j < _n; ++j) {
+                _start[2 * node(i, j)] += i;
+                _start[2 * node(i, j) + 1] += j;
+            }
+    }
+
+//=============================================================================
+}
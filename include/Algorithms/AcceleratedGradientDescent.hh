@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cmath>
+#include <FunctionBase/FunctionBaseSparse.hh>
+#include <Utils/MemoryFootprint.hh>
+#include <Utils/Profiler.hh>
+
+//== NAMESPACES ===============================================================
+
+namespace AOPT {
+
+    /* Nesterov's accelerated gradient method (in its FISTA form for smooth problems)
+     * with adaptive restart, see O'Donoghue and Candes, "Adaptive restart for
+     * accelerated gradient schemes", 2015.
+     *
+     * The step 1/L is found by back-tracking on the Lipschitz estimate L, which is
+     * also allowed to shrink again so that it adapts to the local curvature.
+     * Momentum is reset whenever it stops helping, which recovers the fast linear
+     * convergence of gradient descent on strongly convex problems while keeping the
+     * acceleration. Like GradientDescent, it works with any Problem with a
+     * FunctionBase-style interface. */
+    class AcceleratedGradientDescent {
+    public:
+        typedef FunctionBaseSparse::Vec Vec; ///< Eigen::VectorXd
+
+        enum Restart {
+            NO_RESTART,        ///< plain Nesterov momentum
+            FUNCTION_RESTART,  ///< restart if f(x_k+1) > f(x_k)
+            GRADIENT_RESTART   ///< restart if g(y_k)^T (x_k+1 - x_k) > 0
+        };
+
+        /**
+         * \param _problem a pointer to a specific Problem, which can be any type that
+         *        has the same interface as FunctionBase's (i.e. with eval_f, eval_gradient, etc.)
+         * \param _initial_x  the x starting point
+         * \param _eps the stopping criterion on the gradient norm
+         * \param _max_iters maximum number of iterations
+         * \param _restart adaptive restart scheme of the momentum
+         * \param _L0 initial estimate of the Lipschitz constant of the gradient
+         *
+         * \return the minimum found by the method. */
+        template <class Problem>
+        static Vec solve(Problem *_problem, const Vec& _initial_x, const double _eps = 1e-4, const int _max_iters = 1000000,
+                         const Restart _restart = GRADIENT_RESTART, const double _L0 = 1.) {
+            std::cout << "******** Accelerated Gradient Descent ********" << std::endl;
+            AOPT_PROFILE_SCOPE("AcceleratedGradientDescent::solve");
+
+            // squared epsilon for stopping criterion
+            double e2 = _eps * _eps;
+
+            // current iterate x, extrapolated point y and the new iterate
+            Vec x = _initial_x, y = _initial_x, x_new(x.size());
+
+            // allocate gradient storage
+            Vec g(_problem->n_unknowns());
+            AOPT_PROFILE_MEMORY("vectors", MemoryFootprint::of(x) + MemoryFootprint::of(y) + MemoryFootprint::of(x_new)
+                                           + MemoryFootprint::of(g));
+
+            double fx = _problem->eval_f(x);
+            double L = _L0;
+            // momentum parameter
+            double theta = 1.;
+            int iter(0), n_restarts(0);
+
+            do {
+                ++iter;
+                double fy = _problem->eval_f(y);
+                _problem->eval_gradient(y, g);
+
+                double g2 = g.squaredNorm();
+
+                // print status
+                std::cout << "iter: " << iter <<
+                          "   obj = " << fy <<
+                          "   ||g||^2 = " << g2 << std::endl;
+
+                if (g2 <= e2) {
+                    x = y;
+                    break;
+                }
+
+                // back-tracking on L until the gradient step gives sufficient decrease,
+                // f(y - g/L) <= f(y) - ||g||^2 / (2L)
+                L *= 0.9;
+                double f_new;
+                int i(0);
+                do {
+                    x_new = y - g / L;
+                    f_new = _problem->eval_f(x_new);
+                    if (f_new <= fy - 0.5 * g2 / L)
+                        break;
+                    L *= 2.;
+                } while (++i < 100);
+
+                if (i == 100) {
+                    std::cout << "The step length is too small!" << std::endl;
+                    if (fy < fx)
+                        x = y;
+                    break;
+                }
+
+                // adaptive restart
+                bool restart(false);
+                if (_restart == FUNCTION_RESTART)
+                    restart = f_new > fx;
+                else if (_restart == GRADIENT_RESTART)
+                    restart = g.dot(x_new - x) > 0;
+
+                if (restart) {
+                    ++n_restarts;
+                    theta = 1.;
+                    y = x_new;
+                } else {
+                    double theta_new = 0.5 * (1. + std::sqrt(1. + 4. * theta * theta));
+                    y = x_new + ((theta - 1.) / theta_new) * (x_new - x);
+                    theta = theta_new;
+                }
+
+                x = x_new;
+                fx = f_new;
+
+            } while (iter < _max_iters);
+
+            std::cout << "number of restarts: " << n_restarts << std::endl;
+
+            return x;
+        }
+    };
+}
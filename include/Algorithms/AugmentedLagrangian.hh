@@ -3,6 +3,7 @@
 #include <FunctionBase/FunctionBaseSparse.hh>
 #include <Functions/AugmentedLagrangianProblem.hh>
 #include <Utils/OptimizationStatistic.hh>
+#include <Utils/Profiler.hh>
 #include <Algorithms/NewtonMethods.hh>
 #include "LBFGS.hh"
 
@@ -20,6 +21,7 @@ namespace AOPT {
         static Vec solve(FunctionBaseSparse *_obj, const Vec& _initial_x, const std::vector<FunctionBaseSparse*>& _constraints, const std::vector<FunctionBaseSparse*>& _squared_constraints,
                 const double _eta = 1e-4, const double _tau = 1e-4, const int _max_iters = 20) {
             std::cout << "******** Augmented Lagrangian ********" << std::endl;
+            AOPT_PROFILE_SCOPE("AugmentedLagrangian::solve");
 
             double mu = 10,
             tau = 1./mu,
@@ -57,6 +59,7 @@ namespace AOPT {
             int iter(0);
             do {
                 std::cerr<<"\n---------->Augmented Lagrangian iter: "<<iter<<std::endl;
+                AOPT_PROFILE_COUNT("outer_iterations");
                 //approximate x
                 x = NewtonMethods::solve_with_projected_hessian(opt_st.get(), converged, x, 10., std::max(tau*tau, tau2), 1000);
 
@@ -68,6 +71,7 @@ namespace AOPT {
                 if(!converged || hnorm > hnormp) {
                     std::cerr<<"\nDiverged! Restore to previous x.";
                     x = x_p;
+                    AOPT_PROFILE_COUNT("restores");
                 }
 
                 std::cerr<<"\ngradient norm: "<<g.norm()<<"constraint violation: "<<hnorm
@@ -77,10 +81,12 @@ namespace AOPT {
                     if(hnorm <= _eta && g.norm() <= _tau)
                         break;
 
+                    AOPT_PROFILE_COUNT("multiplier_updates");
                     nu += mu*h;
                     eta /= std::pow(mu, 0.9);
                     tau /= mu;
                 } else {
+                    AOPT_PROFILE_COUNT("penalty_increases");
                     mu *= 100;
                     eta = std::pow(mu, -0.1);
                     tau = 1./mu;
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cmath>
+#include <deque>
+#include <algorithm>
+#include <FunctionBase/FunctionBaseSparse.hh>
+#include <Utils/MemoryFootprint.hh>
+#include <Utils/Profiler.hh>
+#include "LineSearch.hh"
+
+//== NAMESPACES ===============================================================
+
+namespace AOPT {
+
+    /* Gradient descent with Barzilai-Borwein step sizes.
+     * The step t = s^Ts/s^Ty (BB1) or t = s^Ty/y^Ty (BB2) uses the curvature seen
+     * along the last step, with s = x_k+1 - x_k and y = g_k+1 - g_k. These steps
+     * do not decrease f monotonically, so they are safeguarded by a nonmonotone
+     * line search which compares against
+     * - the maximum of the last M function values (Grippo, Lampariello, Lucidi), or
+     * - a weighted average C_k of all function values (Zhang and Hager), with
+     *   C_k+1 = (eta Q_k C_k + f_k+1) / Q_k+1 and Q_k+1 = eta Q_k + 1.
+     * Like GradientDescent, it works with any Problem with a FunctionBase-style interface. */
+    class BarzilaiBorwein {
+    public:
+        typedef FunctionBaseSparse::Vec Vec; ///< Eigen::VectorXd
+
+        enum StepSize {
+            BB1,            ///< t = s^Ts / s^Ty
+            BB2,            ///< t = s^Ty / y^Ty
+            ALTERNATING     ///< BB1 at odd, BB2 at even iterations
+        };
+
+        enum Reference {
+            GRIPPO,         ///< max of the last _memory function values
+            ZHANG_HAGER     ///< weighted average with factor _eta
+        };
+
+        /**
+         * \param _problem a pointer to a specific Problem, which can be any type that
+         *        has the same interface as FunctionBase's (i.e. with eval_f, eval_gradient, etc.)
+         * \param _initial_x  the x starting point
+         * \param _eps the stopping criterion on the gradient norm
+         * \param _max_iters maximum number of iterations
+         * \param _step Barzilai-Borwein step size variant
+         * \param _reference reference value of the nonmonotone line search
+         * \param _memory number of function values for GRIPPO
+         * \param _eta averaging factor in [0, 1] for ZHANG_HAGER, 0 gives a monotone search
+         *
+         * \return the minimum found by the method. */
+        template <class Problem>
+        static Vec solve(Problem *_problem, const Vec& _initial_x, const double _eps = 1e-4, const int _max_iters = 1000000,
+                         const StepSize _step = ALTERNATING, const Reference _reference = ZHANG_HAGER,
+                         const int _memory = 10, const double _eta = 0.85) {
+            std::cout << "******** Barzilai-Borwein Gradient Descent ********" << std::endl;
+            AOPT_PROFILE_SCOPE("BarzilaiBorwein::solve");
+
+            // squared epsilon for stopping criterion
+            double e2 = _eps * _eps;
+
+            // safeguards of the step size
+            const double t_min = 1e-10, t_max = 1e10;
+
+            int n = _problem->n_unknowns();
+            Vec x = _initial_x, g(n), x_new(n), g_new(n), s(n), y(n);
+            AOPT_PROFILE_MEMORY("vectors", MemoryFootprint::of(x) + MemoryFootprint::of(g) + MemoryFootprint::of(x_new)
+                                           + MemoryFootprint::of(g_new) + MemoryFootprint::of(s) + MemoryFootprint::of(y));
+
+            double f = _problem->eval_f(x);
+            _problem->eval_gradient(x, g);
+
+            // reference values of the nonmonotone line search
+            std::deque<double> f_hist(1, f);
+            double C = f, Q = 1.;
+
+            // first step of unit length
+            double t_bb = std::min(1., 1. / std::max(g.norm(), 1e-16));
+
+            int iter(0);
+            do {
+                ++iter;
+                double g2 = g.squaredNorm();
+
+                // print status
+                std::cout << "iter: " << iter <<
+                          "   obj = " << f <<
+                          "   ||g||^2 = " << g2 << std::endl;
+
+                if (g2 <= e2)
+                    break;
+
+                double f_ref = _reference == GRIPPO ? *std::max_element(f_hist.begin(), f_hist.end()) : C;
+
+                double t = LineSearch::nonmonotone_backtracking_line_search(_problem, x, g, -g, f_ref, t_bb);
+
+                if (t < 1e-16) {
+                    std::cout << "The step length is too small!" << std::endl;
+                    break;
+                }
+
+                x_new = x - t * g;
+                double f_new = _problem->eval_f(x_new);
+                _problem->eval_gradient(x_new, g_new);
+
+                s = x_new - x;
+                y = g_new - g;
+
+                // new step size, fall back to the largest one without positive curvature
+                double sy = s.dot(y);
+                if (sy <= 0)
+                    t_bb = t_max;
+                else {
+                    bool bb1 = _step == BB1 || (_step == ALTERNATING && iter % 2 == 1);
+                    t_bb = bb1 ? s.squaredNorm() / sy : sy / y.squaredNorm();
+                }
+                t_bb = std::min(std::max(t_bb, t_min), t_max);
+
+                // update the reference values
+                f_hist.push_back(f_new);
+                if ((int)f_hist.size() > _memory)
+                    f_hist.pop_front();
+
+                double Q_new = _eta * Q + 1.;
+                C = (_eta * Q * C + f_new) / Q_new;
+                Q = Q_new;
+
+                x.swap(x_new);
+                g.swap(g_new);
+                f = f_new;
+
+            } while (iter < _max_iters);
+
+            return x;
+        }
+    };
+}
@@ -2,6 +2,15 @@
 
 #include <Utils/RandomNumberGenerator.hh>
 #include <FunctionBase/FunctionBase.hh>
+#include <FunctionBase/FunctionBaseSparse.hh>
+#include <Utils/LanczosEigenSolver.hh>
+#include <Utils/ParallelFor.hh>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <utility>
 
 //== NAMESPACES ===================================================================
 
@@ -20,63 +29,336 @@ namespace AOPT {
 
     public:
 
+        /// how the pairs of points are sampled
+        enum Sampling {
+            RANDOM, ///< independent uniform random points
+            HALTON  ///< a low-discrepancy Halton sequence of the pairs, seen as points of dimension 2n
+        };
+
+        /// the first pair of points, in sampling order, that violates the convexity property
+        struct Violation {
+            std::uint64_t pair = 0; ///< index of the pair in the sampling sequence
+            double t = 0.;          ///< the violation is at p(t) = (1 - t) * p1 + t * p2
+            Vec p1, p2;
+        };
+
+        /// a point where the hessian has a negative eigenvalue
+        struct CurvatureViolation {
+            std::uint64_t sample = 0; ///< index of the point in the sampling sequence
+            double lambda = 0.;       ///< d^T H(x) d, smallest eigenvalue found
+            Vec x, d;                 ///< the point and a unit direction of negative curvature
+        };
+
+        /// result of certifyConvexity()
+        enum Certificate {
+            CONVEX,     ///< the hessian is proven positive semi-definite on the whole box
+            NOT_CONVEX, ///< the hessian is proven to have a negative eigenvalue somewhere in the box
+            UNKNOWN     ///< no bounds of the hessian, or too many boxes were needed
+        };
+
         /** Checks whether the function given as argument is convex or not.
          * If it is not, it should output a point not satisfying the convexity property
          * before returning false.
+         * The pairs are checked in parallel. The i-th pair only depends on i and _seed,
+         * and the violation reported is the one of the first pair that violates the
+         * property, so the result does not depend on the number of threads.
+         * The points of a path are evaluated at once with eval_f_batch(), from several
+         * threads only if the function is_thread_safe().
          * \param _function a function pointer that should be any class inheriting
          * from FunctionBase, e.g. FunctionQuadraticND
          * \param min the minimum value of all tested points' coordinate
          * \param max the maximum value of all tested points' coordinate
          * \param n_evals the number of evaluations/samples tested on the
-         *        line between the two points on the function */
-        static bool isConvex(FunctionBase* _function, const double min = -1000., const double max = 1000., const int n_evals = 10) {
+         *        line between the two points on the function
+         * \param _sampling how the pairs of points are generated
+         * \param _n_threads number of threads, 0 uses all hardware threads, 1 is used if the
+         *        function is not thread safe
+         * \param _seed seed of the sampling sequence
+         * \param _violation if not null and the function is not convex, the violation found */
+        static bool isConvex(FunctionBase* _function, const double min = -1000., const double max = 1000., const int n_evals = 10,
+                             const Sampling _sampling = RANDOM, const int _n_threads = 0, const std::uint64_t _seed = 0,
+                             Violation* _violation = nullptr) {
             const int n = _function->n_unknowns();
             //randomly generate number from min to max
-            RandomNumberGenerator rng(min, max);
-            
-            const int max_sampling_points(1000000);
+            const CounterRandomNumberGenerator rng(min, max, _seed);
+            const HaltonSequence halton(_sampling == HALTON ? 2 * n : 0, min, max, _seed);
+
+            const std::uint64_t max_sampling_points(1000000);
+            const std::uint64_t chunk_size(1024);
 
             //------------------------------------------------------//
             //Todo: Add your code here
-            int count = 0;
-            double delta = 1.0 / n_evals;
-            while (count < max_sampling_points) {
-                // generate a pair of points
-                Vec p1 = rng.get_random_nd_vector(n);
-                Vec p2 = rng.get_random_nd_vector(n);
+            const int n_threads = !_function->is_thread_safe() ? 1 : _n_threads > 0 ? _n_threads : default_n_threads();
 
-                // evaluate the function along the convex combination of p1 and p2
-                double f1 = _function->eval_f(p1);
-                double f2 = _function->eval_f(p2);
+            // the pair _k of the sampling sequence
+            auto sample = [&](const std::uint64_t _k, Vec& _p1, Vec& _p2) {
+                if (_sampling == HALTON) {
+                    halton.get_nd_vector(_k, _p1, 0);
+                    halton.get_nd_vector(_k, _p2, n);
+                } else {
+                    rng.get_random_nd_vector(_k, _p1, 0);
+                    rng.get_random_nd_vector(_k, _p2, n);
+                }
+            };
 
+            // the first t on the path between _p1 and _p2 violating the property, or 0.
+            // The points of the path, ends included, are the columns of _P
+            auto check_path = [&](const Vec& _p1, const Vec& _p2, Mat& _P, Vec& _fP, Vec& _p, double& _fp, double& _sp) {
+                _P.col(0) = _p1;
                 for (int i = 1; i < n_evals; i++) {
+                    const double t = double(i) / n_evals;
+                    _P.col(i) = (1.0 - t) * _p1 + t * _p2;
+                }
+                _P.col(n_evals) = _p2;
+                _function->eval_f_batch(_P, _fP);
 
-                    double t = delta * i;
-
-                    Vec p = (1.0 - t) * p1 + t * p2;
-                    double fp = _function->eval_f(p);
-                    double sp = (1.0 - t) * f1 + t * f2;
+                for (int i = 1; i < n_evals; i++) {
+                    const double t = double(i) / n_evals;
 
                     // check that the function f(p) <= (1 - t)*f(p1) + t*f(p2)
-                    if (fp > sp) {
-                        std::cout << "Function non convexity detected: f(p) = " << fp
-                                  << " > (1 - t)*f(p1) + t*f(p2) = " << sp << ". Difference is: "<<fp-sp<<"\n";
-                        printPathInfo(p1, p2, p, t);
-                        return false;
+                    _fp = _fP[i];
+                    _sp = (1.0 - t) * _fP[0] + t * _fP[n_evals];
+                    if (_fp > _sp) {
+                        _p = _P.col(i);
+                        return t;
                     }
                 }
+                return 0.;
+            };
 
-                count++;
+            // per thread buffers
+            std::vector<Vec> p1(n_threads, Vec(n)), p2(n_threads, Vec(n)), p(n_threads, Vec(n)), fP(n_threads);
+            std::vector<Mat> P(n_threads, Mat(n, n_evals + 1));
 
-                if(count % 100000 == 0) {
-                    std::cout<<"Processed "<<count<<" pairs of points ..."<<std::endl;
+            // the index of the first violating pair found so far, the threads stop at it
+            std::atomic<std::uint64_t> first_violation(max_sampling_points);
+            std::atomic<std::uint64_t> count(0);
+
+            const std::uint64_t n_chunks = (max_sampling_points + chunk_size - 1) / chunk_size;
+            parallel_for_chunks(n_chunks, [&](const std::uint64_t _c, const int _t) {
+                const std::uint64_t begin = _c * chunk_size;
+                const std::uint64_t end = std::min(begin + chunk_size, max_sampling_points);
+                double fp, sp;
+                for (std::uint64_t k = begin; k < end; ++k) {
+                    if (k >= first_violation.load(std::memory_order_relaxed))
+                        return;
+
+                    sample(k, p1[_t], p2[_t]);
+                    if (check_path(p1[_t], p2[_t], P[_t], fP[_t], p[_t], fp, sp) > 0.) {
+                        std::uint64_t first = first_violation.load();
+                        while (k < first && !first_violation.compare_exchange_weak(first, k)) {}
+                        return;
+                    }
+                }
+
+                const std::uint64_t old_count = count.fetch_add(end - begin);
+                if (old_count / 100000 != (old_count + end - begin) / 100000)
+                    std::cout << "Processed " << (old_count + end - begin) / 100000 * 100000 << " pairs of points ..." << std::endl;
+            }, n_threads);
+
+            if (first_violation.load() < max_sampling_points) {
+                // the samples only depend on the pair index, recompute the violation
+                double fp, sp;
+                sample(first_violation.load(), p1[0], p2[0]);
+                const double t = check_path(p1[0], p2[0], P[0], fP[0], p[0], fp, sp);
+                std::cout << "Function non convexity detected: f(p) = " << fp
+                          << " > (1 - t)*f(p1) + t*f(p2) = " << sp << ". Difference is: " << fp - sp << "\n";
+                printPathInfo(p1[0], p2[0], p[0], t);
+                if (_violation != nullptr) {
+                    _violation->pair = first_violation.load();
+                    _violation->t = t;
+                    _violation->p1 = p1[0];
+                    _violation->p2 = p2[0];
                 }
+                return false;
             }
             //------------------------------------------------------//
             return true;
         }
 
 
+        /** Checks the convexity of a twice differentiable function with its hessian
+         * instead of paths between points. It is convex on the box [min, max]^n iff
+         * its hessian is positive semi-definite at all points of the box.
+         *  1. certifyConvexity() tries to prove it from bounds of the hessian
+         *  2. otherwise the smallest eigenvalue of the hessian is computed at sample
+         *     points, with the Lanczos method, and the first point with a negative one
+         *     is reported with its direction of negative curvature. A single point is
+         *     enough if the hessian is constant.
+         * The points are checked in parallel if the function is_thread_safe(). As in
+         * isConvex(), the violation reported does not depend on the number of threads.
+         * \param _function any class inheriting from FunctionBase with a hessian
+         * \param min the minimum value of all tested points' coordinate
+         * \param max the maximum value of all tested points' coordinate
+         * \param _n_samples the number of points tested
+         * \param _sampling how the points are generated
+         * \param _n_threads number of threads, 0 uses all hardware threads, 1 is used if the
+         *        function is not thread safe
+         * \param _seed seed of the sampling sequence
+         * \param _violation if not null and the function is not convex, the point found */
+        static bool isConvexSecondOrder(FunctionBase* _function, const double min = -1000., const double max = 1000.,
+                                        const std::uint64_t _n_samples = 10000, const Sampling _sampling = RANDOM,
+                                        const int _n_threads = 0, const std::uint64_t _seed = 0,
+                                        CurvatureViolation* _violation = nullptr) {
+            const int n = _function->n_unknowns();
+
+            if (certifyConvexity(_function, Vec::Constant(n, min), Vec::Constant(n, max)) == CONVEX) {
+                std::cout << "Convexity certified by bounds of the hessian" << std::endl;
+                return true;
+            }
+
+            const CounterRandomNumberGenerator rng(min, max, _seed);
+            const HaltonSequence halton(_sampling == HALTON ? n : 0, min, max, _seed);
+            const std::uint64_t n_samples = _function->has_constant_hessian() ? 1 : _n_samples;
+            const std::uint64_t chunk_size(64);
+            const int n_threads = !_function->is_thread_safe() ? 1 : _n_threads > 0 ? _n_threads : default_n_threads();
+
+            // the smallest eigenvalue of the hessian at the _k-th point if negative, else 0
+            auto check_point = [&](const std::uint64_t _k, Vec& _x, Mat& _H, Vec& _d, LanczosEigenSolver& _lanczos) {
+                if (_sampling == HALTON)
+                    halton.get_nd_vector(_k, _x);
+                else
+                    rng.get_random_nd_vector(_k, _x);
+
+                _function->eval_hessian(_x, _H);
+                if (gershgorin_bound(_H) >= 0.)
+                    return 0.;
+                const double lambda = _lanczos.smallest_eigenvalue([&](const Vec& _v, Vec& _w) { _w.noalias() = _H * _v; }, n, _d);
+                return lambda < -1e-10 * std::max(1., _H.cwiseAbs().maxCoeff()) ? lambda : 0.;
+            };
+
+            // per thread buffers
+            std::vector<Vec> x(n_threads, Vec(n)), d(n_threads, Vec(n));
+            std::vector<Mat> H(n_threads, Mat(n, n));
+            std::vector<LanczosEigenSolver> lanczos(n_threads);
+
+            std::atomic<std::uint64_t> first_violation(n_samples);
+
+            const std::uint64_t n_chunks = (n_samples + chunk_size - 1) / chunk_size;
+            parallel_for_chunks(n_chunks, [&](const std::uint64_t _c, const int _t) {
+                const std::uint64_t end = std::min((_c + 1) * chunk_size, n_samples);
+                for (std::uint64_t k = _c * chunk_size; k < end; ++k) {
+                    if (k >= first_violation.load(std::memory_order_relaxed))
+                        return;
+
+                    if (check_point(k, x[_t], H[_t], d[_t], lanczos[_t]) < 0.) {
+                        std::uint64_t first = first_violation.load();
+                        while (k < first && !first_violation.compare_exchange_weak(first, k)) {}
+                        return;
+                    }
+                }
+            }, n_threads);
+
+            if (first_violation.load() < n_samples) {
+                // the samples only depend on their index, recompute the violation
+                const double lambda = check_point(first_violation.load(), x[0], H[0], d[0], lanczos[0]);
+                printCurvatureInfo(x[0], d[0], lambda);
+                if (_violation != nullptr) {
+                    _violation->sample = first_violation.load();
+                    _violation->lambda = lambda;
+                    _violation->x = x[0];
+                    _violation->d = d[0];
+                }
+                return false;
+            }
+            return true;
+        }
+
+
+        /** Same as above for sparse functions, e.g. the energy of a mass spring system.
+         * The eigenvalue is computed with products of the sparse hessian, so that large
+         * problems can be checked. The points are checked one after the other since
+         * those functions usually evaluate into member buffers.
+         * \param _n_samples the number of random points tested */
+        static bool isConvexSecondOrder(FunctionBaseSparse* _function, const double min = -1000., const double max = 1000.,
+                                        const std::uint64_t _n_samples = 100, const std::uint64_t _seed = 0,
+                                        CurvatureViolation* _violation = nullptr) {
+            const int n = _function->n_unknowns();
+            const CounterRandomNumberGenerator rng(min, max, _seed);
+            const std::uint64_t n_samples = _function->has_constant_hessian() ? 1 : _n_samples;
+
+            Vec x(n), d(n);
+            FunctionBaseSparse::SMat H(n, n);
+            LanczosEigenSolver lanczos;
+
+            for (std::uint64_t k = 0; k < n_samples; ++k) {
+                rng.get_random_nd_vector(k, x);
+                _function->eval_hessian(x, H);
+                if (gershgorin_bound(H) >= 0.)
+                    continue;
+
+                const double lambda = lanczos.smallest_eigenvalue([&](const Vec& _v, Vec& _w) { _w.noalias() = H * _v; }, n, d);
+                if (lambda < -1e-10 * std::max(1., H.coeffs().cwiseAbs().maxCoeff())) {
+                    printCurvatureInfo(x, d, lambda);
+                    if (_violation != nullptr) {
+                        _violation->sample = k;
+                        _violation->lambda = lambda;
+                        _violation->x = x;
+                        _violation->d = d;
+                    }
+                    return false;
+                }
+            }
+            return true;
+        }
+
+
+        /** Tries to prove that the function is convex on the box [_x_l, _x_u] from
+         * element-wise bounds H_l <= H <= H_u of its hessian (see
+         * FunctionBase::eval_hessian_bounds()). All the eigenvalues of H are at least
+         *  - min_i H_l(i,i) - sum_{j != i} max(|H_l(i,j)|, |H_u(i,j)|) by Gershgorin's theorem
+         *  - lambda_min(H_c) - max_i sum_j R(i,j) by Weyl's inequality, with the center
+         *    H_c = (H_l + H_u) / 2 and the radius R = (H_u - H_l) / 2 of the bounds
+         * so the box is convex if one of them is not negative. Otherwise the box is split
+         * in two along its longest side, as the bounds get tighter on smaller boxes.
+         * A constant hessian is decided on the first box.
+         * \param _max_boxes maximum number of boxes whose bounds are evaluated */
+        static Certificate certifyConvexity(FunctionBase* _function, const Vec& _x_l, const Vec& _x_u,
+                                            const int _max_boxes = 10000) {
+            const int n = _function->n_unknowns();
+            Mat H_l(n, n), H_u(n, n), H_abs(n, n);
+            Eigen::SelfAdjointEigenSolver<Mat> eigen_solver(n);
+
+            std::vector<std::pair<Vec, Vec>> boxes{{_x_l, _x_u}};
+            int n_boxes = 0;
+            while (!boxes.empty()) {
+                if (n_boxes++ == _max_boxes)
+                    return UNKNOWN;
+
+                const std::pair<Vec, Vec> box = std::move(boxes.back());
+                boxes.pop_back();
+                if (!_function->eval_hessian_bounds(box.first, box.second, H_l, H_u))
+                    return UNKNOWN;
+
+                if (H_u.diagonal().minCoeff() < 0.)
+                    return NOT_CONVEX;
+
+                H_abs = H_l.cwiseAbs().cwiseMax(H_u.cwiseAbs());
+                H_abs.diagonal() = H_l.diagonal();
+                if (gershgorin_bound(H_abs) >= 0.)
+                    continue;
+
+                eigen_solver.compute(0.5 * (H_l + H_u), Eigen::EigenvaluesOnly);
+                const double lambda_c = eigen_solver.eigenvalues()[0];
+                if (lambda_c - 0.5 * (H_u - H_l).rowwise().sum().maxCoeff() >= 0.)
+                    continue;
+
+                // the bounds are the hessian, splitting does not help
+                if (H_l == H_u)
+                    return lambda_c < 0. ? NOT_CONVEX : UNKNOWN;
+
+                int s;
+                (box.second - box.first).maxCoeff(&s);
+                const double mid = 0.5 * (box.first[s] + box.second[s]);
+                boxes.push_back(box);
+                boxes.push_back(box);
+                boxes[boxes.size() - 2].second[s] = mid;
+                boxes.back().first[s] = mid;
+            }
+            return CONVEX;
+        }
+
+
     private:
         static void printPathInfo(FunctionBase::Vec p1, FunctionBase::Vec p2, FunctionBase::Vec p, double t) {
             std::cout << "path: p(t) = (1 - t) * p1 + t * p2; \nwith:\n"
@@ -85,6 +367,28 @@ namespace AOPT {
                       << "  p (t = " << t << ") = (" << p.transpose() << ")" << std::endl;
         }
 
+        static void printCurvatureInfo(const Vec& _x, const Vec& _d, const double _lambda) {
+            std::cout << "Function non convexity detected: d^T H(x) d = " << _lambda << " < 0 with:\n"
+                      << "  x = (" << _x.transpose() << ")\n"
+                      << "  d = (" << _d.transpose() << ")" << std::endl;
+        }
+
+        // lower bound of the eigenvalues of the symmetric matrix _H by Gershgorin's theorem
+        static double gershgorin_bound(const Mat& _H) {
+            double bound = std::numeric_limits<double>::infinity();
+            for (int i = 0; i < _H.rows(); ++i)
+                bound = std::min(bound, _H(i, i) - (_H.col(i).cwiseAbs().sum() - std::abs(_H(i, i))));
+            return bound;
+        }
+
+        static double gershgorin_bound(const FunctionBaseSparse::SMat& _H) {
+            Vec bound = Vec::Zero(_H.cols());
+            for (int j = 0; j < _H.outerSize(); ++j)
+                for (FunctionBaseSparse::SMat::InnerIterator it(_H, j); it; ++it)
+                    bound[j] += it.row() == j ? it.value() : -std::abs(it.value());
+            return bound.size() > 0 ? bound.minCoeff() : 0.;
+        }
+
     };
 
 
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <FunctionBase/FunctionBaseSparse.hh>
+#include <Utils/MemoryFootprint.hh>
+#include <Utils/Profiler.hh>
 #include "LineSearch.hh"
 
 //== NAMESPACES ===============================================================
@@ -30,6 +32,7 @@ namespace AOPT {
         template <class Problem>
         static Vec solve(Problem *_problem, const Vec& _initial_x, const double _eps = 1e-4, const int _max_iters = 1000000) {
             std::cout << "******** Gradient Descent ********" << std::endl;
+            AOPT_PROFILE_SCOPE("GradientDescent::solve");
 
             // squared epsilon for stopping criterion
             double e2 = _eps * _eps;
@@ -37,8 +40,13 @@ namespace AOPT {
             // get starting point
             Vec x = _initial_x;
 
-            // allocate gradient storage
+            // allocate gradient and descent direction storage
             Vec g(_problem->n_unknowns());
+            Vec dx(_problem->n_unknowns());
+            LineSearch::Workspace workspace;
+            workspace.x.resize(_problem->n_unknowns());
+            AOPT_PROFILE_MEMORY("vectors", MemoryFootprint::of(x) + MemoryFootprint::of(g) + MemoryFootprint::of(dx)
+                                           + MemoryFootprint::of(workspace.x));
             int iter(0);
 
             //------------------------------------------------------//
@@ -62,10 +70,11 @@ namespace AOPT {
                 if (f >= fp || g2 <= e2) break;
 
                 // step size
-                double t = LineSearch::backtracking_line_search(_problem, x, g, -g, 1.);
+                dx = -g;
+                double t = LineSearch::backtracking_line_search(_problem, x, g, dx, 1., workspace);
 
                 // update
-                x += t * (-g);
+                x += t * dx;
                 fp = f;
 
             } while (iter < _max_iters);
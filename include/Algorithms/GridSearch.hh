@@ -3,7 +3,14 @@
 #include <Functions/FunctionQuadratic2D.hh>
 #include <Functions/FunctionQuadraticND.hh>
 #include <Functions/FunctionNonConvex2D.hh>
+#include <Utils/ParallelFor.hh>
+#include <Utils/RandomNumberGenerator.hh>
 #include <vector>
+#include <queue>
+#include <cstdint>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 //== NAMESPACES ===================================================================
 
@@ -15,7 +22,13 @@ namespace AOPT {
         using Vec = FunctionBase::Vec;
         using Mat = FunctionBase::Mat;
 
-        GridSearch(const int _grid_dim = 10) : n_grid_(_grid_dim){}
+        using Index = std::uint64_t; ///< linear index of a grid point
+
+        /**
+         * \param _grid_dim number of cells on one side of every dimension
+         * \param _n_threads number of threads of grid_search_nd, 0 uses all hardware threads,
+         *        1 is used for functions that are not thread safe */
+        GridSearch(const int _grid_dim = 10, const int _n_threads = 0) : n_grid_(_grid_dim), n_threads_(_n_threads){}
         ~GridSearch() {}
 
     public:
@@ -39,25 +52,26 @@ namespace AOPT {
             // algorithm to find minimum value of _func between _x_l and _x_u
             //------------------------------------------------------//
 
-            //set-up the evaluation point and delta vector
-            Vec x(2), dx(2);
+            //set-up the delta vector and the points of a line of the grid
+            Vec dx(2), f_line;
             dx = (_x_u - _x_l) / n_grid_;
+            Mat X(2, n_grid_ + 1);
+            for(int j=0; j <= n_grid_; ++j)
+                X(1, j) = _x_l[1] + dx[1]*j;
 
             //going through first dimension
             for(int i=0; i <= n_grid_; ++i) {
-                x[0] = _x_l[0] + dx[0]*i;
-
-                //and 2nd dimension
-                for(int j=0; j <= n_grid_; ++j) {
-                    x[1] = _x_l[1] + dx[1]*j;
+                X.row(0).setConstant(_x_l[0] + dx[0]*i);
 
-                    //evaluate function at x
-                    f = _func->eval_f(x);
+                //evaluate function along the 2nd dimension at once
+                _func->eval_f_batch(X, f_line);
 
-                    //and update the minimum if needed
+                //and update the minimum if needed
+                for(int j=0; j <= n_grid_; ++j) {
+                    f = f_line[j];
                     if(f < fmin) {
                         fmin = f;
-                        x_min = x;
+                        x_min = X.col(j);
                     }
                 }
             }
@@ -69,6 +83,12 @@ namespace AOPT {
 
 
 
+        /** a grid point and its function value */
+        struct GridPoint {
+            double f;
+            Vec x;
+        };
+
         /** Evaluation of an ND function over the whole grid to find its minimum
          *  using an iterative approach
          *
@@ -79,68 +99,332 @@ namespace AOPT {
          *             _x_l and _x_u together define an ND cuboid in which the grid lies
          * \return 0 if all went well, -1 if not.*/
         int grid_search_nd(FunctionBase* _func, const Vec& _x_l, const Vec& _x_u, double& _f_min) const {
+            std::vector<GridPoint> minima;
+            if(grid_search_nd(_func, _x_l, _x_u, 1, minima) != 0)
+                return -1;
+
+            _f_min = minima[0].f;
+            std::cout << "Minimum value of the function is: " << minima[0].f << " at x:\n" << minima[0].x << std::endl;
+
+            return 0;
+        }
+
+        /** Same as above, but returns the _k grid points with the smallest values,
+         * e.g. as starting points of local solvers.
+         *
+         * The grid points are numbered by a 64 bit linear index, which is split into
+         * chunks that the threads take one after the other. Each thread walks its
+         * chunks with the incremental evaluation of FunctionBase::eval_f_start() and
+         * eval_f_step(), with a state of its own, and keeps its own _k best points,
+         * which are merged at the end. Points of equal value are ordered by index, so
+         * the result does not depend on the number of threads.
+         *
+         * \param _k number of minima
+         * \param _minima output, the min(_k, number of grid points) best points
+         *                in increasing order of f
+         * \return 0 if all went well, -1 if not.*/
+        int grid_search_nd(FunctionBase* _func, const Vec& _x_l, const Vec& _x_u, const int _k,
+                           std::vector<GridPoint>& _minima) const {
             int n = _func->n_unknowns();
             if (_x_l.size() != n || _x_u.size() != n) {
                 std::cout << "Error: input limits are not of correct dimension!" << std::endl;
                 return -1;
             }
+            if (n_grid_ < 1 || _k < 1) {
+                std::cout << "Error: the number of grid cells and of minima should be positive!" << std::endl;
+                return -1;
+            }
+
+            // number of grid points, (n_grid + 1)^n
+            const Index m = n_grid_ + 1;
+            Index nt = 1;
+            for (int j = 0; j < n; ++j) {
+                if (nt > std::numeric_limits<Index>::max() / m) {
+                    std::cout << "Error: the number of grid points (" << n_grid_ + 1 << "^" << n
+                              << ") does not fit into 64 bits!" << std::endl;
+                    return -1;
+                }
+                nt *= m;
+            }
+
             std::cout << "Grid searching the minimum of a " << n << "-D function..." << std::endl;
 
-            double f_min = std::numeric_limits<double>::max();
-            Vec x_min(n);
             //------------------------------------------------------//
             //Todo: implement the nd version of the grid search
             // algorithm to find minimum value of a nd quadratic function
             // set f_min with the minimum, which is then stored in the referenced argument _f_min
 
-            // iteratively walk through all grid cells with n-dimensional indices idx
-            std::vector<int> idx(n, 0);
-            // current grid coordiantes x and grid size dx
-            Vec x(n), dx(n);
-            dx = (_x_u - _x_l) / double(n_grid_);
-            // start from lower limits
-            x = _x_l;
-            
-            unsigned int nt = std::pow(n_grid_ + 1, n);
+            // grid size
+            Vec dx = (_x_u - _x_l) / double(n_grid_);
+
+            // a thread takes chunk_size points at once
+            const Index chunk_size = 16384;
+            const Index n_chunks = nt / chunk_size + (nt % chunk_size != 0);
+            const int n_threads = !_func->is_thread_safe() ? 1 : n_threads_ > 0 ? n_threads_ : default_n_threads();
+
+            // _k best (value, index) pairs of each thread, the largest on top
+            using Candidate = std::pair<double, Index>;
+            std::vector<std::priority_queue<Candidate>> best(n_threads);
+
+            parallel_for_chunks(n_chunks, [&](const Index _c, const int _t) {
+                const Index begin = _c * chunk_size;
+                const Index end = std::min(nt, begin + chunk_size);
+
+                // iteratively walk through the grid cells with n-dimensional indices idx.
+                // The walk is a reflected (boustrophedon) Gray code: every dimension goes
+                // back and forth in direction dir instead of jumping back to its lower
+                // limit, so consecutive points only differ in one coordinate and f can
+                // be updated incrementally (see FunctionBase::eval_f_step())
+                std::vector<int> idx(n), dir(n);
+                decode(begin, n, idx, dir);
+
+                // current grid coordinates, computed from the index so that they do not drift
+                Vec x(n);
+                for (int j = 0; j < n; ++j)
+                    x[j] = _x_l[j] + dx[j] * idx[j];
+
+                FunctionBase::IncrementalState state;
+                auto& queue = best[_t];
+                // the value a point has to beat to be stored once the queue is full
+                bool full = (int)queue.size() == _k;
+                double worst = full ? queue.top().first : std::numeric_limits<double>::infinity();
+
+                // local copies, which the compiler can keep in registers across the calls of _func
+                FunctionBase* func = _func;
+                const int k = _k;
+                const int n_grid = n_grid_;
+                int* pidx = idx.data();
+                int* pdir = dir.data();
+                const double* xl = _x_l.data();
+                const double* h = dx.data();
+
+                double f = func->eval_f_start(x, state);
+                for (Index i = begin; i < end; ++i) {
+                    // if better than best found -> store new solution. A thread takes
+                    // the chunks in increasing order, so on equal values the point
+                    // already stored has the smaller index and stays
+                    if (f < worst || !full) {
+                        if (full)
+                            queue.pop();
+                        queue.emplace(f, i);
+                        full = (int)queue.size() == k;
+                        if (full)
+                            worst = queue.top().first;
+                    }
+
+                    if (i + 1 == end)
+                        break;
 
-            for (unsigned int i = 0; i < nt; ++i) {
-                // evaluate function
-                double f = _func->eval_f(x);
-                // if better than best found -> store new solution
+                    // the lowest dimension that can still move in its direction,
+                    // the ones below it reached their end and turn around
+                    int j = 0;
+                    while (pidx[j] + pdir[j] < 0 || pidx[j] + pdir[j] > n_grid) {
+                        pdir[j] = -pdir[j];
+                        ++j;
+                    }
+
+                    // move to the next grid cell
+                    pidx[j] += pdir[j];
+                    const double xj = xl[j] + h[j] * pidx[j];
+                    const double step_j = xj - x[j];
+                    x[j] = xj;
+
+                    // evaluate function, restarting the incremental evaluation once
+                    // per 2D slice bounds the accumulated round-off
+                    if (j < 2)
+                        f = func->eval_f_step(x, j, step_j, state);
+                    else
+                        f = func->eval_f_start(x, state);
+                }
+            }, n_threads);
+
+            // merge the minima of all threads
+            std::vector<Candidate> all;
+            for (auto& queue : best)
+                for (; !queue.empty(); queue.pop())
+                    all.push_back(queue.top());
+            std::sort(all.begin(), all.end());
+            if ((int)all.size() > _k)
+                all.resize(_k);
+
+            _minima.clear();
+            std::vector<int> idx(n), dir(n);
+            for (const auto& cand : all) {
+                decode(cand.second, n, idx, dir);
+                Vec x(n);
+                for (int j = 0; j < n; ++j)
+                    x[j] = _x_l[j] + dx[j] * idx[j];
+                _minima.push_back({cand.first, x});
+            }
+            //------------------------------------------------------//
+
+            return 0;
+        }
+
+
+        /** Finds the minimum over the same grid as grid_search_nd(), without evaluating
+         * all its points. The grid is recursively split into cells, which are processed
+         * in increasing order of a lower bound of f over their box and evaluated at their
+         * center grid point. Cells whose bound cannot beat the best point found so far are
+         * skipped. A cell of a single grid point is not split further, so the resolution
+         * is the one of the grid. The bound of a cell is the larger of
+         *  - FunctionBase::eval_lower_bound() over its box, if the function provides one
+         *  - f(c) - L * (largest distance from the center c to the box), with a Lipschitz
+         *    constant L of f
+         * As long as the bounds hold, the result is the minimum of the dense grid.
+         *
+         * \param _func a pointer to any ND function inheriting from FunctionBase
+         * \param _x_l the coordinates of the lower corner of the grid
+         * \param _x_u the coordinates of the upper corner of the grid
+         * \param _f_min output minimum
+         * \param _x_min output grid point of the minimum
+         * \param _lipschitz Lipschitz constant of _func over the box, not used if <= 0.
+         *        If neither it nor a lower bound of _func is available, it is estimated
+         *        from differences of f at random points of the box, which makes the
+         *        search a heuristic.
+         * \return 0 if all went well, -1 if not.*/
+        int branch_and_bound_nd(FunctionBase* _func, const Vec& _x_l, const Vec& _x_u, double& _f_min, Vec& _x_min,
+                                double _lipschitz = 0.) const {
+            int n = _func->n_unknowns();
+            if (_x_l.size() != n || _x_u.size() != n) {
+                std::cout << "Error: input limits are not of correct dimension!" << std::endl;
+                return -1;
+            }
+            if (n_grid_ < 1) {
+                std::cout << "Error: the number of grid cells should be positive!" << std::endl;
+                return -1;
+            }
+            std::cout << "Branch and bound search of the minimum of a " << n << "-D function..." << std::endl;
+
+            const Vec dx = (_x_u - _x_l) / double(n_grid_);
+
+            // a cell is the box of grid indices [lo, hi], lb is the lower bound of f on it
+            struct Cell {
+                double lb;
+                std::vector<int> lo, hi;
+
+                // the cell with the smallest bound on top of the queue
+                bool operator<(const Cell& _other) const { return lb > _other.lb; }
+            };
+
+            const bool has_bound = std::isfinite(_func->eval_lower_bound(_x_l, _x_u));
+            if (_lipschitz <= 0. && !has_bound) {
+                _lipschitz = estimate_lipschitz(_func, _x_l, _x_u);
+                std::cout << "estimated Lipschitz constant: " << _lipschitz << std::endl;
+            }
+
+            double f_min = std::numeric_limits<double>::max();
+            long n_evals = 0;
+            Vec x(n), xl(n), xu(n), c(n);
+
+            // evaluates the center of the cell and computes its bound
+            auto evaluate = [&](Cell& _cell) {
+                for (int j = 0; j < n; ++j) {
+                    const int cj = (_cell.lo[j] + _cell.hi[j]) / 2;
+                    x[j] = _x_l[j] + dx[j] * cj;
+                    xl[j] = _x_l[j] + dx[j] * _cell.lo[j];
+                    xu[j] = _x_l[j] + dx[j] * _cell.hi[j];
+                    c[j] = dx[j] * std::max(cj - _cell.lo[j], _cell.hi[j] - cj);
+                }
+
+                const double f = _func->eval_f(x);
+                ++n_evals;
                 if (f < f_min) {
                     f_min = f;
-                    x_min = x;
+                    _x_min = x;
                 }
 
-                // move to next grid cell
-                idx[0]++;
-                x[0] += dx[0];
-
-                // update grid indices and grid coordinates when necessary
-                for (int j = 0; j < n-1; ++j) {
-                    if (idx[j] > n_grid_) {
-                        // reset current dimension
-                        idx[j] = 0;
-                        x[j] = _x_l[j];
-
-                        // increase index and coordinate of next dimension
-                        idx[j + 1]++;
-                        x[j + 1] += dx[j + 1];
-                    } else break; // next dimension can only increase if current one increased
+                _cell.lb = f;
+                if (has_bound)
+                    _cell.lb = std::min(f, _func->eval_lower_bound(xl, xu));
+                if (_lipschitz > 0.)
+                    _cell.lb = std::max(has_bound ? _cell.lb : -std::numeric_limits<double>::infinity(),
+                                        f - _lipschitz * c.norm());
+            };
+
+            // keep cells whose bound is within round-off of the best value
+            auto can_improve = [&](const Cell& _cell) {
+                return _cell.lb < f_min - 1e-12 * (1. + std::abs(f_min));
+            };
+
+            std::priority_queue<Cell> queue;
+            Cell root{0., std::vector<int>(n, 0), std::vector<int>(n, n_grid_)};
+            evaluate(root);
+            queue.push(root);
+
+            while (!queue.empty()) {
+                Cell cell = queue.top();
+                queue.pop();
+
+                // all remaining cells have larger bounds
+                if (!can_improve(cell))
+                    break;
+
+                // split the dimension with the most grid points in two
+                int s = 0;
+                for (int j = 1; j < n; ++j)
+                    if (cell.hi[j] - cell.lo[j] > cell.hi[s] - cell.lo[s])
+                        s = j;
+                if (cell.hi[s] == cell.lo[s])
+                    continue; // a single grid point, already evaluated
+
+                const int mid = (cell.lo[s] + cell.hi[s]) / 2;
+                Cell left{0., cell.lo, cell.hi}, right{0., cell.lo, cell.hi};
+                left.hi[s] = mid;
+                right.lo[s] = mid + 1;
+
+                for (Cell* child : {&left, &right}) {
+                    evaluate(*child);
+                    if (can_improve(*child))
+                        queue.push(std::move(*child));
                 }
             }
-            //------------------------------------------------------//
+
             _f_min = f_min;
-            std::cout << "Minimum value of the function is: " << f_min << " at x:\n" << x_min << std::endl;
+            std::cout << "Minimum value of the function is: " << f_min << " at x:\n" << _x_min << std::endl;
+            std::cout << "number of evaluations: " << n_evals << " (the grid has " << n_grid_ + 1 << "^" << n << " points)" << std::endl;
 
             return 0;
         }
 
 
 
+    private:
+        /** twice the largest slope |f(y) - f(x)| / |y - x| between random points x in
+         * [_x_l, _x_u] and y at most one grid cell away, only f is evaluated */
+        double estimate_lipschitz(FunctionBase* _func, const Vec& _x_l, const Vec& _x_u) const {
+            const int n = _func->n_unknowns();
+            const Vec dx = (_x_u - _x_l) / double(n_grid_);
+            RandomNumberGenerator rng(0., 1.), rng_step(-1., 1.);
+            Vec x(n), y(n);
+            double slope = 0.;
+            for (int i = 0; i < 100 * n; ++i) {
+                x = _x_l + (_x_u - _x_l).cwiseProduct(rng.get_random_nd_vector(n));
+                y = x + dx.cwiseProduct(rng_step.get_random_nd_vector(n));
+                const double d = (y - x).norm();
+                if (d > 0.)
+                    slope = std::max(slope, std::abs(_func->eval_f(y) - _func->eval_f(x)) / d);
+            }
+            return 2. * slope;
+        }
+
+        /** grid indices idx and walking directions dir of the point with linear index _i
+         * on the Gray code walk. Dimension j goes backwards when the number formed by the
+         * higher digits of _i (in base n_grid + 1) is odd. */
+        void decode(Index _i, const int _n, std::vector<int>& _idx, std::vector<int>& _dir) const {
+            for (int j = 0; j < _n; ++j) {
+                const int d = (int)(_i % (n_grid_ + 1));
+                _i /= (n_grid_ + 1);
+                const bool backwards = _i & 1;
+                _idx[j] = backwards ? n_grid_ - d : d;
+                _dir[j] = backwards ? -1 : 1;
+            }
+        }
+
     private:
         int n_grid_; ///< the number of cells on one side of every dimension
                     ///< e.g., with a ND grid, you would have (n_grid_)^n cells and thus (n_grid_ + 1)^n evaluation points
+        int n_threads_; ///< number of threads of grid_search_nd, 0 uses all hardware threads
 
     };
 
@@ -4,6 +4,7 @@
 #include <Functions/InteriorPointProblem.hh>
 #include <Algorithms/NewtonMethods.hh>
 #include <Utils/OptimizationStatistic.hh>
+#include <Utils/Profiler.hh>
 #include <iostream>
 #include <vector>
 #include <memory>
@@ -21,6 +22,7 @@ namespace AOPT {
         static Vec solve(FunctionBaseSparse *_obj, const Vec& _initial_x, const std::vector<FunctionBaseSparse*>& _constraints,
                 const double _eps = 1e-4, const double _mu = 10.0, const int _max_iters = 1000) {
             std::cerr << "******** Interior Point ********" << std::endl;
+            AOPT_PROFILE_SCOPE("InteriorPoint::solve");
 
             // Construct log-barrier problem
             InteriorPointProblem problem(_obj, _constraints);
@@ -42,6 +44,7 @@ namespace AOPT {
             bool converged = false;
             
             while (iter < _max_iters) {
+                AOPT_PROFILE_COUNT("outer_iterations");
                 problem.t() = t; // Update barrier parameter
 
                 // Centering step using Newton's method with projected Hessian
@@ -1,8 +1,12 @@
 #pragma once
 
 #include <Eigen/Core>
+#include <vector>
+#include <functional>
 #include <Algorithms/LineSearch.hh>
 #include <FunctionBase/FunctionBaseSparse.hh>
+#include <Utils/MemoryFootprint.hh>
+#include <Utils/Profiler.hh>
 
 //== NAMESPACES ===============================================================
 
@@ -15,8 +19,43 @@ namespace AOPT {
         using Vec = FunctionBaseSparse::Vec;
         using Mat = FunctionBaseSparse::Mat;
         using MapVec = Eigen::Map<Vec>;
+        //computes the diagonal blocks of the Hessian at x, see set_block_preconditioner()
+        using BlockEvaluator = std::function<void(const Vec&, Vec&)>;
 
-        LBFGS(const int _m): m_(_m) {}
+        /**
+        * \param _m number of most recent (s, y) pairs to store
+        * \param _compact if true, the search direction is computed with the compact
+        *        (Byrd-Nocedal-Schnabel) representation of the inverse Hessian instead
+        *        of the two-loop recursion. Both give the same direction, but the compact
+        *        form only streams the stored pairs through a few matrix-vector products,
+        *        which pays off when n is large. */
+        LBFGS(const int _m, const bool _compact = false): m_(_m), compact_(_compact) {}
+
+
+        /** replaces the scalar initial matrix H_0 = ys/yy * I by the scaled inverse of
+        * the block diagonal of the Hessian, H_0 = gamma * P^-1 with gamma = ys/(y^T P^-1 y).
+        * On problems whose curvature varies by orders of magnitude across the unknowns
+        * (e.g. stiff pinning springs), this removes most of the ill-conditioning.
+        * Blocks that are not positive definite fall back to the inverse of their absolute
+        * diagonal. The compact representation is not used when a preconditioner is set.
+        *
+        * \param _eval_blocks computes the diagonal blocks at x, the i-th block is stored
+        *        row by row in _blocks[b*b*i], ..., _blocks[b*b*(i+1)-1]
+        * \param _block_size size b of the blocks, 1 or 2 (e.g. one block per node in 2D)
+        * \param _diagonal_only if true, only the diagonal entries of the blocks are used
+        * \param _refresh the blocks are re-evaluated every _refresh iterations,
+        *        0 evaluates them only once at the starting point */
+        void set_block_preconditioner(const BlockEvaluator& _eval_blocks, const int _block_size = 2,
+                                      const bool _diagonal_only = false, const int _refresh = 1) {
+            if(_block_size != 1 && _block_size != 2) {
+                std::cout<<"Warning: only blocks of size 1 or 2 are supported, the preconditioner is ignored!"<<std::endl;
+                return;
+            }
+            eval_blocks_ = _eval_blocks;
+            block_size_ = _block_size;
+            diagonal_only_ = _diagonal_only;
+            refresh_ = _refresh;
+        }
 
 
         /**
@@ -29,11 +68,18 @@ namespace AOPT {
         template <class Problem>
         Vec solve(Problem *_problem, const Vec& _initial_x, const double _eps = 1e-4, const int _max_iters = 1000000) {
             std::cout << "******** LBFGS ********" << std::endl;
+            AOPT_PROFILE_SCOPE("LBFGS::solve");
 
             int n = _problem->n_unknowns();
 
             //allocate storage
             init_storage(n);
+            AOPT_PROFILE_MEMORY("history", MemoryFootprint::of(mat_s_) + MemoryFootprint::of(mat_y_));
+            if(compact_)
+                AOPT_PROFILE_MEMORY("compact_history", MemoryFootprint::of(mat_sy_) + MemoryFootprint::of(mat_yy_)
+                                                       + MemoryFootprint::of(small_r_) + MemoryFootprint::of(small_n_));
+            AOPT_PROFILE_MEMORY("vectors", MemoryFootprint::of(xp_) + MemoryFootprint::of(gp_) + MemoryFootprint::of(r_)
+                                           + MemoryFootprint::of(dx_));
 
             //get starting point
             Vec x = _initial_x;
@@ -61,6 +107,7 @@ namespace AOPT {
 
 
             do {
+                AOPT_PROFILE_COUNT("iterations");
                 double g2 = g.squaredNorm();
 
                 //print status
@@ -73,14 +120,27 @@ namespace AOPT {
                     return x;
                 }
 
+                //(re-)build the preconditioner
+                if(eval_blocks_ && (k == 0 || (refresh_ > 0 && k % refresh_ == 0))) {
+                    AOPT_PROFILE_SCOPE("preconditioner");
+                    update_preconditioner(x);
+                }
+
                 //compute r_
                 //------------------------------------------------------//
                 //TODO: complete the function
-                two_loop_recursion(g, sk, yk, k);
+                {
+                    AOPT_PROFILE_SCOPE("direction");
+                    if(compact_ && !eval_blocks_)
+                        compact_representation(g, sk, yk, k);
+                    else
+                        two_loop_recursion(g, sk, yk, k);
+                }
                 //------------------------------------------------------//
 
                 //compute the step size
-                double t = LineSearch::backtracking_line_search(_problem, x, g, -r_, 1.);
+                dx_ = -r_;
+                double t = LineSearch::backtracking_line_search(_problem, x, g, dx_, 1., line_search_);
 //                double t = LineSearch::wolfe_line_search(_problem, x, g, -r_, 1.);
 
                 if(t < 1e-16) {
@@ -95,6 +155,7 @@ namespace AOPT {
 
                 //update x
                 x -= t * r_;
+                step_ = t;
 
                 //evaluate current f
                 f = _problem->eval_f(x);
@@ -105,7 +166,10 @@ namespace AOPT {
                 }
 
                 //current gradient
-                _problem->eval_gradient(x, g);
+                {
+                    AOPT_PROFILE_SCOPE("eval_gradient");
+                    _problem->eval_gradient(x, g);
+                }
 
                 //update storage
                 sk = x - xp_;
@@ -126,12 +190,14 @@ namespace AOPT {
 
 
 
-    private:
+    protected:
         void two_loop_recursion(const Vec& _g, const Vec& _sk, const Vec& _yk, const int _k) {
             //------------------------------------------------------//
             //TODO: implement the two-loop recursion as described in the lecture slides
             if(_k == 0) {
                 r_ = _g;
+                if(eval_blocks_)
+                    apply_preconditioner(r_);
                 return;
             }
 
@@ -142,6 +208,9 @@ namespace AOPT {
             if(ys < 0) {
                 std::cout<<"Curvature condition violated, search in negative gradient direction!"<<std::endl;
                 r_ = _g;
+                //same fallback as for _k == 0
+                if(eval_blocks_)
+                    apply_preconditioner(r_);
                 return;
             }
 
@@ -165,7 +234,14 @@ namespace AOPT {
             }
 
             //H_0^k: see formula 6.20 in "Numerical Optimization"
-            r_ *= (ys / yy);
+            if(eval_blocks_) {
+                //same scaling with respect to the preconditioner
+                py_ = _yk;
+                apply_preconditioner(py_);
+                apply_preconditioner(r_);
+                r_ *= ys / _yk.dot(py_);
+            } else
+                r_ *= (ys / yy);
 
             for(int i = 0; i < range; ++i) {
                 double beta = rho_[j] * (mat_y_.col(j).dot(r_));
@@ -184,6 +260,7 @@ namespace AOPT {
             double ys = _sk.dot(_yk);
             if(ys < 0) {
                 std::cout<<"Curvature condition violated, skip updating!"<<std::endl;
+                AOPT_PROFILE_COUNT("skipped_updates");
                 return;
             }
 
@@ -196,6 +273,196 @@ namespace AOPT {
             //update \rho
             rho_[cur_idx] = 1./ys;
             //------------------------------------------------------//
+
+            if(compact_ && !eval_blocks_)
+                update_compact_storage(cur_idx, _k, ys, _yk.squaredNorm());
+        }
+
+
+        /** Computes r_ = H_k * g with the compact representation of H_k
+         * (see "Numerical Optimization", section 7.2 and Byrd, Nocedal, Schnabel 1994):
+         *
+         *   H_k = gI + [S gY] | R^-T (D + gY^TY) R^-1   -R^-T | | S^T  |
+         *                     |       -R^-1              0    | | gY^T |
+         *
+         * with g = s^Ty/y^Ty, R the upper triangular part of S^TY and D its diagonal.
+         * Apart from O(m^2) work on small matrices, only the products S^T g, Y^T g
+         * and S w1 + Y w2 touch the n-dimensional data. The new row and column of
+         * S^TY and Y^TY are obtained from these products as well (see update_storage),
+         * so no extra pass over the storage is needed per iteration. */
+        void compact_representation(const Vec& _g, const Vec& _sk, const Vec& _yk, const int _k) {
+            if(_k == 0) {
+                r_ = _g;
+                //no pairs stored yet, nothing to keep in sync
+                synced_ = true;
+                return;
+            }
+
+            //check the curvature condition
+            double ys = _sk.dot(_yk);
+            if(ys < 0) {
+                std::cout<<"Curvature condition violated, search in negative gradient direction!"<<std::endl;
+                r_ = _g;
+                synced_ = false;
+                return;
+            }
+
+            double gamma = ys / _yk.squaredNorm();
+
+            //only the first nc columns have been written so far
+            int nc = std::min(m_, _k);
+            auto S = mat_s_.leftCols(nc);
+            auto Y = mat_y_.leftCols(nc);
+
+            //S^T g and Y^T g, in storage order
+            sg_.head(nc).noalias() = S.transpose() * _g;
+            yg_.head(nc).noalias() = Y.transpose() * _g;
+
+            if(pending_ >= 0)
+                finish_compact_update(nc);
+
+            //stored pairs ordered from the oldest to the newest,
+            //slots that were skipped (zero pair) do not contribute
+            int l = 0;
+            for(int i = 0; i < nc; ++i) {
+                int idx = (_k - nc + i) % m_;
+                if(mat_sy_(idx, idx) > 0)
+                    order_[l++] = idx;
+            }
+
+            //gather the small matrices in chronological order
+            auto R = small_r_.topLeftCorner(l, l);
+            auto N = small_n_.topLeftCorner(l, l);
+            auto p1 = p1_.head(l);
+            auto p2 = p2_.head(l);
+            for(int j = 0; j < l; ++j) {
+                p1[j] = sg_[order_[j]];
+                p2[j] = gamma * yg_[order_[j]];
+                for(int i = 0; i < l; ++i) {
+                    R(i, j) = i <= j ? mat_sy_(order_[i], order_[j]) : 0.;
+                    N(i, j) = gamma * mat_yy_(order_[i], order_[j]);
+                }
+                N(j, j) += mat_sy_(order_[j], order_[j]);
+            }
+
+            //w2 = -R^-1 S^T g
+            auto w1 = w1_.head(l);
+            auto w2 = w2_.head(l);
+            w2 = R.triangularView<Eigen::Upper>().solve(p1);
+            //w1 = R^-T ((D + gY^TY) R^-1 S^T g - gY^T g)
+            w1.noalias() = N * w2;
+            w1 -= p2;
+            R.triangularView<Eigen::Upper>().transpose().solveInPlace(w1);
+            w2 = -w2;
+
+            //scatter back to storage order, unused columns get zero weights
+            ws_.head(nc).setZero();
+            wy_.head(nc).setZero();
+            for(int i = 0; i < l; ++i) {
+                ws_[order_[i]] = w1[i];
+                wy_[order_[i]] = gamma * w2[i];
+            }
+
+            r_ = gamma * _g;
+            r_.noalias() += S * ws_.head(nc);
+            r_.noalias() += Y * wy_.head(nc);
+
+            //keep what the next update needs: S^T g, Y^T g and Y^T r
+            sg_prev_.head(nc) = sg_.head(nc);
+            yg_prev_.head(nc) = yg_.head(nc);
+            ytr_.head(nc) = gamma * yg_.head(nc);
+            ytr_.head(nc).noalias() += mat_sy_.topLeftCorner(nc, nc).transpose() * ws_.head(nc);
+            ytr_.head(nc).noalias() += mat_yy_.topLeftCorner(nc, nc) * wy_.head(nc);
+            synced_ = true;
+        }
+
+        /** writes row _idx of S^TY and the diagonal entries of the new pair at _idx.
+         * Since s_k = -t r_k, s_k^T y_j = -t (Y^T r_k)_j is known without touching Y. */
+        void update_compact_storage(const int _idx, const int _k, const double _ys, const double _yy) {
+            int nc = std::min(m_, _k + 1);
+            if(synced_) {
+                for(int j = 0; j < nc; ++j)
+                    if(j != _idx)
+                        mat_sy_(_idx, j) = -step_ * ytr_[j];
+            } else {
+                mat_sy_.row(_idx).head(nc).noalias() =
+                        (mat_y_.leftCols(nc).transpose() * mat_s_.col(_idx)).transpose();
+            }
+            mat_sy_(_idx, _idx) = _ys;
+            mat_yy_(_idx, _idx) = _yy;
+
+            pending_ = _idx;
+        }
+
+        /** completes column pending_ of S^TY and Y^TY once S^T g and Y^T g are known
+         * for the new gradient: s_i^T y_k = s_i^T g_k+1 - s_i^T g_k, same for Y^TY. */
+        void finish_compact_update(const int _nc) {
+            int c = pending_;
+            if(synced_) {
+                for(int i = 0; i < _nc; ++i) {
+                    if(i == c)
+                        continue;
+                    mat_sy_(i, c) = sg_[i] - sg_prev_[i];
+                    mat_yy_(i, c) = mat_yy_(c, i) = yg_[i] - yg_prev_[i];
+                }
+            } else {
+                double ys = mat_sy_(c, c), yy = mat_yy_(c, c);
+                mat_sy_.col(c).head(_nc).noalias() = mat_s_.leftCols(_nc).transpose() * mat_y_.col(c);
+                mat_yy_.col(c).head(_nc).noalias() = mat_y_.leftCols(_nc).transpose() * mat_y_.col(c);
+                mat_yy_.row(c).head(_nc) = mat_yy_.col(c).head(_nc).transpose();
+                mat_sy_(c, c) = ys;
+                mat_yy_(c, c) = yy;
+            }
+            pending_ = -1;
+        }
+
+
+        /** evaluates the diagonal blocks at _x and stores their inverses in pinv_ */
+        void update_preconditioner(const Vec& _x) {
+            eval_blocks_(_x, blocks_);
+
+            const int b = block_size_;
+            const int n_blocks = (int)blocks_.size() / (b * b);
+
+            //lower bound on the absolute diagonal, avoids dividing by (almost) zero
+            double max_diag(0);
+            for(int i = 0; i < n_blocks; ++i)
+                for(int j = 0; j < b; ++j)
+                    max_diag = std::max(max_diag, std::abs(blocks_[b*b*i + j*(b+1)]));
+            const double floor = std::max(1e-8 * max_diag, 1e-16);
+
+            pinv_.setZero(blocks_.size());
+            for(int i = 0; i < n_blocks; ++i) {
+                double* blk = blocks_.data() + b*b*i;
+                double* inv = pinv_.data() + b*b*i;
+                if(b == 2 && !diagonal_only_) {
+                    double a = blk[0], c = 0.5 * (blk[1] + blk[2]), d = blk[3];
+                    double det = a * d - c * c;
+                    if(a > 0 && det > floor * floor) {
+                        inv[0] = d / det;
+                        inv[1] = inv[2] = -c / det;
+                        inv[3] = a / det;
+                        continue;
+                    }
+                }
+                for(int j = 0; j < b; ++j)
+                    inv[j*(b+1)] = 1. / std::max(std::abs(blk[j*(b+1)]), floor);
+            }
+        }
+
+        /** _v = P^-1 _v with the block inverses of update_preconditioner() */
+        void apply_preconditioner(Vec& _v) const {
+            if(block_size_ == 1) {
+                _v.array() *= pinv_.array();
+                return;
+            }
+
+            for(int i = 0; i < (int)_v.size() / 2; ++i) {
+                const double* inv = pinv_.data() + 4*i;
+                double v0 = _v[2*i], v1 = _v[2*i+1];
+                _v[2*i]   = inv[0] * v0 + inv[1] * v1;
+                _v[2*i+1] = inv[2] * v0 + inv[3] * v1;
+            }
         }
 
 
@@ -205,11 +472,38 @@ namespace AOPT {
             xp_.resize(_n);
             gp_.resize(_n);
             r_.resize(_n);
-            rho_.resize(m_);
+            dx_.resize(_n);
+            rho_.setZero(m_);
             alpha_.resize(m_);
+
+            //a skipped update leaves its slot untouched, so unused
+            //columns must not contain garbage
+            mat_y_.setZero();
+            mat_s_.setZero();
+
+            if(compact_) {
+                mat_sy_.setZero(m_, m_);
+                mat_yy_.setZero(m_, m_);
+                small_r_.resize(m_, m_);
+                small_n_.resize(m_, m_);
+                sg_.resize(m_);
+                yg_.resize(m_);
+                sg_prev_.resize(m_);
+                yg_prev_.resize(m_);
+                ytr_.resize(m_);
+                p1_.resize(m_);
+                p2_.resize(m_);
+                w1_.resize(m_);
+                w2_.resize(m_);
+                ws_.resize(m_);
+                wy_.resize(m_);
+                order_.resize(m_);
+                pending_ = -1;
+                synced_ = false;
+            }
         }
 
-    private:
+    protected:
         //variables' name convention follow the lecture slides
         //number of most recent pairs of s and y to store
         int m_;
@@ -225,10 +519,41 @@ namespace AOPT {
         Vec gp_;
         //move direction
         Vec r_;
+        //descent direction -r_ and the trial points of the line search
+        Vec dx_;
+        LineSearch::Workspace line_search_;
 
         Vec alpha_;
         Vec rho_;
 
+        //compact representation
+        bool compact_;
+        //S^TY and Y^TY in storage order
+        Mat mat_sy_;
+        Mat mat_yy_;
+        //R and D + gY^TY in chronological order
+        Mat small_r_;
+        Mat small_n_;
+        //temporaries of size m
+        Vec sg_, yg_, p1_, p2_, w1_, w2_, ws_, wy_;
+        std::vector<int> order_;
+        //S^T g, Y^T g and Y^T r of the last direction, used to update S^TY and Y^TY
+        Vec sg_prev_, yg_prev_, ytr_;
+        //slot whose column in S^TY and Y^TY is still to be completed, -1 if none
+        int pending_ = -1;
+        //whether sg_prev_, yg_prev_ and ytr_ belong to the last direction
+        bool synced_ = false;
+        //step length of the last iteration
+        double step_ = 0.;
+
+        //block preconditioner of H_0
+        BlockEvaluator eval_blocks_;
+        int block_size_ = 2;
+        bool diagonal_only_ = false;
+        int refresh_ = 1;
+        //diagonal blocks, their inverses and P^-1 y
+        Vec blocks_, pinv_, py_;
+
     };
 
 //=============================================================================
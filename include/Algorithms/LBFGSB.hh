@@ -0,0 +1,484 @@
+#pragma once
+
+#include <Eigen/Core>
+#include <Eigen/LU>
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <Algorithms/LBFGS.hh>
+#include <Algorithms/LineSearch.hh>
+
+//== NAMESPACES ===============================================================
+
+namespace AOPT {
+
+    //== CLASS DEFINITION =========================================================
+
+    /* Limited-memory BFGS for simple bounds l <= x <= u (L-BFGS-B), following
+     * Byrd, Lu, Nocedal, Zhu, "A limited memory algorithm for bound constrained
+     * optimization", 1995, with the projection step of Morales and Nocedal, 2011.
+     *
+     * Each iteration
+     * 1. computes the generalized Cauchy point, i.e. the first local minimizer of
+     *    the quadratic model along the projected steepest descent path,
+     * 2. minimizes the model over the variables that are not at a bound there,
+     * 3. runs a projected back-tracking line search towards that point.
+     *
+     * The model Hessian is the compact representation B = theta*I - W M W^T
+     * with W = [Y theta*S], built from the (s, y) pairs kept in the LBFGS storage.
+     * Only gradients are needed, so it scales to problems whose Hessian is too
+     * expensive to factorize. */
+    class LBFGSB : public LBFGS {
+    public:
+        using Vec = LBFGS::Vec;
+        using Mat = LBFGS::Mat;
+
+        /**
+        * \param _m number of most recent (s, y) pairs to store */
+        LBFGSB(const int _m) : LBFGS(_m) {}
+
+
+        /**
+        * @brief solve
+        * \param _problem pointer to any function/problem inheriting from FunctionBaseSparse
+        * \param _initial_x starting point of the method, it is projected onto the box first
+        * \param _lower lower bounds of x, use -inf for unbounded entries
+        * \param _upper upper bounds of x, use +inf for unbounded entries
+        * \param _eps epsilon under which the method stops, measured on the
+        *        infinity norm of the projected gradient P(x - g) - x
+        * \param _max_iters maximum iteration of the method*/
+        template <class Problem>
+        Vec solve(Problem *_problem, const Vec& _initial_x, const Vec& _lower, const Vec& _upper,
+                  const double _eps = 1e-4, const int _max_iters = 1000000) {
+            std::cout << "******** LBFGS-B ********" << std::endl;
+            AOPT_PROFILE_SCOPE("LBFGSB::solve");
+
+            int n = _problem->n_unknowns();
+
+            //get starting point
+            Vec x = _initial_x.cwiseMax(_lower).cwiseMin(_upper);
+
+            if(m_ < 1) {
+                std::cout<<"\nError: m should be larger than 0!"<<std::endl;
+                return x;
+            }
+
+            if((_lower.array() > _upper.array()).any()) {
+                std::cout<<"\nError: lower bounds should not be larger than upper bounds!"<<std::endl;
+                return x;
+            }
+
+            //allocate storage
+            init_storage(n);
+            init_bound_storage(n);
+
+            //allocate gradient storage
+            Vec g(n), sk(n), yk(n);
+
+            //wf_ and the temporaries of the subspace minimization grow with the free
+            //variables in the iterations and are not recorded
+            AOPT_PROFILE_MEMORY("history", MemoryFootprint::of(mat_s_) + MemoryFootprint::of(mat_y_));
+            AOPT_PROFILE_MEMORY("bound_history", MemoryFootprint::of(mat_ss_) + MemoryFootprint::of(mat_sy_)
+                                                 + MemoryFootprint::of(sg_) + MemoryFootprint::of(yg_));
+            AOPT_PROFILE_MEMORY("cauchy_point", MemoryFootprint::of(xcp_) + MemoryFootprint::of(xbar_) + MemoryFootprint::of(d_)
+                                                + MemoryFootprint::of(breakpoints_) + MemoryFootprint::of(free_));
+            AOPT_PROFILE_MEMORY("vectors", MemoryFootprint::of(x) + MemoryFootprint::of(g) + MemoryFootprint::of(sk)
+                                           + MemoryFootprint::of(yk) + MemoryFootprint::of(xp_) + MemoryFootprint::of(gp_)
+                                           + MemoryFootprint::of(r_));
+
+            //initialize k
+            int k(0);
+
+            //initialize
+            double f = _problem->eval_f(x);
+            _problem->eval_gradient(x, g);
+
+            do {
+                double pg = projected_gradient_norm(x, g, _lower, _upper);
+
+                //print status
+                std::cout << "iter: " << k <<
+                          "   obj = " << f <<
+                          "   ||Pg||_inf = " << pg << std::endl;
+
+                if(pg < _eps) {
+                    std::cout<<"Projected gradient norm converges!"<<std::endl;
+                    return x;
+                }
+
+                //generalized Cauchy point, then minimization over the free variables
+                generalized_cauchy_point(x, g, _lower, _upper);
+                subspace_minimization(x, g, _lower, _upper);
+
+                r_ = xbar_ - x;
+
+                //the model might not give a descent direction due to rounding,
+                //restart from the projected steepest descent in that case
+                if(g.dot(r_) >= 0) {
+                    std::cout<<"No descent direction, reset the memory!"<<std::endl;
+                    reset_memory();
+                    r_ = (x - g).cwiseMax(_lower).cwiseMin(_upper) - x;
+                }
+
+                //compute the step size. Without curvature information the
+                //first step is scaled to unit length
+                double t0 = n_pairs_ == 0 ? std::min(1., 1./r_.norm()) : 1.;
+                double t = LineSearch::projected_backtracking_line_search(_problem, x, g, r_, _lower, _upper, t0);
+
+                if(t < 1e-16) {
+                    std::cout<<"The step length is too small!"<<std::endl;
+                    return x;
+                }
+
+                //update previous function value, x and gradient
+                fp_ = f;
+                xp_ = x;
+                gp_ = g;
+
+                //update x
+                x = (x + t * r_).cwiseMax(_lower).cwiseMin(_upper);
+
+                //evaluate current f
+                f = _problem->eval_f(x);
+
+                if(k > 0 && fp_ <= f) {
+                    std::cout<<"Function value converges!"<<std::endl;
+                    return x;
+                }
+
+                //current gradient
+                _problem->eval_gradient(x, g);
+
+                //update storage
+                sk = x - xp_;
+                yk = g - gp_;
+
+                update_bound_storage(sk, yk);
+
+                k++;
+
+            } while (k < _max_iters);
+
+
+            return x;
+        }
+
+
+        /** infinity norm of the projected gradient P(x - g) - x */
+        static double projected_gradient_norm(const Vec& _x, const Vec& _g, const Vec& _lower, const Vec& _upper) {
+            double pg(0);
+            for(int i = 0; i < (int)_x.size(); ++i)
+                pg = std::max(pg, std::abs(std::min(std::max(_x[i] - _g[i], _lower[i]), _upper[i]) - _x[i]));
+
+            return pg;
+        }
+
+
+    private:
+        /** computes the generalized Cauchy point xcp_ (Algorithm CP in the paper).
+         * The breakpoints t_i where variable i hits its bound along x - t*g are visited
+         * in increasing order and the piecewise quadratic model is minimized segment
+         * by segment. c_ = W^T (xcp_ - x) is kept for the subspace minimization. */
+        void generalized_cauchy_point(const Vec& _x, const Vec& _g, const Vec& _lower, const Vec& _upper) {
+            int n = (int)_x.size();
+            int l2 = 2 * n_cols_;
+
+            xcp_ = _x;
+            c_.setZero(l2);
+
+            //breakpoints and steepest descent direction
+            breakpoints_.clear();
+            d_ = -_g;
+            for(int i = 0; i < n; ++i) {
+                double tb = std::numeric_limits<double>::infinity();
+                if(_g[i] < 0)
+                    tb = (_x[i] - _upper[i]) / _g[i];
+                else if(_g[i] > 0)
+                    tb = (_x[i] - _lower[i]) / _g[i];
+
+                if(tb <= 0)
+                    d_[i] = 0;
+                else if(tb < std::numeric_limits<double>::infinity())
+                    breakpoints_.emplace_back(tb, i);
+            }
+            std::sort(breakpoints_.begin(), breakpoints_.end());
+
+            //f' and f'' of the model along d
+            double fp = -d_.squaredNorm();
+            if(fp >= 0)
+                return;
+
+            compute_wt(d_, p_);
+            apply_m(p_, mp_);
+            double fpp = -theta_ * fp - p_.dot(mp_);
+            const double fpp0 = -theta_ * fp;
+
+            double dt_min = -fp / fpp;
+            double t_old = 0;
+
+            size_t b = 0;
+            double dt = breakpoints_.empty() ? std::numeric_limits<double>::infinity() : breakpoints_[0].first;
+
+            //examine the segments [t_old, t_b] as long as the minimizer is beyond them
+            while(b < breakpoints_.size() && dt_min >= dt) {
+                int i = breakpoints_[b].second;
+                double tb = breakpoints_[b].first;
+
+                xcp_[i] = d_[i] > 0 ? _upper[i] : _lower[i];
+                double zb = xcp_[i] - _x[i];
+                double gb = _g[i];
+
+                c_ += dt * p_;
+
+                if(l2 > 0) {
+                    w_row(i, wb_);
+                    apply_m(c_, mc_);
+                    apply_m(p_, mp_);
+                    apply_m(wb_, mwb_);
+                    fp += dt * fpp + gb * gb + theta_ * gb * zb - gb * wb_.dot(mc_);
+                    fpp += -theta_ * gb * gb - 2. * gb * wb_.dot(mp_) - gb * gb * wb_.dot(mwb_);
+                    p_ += gb * wb_;
+                } else {
+                    fp += dt * fpp + gb * gb + theta_ * gb * zb;
+                    fpp += -theta_ * gb * gb;
+                }
+                //safeguard against loss of accuracy in f''
+                fpp = std::max(fpp, std::numeric_limits<double>::epsilon() * fpp0);
+
+                d_[i] = 0;
+                dt_min = -fp / fpp;
+                t_old = tb;
+
+                ++b;
+                dt = b < breakpoints_.size() ? breakpoints_[b].first - t_old : std::numeric_limits<double>::infinity();
+            }
+
+            dt_min = std::max(dt_min, 0.);
+            t_old += dt_min;
+
+            //the remaining variables move freely along d
+            for(int i = 0; i < n; ++i)
+                if(d_[i] != 0)
+                    xcp_[i] = _x[i] + t_old * d_[i];
+
+            c_ += dt_min * p_;
+        }
+
+
+        /** minimizes the quadratic model over the variables that are not at a bound
+         * at the Cauchy point (direct primal method), then projects the result onto
+         * the box. If the projected point is no descent direction, the step from the
+         * Cauchy point is truncated to stay feasible instead. The result is xbar_. */
+        void subspace_minimization(const Vec& _x, const Vec& _g, const Vec& _lower, const Vec& _upper) {
+            int n = (int)_x.size();
+            int l2 = 2 * n_cols_;
+
+            xbar_ = xcp_;
+
+            free_.clear();
+            for(int i = 0; i < n; ++i)
+                if(xcp_[i] > _lower[i] && xcp_[i] < _upper[i])
+                    free_.push_back(i);
+
+            int nf = (int)free_.size();
+            if(nf == 0)
+                return;
+
+            //rows of W of the free variables
+            if(l2 > 0) {
+                wf_.resize(nf, l2);
+                for(int j = 0; j < nf; ++j) {
+                    w_row(free_[j], wb_);
+                    wf_.row(j) = wb_.transpose();
+                }
+            }
+
+            //reduced gradient of the model at the Cauchy point
+            // rc = Z^T (g + theta (xcp - x) - W M c)
+            rc_.resize(nf);
+            for(int j = 0; j < nf; ++j) {
+                int i = free_[j];
+                rc_[j] = _g[i] + theta_ * (xcp_[i] - _x[i]);
+            }
+            if(l2 > 0) {
+                apply_m(c_, mc_);
+                rc_.noalias() -= wf_ * mc_;
+            }
+
+            //du = -(1/theta) rc - (1/theta^2) Z^T W (I - (1/theta) M W^T Z Z^T W)^-1 M W^T Z rc
+            du_ = -rc_ / theta_;
+            if(l2 > 0) {
+                Vec wtr = wf_.transpose() * rc_;
+                apply_m(wtr, mv_);
+
+                Mat wtzw = wf_.transpose() * wf_;
+                Mat nmat = Mat::Identity(l2, l2);
+                for(int j = 0; j < l2; ++j) {
+                    apply_m(wtzw.col(j), mwb_);
+                    nmat.col(j) -= mwb_ / theta_;
+                }
+                Vec v = nmat.partialPivLu().solve(mv_);
+                du_.noalias() -= wf_ * v / (theta_ * theta_);
+            }
+
+            //projected subspace step
+            for(int j = 0; j < nf; ++j) {
+                int i = free_[j];
+                xbar_[i] = std::min(std::max(xcp_[i] + du_[j], _lower[i]), _upper[i]);
+            }
+
+            if(_g.dot(xbar_ - _x) < 0)
+                return;
+
+            //otherwise move from the Cauchy point as far as the box allows
+            double alpha(1);
+            for(int j = 0; j < nf; ++j) {
+                int i = free_[j];
+                if(du_[j] > 0)
+                    alpha = std::min(alpha, (_upper[i] - xcp_[i]) / du_[j]);
+                else if(du_[j] < 0)
+                    alpha = std::min(alpha, (_lower[i] - xcp_[i]) / du_[j]);
+            }
+
+            for(int j = 0; j < nf; ++j)
+                xbar_[free_[j]] = xcp_[free_[j]] + alpha * du_[j];
+        }
+
+
+        /** stores a new (s, y) pair if s^T y is sufficiently positive, updates
+         * S^TS, S^TY and theta, and factorizes the middle matrix
+         * K = | -D   L^T     |  (= M^-1)
+         *     |  L   theta S^TS |
+         * with L the strictly lower triangular part of S^TY. */
+        void update_bound_storage(const Vec& _sk, const Vec& _yk) {
+            double ys = _sk.dot(_yk);
+            double yy = _yk.squaredNorm();
+            if(ys <= std::numeric_limits<double>::epsilon() * yy) {
+                std::cout<<"Curvature condition violated, skip updating!"<<std::endl;
+                return;
+            }
+
+            int cur_idx = n_pairs_ % m_;
+
+            //update s and y in the storage
+            mat_s_.col(cur_idx) = _sk;
+            mat_y_.col(cur_idx) = _yk;
+            rho_[cur_idx] = 1./ys;
+
+            n_pairs_++;
+            n_cols_ = std::min(m_, n_pairs_);
+            theta_ = yy / ys;
+
+            //new row and column of S^TS and S^TY, in storage order
+            auto S = mat_s_.leftCols(n_cols_);
+            auto Y = mat_y_.leftCols(n_cols_);
+            mat_ss_.col(cur_idx).head(n_cols_).noalias() = S.transpose() * _sk;
+            mat_ss_.row(cur_idx).head(n_cols_) = mat_ss_.col(cur_idx).head(n_cols_).transpose();
+            mat_sy_.col(cur_idx).head(n_cols_).noalias() = S.transpose() * _yk;
+            mat_sy_.row(cur_idx).head(n_cols_).noalias() = (Y.transpose() * _sk).transpose();
+
+            //chronological order, oldest first
+            for(int i = 0; i < n_cols_; ++i)
+                order_[i] = (n_pairs_ - n_cols_ + i) % m_;
+
+            int l = n_cols_;
+            Mat K = Mat::Zero(2 * l, 2 * l);
+            for(int j = 0; j < l; ++j) {
+                K(j, j) = -mat_sy_(order_[j], order_[j]);
+                for(int i = j + 1; i < l; ++i) {
+                    K(l + i, j) = mat_sy_(order_[i], order_[j]);
+                    K(j, l + i) = K(l + i, j);
+                }
+                for(int i = 0; i < l; ++i)
+                    K(l + i, l + j) = theta_ * mat_ss_(order_[i], order_[j]);
+            }
+            k_lu_.compute(K);
+        }
+
+
+        /** forgets all stored pairs */
+        void reset_memory() {
+            n_pairs_ = 0;
+            n_cols_ = 0;
+            theta_ = 1.;
+        }
+
+
+        /** _wt = W^T _v with W = [Y theta*S] in chronological order */
+        void compute_wt(const Vec& _v, Vec& _wt) {
+            int l = n_cols_;
+            _wt.resize(2 * l);
+            if(l == 0)
+                return;
+
+            sg_.head(l).noalias() = mat_s_.leftCols(l).transpose() * _v;
+            yg_.head(l).noalias() = mat_y_.leftCols(l).transpose() * _v;
+            for(int i = 0; i < l; ++i) {
+                _wt[i] = yg_[order_[i]];
+                _wt[l + i] = theta_ * sg_[order_[i]];
+            }
+        }
+
+        /** _w = i-th row of W = [Y theta*S] */
+        void w_row(const int _i, Vec& _w) {
+            int l = n_cols_;
+            _w.resize(2 * l);
+            for(int j = 0; j < l; ++j) {
+                _w[j] = mat_y_(_i, order_[j]);
+                _w[l + j] = theta_ * mat_s_(_i, order_[j]);
+            }
+        }
+
+        /** _mv = M _v = K^-1 _v */
+        template <class Derived>
+        void apply_m(const Eigen::MatrixBase<Derived>& _v, Vec& _mv) {
+            if(n_cols_ == 0) {
+                _mv.setZero(_v.size());
+                return;
+            }
+            _mv = k_lu_.solve(_v);
+        }
+
+
+        void init_bound_storage(const int _n) {
+            mat_ss_.setZero(m_, m_);
+            mat_sy_.setZero(m_, m_);
+            sg_.resize(m_);
+            yg_.resize(m_);
+            order_.resize(m_);
+            xcp_.resize(_n);
+            xbar_.resize(_n);
+            d_.resize(_n);
+            breakpoints_.reserve(_n);
+            free_.reserve(_n);
+
+            reset_memory();
+        }
+
+    private:
+        //number of accepted pairs so far and number of used storage columns
+        int n_pairs_ = 0;
+        int n_cols_ = 0;
+        //scaling of the initial matrix B0 = theta*I
+        double theta_ = 1.;
+        //S^TS in storage order (S^TY is kept in mat_sy_)
+        Mat mat_ss_;
+        //LU factorization of the middle matrix K = M^-1
+        Eigen::PartialPivLU<Mat> k_lu_;
+
+        //generalized Cauchy point and result of the subspace minimization
+        Vec xcp_, xbar_;
+        //projected steepest descent direction
+        Vec d_;
+        //breakpoints (t_i, i)
+        std::vector<std::pair<double, int>> breakpoints_;
+        //free variables at the Cauchy point
+        std::vector<int> free_;
+        //temporaries, c_ = W^T (xcp - x) and p_ = W^T d
+        Vec c_, p_, wb_, mc_, mp_, mwb_, mv_, rc_, du_;
+        //rows of W of the free variables
+        Mat wf_;
+    };
+
+//=============================================================================
+}
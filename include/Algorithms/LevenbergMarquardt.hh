@@ -0,0 +1,266 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <Eigen/Sparse>
+#include <Eigen/SparseCholesky>
+#include <FunctionBase/FunctionBaseSparse.hh>
+#include <Utils/MemoryFootprint.hh>
+#include <Utils/Profiler.hh>
+
+//== NAMESPACES ===============================================================
+
+namespace AOPT {
+
+    //== CLASS DEFINITION =========================================================
+
+    /* Levenberg-Marquardt method for least squares problems F(x) = 1/2 ||r(x)||^2.
+     * Each iteration solves
+     *      (J^TJ + lambda D) v = -J^T r,   with D = diag(J^TJ),
+     * and the damping lambda is adapted from the gain ratio of the step
+     * (Nielsen, "Damping parameter in Marquardt's method", 1999).
+     * Optionally, the step is corrected with the geodesic acceleration
+     * (Transtrum, Sethna, "Improvements to the Levenberg-Marquardt algorithm
+     * for nonlinear least-squares minimization", 2012).
+     *
+     * The Problem has to provide n_unknowns(), eval_r(x, r) and
+     * eval_r_and_jacobian(x, r, J), see MassSpringProblem2DLeastSquare.
+     * r and J are evaluated once per iterate. The pattern of J must not change,
+     * so that J^TJ is accumulated row by row directly into a cached (lower
+     * triangular) pattern, its symbolic factorization is done once, and changing
+     * lambda only rewrites the diagonal before the numerical factorization. */
+    class LevenbergMarquardt {
+    public:
+        using Vec = FunctionBaseSparse::Vec;
+        using SMat = FunctionBaseSparse::SMat;
+        using T = FunctionBaseSparse::T;
+
+        /**
+         * \param _geodesic_acceleration if true, the second order correction along the
+         *        geodesic is added to every step
+         * \param _alpha bound on 2||a||/||v|| above which the acceleration is dropped */
+        LevenbergMarquardt(const bool _geodesic_acceleration = false, const double _alpha = 0.75)
+                : geodesic_acceleration_(_geodesic_acceleration), alpha_(_alpha) {}
+
+
+        /**
+         * \param _problem pointer to a least squares problem (see above)
+         * \param _initial_x starting point of the method
+         * \param _eps epsilon under which the method stops, on the gradient norm J^Tr
+         * \param _max_iters maximum iteration of the method
+         * \return the minimum found by the method */
+        template <class Problem>
+        Vec solve(Problem *_problem, const Vec& _initial_x, const double _eps = 1e-4, const int _max_iters = 10000) {
+            std::cout << "******** Levenberg-Marquardt" << (geodesic_acceleration_ ? " (geodesic acceleration)" : "")
+                      << " ********" << std::endl;
+            AOPT_PROFILE_SCOPE("LevenbergMarquardt::solve");
+
+            n_eval_r_ = n_eval_rj_ = n_factorizations_ = n_rejected_accelerations_ = 0;
+
+            double e2 = _eps * _eps;
+
+            Vec x = _initial_x;
+
+            _problem->eval_r_and_jacobian(x, r_, J_);
+            ++n_eval_rj_;
+            init_pattern();
+            accumulate_jtj();
+            AOPT_PROFILE_MEMORY("jacobian", J_);
+            AOPT_PROFILE_MEMORY("jtj", H_);
+            AOPT_PROFILE_MEMORY("jtj_map", jtj_map_);
+
+            double F = 0.5 * r_.squaredNorm();
+            g_ = J_.transpose() * r_;
+
+            //the damping is relative to diag(J^TJ), hence scale invariant
+            double lambda = 1e-3;
+            double nu = 2.;
+
+            int iter(0);
+            while(iter < _max_iters) {
+                double g2 = g_.squaredNorm();
+
+                std::cout << "iter: " << iter <<
+                          "   obj = " << F <<
+                          "   ||g||^2 = " << g2 <<
+                          "   lambda = " << lambda << std::endl;
+
+                if(g2 < e2) {
+                    std::cout<<"Gradient norm converges!"<<std::endl;
+                    break;
+                }
+
+                ++iter;
+
+                //damped system
+                set_damping(lambda);
+                solver_.factorize(H_);
+                ++n_factorizations_;
+                AOPT_PROFILE_MEMORY("factor", solver_);
+                AOPT_PROFILE_VALUE("factor_fill", MemoryFootprint::fill_ratio(solver_, H_));
+                if(solver_.info() != Eigen::Success) {
+                    lambda *= nu;
+                    nu *= 2;
+                    continue;
+                }
+
+                v_ = solver_.solve(-g_);
+                delta_ = v_;
+
+                //second directional derivative of r along v by finite differences,
+                //r_vv = 2/h ((r(x + hv) - r(x))/h - Jv)
+                if(geodesic_acceleration_) {
+                    const double h = 0.1;
+                    _problem->eval_r(x + h * v_, r_new_);
+                    ++n_eval_r_;
+                    Vec rvv = (2. / h) * ((r_new_ - r_) / h - J_ * v_);
+                    a_ = solver_.solve(-(J_.transpose() * rvv));
+
+                    //ratio measured in the norm scaled by D, as the damping;
+                    //a too large correction is dropped and the plain step is tried
+                    double a2 = (diag_.array() * a_.array().square()).sum();
+                    double v2 = (diag_.array() * v_.array().square()).sum();
+                    if(4. * a2 <= alpha_ * alpha_ * v2)
+                        delta_ += 0.5 * a_;
+                    else
+                        ++n_rejected_accelerations_;
+                }
+
+                if(delta_.norm() <= 1e-12 * (x.norm() + 1e-12)) {
+                    std::cout<<"The step length is too small!"<<std::endl;
+                    break;
+                }
+
+                //gain ratio between actual and predicted decrease
+                x_new_ = x + delta_;
+                _problem->eval_r_and_jacobian(x_new_, r_new_, J_new_);
+                ++n_eval_rj_;
+                double F_new = 0.5 * r_new_.squaredNorm();
+
+                double predicted = -delta_.dot(g_) - 0.5 * (J_ * delta_).squaredNorm();
+                double rho = predicted > 0 ? (F - F_new) / predicted : -1.;
+
+                if(rho > 0) {
+                    x.swap(x_new_);
+                    r_.swap(r_new_);
+                    J_.swap(J_new_);
+                    F = F_new;
+                    g_ = J_.transpose() * r_;
+                    accumulate_jtj();
+
+                    lambda *= std::max(1. / 3., 1. - std::pow(2. * rho - 1., 3));
+                    nu = 2.;
+                } else {
+                    lambda *= nu;
+                    nu *= 2;
+                }
+            }
+
+            std::cout << "#eval_r: " << n_eval_r_ << "   #eval_r_and_jacobian: " << n_eval_rj_
+                      << "   #factorizations: " << n_factorizations_ << std::endl;
+            if(geodesic_acceleration_)
+                std::cout << "#rejected accelerations: " << n_rejected_accelerations_ << std::endl;
+
+            return x;
+        }
+
+        int n_eval_r() const { return n_eval_r_; }
+        int n_eval_r_and_jacobian() const { return n_eval_rj_; }
+        int n_factorizations() const { return n_factorizations_; }
+
+    private:
+        /** builds the lower triangular pattern of J^TJ and, for every pair of nonzeros
+         * (k1, k2) in the same row of J, the position in H_ where J_k1 * J_k2 is added */
+        void init_pattern() {
+            const int n = (int)J_.cols();
+
+            //nonzeros of J grouped by row, and the column of each nonzero
+            std::vector<std::vector<int>> rows(J_.rows());
+            std::vector<int> cols(J_.nonZeros());
+            for(int c = 0; c < n; ++c)
+                for(int k = J_.outerIndexPtr()[c]; k < J_.outerIndexPtr()[c+1]; ++k) {
+                    rows[J_.innerIndexPtr()[k]].push_back(k);
+                    cols[k] = c;
+                }
+
+            std::vector<T> triplets;
+            for(auto& row : rows)
+                for(int k1 : row)
+                    for(int k2 : row)
+                        if(cols[k1] >= cols[k2])
+                            triplets.emplace_back(cols[k1], cols[k2], 0.);
+            for(int i = 0; i < n; ++i)
+                triplets.emplace_back(i, i, 0.);
+
+            H_.resize(n, n);
+            H_.setFromTriplets(triplets.begin(), triplets.end());
+            H_.makeCompressed();
+
+            //value map
+            jtj_map_.clear();
+            for(auto& row : rows)
+                for(int k1 : row)
+                    for(int k2 : row)
+                        if(cols[k1] >= cols[k2])
+                            jtj_map_.push_back({k1, k2, index_of(cols[k1], cols[k2])});
+
+            diag_idx_.resize(n);
+            for(int i = 0; i < n; ++i)
+                diag_idx_[i] = index_of(i, i);
+            diag_.resize(n);
+
+            solver_.analyzePattern(H_);
+        }
+
+        /** H_ = J^TJ (lower triangle) using the cached value map */
+        void accumulate_jtj() {
+            double* h = H_.valuePtr();
+            const double* j = J_.valuePtr();
+            std::fill(h, h + H_.nonZeros(), 0.);
+            for(const auto& e : jtj_map_)
+                h[e.h] += j[e.k1] * j[e.k2];
+
+            for(int i = 0; i < (int)diag_idx_.size(); ++i)
+                diag_[i] = h[diag_idx_[i]];
+        }
+
+        /** only the diagonal changes with lambda: H_ii = (1 + lambda) (J^TJ)_ii */
+        void set_damping(const double _lambda) {
+            double* h = H_.valuePtr();
+            for(int i = 0; i < (int)diag_idx_.size(); ++i)
+                h[diag_idx_[i]] = (1. + _lambda) * std::max(diag_[i], 1e-12);
+        }
+
+        /** position of entry (_r, _c) in H_.valuePtr() */
+        int index_of(const int _r, const int _c) const {
+            const int* inner = H_.innerIndexPtr();
+            const int* begin = inner + H_.outerIndexPtr()[_c];
+            const int* end = inner + H_.outerIndexPtr()[_c+1];
+            return int(std::lower_bound(begin, end, _r) - inner);
+        }
+
+    private:
+        bool geodesic_acceleration_;
+        double alpha_;
+
+        //residuals and Jacobian at the current and the trial iterate
+        Vec r_, r_new_;
+        SMat J_, J_new_;
+        //gradient, steps and trial point
+        Vec g_, v_, a_, delta_, x_new_;
+
+        //damped J^TJ, lower triangle with fixed pattern
+        SMat H_;
+        Eigen::SimplicialLDLT<SMat, Eigen::Lower> solver_;
+        struct Entry { int k1, k2, h; };
+        std::vector<Entry> jtj_map_;
+        std::vector<int> diag_idx_;
+        Vec diag_;
+
+        //statistics
+        int n_eval_r_ = 0, n_eval_rj_ = 0, n_factorizations_ = 0, n_rejected_accelerations_ = 0;
+    };
+
+//=============================================================================
+}
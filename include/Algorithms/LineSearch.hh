@@ -1,6 +1,7 @@
 #pragma once
 
 #include <FunctionBase/FunctionBaseSparse.hh>
+#include <Utils/Profiler.hh>
 
 //== NAMESPACES ===============================================================
 
@@ -13,6 +14,13 @@ namespace AOPT {
         typedef FunctionBaseSparse::Vec Vec;
         typedef FunctionBaseSparse::SMat SMat;
 
+        /* buffers of the line searches, a solver that keeps one between its iterations
+         * avoids allocating the trial points at every call */
+        struct Workspace {
+            // trial point x + t*dx
+            Vec x;
+        };
+
         /** Back-tracking line search method
          *
          * \param _problem a pointer to a specific Problem, which can be any type that
@@ -31,6 +39,23 @@ namespace AOPT {
                                                const double _t0,
                                                const double _alpha = 0.5,
                                                const double _tau = 0.75) {
+            Workspace workspace;
+            return backtracking_line_search(_problem, _x, _g, _dx, _t0, workspace, _alpha, _tau);
+        }
+
+        /** Back-tracking line search with the trial points stored in _workspace,
+         * which does not allocate once _workspace has been used with a vector of
+         * the same size. The other parameters are the same as above. */
+        template <class Problem>
+        static double backtracking_line_search(Problem *_problem,
+                                               const Vec &_x,
+                                               const Vec &_g,
+                                               const Vec &_dx,
+                                               const double _t0,
+                                               Workspace &_workspace,
+                                               const double _alpha = 0.5,
+                                               const double _tau = 0.75) {
+            AOPT_PROFILE_SCOPE("LineSearch::backtracking");
 
             double t(0);
 
@@ -52,8 +77,13 @@ namespace AOPT {
 
             // backtracking (stable in case of NAN)
             int i = 0;
-            while (!(_problem->eval_f(_x + t * _dx) <= fx + _alpha * t * gtdx) && i<1000) {
+            Vec& x = _workspace.x;
+            x.resize(_x.size());
+            x.noalias() = _x + t * _dx;
+            while (!(_problem->eval_f(x) <= fx + _alpha * t * gtdx) && i<1000) {
+                AOPT_PROFILE_COUNT("backtracks");
                 t *= _tau;
+                x.noalias() = _x + t * _dx;
                 i++;
             }
 
@@ -64,6 +94,103 @@ namespace AOPT {
 
 
 
+        /** Nonmonotone back-tracking line search. Instead of f(x), the sufficient
+         * decrease condition uses a reference value _f_ref >= f(x), e.g. the maximum
+         * of the last function values:
+         * f(x + t*dx) <= f_ref + alpha * t * g^T dx
+         *
+         * \param _problem a pointer to a specific Problem, which can be any type that
+         *        has the same interface as FunctionBase's (i.e. with eval_f, eval_gradient, etc.)
+         * \param _x starting point of the method. Should be of the same dimension as the Problem's
+         * \param _g gradient at the starting point.
+         * \param _dx delta x
+         * \param _f_ref reference function value
+         * \param _t0 inital step of the method
+         * \param _alpha and _tau variation constant, as stated by the method's definition
+         * \return the final step t computed by the back-tracking line search */
+        template <class Problem>
+        static double nonmonotone_backtracking_line_search(Problem *_problem,
+                                                           const Vec &_x,
+                                                           const Vec &_g,
+                                                           const Vec &_dx,
+                                                           const double _f_ref,
+                                                           const double _t0,
+                                                           const double _alpha = 1e-4,
+                                                           const double _tau = 0.5) {
+            AOPT_PROFILE_SCOPE("LineSearch::nonmonotone_backtracking");
+            double t = _t0;
+
+            // pre-compute dot product
+            double gtdx = _g.dot(_dx);
+
+            // make sure dx points to a descent direction
+            if (gtdx > 0) {
+                std::cerr << "dx is in the direction that increases the function value. gTdx = "<<gtdx << std::endl;
+                return t;
+            }
+
+            // backtracking (stable in case of NAN)
+            int i = 0;
+            while (!(_problem->eval_f(_x + t * _dx) <= _f_ref + _alpha * t * gtdx) && i<1000) {
+                AOPT_PROFILE_COUNT("backtracks");
+                t *= _tau;
+                i++;
+            }
+
+            return t;
+        }
+
+
+
+        /** Back-tracking line search along the projected path x(t) = P(x + t*dx),
+         * where P clamps onto the box [_lower, _upper]. The sufficient decrease
+         * condition is measured with the actual step, i.e.
+         * f(x(t)) <= f(x) + alpha * g^T (x(t) - x)
+         *
+         * \param _problem a pointer to a specific Problem, which can be any type that
+         *        has the same interface as FunctionBase's (i.e. with eval_f, eval_gradient, etc.)
+         * \param _x starting point of the method, should be feasible
+         * \param _g gradient at the starting point.
+         * \param _dx delta x
+         * \param _lower lower bounds of x
+         * \param _upper upper bounds of x
+         * \param _t0 inital step of the method
+         * \param _alpha and _tau variation constant, as stated by the method's definition
+         * \return the final step t computed by the back-tracking line search */
+        template <class Problem>
+        static double projected_backtracking_line_search(Problem *_problem,
+                                                         const Vec &_x,
+                                                         const Vec &_g,
+                                                         const Vec &_dx,
+                                                         const Vec &_lower,
+                                                         const Vec &_upper,
+                                                         const double _t0,
+                                                         const double _alpha = 1e-4,
+                                                         const double _tau = 0.5) {
+            AOPT_PROFILE_SCOPE("LineSearch::projected_backtracking");
+            double t = _t0;
+
+            // pre-compute objective
+            double fx = _problem->eval_f(_x);
+
+            // backtracking (stable in case of NAN)
+            Vec xt(_x.size());
+            int i = 0;
+            while (i < 1000) {
+                xt = (_x + t * _dx).cwiseMax(_lower).cwiseMin(_upper);
+                if (_problem->eval_f(xt) <= fx + _alpha * _g.dot(xt - _x))
+                    break;
+
+                AOPT_PROFILE_COUNT("backtracks");
+                t *= _tau;
+                i++;
+            }
+
+            return t;
+        }
+
+
+
         /** Back-tracking line search for infeasible start Newton's method
         *
         * \param _problem a pointer to a specific Problem, which can be any type that
@@ -91,6 +218,7 @@ namespace AOPT {
                                                                             const double _alpha = 0.2,
                                                                             const double _beta = 0.9) {
             //------------------------------------------------------//
+            AOPT_PROFILE_SCOPE("LineSearch::infeasible_start_backtracking");
 
             double t = _t0;
 
@@ -116,6 +244,7 @@ namespace AOPT {
                             if(t < 1e-7) {
                                 return t;
                             }
+                            AOPT_PROFILE_COUNT("backtracks");
                             t *= _beta;
                         }
 
@@ -126,15 +255,29 @@ namespace AOPT {
 
 
 
+        /** Line search satisfying the strong Wolfe conditions
+         *
+         * \param _problem a pointer to a specific Problem, which can be any type that
+         *        has the same interface as FunctionBase's (i.e. with eval_f, eval_gradient, etc.)
+         * \param _x starting point of the method. Should be of the same dimension as the Problem's
+         * \param _g gradient at the starting point.
+         * \param _dx delta x
+         * \param _t0 inital step of the method
+         * \param _t_max largest step that is tried
+         * \param _c2 curvature constant, |g(x + t dx)^T dx| <= c2 |g^T dx|. The default 0.9
+         *        suits quasi-Newton methods, nonlinear CG needs a stricter value such as 0.1
+         * \return the final step t computed by the line search */
         template <class Problem>
         static double wolfe_line_search(Problem *_problem,
                                         const Vec &_x,
                                         const Vec &_g,
                                         const Vec &_dx,
-                                        double _t0, double _t_max = 100) {
+                                        double _t0, double _t_max = 100,
+                                        const double _c2 = 0.9) {
             //------------------------------------------------------//
             //TODO: implement the line search algorithm that satisfies wolfe condition
             // reference: "Numerical Optimization", "Algorithm 3.5 (Line Search Algorithm)".
+            AOPT_PROFILE_SCOPE("LineSearch::wolfe");
 
             double t = _t0;
             // reference: "Numerical Optimization", "Algorithm 3.5 (Line Search Algorithm)".
@@ -156,7 +299,7 @@ namespace AOPT {
             }
 
             const double dg_test = 1e-4 * dg_init,
-                    dg_wolfe = -0.9 * dg_init;
+                    dg_wolfe = -_c2 * dg_init;
 
             // first stage:
             // begins with a trial estimate t, and keeps increasing it until it finds either
@@ -165,12 +308,13 @@ namespace AOPT {
             int iter = 1;
             double tp = 0, fxp = fx_init, dgp = dg_init;
             do {
+                AOPT_PROFILE_COUNT("trials");
                 double fx = _problem->eval_f(_x + t * _dx);
                 _problem->eval_gradient(_x + t * _dx, g);
                 const double dg = g.dot(_dx);
 
                 if (fx - fx_init > t * dg_test || (1 < iter && fx >= fxp)) {
-                    t = zoom(_problem, _x, _dx, fx_init, dg_init, fx, fxp, dg, dgp, t, tp);
+                    t = zoom(_problem, _x, _dx, fx_init, dg_init, fx, fxp, dg, dgp, t, tp, _c2);
                     return t;
                 }
 
@@ -178,7 +322,7 @@ namespace AOPT {
                     return t;
 
                 if (dg >= 0) {
-                    t = zoom(_problem, _x, _dx, fx_init, dg_init, fxp, fx, dgp, dg, tp, t);
+                    t = zoom(_problem, _x, _dx, fx_init, dg_init, fxp, fx, dgp, dg, tp, t, _c2);
                     return t;
                 }
 
@@ -213,12 +357,14 @@ namespace AOPT {
                            double _fx_lo,
                            double _dg_hi,
                            double _dg_lo,
-                           double _thi, double _tlo) {
+                           double _thi, double _tlo,
+                           const double _c2) {
             // second stage:
             // successively decreases the size of the interval until
             // an acceptable step length is identified.
+            AOPT_PROFILE_SCOPE("zoom");
             const double dg_test = 1e-4 * _dg_init,
-                    dg_wolfe = -0.9 * _dg_init;
+                    dg_wolfe = -_c2 * _dg_init;
 
             int iter(0);
             Vec g(_problem->n_unknowns());
@@ -258,6 +404,7 @@ namespace AOPT {
                 if (t <= std::min(_tlo, _thi) || t >= std::max(_tlo, _thi))
                     t = (_tlo + _thi) / 2;
 
+                AOPT_PROFILE_COUNT("trials");
                 double fx = _problem->eval_f(_x + t * _dx);
                 _problem->eval_gradient(_x + t * _dx, g);
 
@@ -0,0 +1,218 @@
+#pragma once
+
+#include <cmath>
+#include <algorithm>
+#include <FunctionBase/FunctionBaseSparse.hh>
+#include <Utils/MemoryFootprint.hh>
+#include <Utils/Profiler.hh>
+#include "LineSearch.hh"
+
+//== NAMESPACES ===============================================================
+
+namespace AOPT {
+
+    //== CLASS DEFINITION =========================================================
+
+    /* Gauss-Newton method for F(x) = 1/2 ||r(x)||^2 that never forms J^TJ, nor J.
+     * The step is the least squares solution of
+     *      min_dx ||J dx + r||,
+     * computed by CGLS or LSQR (Paige, Saunders, "LSQR: An algorithm for sparse linear
+     * equations and sparse least squares", 1982), which only need the products Jv and
+     * J^Tw. Both work on J directly, so the condition number is not squared as with the
+     * normal equations, and the memory is a few vectors of size n and m.
+     *
+     * With column scaling, the inner solver works on J D^-1 with D = diag(||J_:,i||)
+     * and dx = D^-1 y. The inner iterations stop when the residual of the normal
+     * equations decreased by the forcing term min(0.5, sqrt(||g||)) (inexact Newton),
+     * and the step length comes from LineSearch's backtracking line search.
+     *
+     * The Problem has to provide n_unknowns(), n_residuals(), eval_f(x), eval_r(x, r),
+     * eval_jacobian_product(x, v, Jv), eval_jacobian_transpose_product(x, w, J^Tw)
+     * and eval_jacobian_column_norms(x, c), see MassSpringProblem2DLeastSquare. */
+    class MatrixFreeGaussNewton {
+    public:
+        typedef FunctionBaseSparse::Vec Vec; ///< Eigen::VectorXd
+
+        enum LinearSolver {
+            CGLS,
+            LSQR
+        };
+
+        /**
+         * \param _problem a pointer to a least squares problem (see above)
+         * \param _initial_x the x starting point
+         * \param _eps the stopping criterion on the gradient norm J^Tr
+         * \param _max_iters maximum number of Gauss-Newton iterations
+         * \param _linear_solver CGLS or LSQR
+         * \param _column_scaling if true, the columns of J are scaled to unit norm
+         * \param _max_inner_iters maximum number of CGLS/LSQR iterations per step,
+         *        0 uses the number of unknowns
+         *
+         * \return the minimum found by the method. */
+        template <class Problem>
+        static Vec solve(Problem *_problem, const Vec& _initial_x, const double _eps = 1e-4, const int _max_iters = 1000,
+                         const LinearSolver _linear_solver = LSQR, const bool _column_scaling = true,
+                         const int _max_inner_iters = 0) {
+            std::cout << "******** Matrix-free Gauss-Newton ("
+                      << (_linear_solver == LSQR ? "LSQR" : "CGLS")
+                      << (_column_scaling ? ", column scaling" : "") << ") ********" << std::endl;
+            AOPT_PROFILE_SCOPE("MatrixFreeGaussNewton::solve");
+
+            double e2 = _eps * _eps;
+
+            const int n = _problem->n_unknowns();
+            const int max_inner_iters = _max_inner_iters > 0 ? _max_inner_iters : n;
+
+            Vec x = _initial_x, r, g, d_inv = Vec::Ones(n), b, y, dx;
+
+            // J(x) D^-1 and its transpose, evaluated on the fly
+            int n_products(0);
+            auto A = [&](const Vec& _v, Vec& _av) {
+                _problem->eval_jacobian_product(x, d_inv.cwiseProduct(_v), _av);
+                ++n_products;
+            };
+            auto At = [&](const Vec& _w, Vec& _atw) {
+                _problem->eval_jacobian_transpose_product(x, _w, _atw);
+                _atw.array() *= d_inv.array();
+                ++n_products;
+            };
+
+            int iter(0), n_inner(0);
+            while (iter < _max_iters) {
+                _problem->eval_r(x, r);
+                _problem->eval_jacobian_transpose_product(x, r, g);
+                double f = 0.5 * r.squaredNorm();
+                double g2 = g.squaredNorm();
+
+                std::cout << "iter: " << iter <<
+                          "   obj = " << f <<
+                          "   ||g||^2 = " << g2 << std::endl;
+
+                if (g2 <= e2) {
+                    std::cout << "Gradient norm converges!" << std::endl;
+                    break;
+                }
+
+                if (_column_scaling) {
+                    _problem->eval_jacobian_column_norms(x, d_inv);
+                    for (int i = 0; i < n; ++i)
+                        d_inv[i] = d_inv[i] > 0 ? 1. / d_inv[i] : 1.;
+                }
+
+                b = -r;
+                double eta = std::min(0.5, std::sqrt(std::sqrt(g2)));
+                n_inner += _linear_solver == LSQR ? lsqr(A, At, b, n, eta, max_inner_iters, y)
+                                                  : cgls(A, At, b, n, eta, max_inner_iters, y);
+                dx = d_inv.cwiseProduct(y);
+                AOPT_PROFILE_MEMORY("vectors", MemoryFootprint::of(x) + MemoryFootprint::of(r) + MemoryFootprint::of(g)
+                                               + MemoryFootprint::of(d_inv) + MemoryFootprint::of(b) + MemoryFootprint::of(y)
+                                               + MemoryFootprint::of(dx));
+
+                double t = LineSearch::backtracking_line_search(_problem, x, g, dx, 1.);
+                if (t * dx.norm() < 1e-16) {
+                    std::cout << "The step length is too small!" << std::endl;
+                    break;
+                }
+
+                x += t * dx;
+                ++iter;
+            }
+
+            std::cout << "#inner iterations: " << n_inner << "   #Jv and J^Tw products: " << n_products << std::endl;
+
+            return x;
+        }
+
+    private:
+        /** CGLS, i.e. CG on A^TA y = A^Tb without forming A^TA.
+         * Stops when ||A^T(b - Ay)|| <= _eta ||A^Tb||.
+         * \return the number of iterations */
+        template <class Op, class OpT>
+        static int cgls(Op& _A, OpT& _At, const Vec& _b, const int _n, const double _eta, const int _max_iters, Vec& _y) {
+            _y.setZero(_n);
+            Vec s = _b, q, p, t;
+            _At(s, q);
+            p = q;
+            double gamma = q.squaredNorm();
+            const double tol2 = _eta * _eta * gamma;
+
+            int k(0);
+            while (k < _max_iters && gamma > tol2) {
+                _A(p, t);
+                double tt = t.squaredNorm();
+                if (tt <= 0)
+                    break;
+                double alpha = gamma / tt;
+                _y += alpha * p;
+                s -= alpha * t;
+                _At(s, q);
+                double gamma_new = q.squaredNorm();
+                p = q + (gamma_new / gamma) * p;
+                gamma = gamma_new;
+                ++k;
+            }
+            AOPT_PROFILE_MEMORY("cgls_vectors", MemoryFootprint::of(s) + MemoryFootprint::of(q) + MemoryFootprint::of(p)
+                                                + MemoryFootprint::of(t));
+            return k;
+        }
+
+        /** LSQR, mathematically equivalent to CGLS but more stable when A is
+         * ill-conditioned. Uses the same stopping criterion as cgls().
+         * \return the number of iterations */
+        template <class Op, class OpT>
+        static int lsqr(Op& _A, OpT& _At, const Vec& _b, const int _n, const double _eta, const int _max_iters, Vec& _y) {
+            _y.setZero(_n);
+
+            // Golub-Kahan bidiagonalization
+            double beta = _b.norm();
+            if (beta <= 0)
+                return 0;
+            Vec u = _b / beta, v, w, av;
+            _At(u, v);
+            double alpha = v.norm();
+            if (alpha <= 0)
+                return 0;
+            v /= alpha;
+            w = v;
+
+            double phibar = beta, rhobar = alpha;
+            const double tol = _eta * alpha * beta;
+
+            int k(0);
+            while (k < _max_iters) {
+                _A(v, av);
+                u = av - alpha * u;
+                beta = u.norm();
+                if (beta > 0)
+                    u /= beta;
+
+                _At(u, av);
+                v = av - beta * v;
+                alpha = v.norm();
+                if (alpha > 0)
+                    v /= alpha;
+
+                // plane rotation eliminating beta
+                double rho = std::hypot(rhobar, beta);
+                double c = rhobar / rho, s = beta / rho;
+                double theta = s * alpha;
+                rhobar = -c * alpha;
+                double phi = c * phibar;
+                phibar *= s;
+
+                _y += (phi / rho) * w;
+                w = v - (theta / rho) * w;
+                ++k;
+
+                // ||A^T(b - Ay)|| = phibar * alpha * |c|
+                if (phibar * alpha * std::abs(c) <= tol || alpha <= 0)
+                    break;
+            }
+            AOPT_PROFILE_MEMORY("lsqr_vectors", MemoryFootprint::of(u) + MemoryFootprint::of(v) + MemoryFootprint::of(w)
+                                                + MemoryFootprint::of(av));
+            return k;
+        }
+    };
+
+//=============================================================================
+}
@@ -1,6 +1,9 @@
 #pragma once
 
 #include <FunctionBase/FunctionBaseSparse.hh>
+#include <Utils/MemoryFootprint.hh>
+#include <Utils/Profiler.hh>
+#include <Utils/RefactorizableLLT.hh>
 #include "LineSearch.hh"
 
 //== NAMESPACES ===============================================================
@@ -25,6 +28,7 @@ namespace AOPT {
          * \param _max_iters maximum iteration of the method*/
         static Vec solve(FunctionBaseSparse *_problem, const Vec& _initial_x, const double _eps = 1e-4, const int _max_iters = 1000000) {
             std::cout << "******** Newton Method ********" << std::endl;
+            AOPT_PROFILE_SCOPE("NewtonMethods::solve");
 
             // squared epsilon for stopping criterion
             double e2 = 2* _eps * _eps;
@@ -45,7 +49,15 @@ namespace AOPT {
             int iter(0);
 
 
-            Eigen::SimplicialLLT<SMat> solver;
+            // the hessians have the same pattern, after the first iteration only the
+            // numeric factorization is done
+            RefactorizableLLT<SMat> solver;
+            LineSearch::Workspace workspace;
+
+            // a constant hessian is evaluated and factorized only once, and on a
+            // quadratic the full step reaches the minimum, the next iteration only checks it
+            const bool constant_hessian = _problem->has_constant_hessian();
+            const bool quadratic = _problem->is_quadratic();
   
             //------------------------------------------------------//
             //TODO: implement Newton method
@@ -54,19 +66,24 @@ namespace AOPT {
 
             do {
                 ++iter;
+                AOPT_PROFILE_COUNT("iterations");
 
                 // solve for search direction
-                _problem->eval_gradient(x, g);
-                _problem->eval_hessian(x, H);
+                eval_gradient(_problem, x, g);
 
-                // H dx = -g
-                solver.compute(H);
-                if(solver.info() == Eigen::NumericalIssue) {
-                    std::cerr << "Warning: LLT factorization has numerical issue!" << std::endl;
-                    break;
+                if(iter == 1 || !constant_hessian) {
+                    eval_hessian(_problem, x, H);
+
+                    // H dx = -g
+                    factorize(solver, H);
+                    if(solver.info() == Eigen::NumericalIssue) {
+                        std::cerr << "Warning: LLT factorization has numerical issue!" << std::endl;
+                        break;
+                    }
                 }
 
-                delta_x = solver.solve(-g);
+                delta_x = -g;
+                back_substitute(solver, delta_x, delta_x);
 
                 // Newton decrement
                 double lambda2 = -g.transpose() * delta_x;
@@ -83,7 +100,7 @@ namespace AOPT {
 
 
                 // step size
-                double t = LineSearch::backtracking_line_search(_problem, x, g, delta_x, 1.0);
+                double t = quadratic ? 1.0 : LineSearch::backtracking_line_search(_problem, x, g, delta_x, 1.0, workspace);
 //            t = LineSearch::wolfe_line_search(_problem, x, g, delta_x, t);
 
                 // update
@@ -115,6 +132,7 @@ namespace AOPT {
         static Vec solve_with_projected_hessian(FunctionBaseSparse *_problem, bool& _converged, const Vec& _initial_x, const double _gamma = 10.0,
                                                 const double _eps = 1e-4, const int _max_iters = 1000000) {
             std::cout << "******** Newton Method with projected hessian ********" << std::endl;
+            AOPT_PROFILE_SCOPE("NewtonMethods::solve_with_projected_hessian");
 
             // squared epsilon for stopping criterion
             double e2 = 2*_eps * _eps;
@@ -140,7 +158,14 @@ namespace AOPT {
 
             _converged = false;
 
-            Eigen::SimplicialLLT<SMat> solver;
+            RefactorizableLLT<SMat> solver;
+            LineSearch::Workspace workspace;
+
+            // a constant hessian is projected and factorized only once, on a convex
+            // quadratic (no projection needed) the full step reaches the minimum
+            const bool constant_hessian = _problem->has_constant_hessian();
+            const bool quadratic = _problem->is_quadratic();
+            int cnt = 0;
 
             //------------------------------------------------------//
             //TODO: implement Newton with projected hessian method
@@ -150,36 +175,39 @@ namespace AOPT {
 
             do {
                 ++iter;
+                AOPT_PROFILE_COUNT("iterations");
 
                 // solve for search direction
-                _problem->eval_gradient(x, g);
-                _problem->eval_hessian(x, H);
+                eval_gradient(_problem, x, g);
 
-                int cnt = 0;
-                double delta = 0.;
-                
-                std::cout<<" H = "<<H<<std::endl;
+                if(iter == 1 || !constant_hessian) {
+                    eval_hessian(_problem, x, H);
 
+                    cnt = 0;
+                    double delta = 0.;
 
-                solver.compute(H);
-                bool is_not_psd = solver.info() == Eigen::NumericalIssue;
-                std::cout<<" psd: "<<!is_not_psd<<std::endl;
+                    factorize(solver, H);
+                    bool is_not_psd = solver.info() == Eigen::NumericalIssue;
+                    std::cout<<" psd: "<<!is_not_psd<<std::endl;
 
-                while (is_not_psd && cnt < _max_iters) {
-                    if (cnt == 0) {
-                        delta = 1e-3 * std::abs(H.diagonal().sum()) / double(n);
-                    }
-                    H += delta * I;
+                    while (is_not_psd && cnt < _max_iters) {
+                        if (cnt == 0) {
+                            delta = 1e-3 * std::abs(H.diagonal().sum()) / double(n);
+                        }
+                        H += delta * I;
 
-                    solver.compute(H);
-                    is_not_psd = solver.info() == Eigen::NumericalIssue;
-                    cnt++;
-                    delta *= _gamma;
+                        AOPT_PROFILE_COUNT("psd_retries");
+                        factorize(solver, H);
+                        is_not_psd = solver.info() == Eigen::NumericalIssue;
+                        cnt++;
+                        delta *= _gamma;
+                    }
                 }
-                delta_x = solver.solve(-g);
+                delta_x = -g;
+                back_substitute(solver, delta_x, delta_x);
 
                 // Newton decrement
-                double lambda2 = g.transpose() * (-delta_x);
+                double lambda2 = -g.transpose() * delta_x;
 
                 double f = _problem->eval_f(x);
 
@@ -195,7 +223,7 @@ namespace AOPT {
                 }
 
                 // step size
-                double t = LineSearch::backtracking_line_search(_problem, x, g, delta_x, 1.);
+                double t = (quadratic && cnt == 0) ? 1. : LineSearch::backtracking_line_search(_problem, x, g, delta_x, 1., workspace);
 
                 // update
                 x += t * delta_x;
@@ -223,6 +251,7 @@ namespace AOPT {
         static Vec solve_equality_constrained(FunctionBaseSparse *_problem, const Vec& _initial_x, const SMat &_A, const Vec &_b,
                                               const double _eps = 1e-4, const int _max_iters = 1000) {
             std::cerr << "******** Equality Constrained Newton ********" << std::endl;
+            AOPT_PROFILE_SCOPE("NewtonMethods::solve_equality_constrained");
 
             double eps2 = 2.0 *_eps * _eps;
 
@@ -256,6 +285,10 @@ namespace AOPT {
             int iter(0);
 
             Eigen::SparseLU<SMat> solver;
+
+            // the KKT matrix of a constant hessian is factorized only once
+            const bool constant_hessian = _problem->has_constant_hessian();
+            const bool quadratic = _problem->is_quadratic();
             //------------------------------------------------------//
             //TODO: implement the Newton with equality constraints
             //Hint: the function to set up the KKT matrix is
@@ -263,20 +296,24 @@ namespace AOPT {
             double fp = std::numeric_limits<double>::max();
 
             while (iter < _max_iters) {
+                AOPT_PROFILE_COUNT("iterations");
+
                 // get gradient
-                _problem->eval_gradient(x, g);
+                eval_gradient(_problem, x, g);
 
-                // get hessian
-                _problem->eval_hessian(x, H);
+                if(iter == 0 || !constant_hessian) {
+                    // get hessian
+                    eval_hessian(_problem, x, H);
 
-                setup_KKT_matrix(H, _A, K);
+                    setup_KKT_matrix(H, _A, K);
+                    factorize(solver, K);
+                }
 
                 rhs.setZero(n + p);
                 rhs.head(n) = -g;
 
                 // solve for constrained Newton step
-                solver.compute(K);
-                dxl = solver.solve(rhs);
+                back_substitute(solver, rhs, dxl);
 
                 // extract primal variables
                 dx = dxl.head(n);
@@ -294,8 +331,8 @@ namespace AOPT {
                 if (lambda2 <= eps2 || f >= fp)
                     break;
 
-                // step size
-                double t = LineSearch::backtracking_line_search(_problem, x, g, dx, 1.);
+                // step size, the full step is exact on a quadratic
+                double t = quadratic ? 1. : LineSearch::backtracking_line_search(_problem, x, g, dx, 1.);
 
                 // update
                 x += t * dx;
@@ -312,6 +349,7 @@ namespace AOPT {
         static Vec solve_equality_constrained_with_infeasible_start(FunctionBaseSparse *_problem, const Vec& _initial_x, const SMat &_A, const Vec &_b,
                                                                     const double _eps = 1e-4, const double _eps_constraints = 1e-4, const int _max_iters = 1000) {
             std::cerr << "******** Equality Constrained Newton with Infeasible Start Point********" << std::endl;
+            AOPT_PROFILE_SCOPE("NewtonMethods::solve_equality_constrained_with_infeasible_start");
             // get number of unknowns
             int n = _problem->n_unknowns();
 
@@ -349,6 +387,11 @@ namespace AOPT {
             double res(0);
 
             Eigen::SparseLU<SMat> solver;
+
+            // the KKT matrix of a constant hessian is factorized only once
+            const bool constant_hessian = _problem->has_constant_hessian();
+            const bool quadratic = _problem->is_quadratic();
+            bool factorized = false;
             //------------------------------------------------------//
             //TODO: implement the Newton with equality constraints
             //count number of iterations
@@ -356,8 +399,10 @@ namespace AOPT {
             double f, fp = std::numeric_limits<double>::max();
 
             while (iter < _max_iters) {
+                AOPT_PROFILE_COUNT("iterations");
+
                 //get gradient
-                _problem->eval_gradient(x, g);
+                eval_gradient(_problem, x, g);
 
                 //get function value
                 f = _problem->eval_f(x);
@@ -386,10 +431,14 @@ namespace AOPT {
                 }
 
 
-                // get hessian
-                _problem->eval_hessian(x, H);
+                if(!factorized || !constant_hessian) {
+                    // get hessian
+                    eval_hessian(_problem, x, H);
 
-                setup_KKT_matrix(H, _A, K);
+                    setup_KKT_matrix(H, _A, K);
+                    factorize(solver, K);
+                    factorized = true;
+                }
 
                 //set right hand side
                 rhs.setZero(n + p);
@@ -399,8 +448,7 @@ namespace AOPT {
                 rhs.tail(p) = -rpri;
 
                 // solve for constrained Newton step
-                solver.compute(K);
-                dxl = solver.solve(rhs);
+                back_substitute(solver, rhs, dxl);
 
                 //get dx
                 dx = dxl.head(n);
@@ -408,8 +456,8 @@ namespace AOPT {
                 //get dnu
                 dnu = dxl.tail(p);
 
-                // step size
-                double t = LineSearch::backtracking_line_search_newton_with_infeasible_start(_problem, _A, _b, x, nu, dx, dnu, res, 1.);
+                // step size, the full step solves the KKT system of a quadratic
+                double t = quadratic ? 1. : LineSearch::backtracking_line_search_newton_with_infeasible_start(_problem, _A, _b, x, nu, dx, dnu, res, 1.);
                 // update
                 nu += t * dnu;
                 x += t * dx;
@@ -428,6 +476,7 @@ namespace AOPT {
         static Vec solve_equality_constrained_hybrid(FunctionBaseSparse *_problem, const Vec& _initial_x, const SMat &_A, const Vec &_b,
                                                                     const double _eps = 1e-4, const double _eps_constraints = 1e-4, const int _max_iters = 1000) {
             std::cerr << "******** Equality Constrained Newton with hybrid method********" << std::endl;
+            AOPT_PROFILE_SCOPE("NewtonMethods::solve_equality_constrained_hybrid");
             // epsilon for newton decrement
             double eps2 = 2.0 *_eps * _eps;
 
@@ -469,6 +518,11 @@ namespace AOPT {
             double res(0);
 
             Eigen::SparseLU<SMat> solver;
+
+            // the KKT matrix of a constant hessian is factorized only once
+            const bool constant_hessian = _problem->has_constant_hessian();
+            const bool quadratic = _problem->is_quadratic();
+            bool factorized = false;
             //------------------------------------------------------//
             //TODO: implement the Newton with equality constraints
             //count number of iterations
@@ -476,11 +530,13 @@ namespace AOPT {
             double f, fp = std::numeric_limits<double>::max();
 
             while (iter < _max_iters) {
+                AOPT_PROFILE_COUNT("iterations");
+
                 //get function value
                 f = _problem->eval_f(x);
 
                 //get gradient
-                _problem->eval_gradient(x, g);
+                eval_gradient(_problem, x, g);
 
                 //compute the residual of the primal
                 rpri = _A * x - _b;
@@ -515,10 +571,14 @@ namespace AOPT {
                         break;
                 }
 
-                // get hessian
-                _problem->eval_hessian(x, H);
+                if(!factorized || !constant_hessian) {
+                    // get hessian
+                    eval_hessian(_problem, x, H);
 
-                setup_KKT_matrix(H, _A, K);
+                    setup_KKT_matrix(H, _A, K);
+                    factorize(solver, K);
+                    factorized = true;
+                }
 
                 rhs.setZero(n + p);
                 rhs.head(n) = -g;
@@ -528,8 +588,7 @@ namespace AOPT {
                     rhs.tail(p) = -rpri;
 
                 // solve for constrained Newton step
-                solver.compute(K);
-                dxl = solver.solve(rhs);
+                back_substitute(solver, rhs, dxl);
 
                 dx = dxl.head(n);
 
@@ -538,13 +597,13 @@ namespace AOPT {
                     dnu = dxl.tail(p) - nu;
 
                     // step size
-                    double t = LineSearch::backtracking_line_search_newton_with_infeasible_start(_problem, _A, _b, x, nu, dx, dnu, res, 1.);
+                    double t = quadratic ? 1. : LineSearch::backtracking_line_search_newton_with_infeasible_start(_problem, _A, _b, x, nu, dx, dnu, res, 1.);
                     // update
                     nu += t * dnu;
                     x += t * dx;
                 } else { //use feasible start newton
                     // step size
-                    double t = LineSearch::backtracking_line_search(_problem, x, g, dx, 1.);
+                    double t = quadratic ? 1. : LineSearch::backtracking_line_search(_problem, x, g, dx, 1.);
 
                     // update
                     x += t * dx;
@@ -590,9 +649,44 @@ namespace AOPT {
         }
 
     private:
-        
+        /* the steps of the methods, each timed as a scope of the Profiler, which also records
+         * the sizes of the hessian, the KKT matrix and the factors, see MemoryFootprint */
+
+        static void eval_gradient(FunctionBaseSparse *_problem, const Vec &_x, Vec &_g) {
+            AOPT_PROFILE_SCOPE("eval_gradient");
+            _problem->eval_gradient(_x, _g);
+        }
+
+        static void eval_hessian(FunctionBaseSparse *_problem, const Vec &_x, SMat &_H) {
+            AOPT_PROFILE_SCOPE("eval_hessian");
+            _problem->eval_hessian(_x, _H);
+            AOPT_PROFILE_MEMORY("hessian", _H);
+        }
+
+        template <class Solver>
+        static void factorize(Solver &_solver, const SMat &_M) {
+            AOPT_PROFILE_COUNT("factorizations");
+            AOPT_PROFILE_SCOPE("factorization");
+            _solver.compute(_M);
+            AOPT_PROFILE_MEMORY("matrix", _M);
+            AOPT_PROFILE_MEMORY("factor", _solver);
+            AOPT_PROFILE_VALUE("factor_fill", MemoryFootprint::fill_ratio(_solver, _M));
+        }
+
+        template <class Solver>
+        static void back_substitute(const Solver &_solver, const Vec &_rhs, Vec &_x) {
+            AOPT_PROFILE_SCOPE("back_substitution");
+            _x = _solver.solve(_rhs);
+        }
+
+        // _rhs and _x can be the same vector
+        static void back_substitute(const RefactorizableLLT<SMat> &_solver, const Vec &_rhs, Vec &_x) {
+            AOPT_PROFILE_SCOPE("back_substitution");
+            _solver.solve(_rhs, _x);
+        }
 
         static void setup_KKT_matrix(const SMat &_H, const SMat &_A, SMat& _K) {
+            AOPT_PROFILE_SCOPE("kkt_assembly");
             const int n  = static_cast<int>(_H.cols());
             const int m  = static_cast<int>(_A.rows());
             const int nf = n+m;
@@ -621,6 +715,9 @@ namespace AOPT {
             // create KKT matrix
             _K.resize(nf,nf);
             _K.setFromTriplets(trips.begin(), trips.end());
+            AOPT_PROFILE_MEMORY("kkt_triplets", trips);
+            AOPT_PROFILE_MEMORY("kkt", _K);
+            AOPT_PROFILE_VALUE("kkt_rows", nf);
         }
     };
 
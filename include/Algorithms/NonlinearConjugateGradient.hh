@@ -0,0 +1,159 @@
+#pragma once
+
+#include <cmath>
+#include <algorithm>
+#include <FunctionBase/FunctionBaseSparse.hh>
+#include <Utils/MemoryFootprint.hh>
+#include <Utils/Profiler.hh>
+#include "LineSearch.hh"
+
+//== NAMESPACES ===============================================================
+
+namespace AOPT {
+
+    /* Nonlinear conjugate gradient method, see "Numerical Optimization", chapter 5.2,
+     * and Hager, Zhang, "A survey of nonlinear conjugate gradient methods", 2006.
+     *
+     * The search direction is d_k+1 = -g_k+1 + beta_k d_k, with y_k = g_k+1 - g_k and
+     * - PR+:    beta = max(0, g_k+1^T y_k / g_k^T g_k)        (Polak-Ribiere)
+     * - HS:     beta = g_k+1^T y_k / d_k^T y_k                  (Hestenes-Stiefel)
+     * - DY:     beta = g_k+1^T g_k+1 / d_k^T y_k                (Dai-Yuan)
+     * - HYBRID: beta = max(0, min(beta_HS, beta_DY))            (Dai-Yuan hybrid)
+     * The step comes from LineSearch's strong Wolfe search. The method restarts with
+     * the steepest descent direction every _restart_every iterations, when successive
+     * gradients are far from orthogonal (Powell) or when d is no descent direction.
+     *
+     * Apart from the line search, only x, g, g_k+1 and d are stored, i.e. the memory
+     * is O(n) whereas LBFGS needs 2m additional vectors. */
+    class NonlinearConjugateGradient {
+    public:
+        typedef FunctionBaseSparse::Vec Vec; ///< Eigen::VectorXd
+
+        enum Variant {
+            PR_PLUS,
+            HS,
+            DY,
+            HYBRID
+        };
+
+        /**
+         * \param _problem a pointer to a specific Problem, which can be any type that
+         *        has the same interface as FunctionBase's (i.e. with eval_f, eval_gradient, etc.)
+         * \param _initial_x  the x starting point
+         * \param _eps the stopping criterion on the gradient norm
+         * \param _max_iters maximum number of iterations
+         * \param _variant formula of beta
+         * \param _restart_every number of iterations between two periodic restarts,
+         *        0 uses the number of unknowns
+         * \param _c2 curvature constant of the strong Wolfe conditions
+         *
+         * \return the minimum found by the method. */
+        template <class Problem>
+        static Vec solve(Problem *_problem, const Vec& _initial_x, const double _eps = 1e-4, const int _max_iters = 1000000,
+                         const Variant _variant = HYBRID, const int _restart_every = 0, const double _c2 = 0.1) {
+            std::cout << "******** Nonlinear Conjugate Gradient ********" << std::endl;
+            AOPT_PROFILE_SCOPE("NonlinearConjugateGradient::solve");
+
+            // squared epsilon for stopping criterion
+            double e2 = _eps * _eps;
+
+            int n = _problem->n_unknowns();
+            const int restart_every = _restart_every > 0 ? _restart_every : n;
+
+            Vec x = _initial_x, g(n), g_new(n), d(n);
+            AOPT_PROFILE_MEMORY("vectors", MemoryFootprint::of(x) + MemoryFootprint::of(g) + MemoryFootprint::of(g_new)
+                                           + MemoryFootprint::of(d));
+
+            double f = _problem->eval_f(x);
+            _problem->eval_gradient(x, g);
+            d = -g;
+
+            // previous step and slope, used for the initial step of the line search
+            double t(0), gd_prev(0);
+            int iter(0), n_restarts(0), since_restart(0);
+
+            do {
+                double g2 = g.squaredNorm();
+
+                // print status
+                std::cout << "iter: " << iter <<
+                          "   obj = " << f <<
+                          "   ||g||^2 = " << g2 << std::endl;
+
+                if (g2 <= e2)
+                    break;
+
+                double gd = g.dot(d);
+                if (gd >= 0) {
+                    // not a descent direction
+                    d = -g;
+                    gd = -g2;
+                    ++n_restarts;
+                    since_restart = 0;
+                }
+
+                // initial step: same first-order change as in the last iteration
+                double t0 = iter == 0 ? std::min(1., 1. / std::sqrt(g2)) : t * gd_prev / gd;
+                t = LineSearch::wolfe_line_search(_problem, x, g, d, t0, 100. * std::max(t0, 1.), _c2);
+
+                if (t < 1e-16) {
+                    std::cout << "The step length is too small!" << std::endl;
+                    break;
+                }
+
+                x += t * d;
+                double fp = f;
+                f = _problem->eval_f(x);
+
+                if (fp <= f) {
+                    std::cout << "Function value converges!" << std::endl;
+                    break;
+                }
+
+                _problem->eval_gradient(x, g_new);
+
+                // y = g_new - g only enters through dot products
+                double gn2 = g_new.squaredNorm();
+                double gn_g = g_new.dot(g);
+                double gn_y = gn2 - gn_g;
+                double d_y = d.dot(g_new) - gd;
+
+                double beta(0);
+                switch (_variant) {
+                    case PR_PLUS:
+                        beta = std::max(0., gn_y / g2);
+                        break;
+                    case HS:
+                        beta = d_y != 0 ? gn_y / d_y : 0.;
+                        break;
+                    case DY:
+                        beta = d_y != 0 ? gn2 / d_y : 0.;
+                        break;
+                    case HYBRID:
+                        beta = d_y != 0 ? std::max(0., std::min(gn_y, gn2) / d_y) : 0.;
+                        break;
+                }
+
+                // restarts
+                ++since_restart;
+                if (since_restart >= restart_every || std::abs(gn_g) >= 0.2 * gn2) {
+                    beta = 0.;
+                    ++n_restarts;
+                    since_restart = 0;
+                }
+
+                d *= beta;
+                d -= g_new;
+
+                g.swap(g_new);
+                gd_prev = gd;
+                ++iter;
+
+            } while (iter < _max_iters);
+
+            std::cout << "number of restarts: " << n_restarts << std::endl;
+
+            return x;
+        }
+    };
+}
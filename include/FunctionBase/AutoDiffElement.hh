@@ -0,0 +1,83 @@
+#pragma once
+
+#include <array>
+#include <FunctionBase/ParametricFunctionBase.hh>
+#include <Utils/AutoDiff.hh>
+
+//== NAMESPACES ===============================================================
+
+namespace AOPT {
+
+    //== CLASS DEFINITION =========================================================
+
+    /* Base of an element function whose gradient and Hessian are generated by forward
+     * mode automatic differentiation (see Utils/AutoDiff.hh).
+     *
+     * This uses the CRTP: the Derived class only implements its energy as a template
+     * over the scalar type
+     *      template <class S> S energy(const std::array<S, N>& _x, const Vec& _coeffs) const
+     * which is instantiated with double for eval_f(), with Dual<N> for eval_gradient()
+     * and with HyperDual<N> for eval_hessian(). The number of unknowns N is a compile
+     * time constant, so no memory is allocated and the energy is inlined.
+     *
+     * eval_local() computes all of them at once on fixed size vectors, without the
+     * virtual call. */
+    template <class Derived, int N>
+    class AutoDiffElement : public ParametricFunctionBase {
+    public:
+        using LocalVec = Eigen::Matrix<double, N, 1>;
+        using LocalMat = Eigen::Matrix<double, N, N>;
+
+        AutoDiffElement() : ParametricFunctionBase() {}
+
+        inline virtual int n_unknowns() override { return N; }
+
+        // the energy is const, so the evaluations do not modify the element
+        inline virtual bool is_thread_safe() override { return true; }
+
+        AOPT_AUTODIFF_FLATTEN inline virtual double eval_f(const Vec &_x, const Vec &_coeffs) override {
+            std::array<double, N> x;
+            for(int i = 0; i < N; ++i)
+                x[i] = _x[i];
+            return derived().energy(x, _coeffs);
+        }
+
+        AOPT_AUTODIFF_FLATTEN inline virtual void eval_gradient(const Vec &_x, const Vec &_coeffs, Vec &_g) override {
+            const Dual<N> e = derived().energy(variables<Dual<N>, N>(_x), _coeffs);
+            _g = e.gradient();
+        }
+
+        AOPT_AUTODIFF_FLATTEN inline virtual void eval_hessian(const Vec &_x, const Vec &_coeffs, Mat &_H) override {
+            const HyperDual<N> e = derived().energy(variables<HyperDual<N>, N>(_x), _coeffs);
+            _H = e.hessian();
+        }
+
+        /** evaluates the energy and, if not null, its gradient and Hessian in a single pass
+         * \param _g the output gradient
+         * \param _H the output Hessian
+         * \return the energy */
+        AOPT_AUTODIFF_FLATTEN double eval_local(const LocalVec &_x, const Vec &_coeffs, LocalVec *_g = nullptr, LocalMat *_H = nullptr) const {
+            if(_H != nullptr) {
+                const HyperDual<N> e = derived().energy(variables<HyperDual<N>, N>(_x), _coeffs);
+                if(_g != nullptr)
+                    *_g = e.gradient();
+                *_H = e.hessian();
+                return e.v;
+            }
+            if(_g != nullptr) {
+                const Dual<N> e = derived().energy(variables<Dual<N>, N>(_x), _coeffs);
+                *_g = e.gradient();
+                return e.v;
+            }
+            std::array<double, N> x;
+            for(int i = 0; i < N; ++i)
+                x[i] = _x[i];
+            return derived().energy(x, _coeffs);
+        }
+
+    private:
+        const Derived& derived() const { return static_cast<const Derived&>(*this); }
+    };
+
+//=============================================================================
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <FunctionBase/FunctionBaseSparse.hh>
+#include <Utils/AutoDiff.hh>
+
+//== NAMESPACES ===============================================================
+
+namespace AOPT {
+
+    //== CLASS DEFINITION =========================================================
+
+    /* Base of a function of n unknowns that only depends on N of them, e.g. a
+     * constraint on a few nodes of a mass spring system, whose gradient and Hessian
+     * are generated by forward mode automatic differentiation (see Utils/AutoDiff.hh).
+     *
+     * This uses the CRTP: the Derived class only implements
+     *      template <class S> S energy(const std::array<S, N>& _x) const
+     * where _x[i] = x[indices[i]], and the derivatives are scattered into the n
+     * dimensional gradient and the n x n sparse Hessian. */
+    template <class Derived, int N>
+    class AutoDiffSparseFunction : public FunctionBaseSparse {
+    public:
+        using Indices = std::array<int, N>;
+
+        /**
+         * \param _n number of unknowns
+         * \param _indices indices of the N unknowns the function depends on */
+        AutoDiffSparseFunction(const int _n, const Indices &_indices) : FunctionBaseSparse(), n_(_n), indices_(_indices) {}
+
+        inline virtual int n_unknowns() override { return n_; }
+
+        const Indices& indices() const { return indices_; }
+
+        AOPT_AUTODIFF_FLATTEN inline virtual double eval_f(const Vec &_x) override {
+            return derived().energy(gather(_x));
+        }
+
+        AOPT_AUTODIFF_FLATTEN inline virtual void eval_gradient(const Vec &_x, Vec &_g) override {
+            const Dual<N> e = derived().energy(variables<Dual<N>, N>(gather(_x)));
+
+            _g.setZero();
+            for(int i = 0; i < N; ++i)
+                _g[indices_[i]] += e.g[i];
+        }
+
+        AOPT_AUTODIFF_FLATTEN inline virtual void eval_hessian(const Vec &_x, SMat &_h) override {
+            const HyperDual<N> e = derived().energy(variables<HyperDual<N>, N>(gather(_x)));
+
+            std::vector<T> triplets;
+            triplets.reserve(N * N);
+            for(int i = 0, k = 0; i < N; ++i)
+                for(int j = i; j < N; ++j, ++k) {
+                    triplets.emplace_back(indices_[i], indices_[j], e.h[k]);
+                    if(j != i)
+                        triplets.emplace_back(indices_[j], indices_[i], e.h[k]);
+                }
+            _h.resize(n_, n_);
+            _h.setFromTriplets(triplets.begin(), triplets.end());
+        }
+
+    private:
+        const Derived& derived() const { return static_cast<const Derived&>(*this); }
+
+        std::array<double, N> gather(const Vec &_x) const {
+            std::array<double, N> x;
+            for(int i = 0; i < N; ++i)
+                x[i] = _x[indices_[i]];
+            return x;
+        }
+
+    private:
+        int n_;
+        Indices indices_;
+    };
+
+//=============================================================================
+}
@@ -23,6 +23,14 @@ namespace AOPT {
             return param_func_.n_unknowns();
         }
 
+        virtual bool is_quadratic(){
+            return param_func_.is_quadratic();
+        }
+
+        virtual bool has_constant_hessian(){
+            return param_func_.has_constant_hessian();
+        }
+
         // funcion evaluation
         virtual double eval_f(const Vec &_x){
             return param_func_.eval_f(_x, coeffs_);
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <FunctionBase/FunctionBaseSparse.hh>
+#include <Utils/SparseFiniteDifferences.hh>
+
+
+namespace AOPT {
+
+    /**
+     * \brief wrapper providing eval_hessian by sparse finite differences of eval_gradient,
+     * for functions without (or with an untrusted) analytic hessian.
+     * The sparsity pattern of the hessian must be known, e.g. from
+     * MassSpringSystemT::hessian_sparsity_pattern(); every hessian then costs
+     * 2 * n_colors() gradient evaluations instead of 2n (see SparseHessianFD). */
+    class FiniteDifferenceHessianWrapper : public FunctionBaseSparse {
+
+    public:
+
+        typedef FunctionBaseSparse::Vec Vec;
+        typedef FunctionBaseSparse::SMat SMat;
+
+        /**
+         * \param _func the wrapped function, its eval_hessian is never called
+         * \param _pattern sparsity pattern of the hessian of _func
+         * \param _central central differences (default) or forward differences */
+        FiniteDifferenceHessianWrapper(FunctionBaseSparse& _func, const SMat& _pattern, const bool _central = true)
+        : func_(_func), fd_(_pattern, _central) {}
+
+        virtual int n_unknowns() override {
+            return func_.n_unknowns();
+        }
+
+        // differences of a linear gradient are constant up to round-off
+        virtual bool is_quadratic() override {
+            return func_.is_quadratic();
+        }
+
+        virtual bool has_constant_hessian() override {
+            return func_.has_constant_hessian();
+        }
+
+        virtual double eval_f(const Vec &_x) override {
+            return func_.eval_f(_x);
+        }
+
+        virtual void eval_gradient(const Vec &_x, Vec &_g) override {
+            func_.eval_gradient(_x, _g);
+        }
+
+        virtual void eval_hessian(const Vec &_x, SMat &_H) override {
+            fd_.eval([&](const Vec& _xx, Vec& _g) { func_.eval_gradient(_xx, _g); }, _x, _H);
+        }
+
+        /** number of groups of unknowns perturbed together */
+        int n_colors() const {
+            return fd_.n_colors();
+        }
+
+    private:
+        FunctionBaseSparse& func_;
+        SparseHessianFD fd_;
+    };
+}
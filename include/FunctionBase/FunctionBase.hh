@@ -2,6 +2,7 @@
 
 #include <Eigen/Dense>
 #include <iostream>
+#include <limits>
 
 //== NAMESPACES ===============================================================
 
@@ -59,6 +60,80 @@ namespace AOPT {
          * i.e _H(i,j) = (d^2f/(dx_i dx_j))(_x)
          * IMPORTANT NOTE: _H should be properly sized at the start of the function */
         virtual void eval_hessian(const Vec &_x, Mat &_H) = 0;
+
+        /** true if f is a quadratic (or linear) function, i.e. a single Newton step
+         * from any point gives the stationary point */
+        virtual bool is_quadratic() { return false; }
+
+        // true if the hessian does not depend on _x
+        virtual bool has_constant_hessian() { return is_quadratic(); }
+
+        /** true if the evaluations (eval_f(), eval_f_batch(), eval_f_start() and
+         * eval_f_step() with a state per thread, eval_gradient() and eval_hessian())
+         * can run in several threads at once, i.e. they do not modify the function.
+         * GridSearch, ConvexityTest, FieldExporter and the sparse checks of
+         * DerivativeChecker use one thread otherwise */
+        virtual bool is_thread_safe() { return false; }
+
+        /** state of an incremental evaluation, see eval_f_start(). It is kept by the
+         * caller, so that several walks over the same function, e.g. one per thread of
+         * GridSearch::grid_search_nd, do not interfere */
+        struct IncrementalState {
+            // what the function needs to update f, e.g. Ax + b of a quadratic
+            Vec r;
+            // f at the current point
+            double f = 0.;
+        };
+
+        /** starts an incremental evaluation along a walk that moves one coordinate
+         * at a time, e.g. over the points of GridSearch::grid_search_nd.
+         * Functions that can update f faster than evaluating it from scratch
+         * override this and eval_f_step() and keep what they need in _state.
+         * \return f(_x) */
+        virtual double eval_f_start(const Vec &_x, IncrementalState &/*_state*/) { return eval_f(_x); }
+
+        /** next point of the walk started by eval_f_start() with the same _state
+         * \param _x the new point, the previous one with _x[_j] moved by _dx
+         * \return f(_x) */
+        virtual double eval_f_step(const Vec &_x, const int /*_j*/, const double /*_dx*/, IncrementalState &/*_state*/) {
+            return eval_f(_x);
+        }
+
+        /** function evaluation at many points at once, e.g. the points of GridSearch.
+         * Functions that can evaluate several points faster than one by one override
+         * this. ConvexityTest and FieldExporter call it from several threads at the same
+         * time if the function is_thread_safe().
+         * \param _X the points, one per column
+         * \param _f output, _f[i] = f(_X.col(i)) */
+        virtual void eval_f_batch(const Mat &_X, Vec &_f) {
+            _f.resize(_X.cols());
+            Vec x(_X.rows());
+            for(int i = 0; i < _X.cols(); ++i) {
+                x = _X.col(i);
+                _f[i] = eval_f(x);
+            }
+        }
+
+        /** lower bound of f over the box [_x_l, _x_u], used for pruning by
+         * GridSearch::branch_and_bound_nd
+         * \return -infinity if no bound is known */
+        virtual double eval_lower_bound(const Vec &/*_x_l*/, const Vec &/*_x_u*/) {
+            return -std::numeric_limits<double>::infinity();
+        }
+
+        /** element-wise bounds of the hessian over the box [_x_l, _x_u], i.e.
+         * _H_l(i,j) <= (d^2f/(dx_i dx_j))(x) <= _H_u(i,j) for all x in the box, used by
+         * ConvexityTest::certifyConvexity. If the hessian is constant it is evaluated
+         * at the center of the box.
+         * \return false if no bounds are known */
+        virtual bool eval_hessian_bounds(const Vec &_x_l, const Vec &_x_u, Mat &_H_l, Mat &_H_u) {
+            if(!has_constant_hessian())
+                return false;
+            _H_l.resize(_x_l.size(), _x_l.size());
+            eval_hessian(0.5 * (_x_l + _x_u), _H_l);
+            _H_u = _H_l;
+            return true;
+        }
     };
 
 
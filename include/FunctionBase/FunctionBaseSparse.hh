@@ -49,6 +49,20 @@ namespace AOPT {
 
         // hessian matrix evaluation
         virtual void eval_hessian(const Vec &_x, SMat& _h) = 0;
+
+        /** true if f is a quadratic (or linear) function, i.e. a single Newton step
+         * from any point gives the stationary point. Solvers may use this to skip the
+         * iterations, so only return true if this holds for every _x. */
+        virtual bool is_quadratic() { return false; }
+
+        /** true if the hessian does not depend on _x, which allows to evaluate and
+         * factorize it only once */
+        virtual bool has_constant_hessian() { return is_quadratic(); }
+
+        /** true if eval_f(), eval_gradient() and eval_hessian() can run in several threads
+         * at once, i.e. they do not modify the function, e.g. its buffers.
+         * The sparse checks of DerivativeChecker use one thread otherwise */
+        virtual bool is_thread_safe() { return false; }
     };
 
 
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vector>
+#include <FunctionBase/FunctionBaseSparse.hh>
+
+//== NAMESPACES ===============================================================
+
+namespace AOPT {
+
+    //== CLASS DEFINITION =========================================================
+
+    /* Hessians of a list of functions, e.g. the constraints of a problem.
+     * The hessian of a function with has_constant_hessian() is evaluated the first
+     * time it is asked for and then reused, the others are evaluated every time. */
+    class HessianCache {
+    public:
+        using Vec = FunctionBaseSparse::Vec;
+        using SMat = FunctionBaseSparse::SMat;
+
+        HessianCache() {}
+
+        HessianCache(const std::vector<FunctionBaseSparse*>& _functions) {
+            reset(_functions);
+        }
+
+        /** forgets all cached hessians
+         * \param _functions the functions, they should outlive the cache */
+        void reset(const std::vector<FunctionBaseSparse*>& _functions) {
+            functions_ = _functions;
+            constant_.resize(functions_.size());
+            for(auto i = 0u; i < functions_.size(); ++i)
+                constant_[i] = functions_[i]->has_constant_hessian();
+            cached_.assign(functions_.size(), false);
+            hessians_.assign(functions_.size(), SMat());
+        }
+
+        /** hessian of the _i-th function
+         * \param _tmp storage of the hessian when it is not constant, it should be
+         *             properly sized
+         * \return either the cached hessian or _tmp */
+        const SMat& eval_hessian(const int _i, const Vec& _x, SMat& _tmp) {
+            if(!constant_[_i]) {
+                functions_[_i]->eval_hessian(_x, _tmp);
+                return _tmp;
+            }
+
+            if(!cached_[_i]) {
+                const int n = functions_[_i]->n_unknowns();
+                hessians_[_i].resize(n, n);
+                functions_[_i]->eval_hessian(_x, hessians_[_i]);
+                hessians_[_i].makeCompressed();
+                cached_[_i] = true;
+            }
+            return hessians_[_i];
+        }
+
+        bool is_constant(const int _i) const { return constant_[_i]; }
+
+        // true if all the hessians are constant
+        bool all_constant() const {
+            for(auto c : constant_)
+                if(!c) return false;
+            return true;
+        }
+
+    private:
+        std::vector<FunctionBaseSparse*> functions_;
+        std::vector<bool> constant_;
+        std::vector<bool> cached_;
+        std::vector<SMat> hessians_;
+    };
+
+//=============================================================================
+}
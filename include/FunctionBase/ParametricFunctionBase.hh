@@ -45,6 +45,16 @@ namespace AOPT {
 
         // hessian matrix evaluation
         virtual void eval_hessian(const Vec &_x, const Vec &_coeffs, Mat &_H) = 0;
+
+        // true if f is a quadratic (or linear) function of _x for any _coeffs
+        virtual bool is_quadratic() { return false; }
+
+        // true if the hessian depends on _coeffs only
+        virtual bool has_constant_hessian() { return is_quadratic(); }
+
+        // true if the evaluations do not modify the function, so that a problem can
+        // evaluate it in several threads at once
+        virtual bool is_thread_safe() { return false; }
     };
 
 
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <array>
+#include <Eigen/Dense>
+
+//== NAMESPACES ===============================================================
+
+namespace AOPT {
+
+    //== CLASS DEFINITION =========================================================
+
+    /* Base of a residual block for least squares problems, i.e. a small function
+     *      r_b(x_b) : R^N -> R^R
+     * of the N unknowns x_b = (x[indices[0]], ..., x[indices[N-1]]).
+     * A ResidualBlockProblem sums up 1/2 ||r_b||^2 over all its blocks.
+     *
+     * This uses the CRTP: the Derived class implements
+     *      void eval(const LocalVec& _x, Residual& _r, Jacobian* _J) const
+     * which sets the residual and, if _J is not null, the R x N local Jacobian.
+     * Since R and N are known at compile time, the local vectors and matrices are
+     * fixed size and the call is inlined, there is no virtual call per residual
+     * as with ParametricFunctionBase. */
+    template <class Derived, int R, int N>
+    class ResidualBlock {
+    public:
+        enum { N_RESIDUALS = R, N_PARAMETERS = N };
+
+        using Vec = Eigen::VectorXd;
+        using LocalVec = Eigen::Matrix<double, N, 1>;
+        using Residual = Eigen::Matrix<double, R, 1>;
+        using Jacobian = Eigen::Matrix<double, R, N>;
+        using Indices = std::array<int, N>;
+
+        /** \param _indices indices of the block's unknowns in the global x */
+        explicit ResidualBlock(const Indices& _indices) : indices_(_indices) {}
+
+        const Indices& indices() const { return indices_; }
+
+        /** gathers the block's unknowns from the global _x and evaluates r_b and,
+         * if _J is not null, its Jacobian */
+        void evaluate(const Vec& _x, Residual& _r, Jacobian* _J) const {
+            LocalVec xb;
+            for(int i = 0; i < N; ++i)
+                xb[i] = _x[indices_[i]];
+            static_cast<const Derived&>(*this).eval(xb, _r, _J);
+        }
+
+    private:
+        Indices indices_;
+    };
+
+//=============================================================================
+}
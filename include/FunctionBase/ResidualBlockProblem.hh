@@ -0,0 +1,362 @@
+#pragma once
+
+#include <tuple>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+#include <FunctionBase/FunctionBaseSparse.hh>
+#include <Utils/ParallelFor.hh>
+
+//== NAMESPACES ===============================================================
+
+namespace AOPT {
+
+    //== CLASS DEFINITION =========================================================
+
+    /* Least squares problem
+     *      f(x) = 1/2 ||r(x)||^2 = 1/2 sum_b ||r_b(x_b)||^2
+     * assembled from residual blocks (see ResidualBlock.hh).
+     * The blocks are stored grouped by type, one std::vector per type in Blocks..., so
+     * that every group is evaluated by a loop over statically known fixed-size blocks.
+     * The rows of r are ordered group by group, in the order of Blocks..., and
+     * in the order the blocks were added within a group.
+     *
+     * The patterns of J and of J^TJ only depend on the blocks' indices. They are
+     * built once (after the last block was added) together with, for every block,
+     * the positions of its local entries in the valuePtr() of both matrices. The
+     * assembly then writes values directly, without triplets, and runs the blocks
+     * in parallel: the rows of J are disjoint between blocks, the contributions to
+     * J^TJ and J^Tw are summed in per-thread buffers.
+     *
+     * Besides the FunctionBaseSparse interface (eval_hessian returns the Gauss-Newton
+     * approximation J^TJ), it provides the interface of LevenbergMarquardt and of
+     * MatrixFreeGaussNewton. */
+    template <class... Blocks>
+    class ResidualBlockProblem : public FunctionBaseSparse {
+    public:
+        using Vec = FunctionBaseSparse::Vec;
+        using SMat = FunctionBaseSparse::SMat;
+        using T = FunctionBaseSparse::T;
+
+        /**
+         * \param _n_unknowns dimension of x
+         * \param _n_threads number of threads of the assembly, 0 uses all hardware threads */
+        ResidualBlockProblem(const int _n_unknowns, const int _n_threads = 0) :
+                FunctionBaseSparse(), n_(_n_unknowns), m_(0) {
+            set_n_threads(_n_threads);
+        }
+
+        virtual ~ResidualBlockProblem() {}
+
+        virtual int n_unknowns() override {
+            return n_;
+        }
+
+        /** number of residuals, i.e. the number of rows of J */
+        int n_residuals() const {
+            return m_;
+        }
+
+        void set_n_threads(const int _n_threads) {
+            n_threads_ = _n_threads > 0 ? _n_threads : default_n_threads();
+        }
+
+        /** adds a block, whose type has to be one of Blocks... */
+        template <class Block>
+        void add_residual_block(const Block& _block) {
+            for(int i : _block.indices())
+                if(i < 0 || i >= n_) {
+                    std::cout << "Warning: invalid residual block was added... " << i << std::endl;
+                    return;
+                }
+
+            std::get<Group<Block>>(groups_).blocks.push_back(_block);
+            m_ += Block::N_RESIDUALS;
+            patterns_valid_ = false;
+        }
+
+        template <class Block>
+        int n_blocks() const {
+            return (int)std::get<Group<Block>>(groups_).blocks.size();
+        }
+
+
+        virtual double eval_f(const Vec &_x) override {
+            eval_r(_x, r_);
+            return 0.5 * r_.squaredNorm();
+        }
+
+        /** gradient J^T r */
+        virtual void eval_gradient(const Vec &_x, Vec &_g) override {
+            update_patterns();
+            _g.resize(n_);
+            parallel_accumulate(n_, _g.data(), [&](const auto& _group, const int _b, double* _out) {
+                using Block = block_type<decltype(_group)>;
+                typename Block::Residual rb;
+                typename Block::Jacobian jb;
+                const auto& block = _group.blocks[_b];
+                block.evaluate(_x, rb, &jb);
+                for(int j = 0; j < Block::N_PARAMETERS; ++j)
+                    _out[block.indices()[j]] += jb.col(j).dot(rb);
+            });
+        }
+
+        /** Gauss-Newton approximation of the hessian J^TJ (both triangles) */
+        virtual void eval_hessian(const Vec &_x, SMat& _h) override {
+            update_patterns();
+            parallel_accumulate((int)H_.nonZeros(), H_.valuePtr(), [&](const auto& _group, const int _b, double* _out) {
+                using Block = block_type<decltype(_group)>;
+                constexpr int N = Block::N_PARAMETERS;
+                typename Block::Residual rb;
+                typename Block::Jacobian jb;
+                _group.blocks[_b].evaluate(_x, rb, &jb);
+                Eigen::Matrix<double, N, N> hb = jb.transpose() * jb;
+                const int* pos = &_group.hess_pos[_b * N * N];
+                for(int a = 0; a < N; ++a)
+                    for(int c = 0; c < N; ++c)
+                        _out[pos[a * N + c]] += hb(a, c);
+            });
+            _h = H_;
+        }
+
+        void eval_r(const Vec &_x, Vec &_r) {
+            assemble(_x, &_r, nullptr);
+        }
+
+        void eval_jacobian(const Vec &_x, SMat &_J) {
+            assemble(_x, nullptr, &_J);
+        }
+
+        /** r and J in one pass over the blocks. If _J already has the pattern of J
+         * (e.g. it was set by a previous call), only its values are written. */
+        void eval_r_and_jacobian(const Vec &_x, Vec &_r, SMat &_J) {
+            assemble(_x, &_r, &_J);
+        }
+
+        /** matrix-free product _jv = J(_x) * _v */
+        void eval_jacobian_product(const Vec &_x, const Vec &_v, Vec &_jv) {
+            update_patterns();
+            _jv.resize(m_);
+            for_each_group([&](const auto& _group) {
+                using Block = block_type<decltype(_group)>;
+                constexpr int R = Block::N_RESIDUALS;
+                parallel_for(0, (int)_group.blocks.size(), [&](const int _b, const int) {
+                    typename Block::Residual rb;
+                    typename Block::Jacobian jb;
+                    typename Block::LocalVec vb;
+                    const auto& block = _group.blocks[_b];
+                    block.evaluate(_x, rb, &jb);
+                    for(int j = 0; j < Block::N_PARAMETERS; ++j)
+                        vb[j] = _v[block.indices()[j]];
+                    _jv.template segment<R>(_group.row_offset + _b * R) = jb * vb;
+                }, n_threads_);
+            });
+        }
+
+        /** matrix-free product _jtw = J(_x)^T * _w */
+        void eval_jacobian_transpose_product(const Vec &_x, const Vec &_w, Vec &_jtw) {
+            update_patterns();
+            _jtw.resize(n_);
+            parallel_accumulate(n_, _jtw.data(), [&](const auto& _group, const int _b, double* _out) {
+                using Block = block_type<decltype(_group)>;
+                constexpr int R = Block::N_RESIDUALS;
+                typename Block::Residual rb;
+                typename Block::Jacobian jb;
+                const auto& block = _group.blocks[_b];
+                block.evaluate(_x, rb, &jb);
+                typename Block::Residual wb = _w.template segment<R>(_group.row_offset + _b * R);
+                for(int j = 0; j < Block::N_PARAMETERS; ++j)
+                    _out[block.indices()[j]] += jb.col(j).dot(wb);
+            });
+        }
+
+        /** euclidean norms of the columns of J(_x) */
+        void eval_jacobian_column_norms(const Vec &_x, Vec &_c) {
+            update_patterns();
+            _c.resize(n_);
+            parallel_accumulate(n_, _c.data(), [&](const auto& _group, const int _b, double* _out) {
+                using Block = block_type<decltype(_group)>;
+                typename Block::Residual rb;
+                typename Block::Jacobian jb;
+                const auto& block = _group.blocks[_b];
+                block.evaluate(_x, rb, &jb);
+                for(int j = 0; j < Block::N_PARAMETERS; ++j)
+                    _out[block.indices()[j]] += jb.col(j).squaredNorm();
+            });
+            _c = _c.cwiseSqrt();
+        }
+
+    private:
+        /** blocks of one type, their first row in r and the positions of their
+         * local entries in J.valuePtr() (R x N, row major) and H_.valuePtr() (N x N) */
+        template <class Block>
+        struct Group {
+            using BlockType = Block;
+            std::vector<Block> blocks;
+            int row_offset = 0;
+            std::vector<int> jac_pos;
+            std::vector<int> hess_pos;
+        };
+
+        template <class G>
+        using block_type = typename std::decay_t<G>::BlockType;
+
+        template <class F>
+        void for_each_group(F&& _f) {
+            for_each_group_impl(_f, std::index_sequence_for<Blocks...>());
+        }
+
+        template <class F, std::size_t... I>
+        void for_each_group_impl(F& _f, std::index_sequence<I...>) {
+            int dummy[] = {0, (_f(std::get<I>(groups_)), 0)...};
+            (void)dummy;
+        }
+
+        /** position of entry (_r, _c) in _M.valuePtr() */
+        static int position(const SMat& _M, const int _r, const int _c) {
+            const int* inner = _M.innerIndexPtr();
+            return int(std::lower_bound(inner + _M.outerIndexPtr()[_c], inner + _M.outerIndexPtr()[_c+1], _r) - inner);
+        }
+
+        /** builds the patterns of J and J^TJ and the value positions of all blocks */
+        void update_patterns() {
+            if(patterns_valid_)
+                return;
+
+            std::vector<T> jt, ht;
+            int row(0);
+            for_each_group([&](auto& _group) {
+                using Block = block_type<decltype(_group)>;
+                constexpr int R = Block::N_RESIDUALS, N = Block::N_PARAMETERS;
+                _group.row_offset = row;
+                for(const auto& block : _group.blocks) {
+                    const auto& idx = block.indices();
+                    for(int i = 0; i < R; ++i)
+                        for(int j = 0; j < N; ++j)
+                            jt.emplace_back(row + i, idx[j], 0.);
+                    for(int a = 0; a < N; ++a)
+                        for(int c = 0; c < N; ++c)
+                            ht.emplace_back(idx[a], idx[c], 0.);
+                    row += R;
+                }
+            });
+
+            J_pattern_.resize(m_, n_);
+            J_pattern_.setFromTriplets(jt.begin(), jt.end());
+            J_pattern_.makeCompressed();
+            H_.resize(n_, n_);
+            H_.setFromTriplets(ht.begin(), ht.end());
+            H_.makeCompressed();
+
+            for_each_group([&](auto& _group) {
+                using Block = block_type<decltype(_group)>;
+                constexpr int R = Block::N_RESIDUALS, N = Block::N_PARAMETERS;
+                const int nb = (int)_group.blocks.size();
+                _group.jac_pos.resize(nb * R * N);
+                _group.hess_pos.resize(nb * N * N);
+                for(int b = 0; b < nb; ++b) {
+                    const auto& idx = _group.blocks[b].indices();
+                    for(int i = 0; i < R; ++i)
+                        for(int j = 0; j < N; ++j)
+                            _group.jac_pos[(b * R + i) * N + j] = position(J_pattern_, _group.row_offset + b * R + i, idx[j]);
+                    for(int a = 0; a < N; ++a)
+                        for(int c = 0; c < N; ++c)
+                            _group.hess_pos[(b * N + a) * N + c] = position(H_, idx[a], idx[c]);
+                }
+            });
+
+            patterns_valid_ = true;
+        }
+
+        /** evaluates all blocks in parallel and writes r and/or the values of J */
+        void assemble(const Vec &_x, Vec *_r, SMat *_J) {
+            update_patterns();
+
+            if(_r)
+                _r->resize(m_);
+
+            double* jv = nullptr;
+            if(_J) {
+                if(!has_jacobian_pattern(*_J))
+                    *_J = J_pattern_;
+                jv = _J->valuePtr();
+                std::fill(jv, jv + _J->nonZeros(), 0.);
+            }
+
+            for_each_group([&](const auto& _group) {
+                using Block = block_type<decltype(_group)>;
+                constexpr int R = Block::N_RESIDUALS, N = Block::N_PARAMETERS;
+                parallel_for(0, (int)_group.blocks.size(), [&](const int _b, const int) {
+                    typename Block::Residual rb;
+                    typename Block::Jacobian jb;
+                    _group.blocks[_b].evaluate(_x, rb, jv ? &jb : nullptr);
+                    if(_r)
+                        _r->template segment<R>(_group.row_offset + _b * R) = rb;
+                    if(jv) {
+                        // rows are disjoint between blocks, += only merges repeated indices of one block
+                        const int* pos = &_group.jac_pos[_b * R * N];
+                        for(int i = 0; i < R; ++i)
+                            for(int j = 0; j < N; ++j)
+                                jv[pos[i * N + j]] += jb(i, j);
+                    }
+                }, n_threads_);
+            });
+        }
+
+        bool has_jacobian_pattern(const SMat& _J) const {
+            return _J.rows() == J_pattern_.rows() && _J.cols() == J_pattern_.cols() && _J.isCompressed()
+                   && _J.nonZeros() == J_pattern_.nonZeros()
+                   && std::equal(_J.outerIndexPtr(), _J.outerIndexPtr() + _J.cols() + 1, J_pattern_.outerIndexPtr())
+                   && std::equal(_J.innerIndexPtr(), _J.innerIndexPtr() + _J.nonZeros(), J_pattern_.innerIndexPtr());
+        }
+
+        /** calls _f(group, b, out) for all blocks in parallel, where out is a zeroed
+         * per-thread array of size _size, and writes the sum of those arrays to _out */
+        template <class F>
+        void parallel_accumulate(const int _size, double* _out, F&& _f) {
+            if(n_threads_ == 1) {
+                std::fill(_out, _out + _size, 0.);
+                for_each_group([&](const auto& _group) {
+                    for(int b = 0; b < (int)_group.blocks.size(); ++b)
+                        _f(_group, b, _out);
+                });
+                return;
+            }
+
+            buffers_.resize(n_threads_);
+            for(auto& buffer : buffers_)
+                buffer.setZero(_size);
+
+            for_each_group([&](const auto& _group) {
+                parallel_for(0, (int)_group.blocks.size(), [&](const int _b, const int _t) {
+                    _f(_group, _b, buffers_[_t].data());
+                }, n_threads_);
+            });
+
+            parallel_for(0, _size, [&](const int _i, const int) {
+                double s(0);
+                for(const auto& buffer : buffers_)
+                    s += buffer[_i];
+                _out[_i] = s;
+            }, n_threads_);
+        }
+
+    private:
+        int n_;
+        int m_;
+        int n_threads_;
+
+        std::tuple<Group<Blocks>...> groups_;
+
+        bool patterns_valid_ = false;
+        SMat J_pattern_;
+        // J^TJ, its values are overwritten by eval_hessian
+        SMat H_;
+
+        Vec r_;
+        std::vector<Vec> buffers_;
+    };
+
+//=============================================================================
+}
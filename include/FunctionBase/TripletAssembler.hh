@@ -0,0 +1,105 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+#include <FunctionBase/FunctionBaseSparse.hh>
+
+//== NAMESPACES ===============================================================
+
+namespace AOPT {
+
+    //== CLASS DEFINITION =========================================================
+
+    /* Assembles a sparse matrix from triplets, like setFromTriplets(), but without
+     * allocating when only the values of the triplets change, e.g. the Hessian of
+     * a problem evaluated at a new point.
+     *
+     * The first call (or a call after the positions of the triplets changed) uses
+     * setFromTriplets() and records where the value of each triplet is summed in the
+     * compressed matrix. The next calls reset the values of the matrix and add the
+     * values of the triplets at these positions. A matrix whose pattern was changed
+     * in the meantime, e.g. by adding a diagonal that was not there, is rebuilt. */
+    class TripletAssembler {
+    public:
+        using SMat = FunctionBaseSparse::SMat;
+        using T = FunctionBaseSparse::T;
+
+        TripletAssembler() {}
+
+        /** sets _M to the sum of the _triplets
+         * \param _rows and _cols the size of _M */
+        void assemble(const std::vector<T>& _triplets, const int _rows, const int _cols, SMat& _M) {
+            if(!same_pattern(_triplets, _rows, _cols, _M)) {
+                build(_triplets, _rows, _cols, _M);
+                return;
+            }
+
+            double* values = _M.valuePtr();
+            std::fill(values, values + _M.nonZeros(), 0.);
+            for(size_t k = 0; k < _triplets.size(); ++k)
+                values[positions_[k]] += _triplets[k].value();
+        }
+
+        // forgets the recorded pattern, the next assemble() calls setFromTriplets()
+        void reset() {
+            rows_.clear();
+            cols_.clear();
+            positions_.clear();
+            outer_.clear();
+            inner_.clear();
+        }
+
+        // bytes of the recorded triplet positions and pattern, see MemoryFootprint
+        std::size_t pattern_bytes() const {
+            return (rows_.capacity() + cols_.capacity() + positions_.capacity() + outer_.capacity() + inner_.capacity())
+                   * sizeof(int);
+        }
+
+    private:
+        void build(const std::vector<T>& _triplets, const int _rows, const int _cols, SMat& _M) {
+            _M.resize(_rows, _cols);
+            _M.setFromTriplets(_triplets.begin(), _triplets.end());
+
+            n_rows_ = _rows;
+            n_cols_ = _cols;
+            outer_.assign(_M.outerIndexPtr(), _M.outerIndexPtr() + _cols + 1);
+            inner_.assign(_M.innerIndexPtr(), _M.innerIndexPtr() + _M.nonZeros());
+
+            rows_.resize(_triplets.size());
+            cols_.resize(_triplets.size());
+            positions_.resize(_triplets.size());
+            for(size_t k = 0; k < _triplets.size(); ++k) {
+                rows_[k] = _triplets[k].row();
+                cols_[k] = _triplets[k].col();
+                // the row indices of a column are sorted
+                const int* begin = inner_.data() + outer_[cols_[k]];
+                const int* end = inner_.data() + outer_[cols_[k] + 1];
+                positions_[k] = (int)(std::lower_bound(begin, end, rows_[k]) - inner_.data());
+            }
+        }
+
+        bool same_pattern(const std::vector<T>& _triplets, const int _rows, const int _cols, const SMat& _M) const {
+            if(positions_.size() != _triplets.size() || n_rows_ != _rows || n_cols_ != _cols)
+                return false;
+            if(_M.rows() != _rows || _M.cols() != _cols || !_M.isCompressed() || _M.nonZeros() != (int)inner_.size())
+                return false;
+            for(size_t k = 0; k < _triplets.size(); ++k)
+                if(_triplets[k].row() != rows_[k] || _triplets[k].col() != cols_[k])
+                    return false;
+            return std::equal(outer_.begin(), outer_.end(), _M.outerIndexPtr())
+                   && std::equal(inner_.begin(), inner_.end(), _M.innerIndexPtr());
+        }
+
+        int n_rows_ = 0;
+        int n_cols_ = 0;
+        // positions of the triplets and where their values go in the value array
+        std::vector<int> rows_;
+        std::vector<int> cols_;
+        std::vector<int> positions_;
+        // compressed pattern of the assembled matrix
+        std::vector<int> outer_;
+        std::vector<int> inner_;
+    };
+
+//=============================================================================
+}
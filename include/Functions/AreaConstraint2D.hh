@@ -20,6 +20,9 @@ namespace AOPT {
         // number of unknowns
         inline virtual int n_unknowns() override { return n_; }
 
+        // the signed area is quadratic in the coordinates, its hessian is constant
+        inline virtual bool is_quadratic() override { return true; }
+
         // function evaluation
         // _x stores the coordinates of all nodes
         inline virtual double eval_f(const Vec &_x) override {
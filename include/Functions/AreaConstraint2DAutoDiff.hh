@@ -0,0 +1,32 @@
+#pragma once
+
+#include <FunctionBase/AutoDiffSparseFunction.hh>
+
+//== NAMESPACES ===================================================================
+
+namespace AOPT {
+
+    //== CLASS DEFINITION =========================================================
+
+    /* AreaConstraint2D with automatically differentiated gradient and Hessian */
+    class AreaConstraint2DAutoDiff : public AutoDiffSparseFunction<AreaConstraint2DAutoDiff, 6> {
+    public:
+        // f = -1/2*((x1 - x0)*(y2 - y0) - (x2 - x0)*(y1 - y0)) + eps <= 0
+        AreaConstraint2DAutoDiff(const int _n, const int _idx0, const int _idx1, const int _idx2, const double _eps = 1e-10)
+                : AutoDiffSparseFunction(_n, Indices{{2*_idx0, 2*_idx0+1, 2*_idx1, 2*_idx1+1, 2*_idx2, 2*_idx2+1}}),
+                  eps_(_eps) {}
+
+        inline virtual bool is_quadratic() override { return true; }
+
+        /** \param _x = [x0, y0, x1, y1, x2, y2] */
+        template <class S>
+        S energy(const std::array<S, 6> &_x) const {
+            return -0.5 * ((_x[2] - _x[0]) * (_x[5] - _x[1]) - (_x[4] - _x[0]) * (_x[3] - _x[1])) + eps_;
+        }
+
+    private:
+        double eps_;
+    };
+
+//=============================================================================
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <FunctionBase/FunctionBaseSparse.hh>
+#include <FunctionBase/HessianCache.hh>
 
 
 //== NAMESPACES ===============================================================
@@ -24,7 +25,8 @@ namespace AOPT {
         AugmentedLagrangianProblem(FunctionBaseSparse* _obj, const std::vector<FunctionBaseSparse*>& _constraints,
                 const std::vector<FunctionBaseSparse*>& _squared_constraints, const Vec& _nu, double _mu)
         : FunctionBaseSparse(), obj_(_obj), constraints_(_constraints),
-          squared_constraints_(_squared_constraints), nu_(_nu), mu_over_2_(_mu/2.)
+          squared_constraints_(_squared_constraints), nu_(_nu), mu_over_2_(_mu/2.),
+          obj_hessian_({_obj}), constraint_hessians_(_constraints), squared_constraint_hessians_(_squared_constraints)
         {
             n_ = obj_->n_unknowns();
             g_ = Vec(n_);
@@ -37,6 +39,22 @@ namespace AOPT {
             return n_;
         }
 
+        // quadratic if the objective and all (squared) constraints are
+        virtual bool is_quadratic() override {
+            if(!obj_->is_quadratic())
+                return false;
+            for(auto i=0u; i<constraints_.size(); ++i)
+                if(!constraints_[i]->is_quadratic() || !squared_constraints_[i]->is_quadratic())
+                    return false;
+            return true;
+        }
+
+        // for fixed nu and mu
+        virtual bool has_constant_hessian() override {
+            return obj_hessian_.all_constant() && constraint_hessians_.all_constant()
+                   && squared_constraint_hessians_.all_constant();
+        }
+
         virtual double eval_f(const Vec &_x) override {
             double energy(0);
 
@@ -80,15 +98,12 @@ namespace AOPT {
 
             //------------------------------------------------------//
             //TODO: accumulate hessian matrices (objective function + constraint functions)
-            obj_->eval_hessian(_x, h_);
-            _h += h_;
+            // constant hessians are only evaluated once
+            _h += obj_hessian_.eval_hessian(0, _x, h_);
 
             for(auto i=0u; i<constraints_.size(); ++i) {
-                constraints_[i]->eval_hessian(_x, h_);
-                _h += nu_[i]*h_;
-
-                squared_constraints_[i]->eval_hessian(_x, h_);
-                _h += mu_over_2_*h_;
+                _h += nu_[i]*constraint_hessians_.eval_hessian(i, _x, h_);
+                _h += mu_over_2_*squared_constraint_hessians_.eval_hessian(i, _x, h_);
             }
             //------------------------------------------------------//
         }
@@ -120,6 +135,10 @@ namespace AOPT {
         Vec nu_;
         double mu_over_2_;
 
+        HessianCache obj_hessian_;
+        HessianCache constraint_hessians_;
+        HessianCache squared_constraint_hessians_;
+
         // used as a temporary vector when eval gradient of each constraint
         Vec g_;
         // used as a temporary matrix when eval hessian of each constraint
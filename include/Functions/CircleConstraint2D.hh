@@ -19,6 +19,9 @@ namespace AOPT {
         // number of unknowns
         inline virtual int n_unknowns() override { return n_; }
 
+        // the hessian is constant (2 * identity on the node)
+        inline virtual bool is_quadratic() override { return true; }
+
         // funcion evaluation
         // _x stores the coordinates of all nodes
         inline virtual double eval_f(const Vec &_x) override {
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <FunctionBase/AutoDiffSparseFunction.hh>
+
+//== NAMESPACES ===================================================================
+
+namespace AOPT {
+
+    //== CLASS DEFINITION =========================================================
+
+    /* CircleConstraint2D with automatically differentiated gradient and Hessian */
+    class CircleConstraint2DAutoDiff : public AutoDiffSparseFunction<CircleConstraint2DAutoDiff, 2> {
+    public:
+        // f(x,y) = (x[2*idx]- center_x)^2 + (x[2*idx+1] - center_y)^2 - radius^2
+        CircleConstraint2DAutoDiff(const int _n, const int _idx, const double _center_x, const double _center_y, const double _radius)
+                : AutoDiffSparseFunction(_n, Indices{{2*_idx, 2*_idx+1}}),
+                  center_x_(_center_x), center_y_(_center_y), radius_(_radius) {}
+
+        inline virtual bool is_quadratic() override { return true; }
+
+        template <class S>
+        S energy(const std::array<S, 2> &_x) const {
+            const S dx = _x[0] - center_x_;
+            const S dy = _x[1] - center_y_;
+            return dx*dx + dy*dy - radius_*radius_;
+        }
+
+    private:
+        double center_x_;
+        double center_y_;
+        double radius_;
+    };
+
+//=============================================================================
+}
@@ -51,8 +51,10 @@ namespace AOPT {
             double dify = std::pow(_x[2*idx_+1] - center_y_, 2);
 
             _h.insert(2*idx_, 2*idx_) = 12*difx + 4*dify - 4*radius_*radius_;
-            _h.insert(2*idx_, 2*idx_+1) = 8*(_x[2*idx_] - center_x_)*(_x[2*idx_+1] - center_y_);
-            _h.insert(2*idx_+1, 2*idx_) = _h.coeffRef(2*idx_, 2*idx_+1);
+            // a reference into _h would be invalidated by the next insert
+            double hxy = 8*(_x[2*idx_] - center_x_)*(_x[2*idx_+1] - center_y_);
+            _h.insert(2*idx_, 2*idx_+1) = hxy;
+            _h.insert(2*idx_+1, 2*idx_) = hxy;
             _h.insert(2*idx_+1, 2*idx_+1) = 4*difx + 12*dify - 4*radius_*radius_;
             //------------------------------------------------------//
         }
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cmath>
+#include <FunctionBase/ResidualBlock.hh>
+
+//== NAMESPACES ===============================================================
+
+namespace AOPT {
+
+//== CLASS DEFINITION =========================================================
+
+    /* Residual block attaching the node a to the point p,
+     *      r(x) = sqrt(w) * (x_a - p),
+     * i.e. the two residuals of ConstrainedSpringElement2DLeastSquare. */
+    class ConstrainedPointResidualBlock2D : public ResidualBlock<ConstrainedPointResidualBlock2D, 2, 2> {
+    public:
+        /**
+         * \param _v_idx index of node a
+         * \param _w penalty weight
+         * \param _px, _py the point p */
+        ConstrainedPointResidualBlock2D(const int _v_idx, const double _w = 1., const double _px = 0., const double _py = 0.) :
+                ResidualBlock(Indices{{2 * _v_idx, 2 * _v_idx + 1}}),
+                sqrt_w_(std::sqrt(_w)), p_(_px, _py) {}
+
+        void eval(const LocalVec& _x, Residual& _r, Jacobian* _J) const {
+            _r = sqrt_w_ * (_x - p_);
+
+            if(_J)
+                *_J = sqrt_w_ * Jacobian::Identity();
+        }
+
+    private:
+        double sqrt_w_;
+        Eigen::Vector2d p_;
+    };
+
+//=============================================================================
+}
@@ -15,6 +15,11 @@ namespace AOPT {
         // number of unknowns
         inline virtual int n_unknowns() final { return 2; }
 
+        inline virtual bool is_quadratic() final { return true; }
+
+        // the evaluations only read their arguments
+        inline virtual bool is_thread_safe() final { return true; }
+
         /** evaluates the spring element's energy
          * \param _x the spring's current position
          * \param _coeffs _coeffs[0] is the penalty factor,
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <FunctionBase/AutoDiffElement.hh>
+
+//== NAMESPACES ===============================================================
+
+namespace AOPT {
+
+    //== CLASS DEFINITION =========================================================
+
+    /* ConstrainedSpringElement2D with automatically differentiated gradient and Hessian */
+    class ConstrainedSpringElement2DAutoDiff : public AutoDiffElement<ConstrainedSpringElement2DAutoDiff, 2> {
+    public:
+        ConstrainedSpringElement2DAutoDiff() : AutoDiffElement() {}
+
+        inline virtual bool is_quadratic() override { return true; }
+
+        /** f(x) = 1/2 * w * ((x[0] - px)^2 + (x[1] - py)^2)
+         * \param _x the spring's current position
+         * \param _coeffs _coeffs[0] is the penalty factor w,
+         *                _coeffs[1] and _coeffs[2] are the desired point coordinates */
+        template <class S>
+        S energy(const std::array<S, 2> &_x, const Vec &_coeffs) const {
+            const S dx = _x[0] - _coeffs[1];
+            const S dy = _x[1] - _coeffs[2];
+            return 0.5 * _coeffs[0] * (dx*dx + dy*dy);
+        }
+    };
+
+//=============================================================================
+}
@@ -1,7 +1,10 @@
 #pragma once
 
 #include <iostream>
+#include <cmath>
+#include <algorithm>
 #include <FunctionBase/FunctionBase.hh>
+#include <Utils/VectorizedMath.hh>
 
 //== NAMESPACES ===============================================================
 
@@ -20,6 +23,9 @@ namespace AOPT {
         // number of unknowns
         inline virtual int n_unknowns() { return 2; }
 
+        // the function has no data to modify
+        inline virtual bool is_thread_safe() { return true; }
+
         /** funcion evaluation
          * \param _x the value at which to evaluate the function.
          *           It should be a 2D vector*/
@@ -32,11 +38,93 @@ namespace AOPT {
             //------------------------------------------------------//
         }
 
-        // gradient evaluation. Not necessary for this function
-        inline virtual void eval_gradient(const Vec &_x, Vec &_g) {}
+        /** funcion evaluation at the columns of _X, in blocks whose cosines are computed
+         * with the vectorized cos_batch()
+         * \param _X the points, one per column
+         * \param _f output values */
+        inline virtual void eval_f_batch(const Mat &_X, Vec &_f) {
+            const int m = _X.cols();
+            _f.resize(m);
+
+            const int block = 256;
+            double y4[block], c[block];
+            for(int b = 0; b < m; b += block) {
+                const int nb = std::min(block, m - b);
+                for(int i = 0; i < nb; ++i)
+                    y4[i] = 4*_X(1, b+i);
+                cos_batch(y4, c, nb);
+
+                for(int i = 0; i < nb; ++i) {
+                    const double x = _X(0, b+i), y = _X(1, b+i);
+                    _f[b+i] = (y - x*x)*(y - x*x) + c[i]*c[i]*(1-x)*(1-x) + x*x + y*y;
+                }
+            }
+        }
+
+        // gradient evaluation
+        inline virtual void eval_gradient(const Vec &_x, Vec &_g) {
+            const double x = _x[0], y = _x[1];
+            const double c = cos(4*y);
+            _g[0] = -4*x*(y - x*x) - 2*c*c*(1-x) + 2*x;
+            _g[1] = 2*(y - x*x) - 4*sin(8*y)*(1-x)*(1-x) + 2*y;
+        }
+
+        // hessian matrix evaluation, using cos^2(4y) = (1 + cos(8y))/2
+        inline virtual void eval_hessian(const Vec &_x, Mat &_H) {
+            const double x = _x[0], y = _x[1];
+            _H(0, 0) = 12*x*x - 4*y + 3 + cos(8*y);
+            _H(0, 1) = _H(1, 0) = -4*x + 8*(1-x)*sin(8*y);
+            _H(1, 1) = 4 - 32*cos(8*y)*(1-x)*(1-x);
+        }
+
+        /** bounds of the hessian over the box, obtained by evaluating the expressions of
+         * eval_hessian() in interval arithmetic */
+        inline virtual bool eval_hessian_bounds(const Vec &_x_l, const Vec &_x_u, Mat &_H_l, Mat &_H_u) {
+            const Interval x{_x_l[0], _x_u[0]}, y{_x_l[1], _x_u[1]};
+            const Interval one_minus_x{1 - x.hi, 1 - x.lo};
+            const Interval c = interval_cos(y * 8), s = interval_cos(y * 8 + (-M_PI/2));
 
-        // hessian matrix evaluation. Not necessary for this function
-        inline virtual void eval_hessian(const Vec &_x, Mat &_H) {}
+            const Interval hxx = interval_sqr(x) * 12 + y * (-4) + c + 3;
+            const Interval hxy = x * (-4) + one_minus_x * s * 8;
+            const Interval hyy = c * interval_sqr(one_minus_x) * (-32) + 4;
+
+            _H_l.resize(2, 2);
+            _H_u.resize(2, 2);
+            _H_l << hxx.lo, hxy.lo, hxy.lo, hyy.lo;
+            _H_u << hxx.hi, hxy.hi, hxy.hi, hyy.hi;
+            return true;
+        }
+
+    private:
+        // the real numbers in [lo, hi]
+        struct Interval {
+            double lo, hi;
+
+            Interval operator+(const Interval& _b) const { return {lo + _b.lo, hi + _b.hi}; }
+            Interval operator+(const double _b) const { return {lo + _b, hi + _b}; }
+            Interval operator*(const double _b) const {
+                return _b >= 0 ? Interval{lo * _b, hi * _b} : Interval{hi * _b, lo * _b};
+            }
+            Interval operator*(const Interval& _b) const {
+                const double p[4] = {lo * _b.lo, lo * _b.hi, hi * _b.lo, hi * _b.hi};
+                return {*std::min_element(p, p + 4), *std::max_element(p, p + 4)};
+            }
+        };
+
+        static Interval interval_sqr(const Interval& _a) {
+            if(_a.lo >= 0) return {_a.lo * _a.lo, _a.hi * _a.hi};
+            if(_a.hi <= 0) return {_a.hi * _a.hi, _a.lo * _a.lo};
+            return {0., std::max(_a.lo * _a.lo, _a.hi * _a.hi)};
+        }
+
+        static Interval interval_cos(const Interval& _a) {
+            if(_a.hi - _a.lo >= 2 * M_PI) return {-1., 1.};
+            Interval r{std::min(std::cos(_a.lo), std::cos(_a.hi)), std::max(std::cos(_a.lo), std::cos(_a.hi))};
+            // a maximum 2k pi or a minimum (2k + 1) pi inside
+            if(2 * M_PI * std::ceil(_a.lo / (2 * M_PI)) <= _a.hi) r.hi = 1.;
+            if(M_PI + 2 * M_PI * std::ceil((_a.lo - M_PI) / (2 * M_PI)) <= _a.hi) r.lo = -1.;
+            return r;
+        }
     };
 
 //=============================================================================
@@ -22,6 +22,12 @@ namespace AOPT {
         // number of unknowns
         inline virtual int n_unknowns() { return 2; }
 
+        // f is quadratic, its hessian is constant
+        inline virtual bool is_quadratic() { return true; }
+
+        // the evaluations only read gamma
+        inline virtual bool is_thread_safe() { return true; }
+
         /** funcion evaluation
          * \param _x the value at which to evaluate the function.
          *           It should be a 2D vector*/
@@ -32,6 +38,15 @@ namespace AOPT {
             //------------------------------------------------------//
         }
 
+        /** evaluates the quadratic function at the columns of _X
+         * \param _X the points, one per column
+         * \param _f output values */
+        inline virtual void eval_f_batch(const Mat &_X, Vec &_f) {
+            _f.resize(_X.cols());
+            for(int i = 0; i < _X.cols(); ++i)
+                _f[i] = 0.5 * (_X(0, i) * _X(0, i) + gamma_ * _X(1, i) * _X(1, i));
+        }
+
         /** evaluates the quadratic function's gradient
          * \param _x the point on which to evaluate the function
          * \param _g gradient output */
@@ -52,7 +67,9 @@ namespace AOPT {
             //------------------------------------------------------//
             //Todo: implement the Hessian H = (1, 0
             //                                 0, gamma)
-
+            _H.setZero();
+            _H(0, 0) = 1.;
+            _H(1, 1) = gamma_;
             //------------------------------------------------------//
         }
 
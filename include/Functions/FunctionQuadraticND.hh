@@ -1,6 +1,8 @@
 #pragma once
 
 #include <iostream>
+#include <cmath>
+#include <algorithm>
 #include <FunctionBase/FunctionBase.hh>
 
 //== NAMESPACES ===============================================================
@@ -22,6 +24,7 @@ namespace AOPT {
         FunctionQuadraticND(const int _n, bool _convex = true)
                 : FunctionBase(), n_(_n), A_(n_, n_), b_(n_), c_(0) {
             initialize_random_problem(10, _convex);
+            lambda_min_ = smallest_eigenvalue();
         }
 
         /* Note: the given matrix A should be square, as suggested by the check below. */
@@ -30,12 +33,18 @@ namespace AOPT {
             if(_A.rows() != _A.cols())
                 std::cerr << "Warning: matrix not square in FunctionQuadraticND" << std::endl;
             n_ = A_.rows();
-
+            lambda_min_ = smallest_eigenvalue();
         }
 
         // number of unknowns
         inline virtual int n_unknowns() { return n_; }
 
+        // f is quadratic, its hessian A is constant
+        inline virtual bool is_quadratic() { return true; }
+
+        // the evaluations only read A, b and c, the incremental ones write to their state
+        inline virtual bool is_thread_safe() { return true; }
+
         /** funcion evaluation
          * \param _x the value at which to evaluate the function.
          *           It should be a ND vector*/
@@ -48,6 +57,71 @@ namespace AOPT {
             //-------------------------------------------------------------------------------//
         }
 
+        /** starts an incremental evaluation, keeps r = Ax + b and f of the current point
+         * \param _x the first point of the walk */
+        inline virtual double eval_f_start(const Vec &_x, IncrementalState &_state) {
+            _state.r = A_*_x + b_;
+            _state.f = 0.5 * _x.dot(_state.r + b_) + c_;
+            return _state.f;
+        }
+
+        /** f(x + dx e_j) = f(x) + dx (Ax + b)_j + 1/2 dx^2 A_jj,
+         * which costs O(n) for the update of r instead of O(n^2) */
+        inline virtual double eval_f_step(const Vec &/*_x*/, const int _j, const double _dx, IncrementalState &_state) {
+            _state.f += _dx * (_state.r[_j] + 0.5 * _dx * A_(_j, _j));
+            _state.r += _dx * A_.col(_j);
+            return _state.f;
+        }
+
+        /** evaluates the function at the columns of _X.
+         * A point that differs from the previous one in a single coordinate j, as on
+         * the grid lines of GridSearch::grid_search_2d and the rows of FieldExporter,
+         * is updated in O(n) instead of O(n^2):
+         * f(x + dx e_j) = f(x) + dx (Ax + b)_j + 1/2 dx^2 A_jj
+         * Other batches, e.g. the paths of ConvexityTest, are evaluated by blocks of
+         * columns with a matrix-matrix product A X, which is much faster than one
+         * product per point.
+         * \param _X the points, one per column
+         * \param _f output values */
+        inline virtual void eval_f_batch(const Mat &_X, Vec &_f) {
+            const int m = _X.cols();
+            _f.resize(m);
+            if(m == 0)
+                return;
+
+            int n_steps = 0;
+            for(int k = 1; k < m; ++k)
+                if((_X.col(k).array() != _X.col(k-1).array()).count() <= 1)
+                    ++n_steps;
+
+            if(2 * n_steps < m)
+                eval_f_blocks(_X, _f);
+            else
+                eval_f_walk(_X, _f);
+        }
+
+        /** lower bound over a box by interval arithmetic. With m the center of the box
+         * and h its half size, f(m + d) = f(m) + g^T d + 1/2 d^T A d for |d_i| <= h_i
+         * where g = Am + b. The quadratic term is bounded from below either by
+         * lambda_min |d|^2 or by sum_i A_ii d_i^2 - sum_{i != j} |A_ij| h_i h_j, both
+         * are separable and minimized per coordinate. The larger bound is returned.
+         * \param _x_l the lower corner of the box
+         * \param _x_u the upper corner of the box */
+        inline virtual double eval_lower_bound(const Vec &_x_l, const Vec &_x_u) {
+            const Vec m = 0.5 * (_x_l + _x_u);
+            const Vec h = 0.5 * (_x_u - _x_l);
+            const Vec g = A_*m + b_;
+            const double fm = 0.5 * m.dot(g + b_) + c_;
+
+            double lb_eig = fm;
+            double lb_diag = fm - 0.5 * (h.dot(A_.cwiseAbs() * h) - h.dot(A_.diagonal().cwiseAbs().cwiseProduct(h)));
+            for(int i = 0; i < n_; ++i) {
+                lb_eig += min_1d(g[i], lambda_min_, h[i]);
+                lb_diag += min_1d(g[i], A_(i, i), h[i]);
+            }
+            return std::max(lb_eig, lb_diag);
+        }
+
         /** evaluates the quadratic function's gradient
          * \param _x the point on which to evaluate the function
          * \param _g gradient output */
@@ -71,6 +145,63 @@ namespace AOPT {
         }
 
     private:
+        // f(x) = 1/2 x^T (Ax + 2b) + c for blocks of columns of _X
+        void eval_f_blocks(const Mat &_X, Vec &_f) const {
+            const int m = _X.cols();
+            const int block = 64;
+            Mat R(n_, std::min(block, m));
+            for(int k = 0; k < m; k += block) {
+                const int nb = std::min(block, m - k);
+                R.leftCols(nb).noalias() = A_ * _X.middleCols(k, nb);
+                R.leftCols(nb).colwise() += 2. * b_;
+                _f.segment(k, nb) = 0.5 * _X.middleCols(k, nb).cwiseProduct(R.leftCols(nb)).colwise().sum().transpose();
+                _f.segment(k, nb).array() += c_;
+            }
+        }
+
+        // updates f with eval_f_step() when a single coordinate changes from one column to the next
+        void eval_f_walk(const Mat &_X, Vec &_f) {
+            const int m = _X.cols();
+
+            IncrementalState state;
+            Vec x = _X.col(0);
+            _f[0] = eval_f_start(x, state);
+
+            for(int k = 1; k < m; ++k) {
+                // coordinate that changed
+                int j = -1, n_changed = 0;
+                for(int i = 0; i < n_; ++i)
+                    if(_X(i, k) != _X(i, k-1)) {
+                        j = i;
+                        ++n_changed;
+                    }
+
+                if(n_changed == 1) {
+                    const double dx = _X(j, k) - x[j];
+                    x[j] = _X(j, k);
+                    eval_f_step(x, j, dx, state);
+                } else if(n_changed > 1) {
+                    x = _X.col(k);
+                    eval_f_start(x, state);
+                }
+                _f[k] = state.f;
+            }
+        }
+
+        // minimum of g d + 1/2 a d^2 over |d| <= h
+        static double min_1d(const double _g, const double _a, const double _h) {
+            if(_a > 0. && std::abs(_g) < _a * _h)
+                return -0.5 * _g * _g / _a;
+            return -std::abs(_g) * _h + 0.5 * _a * _h * _h;
+        }
+
+        double smallest_eigenvalue() const {
+            if(n_ == 0)
+                return 0.;
+            Eigen::SelfAdjointEigenSolver<Mat> es(A_, Eigen::EigenvaluesOnly);
+            return es.eigenvalues()[0];
+        }
+
         void initialize_random_problem(double _max_val = 10.0, bool _convex = true, const int _random_index = 0)
         {
             std::cerr << "initialize random QP problem with " << n_ << " unknowns... " << std::endl;
@@ -112,6 +243,9 @@ namespace AOPT {
         Mat A_;
         Vec b_;
         double c_;
+
+        // smallest eigenvalue of A, for the lower bounds
+        double lambda_min_;
     };
 
 //=============================================================================
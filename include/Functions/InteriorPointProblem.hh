@@ -2,6 +2,8 @@
 
 
 #include <FunctionBase/FunctionBaseSparse.hh>
+#include <FunctionBase/HessianCache.hh>
+#include <Utils/Profiler.hh>
 
 
 //== NAMESPACES ===============================================================
@@ -13,7 +15,8 @@ namespace AOPT {
     public:
         // default constructor
         InteriorPointProblem(FunctionBaseSparse *_obj, const std::vector<FunctionBaseSparse *> &_constraints)
-        : FunctionBaseSparse(), obj_(_obj), constraints_(_constraints), t_(1.0) {
+        : FunctionBaseSparse(), obj_(_obj), constraints_(_constraints), t_(1.0),
+          obj_hessian_({_obj}), constraint_hessians_(_constraints) {
             v_ = Vec(obj_->n_unknowns());
             M_ = SMat(obj_->n_unknowns(), obj_->n_unknowns());
             N_ = SMat(obj_->n_unknowns(), obj_->n_unknowns());
@@ -57,14 +60,16 @@ namespace AOPT {
 
         // hessian matrix evaluation
         virtual void eval_hessian(const Vec &_x, SMat &_H) override {
+            AOPT_PROFILE_SCOPE("InteriorPointProblem::eval_hessian");
             //------------------------------------------------------//
             //TODO: add hessian matrices (objective function + barrier function)
-            _H.setZero();
-            obj_->eval_hessian(_x, _H);
+            // constant hessians (e.g. linear or quadratic constraints) are only evaluated once
+            M_.setZero();
+            _H = obj_hessian_.eval_hessian(0, _x, M_);
             _H *= (-t_);
 
             for (auto i = 0; i < constraints_.size(); i++) {
-                add_hess_of_log_of_function(constraints_[i], _x, _H);
+                add_hess_of_log_of_function(i, _x, _H);
             }
             
 
@@ -87,12 +92,14 @@ namespace AOPT {
             _g += 1.0 / _o->eval_f(_x) * v_;
         }
 
-        void add_hess_of_log_of_function(FunctionBaseSparse *_o, const Vec &_x, SMat &_H) {
+        void add_hess_of_log_of_function(const int _i, const Vec &_x, SMat &_H) {
+            FunctionBaseSparse *o = constraints_[_i];
+
             // get f, grad, hess
-            double d = _o->eval_f(_x);
+            double d = o->eval_f(_x);
 
-            _o->eval_gradient(_x, v_);
-            _o->eval_hessian(_x, M_);
+            o->eval_gradient(_x, v_);
+            const SMat& M = constraint_hessians_.eval_hessian(_i, _x, M_);
 
             triplets_.clear();
             triplets_.reserve(36);
@@ -108,7 +115,7 @@ namespace AOPT {
                     }
                 }
             N_.setFromTriplets(triplets_.begin(), triplets_.end());
-            _H += (1.0 / d) * M_ - (1.0 / (d * d)) * N_;
+            _H += (1.0 / d) * M - (1.0 / (d * d)) * N_;
         }
 
     private:
@@ -122,6 +129,10 @@ namespace AOPT {
         // log barrier parameter
         double t_;
 
+        // hessians of the objective and the constraints
+        HessianCache obj_hessian_;
+        HessianCache constraint_hessians_;
+
 
         // temp varibles
         Vec v_;
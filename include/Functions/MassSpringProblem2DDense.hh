@@ -41,6 +41,7 @@ namespace AOPT {
             xe_.resize(func_.n_unknowns());
             ge_.resize(func_.n_unknowns());
             he_.resize(func_.n_unknowns(), func_.n_unknowns());
+            coeff_.resize(2);
         }
 
         ~MassSpringProblem2DDense() {}
@@ -49,6 +50,15 @@ namespace AOPT {
             return n_;
         }
 
+        // the sum is quadratic if the springs are
+        virtual bool is_quadratic() override {
+            return func_.is_quadratic();
+        }
+
+        virtual bool has_constant_hessian() override {
+            return func_.has_constant_hessian();
+        }
+
 
         /** evaluates the spring element's energy, which is the sum of the energy
          * of all its springs.
@@ -60,8 +70,6 @@ namespace AOPT {
         virtual double eval_f(const Vec &_x) override {
             double energy(0);
 
-            //used to store the value of k and l, i.e. coeff[0] = ks_[i], coeff[1] = ls_[i];
-            Vec coeff(2);
 
             //------------------------------------------------------//
             //TODO (done!): assemble function values of all spring elements
@@ -74,10 +82,10 @@ namespace AOPT {
                 xe_[2] = _x[2*springs_[i].second];
                 xe_[3] = _x[2*springs_[i].second+1];
 
-                coeff[0] = ks_[i];
-                coeff[1] = ls_[i];
+                coeff_[0] = ks_[i];
+                coeff_[1] = ls_[i];
 
-                energy += func_.eval_f(xe_, coeff);
+                energy += func_.eval_f(xe_, coeff_);
             }
             //------------------------------------------------------//
 
@@ -99,8 +107,6 @@ namespace AOPT {
             _g.resize(n_unknowns());
             _g.setZero();
 
-            //used to store the value of k and l, i.e. coeff[0] = ks_[i];
-            Vec coeff(2);
 
             //------------------------------------------------------//
             //TODO: assemble local gradient vector to the global one
@@ -112,10 +118,10 @@ namespace AOPT {
                 xe_[2] = _x[2 * springs_[i].second];
                 xe_[3] = _x[2 * springs_[i].second + 1];
 
-                coeff[0] = ks_[i];
-                coeff[1] = ls_[i];
+                coeff_[0] = ks_[i];
+                coeff_[1] = ls_[i];
                 // get local gradient
-                func_.eval_gradient(xe_, coeff, ge_);
+                func_.eval_gradient(xe_, coeff_, ge_);
 
                 //copy to global
                 _g[2 * springs_[i].first] += ge_[0];
@@ -137,8 +143,6 @@ namespace AOPT {
             _h.resize(n_unknowns(), n_unknowns());
             _h.setZero();
 
-            //used to store the value of k and l, i.e. coeff[0] = ks_[i];
-            Vec coeff(2);
 
             //------------------------------------------------------//
             //TODO: assemble local hessian matrix to the global one
@@ -155,11 +159,11 @@ namespace AOPT {
                 xe_[2] = _x[id2];
                 xe_[3] = _x[id3];
 
-                coeff[0] = ks_[i];
-                coeff[1] = ls_[i];
+                coeff_[0] = ks_[i];
+                coeff_[1] = ls_[i];
 
                 //get local hessian
-                func_.eval_hessian(xe_, coeff, he_);
+                func_.eval_hessian(xe_, coeff_, he_);
 
                 //copy to global
                 _h(id0, id0) += he_(0,0);
@@ -186,6 +190,49 @@ namespace AOPT {
         }
 
 
+        /** evaluates only the 2x2 diagonal blocks of the Hessian, i.e. the
+         * per-node blocks d^2E/dx_i^2, in a single pass over the springs,
+         * as MassSpringProblem2DSparse::eval_block_diagonal() does.
+         * No n x n matrix is formed, which makes it usable as a preconditioner.
+         *
+         * \param _x the problem's springs positions.
+         *           It should contain the positions of all nodes of the system.
+         *           i.e. (_x[2*i], _x[2*i+1]) is the position of the i-th node
+         * \param _blocks output of size 2*n_unknowns(), the block of the i-th node
+         *           is stored row by row in _blocks[4*i], ..., _blocks[4*i+3] */
+        void eval_block_diagonal(const Vec &_x, Vec &_blocks) {
+            _blocks.resize(2 * n_unknowns());
+            _blocks.setZero();
+
+            for(size_t i=0; i<springs_.size(); ++i) {
+                int v0 = springs_[i].first;
+                int v1 = springs_[i].second;
+
+                xe_[0] = _x[2*v0];
+                xe_[1] = _x[2*v0+1];
+
+                xe_[2] = _x[2*v1];
+                xe_[3] = _x[2*v1+1];
+
+                coeff_[0] = ks_[i];
+                coeff_[1] = ls_[i];
+
+                func_.eval_hessian(xe_, coeff_, he_);
+
+                //only the blocks coupling a node with itself
+                _blocks[4*v0]   += he_(0,0);
+                _blocks[4*v0+1] += he_(0,1);
+                _blocks[4*v0+2] += he_(1,0);
+                _blocks[4*v0+3] += he_(1,1);
+
+                _blocks[4*v1]   += he_(2,2);
+                _blocks[4*v1+1] += he_(2,3);
+                _blocks[4*v1+2] += he_(3,2);
+                _blocks[4*v1+3] += he_(3,3);
+            }
+        }
+
+
         void add_spring_element(const int _v_idx0, const int _v_idx1, const double _k = 1., const double _l = 1.) {
             if (2 * _v_idx0 > (int) n_ || _v_idx0 < 0 || 2 * _v_idx1 >= (int) n_ || _v_idx1 < 0)
                 std::cout << "Warning: invalid spring element was added... " << _v_idx0 << " " << _v_idx1 << std::endl;
@@ -213,6 +260,8 @@ namespace AOPT {
         Vec ge_;
         // hessian of each spring element
         Mat he_;
+        // constants of a spring, i.e. coeff_[0] = ks_[i], coeff_[1] = ls_[i]
+        Vec coeff_;
     };
 
 //=============================================================================
@@ -2,6 +2,7 @@
 
 #include <FunctionBase/FunctionBaseSparse.hh>
 #include <FunctionBase/ParametricFunctionBase.hh>
+#include <FunctionBase/TripletAssembler.hh>
 #include "ConstrainedSpringElement2DLeastSquare.hh"
 
 //== NAMESPACES ===============================================================
@@ -48,7 +49,10 @@ namespace AOPT {
 
             cs_xe_.resize(cse_.n_unknowns());
             cs_ge_.resize(cse_.n_unknowns());
-            
+
+            // springs without length only use coeff_[0]
+            coeff_.resize(2);
+            coeff1_.resize(2);
 
             if(func_.n_unknowns() == 2)
                 spring_type_ = WITHOUT_LENGTH;
@@ -80,10 +84,9 @@ namespace AOPT {
              * Hint: implement eval_r to set r, containing all rj, and then use it to compute the energy */
 
 
-            Vec r;
-            eval_r(_x, r);
+            eval_r(_x, r_);
 
-            energy = 0.5 * r.squaredNorm();
+            energy = 0.5 * r_.squaredNorm();
 
             //------------------------------------------------------//
 
@@ -110,13 +113,9 @@ namespace AOPT {
              *        then eval_jacobian(_x, J) to compute J,
              * and then compute the gradient with J^T*r */
 
-            Vec r;
-            eval_r(_x, r);
+            eval_r_and_jacobian(_x, r_, J_);
 
-            SMat J;
-            eval_jacobian(_x, J);
-
-            _g = J.transpose()*r;
+            _g.noalias() = J_.transpose()*r_;
             //------------------------------------------------------//
         }
 
@@ -160,18 +159,17 @@ namespace AOPT {
             }
         }
 
-    private:
+        /** number of residuals rj, i.e. the number of rows of the Jacobian */
+        int n_residuals() const {
+            return num_spring_residuals() + 2 * attached_node_indices_.size();
+        }
 
         /** evaluate the  least square expression rj(x) for all springs
          * and then fills the vector _r */
         void eval_r(const Vec &_x, Vec& _r) {
 
             //set dimension of vector r, depending on the type of spring
-            int num_rj;
-            if (spring_type_ == WITHOUT_LENGTH)
-                num_rj = 2 * springs_.size();
-            else if(spring_type_ == WITH_LENGTH)
-                num_rj = springs_.size();
+            int num_rj = num_spring_residuals();
 
             int dim = num_rj + 2 * attached_node_indices_.size();
             _r.resize(dim);
@@ -186,32 +184,28 @@ namespace AOPT {
              *       and every spring element has one rj(x), where x is a 4D vector */
 
             if(spring_type_ == WITHOUT_LENGTH) {
-                Vec coeff(1);
-
                 for(size_t i=0; i<springs_.size(); ++i) {
-                    coeff[0] = ks_[i];
+                    coeff_[0] = ks_[i];
 
                     xe_[0] = _x[2*springs_[i].first];
                     xe_[1] = _x[2*springs_[i].second];
-                    _r[2*i] = func_.eval_f(xe_, coeff);
+                    _r[2*i] = func_.eval_f(xe_, coeff_);
 
                     xe_[0] = _x[2*springs_[i].first+1];
                     xe_[1] = _x[2*springs_[i].second+1];
-                    _r[2*i+1] = func_.eval_f(xe_, coeff);
+                    _r[2*i+1] = func_.eval_f(xe_, coeff_);
                 }
             } else if(spring_type_ == WITH_LENGTH){
-                Vec coeff(2);
-
                 for(size_t i=0; i<springs_.size(); ++i) {
-                    coeff[0] = ks_[i];
-                    coeff[1] = ls_[i];
+                    coeff_[0] = ks_[i];
+                    coeff_[1] = ls_[i];
 
                     xe_[0] = _x[2*springs_[i].first];
                     xe_[1] = _x[2*springs_[i].first+1];
                     xe_[2] = _x[2*springs_[i].second];
                     xe_[3] = _x[2*springs_[i].second+1];
 
-                    _r[i] = func_.eval_f(xe_, coeff);
+                    _r[i] = func_.eval_f(xe_, coeff_);
                 }
             }
 
@@ -221,18 +215,17 @@ namespace AOPT {
              *       rj(x), for all CONSTRAINED springs
              *       Since those are very similar to the springs without length
              *       in their expression, you can use that to get inspired */
-            Vec coeff1(2);
             for(int i=0; i<attached_node_indices_.size(); ++i) {
-                coeff1[0] = weights_[i];
-                coeff1[1] = desired_points_[2*i];
+                coeff1_[0] = weights_[i];
+                coeff1_[1] = desired_points_[2*i];
 
                 cs_xe_[0] = _x[2*attached_node_indices_[i]];
-                _r[num_rj+2*i] = cse_.eval_f(cs_xe_, coeff1);
+                _r[num_rj+2*i] = cse_.eval_f(cs_xe_, coeff1_);
 
                 cs_xe_[0] = _x[2*attached_node_indices_[i]+1];
-                coeff1[1] = desired_points_[2*i+1];
+                coeff1_[1] = desired_points_[2*i+1];
 
-                _r[num_rj+2*i+1] = cse_.eval_f(cs_xe_, coeff1);
+                _r[num_rj+2*i+1] = cse_.eval_f(cs_xe_, coeff1_);
             }
         }
 
@@ -243,11 +236,7 @@ namespace AOPT {
         void eval_jacobian(const Vec &_x, SMat &_J) {
 
             //get dimension of vector r
-            int num_rj;
-            if (spring_type_ == WITHOUT_LENGTH)
-                num_rj = 2 * springs_.size();
-            else if(spring_type_ == WITH_LENGTH)
-                num_rj = springs_.size();
+            int num_rj = num_spring_residuals();
 
             int dim = num_rj + 2 * attached_node_indices_.size();
 
@@ -267,29 +256,27 @@ namespace AOPT {
 
             //SpringElement2DLeastSquare
             if (spring_type_ == WITHOUT_LENGTH) {
-                Vec coeff(1);
                 for (size_t i = 0; i < springs_.size(); ++i) {
-                    coeff[0] = ks_[i];
+                    coeff_[0] = ks_[i];
 
                     xe_[0] = _x[2 * springs_[i].first];
                     xe_[1] = _x[2 * springs_[i].second];
                     // get local gradient
-                    func_.eval_gradient(xe_, coeff, ge_);
+                    func_.eval_gradient(xe_, coeff_, ge_);
                     triplets.emplace_back(2 * i, 2 * springs_[i].first, ge_[0]);
                     triplets.emplace_back(2 * i, 2 * springs_[i].second, ge_[1]);
 
                     xe_[0] = _x[2 * springs_[i].first + 1];
                     xe_[1] = _x[2 * springs_[i].second + 1];
                     // get local gradient
-                    func_.eval_gradient(xe_, coeff, ge_);
+                    func_.eval_gradient(xe_, coeff_, ge_);
                     triplets.emplace_back(2 * i + 1, 2 * springs_[i].first + 1, ge_[0]);
                     triplets.emplace_back(2 * i + 1, 2 * springs_[i].second + 1, ge_[1]);
                 }
             } else if(spring_type_ == WITH_LENGTH) { //SpringElement2DWithLengthLeastSquare
-                Vec coeff(2);
                 for (size_t i = 0; i < springs_.size(); ++i) {
-                    coeff[0] = ks_[i];
-                    coeff[1] = ls_[i];
+                    coeff_[0] = ks_[i];
+                    coeff_[1] = ls_[i];
 
                     xe_[0] = _x[2 * springs_[i].first];
                     xe_[1] = _x[2 * springs_[i].first + 1];
@@ -297,7 +284,7 @@ namespace AOPT {
                     xe_[3] = _x[2 * springs_[i].second + 1];
 
                     // get local gradient
-                    func_.eval_gradient(xe_, coeff, ge_);
+                    func_.eval_gradient(xe_, coeff_, ge_);
 
                     triplets.emplace_back(i, 2 * springs_[i].first, ge_[0]);
                     triplets.emplace_back(i, 2 * springs_[i].first + 1, ge_[1]);
@@ -307,19 +294,18 @@ namespace AOPT {
             }
 
 
-            Vec coeff1(2);
             for (int i = 0; i < attached_node_indices_.size(); ++i) {
-                coeff1[0] = weights_[i];
+                coeff1_[0] = weights_[i];
 
                 cs_xe_[0] = _x[2 * attached_node_indices_[i]];
-                coeff1[1] = desired_points_[2 * i];
-                cse_.eval_gradient(cs_xe_, coeff1, cs_ge_);
+                coeff1_[1] = desired_points_[2 * i];
+                cse_.eval_gradient(cs_xe_, coeff1_, cs_ge_);
                 triplets.emplace_back(num_rj + 2 * i, 2 * attached_node_indices_[i], cs_ge_[0]);
 
 
                 cs_xe_[0] = _x[2 * attached_node_indices_[i] + 1];
-                coeff1[1] = desired_points_[2 * i + 1];
-                cse_.eval_gradient(cs_xe_, coeff1, cs_ge_);
+                coeff1_[1] = desired_points_[2 * i + 1];
+                cse_.eval_gradient(cs_xe_, coeff1_, cs_ge_);
                 triplets.emplace_back(num_rj + 2 * i + 1, 2 * attached_node_indices_[i] + 1, cs_ge_[0]);
             }
 
@@ -330,6 +316,159 @@ namespace AOPT {
         }
 
 
+        /** evaluates r and J in a single pass over the springs, i.e. the same as
+         * eval_r() followed by eval_jacobian() at half the cost.
+         * The sparsity pattern of _J does not depend on _x. */
+        void eval_r_and_jacobian(const Vec &_x, Vec& _r, SMat &_J) {
+            int num_rj = num_spring_residuals();
+            int dim = num_rj + 2 * attached_node_indices_.size();
+
+            _r.resize(dim);
+
+            triplets_.clear();
+            triplets_.reserve(4*springs_.size() + 2*attached_node_indices_.size());
+
+            if (spring_type_ == WITHOUT_LENGTH) {
+                for (size_t i = 0; i < springs_.size(); ++i) {
+                    coeff_[0] = ks_[i];
+
+                    xe_[0] = _x[2 * springs_[i].first];
+                    xe_[1] = _x[2 * springs_[i].second];
+                    _r[2*i] = func_.eval_f(xe_, coeff_);
+                    func_.eval_gradient(xe_, coeff_, ge_);
+                    triplets_.emplace_back(2 * i, 2 * springs_[i].first, ge_[0]);
+                    triplets_.emplace_back(2 * i, 2 * springs_[i].second, ge_[1]);
+
+                    xe_[0] = _x[2 * springs_[i].first + 1];
+                    xe_[1] = _x[2 * springs_[i].second + 1];
+                    _r[2*i+1] = func_.eval_f(xe_, coeff_);
+                    func_.eval_gradient(xe_, coeff_, ge_);
+                    triplets_.emplace_back(2 * i + 1, 2 * springs_[i].first + 1, ge_[0]);
+                    triplets_.emplace_back(2 * i + 1, 2 * springs_[i].second + 1, ge_[1]);
+                }
+            } else if(spring_type_ == WITH_LENGTH) {
+                for (size_t i = 0; i < springs_.size(); ++i) {
+                    coeff_[0] = ks_[i];
+                    coeff_[1] = ls_[i];
+
+                    xe_[0] = _x[2 * springs_[i].first];
+                    xe_[1] = _x[2 * springs_[i].first + 1];
+                    xe_[2] = _x[2 * springs_[i].second];
+                    xe_[3] = _x[2 * springs_[i].second + 1];
+
+                    _r[i] = func_.eval_f(xe_, coeff_);
+                    func_.eval_gradient(xe_, coeff_, ge_);
+
+                    triplets_.emplace_back(i, 2 * springs_[i].first, ge_[0]);
+                    triplets_.emplace_back(i, 2 * springs_[i].first + 1, ge_[1]);
+                    triplets_.emplace_back(i, 2 * springs_[i].second, ge_[2]);
+                    triplets_.emplace_back(i, 2 * springs_[i].second + 1, ge_[3]);
+                }
+            }
+
+            for (int i = 0; i < (int)attached_node_indices_.size(); ++i) {
+                coeff1_[0] = weights_[i];
+
+                cs_xe_[0] = _x[2 * attached_node_indices_[i]];
+                coeff1_[1] = desired_points_[2 * i];
+                _r[num_rj + 2 * i] = cse_.eval_f(cs_xe_, coeff1_);
+                cse_.eval_gradient(cs_xe_, coeff1_, cs_ge_);
+                triplets_.emplace_back(num_rj + 2 * i, 2 * attached_node_indices_[i], cs_ge_[0]);
+
+                cs_xe_[0] = _x[2 * attached_node_indices_[i] + 1];
+                coeff1_[1] = desired_points_[2 * i + 1];
+                _r[num_rj + 2 * i + 1] = cse_.eval_f(cs_xe_, coeff1_);
+                cse_.eval_gradient(cs_xe_, coeff1_, cs_ge_);
+                triplets_.emplace_back(num_rj + 2 * i + 1, 2 * attached_node_indices_[i] + 1, cs_ge_[0]);
+            }
+
+            // only the values change once the pattern of _J is known
+            assembler_.assemble(triplets_, dim, n_unknowns(), _J);
+        }
+
+
+        /** matrix-free product _jv = J(_x) * _v. The entries of J are computed
+         * spring by spring and used right away, J is never stored. */
+        void eval_jacobian_product(const Vec &_x, const Vec &_v, Vec &_jv) {
+            _jv.setZero(n_residuals());
+            for_each_jacobian_entry(_x, [&](const int _row, const int _col, const double _val) {
+                _jv[_row] += _val * _v[_col];
+            });
+        }
+
+        /** matrix-free product _jtw = J(_x)^T * _w */
+        void eval_jacobian_transpose_product(const Vec &_x, const Vec &_w, Vec &_jtw) {
+            _jtw.setZero(n_);
+            for_each_jacobian_entry(_x, [&](const int _row, const int _col, const double _val) {
+                _jtw[_col] += _val * _w[_row];
+            });
+        }
+
+        /** euclidean norms of the columns of J(_x) */
+        void eval_jacobian_column_norms(const Vec &_x, Vec &_c) {
+            _c.setZero(n_);
+            for_each_jacobian_entry(_x, [&](const int, const int _col, const double _val) {
+                _c[_col] += _val * _val;
+            });
+            _c = _c.cwiseSqrt();
+        }
+
+
+    private:
+        /** number of residuals of the (non-constrained) springs */
+        int num_spring_residuals() const {
+            return spring_type_ == WITHOUT_LENGTH ? 2 * springs_.size() : springs_.size();
+        }
+
+        /** calls _f(row, col, value) for every nonzero of J(_x), in the same
+         * order as eval_jacobian() emits its triplets */
+        template <class F>
+        void for_each_jacobian_entry(const Vec &_x, F&& _f) {
+            int num_rj = num_spring_residuals();
+
+            if (spring_type_ == WITHOUT_LENGTH) {
+                for (size_t i = 0; i < springs_.size(); ++i) {
+                    coeff_[0] = ks_[i];
+
+                    for(int d = 0; d < 2; ++d) {
+                        xe_[0] = _x[2 * springs_[i].first + d];
+                        xe_[1] = _x[2 * springs_[i].second + d];
+                        func_.eval_gradient(xe_, coeff_, ge_);
+                        _f(2 * i + d, 2 * springs_[i].first + d, ge_[0]);
+                        _f(2 * i + d, 2 * springs_[i].second + d, ge_[1]);
+                    }
+                }
+            } else if(spring_type_ == WITH_LENGTH) {
+                for (size_t i = 0; i < springs_.size(); ++i) {
+                    coeff_[0] = ks_[i];
+                    coeff_[1] = ls_[i];
+
+                    xe_[0] = _x[2 * springs_[i].first];
+                    xe_[1] = _x[2 * springs_[i].first + 1];
+                    xe_[2] = _x[2 * springs_[i].second];
+                    xe_[3] = _x[2 * springs_[i].second + 1];
+                    func_.eval_gradient(xe_, coeff_, ge_);
+
+                    _f(i, 2 * springs_[i].first, ge_[0]);
+                    _f(i, 2 * springs_[i].first + 1, ge_[1]);
+                    _f(i, 2 * springs_[i].second, ge_[2]);
+                    _f(i, 2 * springs_[i].second + 1, ge_[3]);
+                }
+            }
+
+            for (int i = 0; i < (int)attached_node_indices_.size(); ++i) {
+                coeff1_[0] = weights_[i];
+
+                for(int d = 0; d < 2; ++d) {
+                    cs_xe_[0] = _x[2 * attached_node_indices_[i] + d];
+                    coeff1_[1] = desired_points_[2 * i + d];
+                    cse_.eval_gradient(cs_xe_, coeff1_, cs_ge_);
+                    _f(num_rj + 2 * i + d, 2 * attached_node_indices_[i] + d, cs_ge_[0]);
+                }
+            }
+        }
+
+
     private:
         int n_;
         std::vector<Edge> springs_;
@@ -358,6 +497,18 @@ namespace AOPT {
         Vec cs_xe_;
         // gradient of each attached node
         Vec cs_ge_;
+
+        // constants of a spring (k, l) and of a node constraint (w, p)
+        Vec coeff_;
+        Vec coeff1_;
+
+        // residuals and Jacobian of eval_f() and eval_gradient()
+        Vec r_;
+        SMat J_;
+
+        // triplets of the Jacobian, kept to avoid reallocations
+        std::vector<T> triplets_;
+        TripletAssembler assembler_;
     };
 
 //=============================================================================
@@ -1,7 +1,11 @@
 #pragma once
 
+#include <mutex>
 #include <FunctionBase/FunctionBaseSparse.hh>
 #include <FunctionBase/ParametricFunctionBase.hh>
+#include <FunctionBase/TripletAssembler.hh>
+#include <Utils/MemoryFootprint.hh>
+#include <Utils/Profiler.hh>
 #include "ConstrainedSpringElement2D.hh"
 
 //== NAMESPACES ===============================================================
@@ -34,13 +38,9 @@ namespace AOPT {
             n_(_n_unknowns),
             func_(_spring)
         {
-            xe_.resize(func_.n_unknowns());
-            ge_.resize(func_.n_unknowns());
-            he_.resize(func_.n_unknowns(), func_.n_unknowns());
-
-            cs_xe_.resize(cse_.n_unknowns());
-            cs_ge_.resize(cse_.n_unknowns());
-            cs_he_.resize(cse_.n_unknowns(), cse_.n_unknowns());
+            // sizes the buffers of the constructing thread, the evaluations of the other
+            // threads size theirs on their first call
+            buffers();
         }
 
         ~MassSpringProblem2DSparse() {}
@@ -49,6 +49,21 @@ namespace AOPT {
             return n_;
         }
 
+        // the sum is quadratic if both kinds of springs are
+        virtual bool is_quadratic() override {
+            return func_.is_quadratic() && cse_.is_quadratic();
+        }
+
+        virtual bool has_constant_hessian() override {
+            return func_.has_constant_hessian() && cse_.has_constant_hessian();
+        }
+
+        // the buffers of the elements are per thread, and eval_hessian() assembles the
+        // triplets under a lock
+        virtual bool is_thread_safe() override {
+            return func_.is_thread_safe() && cse_.is_thread_safe();
+        }
+
         /** evaluates the spring element's energy, which is the sum of the energy
          * of all its springs.
          *
@@ -57,43 +72,39 @@ namespace AOPT {
          *           i.e. (_x[2*i], _x[2*i+1]) is the position of the i-th node
          * \return the sum of the energy of all the springs */
         virtual double eval_f(const Vec &_x) override {
+            ElementBuffers& b = buffers();
             double energy(0);
 
-            //used to store the value of k and l, i.e. coeff[0] = ks_[i];
-            Vec coeff(2);
-
             //------------------------------------------------------//
             //TODO (done!): assemble function values of all spring elements
-            //use vector xe_ to store the local coordinates of two nodes of every spring
+            //use vector b.xe to store the local coordinates of two nodes of every spring
             //then pass it to func_.eval_f(...)
 
             for(size_t i=0; i<springs_.size(); ++i) {
-                xe_[0] = _x[2*springs_[i].first];
-                xe_[1] = _x[2*springs_[i].first+1];
+                b.xe[0] = _x[2*springs_[i].first];
+                b.xe[1] = _x[2*springs_[i].first+1];
 
-                xe_[2] = _x[2*springs_[i].second];
-                xe_[3] = _x[2*springs_[i].second+1];
+                b.xe[2] = _x[2*springs_[i].second];
+                b.xe[3] = _x[2*springs_[i].second+1];
 
-                coeff[0] = ks_[i];
-                coeff[1] = ls_[i];
+                b.coeff[0] = ks_[i];
+                b.coeff[1] = ls_[i];
 
-                energy += func_.eval_f(xe_, coeff);
+                energy += func_.eval_f(b.xe, b.coeff);
             }
 
-            //used to store the value of w_n and desired point
-            Vec coeff1(3);
             //------------------------------------------------------//
             //TODO: assemble function values of all the constrained spring elements
-            //use cs_xe_ to store the coordinate of the attached node index
+            //use b.cs_xe to store the coordinate of the attached node index
             for(int i=0; i<attached_node_indices_.size(); ++i) {
-                cs_xe_[0] = _x[2*attached_node_indices_[i]];
-                cs_xe_[1] = _x[2*attached_node_indices_[i]+1];
+                b.cs_xe[0] = _x[2*attached_node_indices_[i]];
+                b.cs_xe[1] = _x[2*attached_node_indices_[i]+1];
 
-                coeff1[0] = weights_[i];
-                coeff1[1] = desired_points_[2*i];
-                coeff1[2] = desired_points_[2*i+1];
+                b.coeff1[0] = weights_[i];
+                b.coeff1[1] = desired_points_[2*i];
+                b.coeff1[2] = desired_points_[2*i+1];
 
-                energy += cse_.eval_f(cs_xe_, coeff1);
+                energy += cse_.eval_f(b.cs_xe, b.coeff1);
             }
 
             //------------------------------------------------------//
@@ -114,51 +125,50 @@ namespace AOPT {
          *           i.e. (_g[2*i], _g[2*i+1]) is the sum of gradients of all the
          *           springs connected to the i-th node (see handout) */
         virtual void eval_gradient(const Vec &_x, Vec &_g) override {
+            ElementBuffers& b = buffers();
             _g.resize(n_unknowns());
             _g.setZero();
-            Vec coeff(2);
 
             //------------------------------------------------------//
             //TODO (done!): assemble local gradient vector to the global one
-            //use ge_ to store the result of the local gradient
+            //use b.ge to store the result of the local gradient
             for(size_t i=0; i<springs_.size(); ++i) {
-                xe_[0] = _x[2 * springs_[i].first];
-                xe_[1] = _x[2 * springs_[i].first + 1];
+                b.xe[0] = _x[2 * springs_[i].first];
+                b.xe[1] = _x[2 * springs_[i].first + 1];
 
-                xe_[2] = _x[2 * springs_[i].second];
-                xe_[3] = _x[2 * springs_[i].second + 1];
+                b.xe[2] = _x[2 * springs_[i].second];
+                b.xe[3] = _x[2 * springs_[i].second + 1];
 
-                coeff[0] = ks_[i];
-                coeff[1] = ls_[i];
+                b.coeff[0] = ks_[i];
+                b.coeff[1] = ls_[i];
                 // get local gradient
-                func_.eval_gradient(xe_, coeff, ge_);
+                func_.eval_gradient(b.xe, b.coeff, b.ge);
 
                 //copy to global
-                _g[2 * springs_[i].first] += ge_[0];
-                _g[2 * springs_[i].first + 1] += ge_[1];
-                _g[2 * springs_[i].second] += ge_[2];
-                _g[2 * springs_[i].second + 1] += ge_[3];
+                _g[2 * springs_[i].first] += b.ge[0];
+                _g[2 * springs_[i].first + 1] += b.ge[1];
+                _g[2 * springs_[i].second] += b.ge[2];
+                _g[2 * springs_[i].second + 1] += b.ge[3];
             }
 
-            Vec coeff1(3);
             //------------------------------------------------------//
             //TODO: assemble local gradient vector of all the constrained spring elements to the global one
-            //use cs_ge_ to store the gradient of the attached node index
+            //use b.cs_ge to store the gradient of the attached node index
 
             for(int i=0; i<attached_node_indices_.size(); ++i) {
-                cs_xe_[0] = _x[2*attached_node_indices_[i]];
-                cs_xe_[1] = _x[2*attached_node_indices_[i]+1];
+                b.cs_xe[0] = _x[2*attached_node_indices_[i]];
+                b.cs_xe[1] = _x[2*attached_node_indices_[i]+1];
 
-                coeff1[0] = weights_[i];
-                coeff1[1] = desired_points_[2*i];
-                coeff1[2] = desired_points_[2*i+1];
+                b.coeff1[0] = weights_[i];
+                b.coeff1[1] = desired_points_[2*i];
+                b.coeff1[2] = desired_points_[2*i+1];
 
                 // get local gradient
-                cse_.eval_gradient(cs_xe_, coeff1, cs_ge_);
+                cse_.eval_gradient(b.cs_xe, b.coeff1, b.cs_ge);
 
                 //copy to global
-                _g[2 * attached_node_indices_[i]] += cs_ge_[0];
-                _g[2 * attached_node_indices_[i] + 1] += cs_ge_[1];
+                _g[2 * attached_node_indices_[i]] += b.cs_ge[0];
+                _g[2 * attached_node_indices_[i] + 1] += b.cs_ge[1];
             }
 
             //------------------------------------------------------//
@@ -175,14 +185,17 @@ namespace AOPT {
          *           It should contain the positions of all nodes of the system.
          *           i.e. (_x[2*i], _x[2*i+1]) is the position of the i-th node **/
         virtual void eval_hessian(const Vec &_x, SMat& _h) override {
-            std::vector<T> triplets;
-            triplets.reserve(16*springs_.size());
+            AOPT_PROFILE_SCOPE("MassSpringProblem2DSparse::eval_hessian");
+            ElementBuffers& b = buffers();
+            std::lock_guard<std::mutex> lock(hessian_mutex_);
+            // the triplets and the pattern of the matrix are kept between the calls,
+            // only the values are updated once the pattern is known
+            triplets_.clear();
+            triplets_.reserve(16*springs_.size() + 4*attached_node_indices_.size());
 
-            //used to store the value of k and l, i.e. coeff[0] = ks_[i], coeff[0] = ls_[i];
-            Vec coeff(2);
             //------------------------------------------------------//
             //TODO (done!): assemble local hessian matrix to the global one
-            //use he_ to store the local hessian matrix
+            //use b.he to store the local hessian matrix
 
             for(int i=0; i<ks_.size(); ++i) {
                 int id0 = 2 * springs_[i].first;
@@ -190,74 +203,136 @@ namespace AOPT {
                 int id2 = 2 * springs_[i].second;
                 int id3 = 2 * springs_[i].second + 1;
 
-                xe_[0] = _x[id0];
-                xe_[1] = _x[id1];
+                b.xe[0] = _x[id0];
+                b.xe[1] = _x[id1];
 
-                xe_[2] = _x[id2];
-                xe_[3] = _x[id3];
+                b.xe[2] = _x[id2];
+                b.xe[3] = _x[id3];
 
-                coeff[0] = ks_[i];
-                coeff[1] = ls_[i];
+                b.coeff[0] = ks_[i];
+                b.coeff[1] = ls_[i];
 
                 //get local hessian
-                func_.eval_hessian(xe_, coeff, he_);
+                func_.eval_hessian(b.xe, b.coeff, b.he);
 
                 //copy to global
                 //NOTE: no need to manually accumulate.
                 //this is done internally by Eigen
                 //e.g. with two triplets (i,j, x) and (i,j,y), you would have the entry (i,j, x+y)
-                triplets.emplace_back(id0, id0, he_(0,0));
-                triplets.emplace_back(id0, id1, he_(0,1));
-                triplets.emplace_back(id0, id2, he_(0,2));
-                triplets.emplace_back(id0, id3, he_(0,3));
-
-                triplets.emplace_back(id1, id0, he_(1,0));
-                triplets.emplace_back(id1, id1, he_(1,1));
-                triplets.emplace_back(id1, id2, he_(1,2));
-                triplets.emplace_back(id1, id3, he_(1,3));
-
-                triplets.emplace_back(id2, id0, he_(2,0));
-                triplets.emplace_back(id2, id1, he_(2,1));
-                triplets.emplace_back(id2, id2, he_(2,2));
-                triplets.emplace_back(id2, id3, he_(2,3));
-
-                triplets.emplace_back(id3, id0, he_(3,0));
-                triplets.emplace_back(id3, id1, he_(3,1));
-                triplets.emplace_back(id3, id2, he_(3,2));
-                triplets.emplace_back(id3, id3, he_(3,3));
+                triplets_.emplace_back(id0, id0, b.he(0,0));
+                triplets_.emplace_back(id0, id1, b.he(0,1));
+                triplets_.emplace_back(id0, id2, b.he(0,2));
+                triplets_.emplace_back(id0, id3, b.he(0,3));
+
+                triplets_.emplace_back(id1, id0, b.he(1,0));
+                triplets_.emplace_back(id1, id1, b.he(1,1));
+                triplets_.emplace_back(id1, id2, b.he(1,2));
+                triplets_.emplace_back(id1, id3, b.he(1,3));
+
+                triplets_.emplace_back(id2, id0, b.he(2,0));
+                triplets_.emplace_back(id2, id1, b.he(2,1));
+                triplets_.emplace_back(id2, id2, b.he(2,2));
+                triplets_.emplace_back(id2, id3, b.he(2,3));
+
+                triplets_.emplace_back(id3, id0, b.he(3,0));
+                triplets_.emplace_back(id3, id1, b.he(3,1));
+                triplets_.emplace_back(id3, id2, b.he(3,2));
+                triplets_.emplace_back(id3, id3, b.he(3,3));
             }
             
             //------------------------------------------------------//
             //TODO: assemble local gradient vector of all the constrained spring elements to the global one
-            //use cs_he_ to store the gradient of the attached node index
+            //use b.cs_he to store the gradient of the attached node index
 
 
-            Vec coeff1(3);
             for(int i=0; i<attached_node_indices_.size(); ++i) {
 
                 int id1 = 2*attached_node_indices_[i];
                 int id2 = 2*attached_node_indices_[i]+1;
 
-                cs_xe_[0] = _x[id1];
-                cs_xe_[1] = _x[id2];
+                b.cs_xe[0] = _x[id1];
+                b.cs_xe[1] = _x[id2];
 
-                coeff1[0] = weights_[i];
-                coeff1[1] = desired_points_[2*i];
-                coeff1[2] = desired_points_[2*i+1];
+                b.coeff1[0] = weights_[i];
+                b.coeff1[1] = desired_points_[2*i];
+                b.coeff1[2] = desired_points_[2*i+1];
 
-                cse_.eval_hessian(cs_xe_, coeff1, cs_he_);
+                cse_.eval_hessian(b.cs_xe, b.coeff1, b.cs_he);
 
                 //copy to global
-                triplets.emplace_back(id1, id1, cs_he_(0,0));
-                triplets.emplace_back(id1, id2, cs_he_(0,1));
-                triplets.emplace_back(id2, id1, cs_he_(1,0));
-                triplets.emplace_back(id2, id2, cs_he_(1,1));
+                triplets_.emplace_back(id1, id1, b.cs_he(0,0));
+                triplets_.emplace_back(id1, id2, b.cs_he(0,1));
+                triplets_.emplace_back(id2, id1, b.cs_he(1,0));
+                triplets_.emplace_back(id2, id2, b.cs_he(1,1));
             }
             //------------------------------------------------------//
 
-            _h.resize(n_unknowns(), n_unknowns());
-            _h.setZero();
-            _h.setFromTriplets(triplets.begin(), triplets.end());
+            AOPT_PROFILE_SCOPE("set_from_triplets");
+            assembler_.assemble(triplets_, n_unknowns(), n_unknowns(), _h);
+            AOPT_PROFILE_MEMORY("triplets", triplets_);
+            AOPT_PROFILE_MEMORY("assembler", assembler_);
+        }
+
+
+        /** evaluates only the 2x2 diagonal blocks of the Hessian, i.e. the
+         * per-node blocks d^2E/dx_i^2, in a single pass over the springs.
+         * This is much cheaper than eval_hessian() since no sparse matrix is
+         * assembled, and it is typically used as a preconditioner.
+         *
+         * \param _x the problem's springs positions.
+         *           It should contain the positions of all nodes of the system.
+         *           i.e. (_x[2*i], _x[2*i+1]) is the position of the i-th node
+         * \param _blocks output of size 2*n_unknowns(), the block of the i-th node
+         *           is stored row by row in _blocks[4*i], ..., _blocks[4*i+3] */
+        void eval_block_diagonal(const Vec &_x, Vec &_blocks) {
+            ElementBuffers& b = buffers();
+            _blocks.resize(2 * n_unknowns());
+            _blocks.setZero();
+
+            for(size_t i=0; i<springs_.size(); ++i) {
+                int v0 = springs_[i].first;
+                int v1 = springs_[i].second;
+
+                b.xe[0] = _x[2*v0];
+                b.xe[1] = _x[2*v0+1];
+
+                b.xe[2] = _x[2*v1];
+                b.xe[3] = _x[2*v1+1];
+
+                b.coeff[0] = ks_[i];
+                b.coeff[1] = ls_[i];
+
+                func_.eval_hessian(b.xe, b.coeff, b.he);
+
+                //only the blocks coupling a node with itself
+                _blocks[4*v0]   += b.he(0,0);
+                _blocks[4*v0+1] += b.he(0,1);
+                _blocks[4*v0+2] += b.he(1,0);
+                _blocks[4*v0+3] += b.he(1,1);
+
+                _blocks[4*v1]   += b.he(2,2);
+                _blocks[4*v1+1] += b.he(2,3);
+                _blocks[4*v1+2] += b.he(3,2);
+                _blocks[4*v1+3] += b.he(3,3);
+            }
+
+            for(size_t i=0; i<attached_node_indices_.size(); ++i) {
+                int v = attached_node_indices_[i];
+
+                b.cs_xe[0] = _x[2*v];
+                b.cs_xe[1] = _x[2*v+1];
+
+                b.coeff1[0] = weights_[i];
+                b.coeff1[1] = desired_points_[2*i];
+                b.coeff1[2] = desired_points_[2*i+1];
+
+                cse_.eval_hessian(b.cs_xe, b.coeff1, b.cs_he);
+
+                _blocks[4*v]   += b.cs_he(0,0);
+                _blocks[4*v+1] += b.cs_he(0,1);
+                _blocks[4*v+2] += b.cs_he(1,0);
+                _blocks[4*v+3] += b.cs_he(1,1);
+            }
         }
 
 
@@ -284,6 +359,33 @@ namespace AOPT {
 
 
     private:
+        // local coordinates, gradient and hessian of a spring element and of a node
+        // constraint element, and their constants (k, l) and (w, px, py)
+        struct ElementBuffers {
+            Vec xe, ge, cs_xe, cs_ge;
+            Mat he, cs_he;
+            Vec coeff, coeff1;
+        };
+
+        // the buffers of the calling thread, sized for the elements of this problem
+        ElementBuffers& buffers() {
+            thread_local ElementBuffers b;
+            const int n = func_.n_unknowns(), m = cse_.n_unknowns();
+            if(b.xe.size() != n) {
+                b.xe.resize(n);
+                b.ge.resize(n);
+                b.he.resize(n, n);
+            }
+            if(b.cs_xe.size() != m) {
+                b.cs_xe.resize(m);
+                b.cs_ge.resize(m);
+                b.cs_he.resize(m, m);
+            }
+            b.coeff.resize(2);
+            b.coeff1.resize(3);
+            return b;
+        }
+
         int n_;
         std::vector<Edge> springs_;
 
@@ -293,13 +395,6 @@ namespace AOPT {
         std::vector<double> ks_;
         std::vector<double> ls_;
 
-        // coordinates of spring nodes (local)
-        Vec xe_;
-        // gradient of each spring element
-        Vec ge_;
-        // hessian of each spring element
-        Mat he_;
-
 
         std::vector<int> attached_node_indices_;
 
@@ -309,12 +404,10 @@ namespace AOPT {
         std::vector<double> weights_;
         std::vector<double> desired_points_;
 
-        // coordinates of each attached node (local)
-        Vec cs_xe_;
-        // gradient of each attached node
-        Vec cs_ge_;
-        // hessian of each node constraint element
-        Mat cs_he_;
+        // triplets of the hessian and their positions in the assembled matrix
+        std::vector<T> triplets_;
+        TripletAssembler assembler_;
+        std::mutex hessian_mutex_;
     };
 
 //=============================================================================
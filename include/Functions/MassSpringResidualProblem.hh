@@ -0,0 +1,58 @@
+#pragma once
+
+#include <FunctionBase/ParametricFunctionBase.hh>
+#include <FunctionBase/ResidualBlockProblem.hh>
+#include "SpringResidualBlock2D.hh"
+#include "SpringWithLengthResidualBlock2D.hh"
+#include "ConstrainedPointResidualBlock2D.hh"
+
+//== NAMESPACES ===============================================================
+
+namespace AOPT {
+
+//== CLASS DEFINITION =========================================================
+
+    /* The least squares mass spring problem of MassSpringProblem2DLeastSquare
+     * written with residual blocks: every spring and every attached node is one block.
+     * It has the same interface, hence it can be used with MassSpringSystemT,
+     * and its residuals are in the same order, i.e. springs first.
+     *
+     * The type of the springs is only looked at when they are added, the evaluation
+     * loops over the blocks of each type (see ResidualBlockProblem). */
+    class MassSpringResidualProblem : public ResidualBlockProblem<SpringResidualBlock2D,
+                                                                  SpringWithLengthResidualBlock2D,
+                                                                  ConstrainedPointResidualBlock2D> {
+    public:
+        /**
+         * \param _spring SpringElement2DLeastSquare or SpringElement2DWithLengthLeastSquare,
+         *        only used to choose the type of the spring blocks
+         * \param _n_unknowns number of unknowns, i.e. twice the number of nodes
+         * \param _n_threads number of threads of the assembly, 0 uses all hardware threads */
+        MassSpringResidualProblem(ParametricFunctionBase& _spring, const int _n_unknowns, const int _n_threads = 0) :
+                ResidualBlockProblem(_n_unknowns, _n_threads),
+                with_length_(_spring.n_unknowns() == 4) {}
+
+        ~MassSpringResidualProblem() {}
+
+        // the residuals of springs without rest length are linear, so is J
+        virtual bool is_quadratic() override {
+            return !with_length_;
+        }
+
+        void add_spring_element(const int _v_idx0, const int _v_idx1, const double _k = 1., const double _l = 1.) {
+            if(with_length_)
+                add_residual_block(SpringWithLengthResidualBlock2D(_v_idx0, _v_idx1, _k, _l));
+            else
+                add_residual_block(SpringResidualBlock2D(_v_idx0, _v_idx1, _k));
+        }
+
+        void add_constrained_spring_element(const int _v_idx, const double _w = 1., const double _px = 0., const double _py = 0.) {
+            add_residual_block(ConstrainedPointResidualBlock2D(_v_idx, _w, _px, _py));
+        }
+
+    private:
+        bool with_length_;
+    };
+
+//=============================================================================
+}
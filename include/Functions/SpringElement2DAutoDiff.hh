@@ -0,0 +1,30 @@
+#pragma once
+
+#include <FunctionBase/AutoDiffElement.hh>
+
+//== NAMESPACES ===============================================================
+
+namespace AOPT {
+
+    //== CLASS DEFINITION =========================================================
+
+    /* SpringElement2D with automatically differentiated gradient and Hessian */
+    class SpringElement2DAutoDiff : public AutoDiffElement<SpringElement2DAutoDiff, 4> {
+    public:
+        SpringElement2DAutoDiff() : AutoDiffElement() {}
+
+        inline virtual bool is_quadratic() override { return true; }
+
+        /** f(x) = 1/2 * k * ((x[0] - x[2])^2 + (x[1] - x[3])^2)
+         * \param _x contains x_a and x_b contiguously, i.e. _x = [x_a, x_b]
+         * \param _coeffs stores the constant k, i.e. _coeffs[0] = k */
+        template <class S>
+        S energy(const std::array<S, 4> &_x, const Vec &_coeffs) const {
+            const S dx = _x[0] - _x[2];
+            const S dy = _x[1] - _x[3];
+            return 0.5 * _coeffs[0] * (dx*dx + dy*dy);
+        }
+    };
+
+//=============================================================================
+}
@@ -21,6 +21,9 @@ namespace AOPT {
         // number of unknowns
         inline virtual int n_unknowns() override { return 4; }
 
+        // the evaluations only read their arguments
+        inline virtual bool is_thread_safe() override { return true; }
+
         /** evaluates the spring element's energy
          * \param _x contains x_a and x_b contiguously,
          *           i.e. _x = [x_a, x_b], i.e. _x is of dimension 4
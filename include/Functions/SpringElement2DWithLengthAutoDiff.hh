@@ -0,0 +1,29 @@
+#pragma once
+
+#include <FunctionBase/AutoDiffElement.hh>
+
+//== NAMESPACES ===============================================================
+
+namespace AOPT {
+
+    //== CLASS DEFINITION =========================================================
+
+    /* SpringElement2DWithLength with automatically differentiated gradient and Hessian */
+    class SpringElement2DWithLengthAutoDiff : public AutoDiffElement<SpringElement2DWithLengthAutoDiff, 4> {
+    public:
+        SpringElement2DWithLengthAutoDiff() : AutoDiffElement() {}
+
+        /** f(x) = 1/2 * k * (((x[0] - x[2])^2 + (x[1] - x[3])^2) - l^2)^2
+         * \param _x contains x_a and x_b contiguously, i.e. _x = [x_a, x_b]
+         * \param _coeffs stores the constants k and l, i.e. _coeffs[0] = k, _coeffs[1] = l */
+        template <class S>
+        S energy(const std::array<S, 4> &_x, const Vec &_coeffs) const {
+            const S dx = _x[0] - _x[2];
+            const S dy = _x[1] - _x[3];
+            const S d = dx*dx + dy*dy - _coeffs[1]*_coeffs[1];
+            return 0.5 * _coeffs[0] * d * d;
+        }
+    };
+
+//=============================================================================
+}
@@ -32,17 +32,19 @@ public:
         // call the parent class hessian computations
         SpringElement2DWithLength::eval_hessian(_x, _coeffs, _H);
 
-        if(_H.llt().info() == Eigen::Success)
+        // the element hessian is 4x4, fixed size matrices keep the
+        // decompositions on the stack
+        const Eigen::Matrix4d H = _H;
+        if(Eigen::LLT<Eigen::Matrix4d>(H).info() == Eigen::Success)
             return;
 
         // Compute Eigen decomposition H = V D V^T
-        Eigen::SelfAdjointEigenSolver<Mat> solver(_H);
-        const Mat& V = solver.eigenvectors();
-        Vec evals = solver.eigenvalues();
+        Eigen::SelfAdjointEigenSolver<Eigen::Matrix4d> solver(H);
+        const Eigen::Matrix4d& V = solver.eigenvectors();
+        Eigen::Vector4d evals = solver.eigenvalues();
         
         // check eigenvalues against epsilon, for those less that eps (zero)
-        const int n = n_unknowns();
-        for (int i = 0; i < n; ++i) {
+        for (int i = 0; i < 4; ++i) {
             if (evals[i] < m_eps) {
                 evals[i] = m_eps;
             }
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cmath>
+#include <FunctionBase/ResidualBlock.hh>
+
+//== NAMESPACES ===============================================================
+
+namespace AOPT {
+
+//== CLASS DEFINITION =========================================================
+
+    /* Residual block of a spring without length between the nodes a and b,
+     *      r(x) = sqrt(k) * (x_a - x_b),
+     * i.e. the two residuals of SpringElement2DLeastSquare (one per dimension)
+     * in a single block of the unknowns x = [x_a, x_b]. */
+    class SpringResidualBlock2D : public ResidualBlock<SpringResidualBlock2D, 2, 4> {
+    public:
+        /**
+         * \param _v_idx0 index of node a
+         * \param _v_idx1 index of node b
+         * \param _k spring constant */
+        SpringResidualBlock2D(const int _v_idx0, const int _v_idx1, const double _k = 1.) :
+                ResidualBlock(Indices{{2 * _v_idx0, 2 * _v_idx0 + 1, 2 * _v_idx1, 2 * _v_idx1 + 1}}),
+                sqrt_k_(std::sqrt(_k)) {}
+
+        void eval(const LocalVec& _x, Residual& _r, Jacobian* _J) const {
+            _r = sqrt_k_ * (_x.head<2>() - _x.tail<2>());
+
+            if(_J) {
+                _J->setZero();
+                (*_J)(0, 0) = (*_J)(1, 1) = sqrt_k_;
+                (*_J)(0, 2) = (*_J)(1, 3) = -sqrt_k_;
+            }
+        }
+
+    private:
+        double sqrt_k_;
+    };
+
+//=============================================================================
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cmath>
+#include <FunctionBase/ResidualBlock.hh>
+
+//== NAMESPACES ===============================================================
+
+namespace AOPT {
+
+//== CLASS DEFINITION =========================================================
+
+    /* Residual block of a spring with rest length l between the nodes a and b,
+     *      r(x) = sqrt(k) * (||x_a - x_b||^2 - l^2),
+     * same as SpringElement2DWithLengthLeastSquare, with x = [x_a, x_b]. */
+    class SpringWithLengthResidualBlock2D : public ResidualBlock<SpringWithLengthResidualBlock2D, 1, 4> {
+    public:
+        /**
+         * \param _v_idx0 index of node a
+         * \param _v_idx1 index of node b
+         * \param _k spring constant
+         * \param _l rest length */
+        SpringWithLengthResidualBlock2D(const int _v_idx0, const int _v_idx1, const double _k = 1., const double _l = 1.) :
+                ResidualBlock(Indices{{2 * _v_idx0, 2 * _v_idx0 + 1, 2 * _v_idx1, 2 * _v_idx1 + 1}}),
+                sqrt_k_(std::sqrt(_k)), l2_(_l * _l) {}
+
+        void eval(const LocalVec& _x, Residual& _r, Jacobian* _J) const {
+            Eigen::Vector2d d = _x.head<2>() - _x.tail<2>();
+            _r[0] = sqrt_k_ * (d.squaredNorm() - l2_);
+
+            if(_J) {
+                _J->head<2>() = 2. * sqrt_k_ * d.transpose();
+                _J->tail<2>() = -_J->head<2>();
+            }
+        }
+
+    private:
+        double sqrt_k_;
+        double l2_;
+    };
+
+//=============================================================================
+}
@@ -0,0 +1,218 @@
+#ifndef AOPT_ALLOCATION_TRACKER_HH
+#define AOPT_ALLOCATION_TRACKER_HH
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+//== NAMESPACES ===============================================================
+
+namespace AOPT {
+
+    //== CLASS DEFINITION =========================================================
+
+    /* Counts the heap allocations of each thread, e.g. to check that the iterations
+     * of a solver do not allocate once its buffers are set up.
+     *
+     * The counting is done by replacements of the global operator new and delete and,
+     * with glibc, of malloc, calloc, realloc and free, which Eigen uses. They are
+     * defined in the single translation unit of a program that defines
+     * AOPT_ALLOCATION_TRACKER_IMPLEMENTATION before including this file:
+     *
+     *     #define AOPT_ALLOCATION_TRACKER_IMPLEMENTATION
+     *     #include <Utils/AllocationTracker.hh>
+     *
+     * Without it, installed() is false and all the counts stay 0. Elsewhere than with
+     * glibc, only operator new and delete are counted and tracks_malloc() is false, so
+     * that the allocations of Eigen are missed. A scope counts the
+     * allocations of the calling thread between its construction and counts():
+     *
+     *     AllocationTracker::Scope scope;
+     *     solver.solve(...);
+     *     std::cout << scope.counts().allocations << std::endl;
+     *
+     * The Profiler also reports the allocations of each of its scopes when the
+     * tracker is installed. */
+    class AllocationTracker {
+    public:
+        struct Counts {
+            // number of allocations and deallocations, a realloc counts as one of each
+            std::uint64_t allocations = 0;
+            std::uint64_t deallocations = 0;
+            // requested bytes
+            std::uint64_t bytes = 0;
+
+            Counts operator-(const Counts& _c) const {
+                Counts d;
+                d.allocations = allocations - _c.allocations;
+                d.deallocations = deallocations - _c.deallocations;
+                d.bytes = bytes - _c.bytes;
+                return d;
+            }
+
+            Counts& operator+=(const Counts& _c) {
+                allocations += _c.allocations;
+                deallocations += _c.deallocations;
+                bytes += _c.bytes;
+                return *this;
+            }
+        };
+
+        class Scope {
+        public:
+            Scope() : start_(AllocationTracker::counts()) {}
+
+            // counts since the construction
+            Counts counts() const { return AllocationTracker::counts() - start_; }
+
+        private:
+            Counts start_;
+        };
+
+        // counts of the calling thread since it started
+        static Counts counts() { return thread_counts(); }
+
+        // true if the replacements of the allocation functions are part of the program
+        static bool installed() { return installed_flag(); }
+
+        // true if the allocations with malloc and co, e.g. of Eigen, are counted as well
+        static bool tracks_malloc() { return installed_flag() && tracks_malloc_flag(); }
+
+        static void record_allocation(const std::size_t _bytes) noexcept {
+            Counts& c = thread_counts();
+            ++c.allocations;
+            c.bytes += _bytes;
+        }
+
+        static void record_deallocation() noexcept { ++thread_counts().deallocations; }
+
+        static bool& installed_flag() noexcept {
+            static bool installed = false;
+            return installed;
+        }
+
+        static bool& tracks_malloc_flag() noexcept {
+            static bool tracks_malloc = false;
+            return tracks_malloc;
+        }
+
+    private:
+        // trivially initialized, so that it can be used from malloc without a guard
+        static Counts& thread_counts() noexcept {
+            thread_local Counts counts;
+            return counts;
+        }
+    };
+
+//=============================================================================
+}
+
+#endif
+
+
+// not covered by the include guard, so that it also works when the header was already
+// included, e.g. through Utils/Profiler.hh
+#if defined(AOPT_ALLOCATION_TRACKER_IMPLEMENTATION) && !defined(AOPT_ALLOCATION_TRACKER_IMPLEMENTED)
+#define AOPT_ALLOCATION_TRACKER_IMPLEMENTED
+
+#if defined(__GLIBC__)
+extern "C" {
+    void* __libc_malloc(std::size_t);
+    void* __libc_calloc(std::size_t, std::size_t);
+    void* __libc_realloc(void*, std::size_t);
+    void* __libc_memalign(std::size_t, std::size_t);
+    void __libc_free(void*);
+
+    void* malloc(std::size_t _n) noexcept {
+        AOPT::AllocationTracker::record_allocation(_n);
+        return __libc_malloc(_n);
+    }
+
+    void* calloc(std::size_t _n, std::size_t _size) noexcept {
+        AOPT::AllocationTracker::record_allocation(_n * _size);
+        return __libc_calloc(_n, _size);
+    }
+
+    void* realloc(void* _p, std::size_t _n) noexcept {
+        if(_p)
+            AOPT::AllocationTracker::record_deallocation();
+        if(_n)
+            AOPT::AllocationTracker::record_allocation(_n);
+        return __libc_realloc(_p, _n);
+    }
+
+    void* memalign(std::size_t _alignment, std::size_t _n) noexcept {
+        AOPT::AllocationTracker::record_allocation(_n);
+        return __libc_memalign(_alignment, _n);
+    }
+
+    void* aligned_alloc(std::size_t _alignment, std::size_t _n) noexcept {
+        AOPT::AllocationTracker::record_allocation(_n);
+        return __libc_memalign(_alignment, _n);
+    }
+
+    int posix_memalign(void** _p, std::size_t _alignment, std::size_t _n) noexcept {
+        AOPT::AllocationTracker::record_allocation(_n);
+        *_p = __libc_memalign(_alignment, _n);
+        return *_p ? 0 : ENOMEM;
+    }
+
+    void free(void* _p) noexcept {
+        if(_p)
+            AOPT::AllocationTracker::record_deallocation();
+        __libc_free(_p);
+    }
+}
+
+// operator new must not count twice through malloc
+#define AOPT_ALLOCATION_TRACKER_MALLOC __libc_malloc
+#define AOPT_ALLOCATION_TRACKER_FREE __libc_free
+#define AOPT_ALLOCATION_TRACKER_TRACKS_MALLOC true
+#else
+#define AOPT_ALLOCATION_TRACKER_MALLOC std::malloc
+#define AOPT_ALLOCATION_TRACKER_FREE std::free
+#define AOPT_ALLOCATION_TRACKER_TRACKS_MALLOC false
+#endif
+
+namespace AOPT {
+    namespace internal {
+        inline void* tracked_new(std::size_t _n) {
+            AllocationTracker::record_allocation(_n);
+            if(void* p = AOPT_ALLOCATION_TRACKER_MALLOC(_n ? _n : 1))
+                return p;
+            throw std::bad_alloc();
+        }
+
+        inline void tracked_delete(void* _p) noexcept {
+            if(_p)
+                AllocationTracker::record_deallocation();
+            AOPT_ALLOCATION_TRACKER_FREE(_p);
+        }
+
+        static const bool allocation_tracker_installed = (AllocationTracker::installed_flag() = true);
+        static const bool allocation_tracker_tracks_malloc =
+                (AllocationTracker::tracks_malloc_flag() = AOPT_ALLOCATION_TRACKER_TRACKS_MALLOC);
+    }
+}
+
+void* operator new(std::size_t _n) { return AOPT::internal::tracked_new(_n); }
+void* operator new[](std::size_t _n) { return AOPT::internal::tracked_new(_n); }
+
+void* operator new(std::size_t _n, const std::nothrow_t&) noexcept {
+    try { return AOPT::internal::tracked_new(_n); } catch(...) { return nullptr; }
+}
+
+void* operator new[](std::size_t _n, const std::nothrow_t&) noexcept {
+    try { return AOPT::internal::tracked_new(_n); } catch(...) { return nullptr; }
+}
+
+void operator delete(void* _p) noexcept { AOPT::internal::tracked_delete(_p); }
+void operator delete[](void* _p) noexcept { AOPT::internal::tracked_delete(_p); }
+void operator delete(void* _p, std::size_t) noexcept { AOPT::internal::tracked_delete(_p); }
+void operator delete[](void* _p, std::size_t) noexcept { AOPT::internal::tracked_delete(_p); }
+void operator delete(void* _p, const std::nothrow_t&) noexcept { AOPT::internal::tracked_delete(_p); }
+void operator delete[](void* _p, const std::nothrow_t&) noexcept { AOPT::internal::tracked_delete(_p); }
+
+#endif
@@ -0,0 +1,307 @@
+#pragma once
+
+#include <cmath>
+#include <array>
+#include <utility>
+#include <Eigen/Dense>
+
+//== NAMESPACES ===============================================================
+
+namespace AOPT {
+
+    /* Forward mode automatic differentiation with respect to N variables.
+     *
+     * Dual<N> carries a value and its gradient, HyperDual<N> additionally carries the
+     * Hessian, i.e. a second order truncated Taylor expansion, of which only the upper
+     * triangle is stored. Every operation applies the chain rule, e.g. for a unary
+     * function f
+     *      f(a).g = f'(a.v) a.g
+     *      f(a).H = f'(a.v) a.H + f''(a.v) a.g a.g^T
+     * All sizes are known at compile time and the derivatives are plain arrays with
+     * loops of constant length, so for the small N of the element functions the
+     * compiler unrolls everything, keeps it in registers and folds the zeros and ones
+     * of the seeded variables, which gives code close to the hand derived one.
+     * (With Eigen vectors as members it does not, the conversion is only done by
+     * gradient() and hessian().)
+     *
+     * A function is written once as a template over its scalar type, e.g.
+     *      template <class S> S f(const S& _x, const S& _y) { using std::sqrt; return sqrt(_x*_x + _y); }
+     * and evaluated with the variables seeded by Dual<N>::variable(value, i), or all
+     * at once by variables<Dual<N>, N>(x).
+     * The math functions below are found by argument dependent lookup, the
+     * using declaration selects the std version for double. */
+
+    // inlines all calls in a function, used to evaluate a whole templated energy as one
+    // function, else the compiler gives up on inlining it for the larger scalar types
+#if defined(__GNUC__) || defined(__clang__)
+#define AOPT_AUTODIFF_FLATTEN __attribute__((flatten))
+#else
+#define AOPT_AUTODIFF_FLATTEN
+#endif
+
+    //== CLASS DEFINITION =========================================================
+
+    template <int N>
+    struct Dual {
+        using Grad = Eigen::Matrix<double, N, 1>;
+
+        // a constant, the conversion from double is implicit on purpose
+        Dual(const double _v = 0.) : v(_v) {
+            for(int i = 0; i < N; ++i)
+                g[i] = 0.;
+        }
+
+        /** the _i-th variable, with value _v */
+        static Dual variable(const double _v, const int _i) {
+            Dual d(_v);
+            d.g[_i] = 1.;
+            return d;
+        }
+
+        Grad gradient() const { return Eigen::Map<const Grad>(g); }
+
+        Dual& operator+=(const Dual& _b) { return *this = *this + _b; }
+        Dual& operator-=(const Dual& _b) { return *this = *this - _b; }
+        Dual& operator*=(const Dual& _b) { return *this = *this * _b; }
+        Dual& operator/=(const Dual& _b) { return *this = *this / _b; }
+        Dual& operator*=(const double _s) { return *this = *this * _s; }
+
+        // value
+        double v;
+        // gradient
+        double g[N];
+    };
+
+
+
+    template <int N>
+    struct HyperDual {
+        // number of entries of the upper triangle of the hessian
+        enum { N_HESSIAN = N * (N + 1) / 2 };
+
+        using Grad = Eigen::Matrix<double, N, 1>;
+        using Hess = Eigen::Matrix<double, N, N>;
+
+        // a constant, the conversion from double is implicit on purpose
+        HyperDual(const double _v = 0.) : v(_v) {
+            for(int i = 0; i < N; ++i)
+                g[i] = 0.;
+            for(int k = 0; k < N_HESSIAN; ++k)
+                h[k] = 0.;
+        }
+
+        /** the _i-th variable, with value _v */
+        static HyperDual variable(const double _v, const int _i) {
+            HyperDual d(_v);
+            d.g[_i] = 1.;
+            return d;
+        }
+
+        Grad gradient() const { return Eigen::Map<const Grad>(g); }
+
+        /** the full (symmetric) hessian */
+        Hess hessian() const {
+            Hess H;
+            for(int i = 0, k = 0; i < N; ++i)
+                for(int j = i; j < N; ++j, ++k)
+                    H(i, j) = H(j, i) = h[k];
+            return H;
+        }
+
+        HyperDual& operator+=(const HyperDual& _b) { return *this = *this + _b; }
+        HyperDual& operator-=(const HyperDual& _b) { return *this = *this - _b; }
+        HyperDual& operator*=(const HyperDual& _b) { return *this = *this * _b; }
+        HyperDual& operator/=(const HyperDual& _b) { return *this = *this / _b; }
+        HyperDual& operator*=(const double _s) { return *this = *this * _s; }
+
+        // value
+        double v;
+        // gradient
+        double g[N];
+        // upper triangle of the hessian, row by row, see hessian()
+        double h[N_HESSIAN];
+    };
+
+
+    //== HELPERS ==================================================================
+
+    /** value of a scalar, for branches in templated functions */
+    inline double value(const double _a) { return _a; }
+
+    template <int N>
+    inline double value(const Dual<N>& _a) { return _a.v; }
+
+    template <int N>
+    inline double value(const HyperDual<N>& _a) { return _a.v; }
+
+    /* The arithmetic is written as linear combinations and products into a new
+     * result, never in place, so that the compiler does not have to care about
+     * aliasing of the arguments. */
+
+    /** _sa _a + _sb _b */
+    template <int N>
+    inline Dual<N> combine(const double _sa, const Dual<N>& _a, const double _sb, const Dual<N>& _b) {
+        Dual<N> r;
+        r.v = _sa * _a.v + _sb * _b.v;
+        for(int i = 0; i < N; ++i)
+            r.g[i] = _sa * _a.g[i] + _sb * _b.g[i];
+        return r;
+    }
+
+    template <int N>
+    inline HyperDual<N> combine(const double _sa, const HyperDual<N>& _a, const double _sb, const HyperDual<N>& _b) {
+        HyperDual<N> r;
+        r.v = _sa * _a.v + _sb * _b.v;
+        for(int i = 0; i < N; ++i)
+            r.g[i] = _sa * _a.g[i] + _sb * _b.g[i];
+        for(int k = 0; k < HyperDual<N>::N_HESSIAN; ++k)
+            r.h[k] = _sa * _a.h[k] + _sb * _b.h[k];
+        return r;
+    }
+
+    /** _s _a + _c */
+    template <int N>
+    inline Dual<N> affine(const double _s, const Dual<N>& _a, const double _c) {
+        Dual<N> r;
+        r.v = _s * _a.v + _c;
+        for(int i = 0; i < N; ++i)
+            r.g[i] = _s * _a.g[i];
+        return r;
+    }
+
+    template <int N>
+    inline HyperDual<N> affine(const double _s, const HyperDual<N>& _a, const double _c) {
+        HyperDual<N> r;
+        r.v = _s * _a.v + _c;
+        for(int i = 0; i < N; ++i)
+            r.g[i] = _s * _a.g[i];
+        for(int k = 0; k < HyperDual<N>::N_HESSIAN; ++k)
+            r.h[k] = _s * _a.h[k];
+        return r;
+    }
+
+    template <int N>
+    inline Dual<N> product(const Dual<N>& _a, const Dual<N>& _b) {
+        Dual<N> r;
+        r.v = _a.v * _b.v;
+        for(int i = 0; i < N; ++i)
+            r.g[i] = _b.v * _a.g[i] + _a.v * _b.g[i];
+        return r;
+    }
+
+    template <int N>
+    inline HyperDual<N> product(const HyperDual<N>& _a, const HyperDual<N>& _b) {
+        HyperDual<N> r;
+        r.v = _a.v * _b.v;
+        for(int i = 0; i < N; ++i)
+            r.g[i] = _b.v * _a.g[i] + _a.v * _b.g[i];
+        // the sum of the two outer products is symmetric, only its upper triangle is computed
+        for(int i = 0, k = 0; i < N; ++i)
+            for(int j = i; j < N; ++j, ++k)
+                r.h[k] = _b.v * _a.h[k] + _a.v * _b.h[k] + _a.g[i] * _b.g[j] + _b.g[i] * _a.g[j];
+        return r;
+    }
+
+    template <class S, class V, int... I>
+    inline std::array<S, sizeof...(I)> variables(const V& _x, std::integer_sequence<int, I...>) {
+        return {{S::variable(_x[I], I)...}};
+    }
+
+    /** the N variables of type S with values _x[0], ..., _x[N-1].
+     * The array is initialized in place and the indices are compile time constants,
+     * which lets the compiler keep the seeds in registers. */
+    template <class S, int N, class V>
+    inline std::array<S, N> variables(const V& _x) {
+        return variables<S>(_x, std::make_integer_sequence<int, N>());
+    }
+
+    /** applies f to _a given f(a), f'(a) and f''(a) */
+    template <int N>
+    inline Dual<N> chain(const Dual<N>& _a, const double _f, const double _df, const double) {
+        Dual<N> r;
+        r.v = _f;
+        for(int i = 0; i < N; ++i)
+            r.g[i] = _df * _a.g[i];
+        return r;
+    }
+
+    template <int N>
+    inline HyperDual<N> chain(const HyperDual<N>& _a, const double _f, const double _df, const double _ddf) {
+        HyperDual<N> r;
+        r.v = _f;
+        for(int i = 0; i < N; ++i)
+            r.g[i] = _df * _a.g[i];
+        for(int i = 0, k = 0; i < N; ++i)
+            for(int j = i; j < N; ++j, ++k)
+                r.h[k] = _df * _a.h[k] + _ddf * _a.g[i] * _a.g[j];
+        return r;
+    }
+
+    /** 1 / _a */
+    template <class S>
+    inline S inverse(const S& _a) {
+        const double inv = 1. / _a.v;
+        return chain(_a, inv, -inv * inv, 2. * inv * inv * inv);
+    }
+
+
+    //== OPERATORS ================================================================
+
+    // all operators are written once for both types, with a constant on either side
+#define AOPT_AUTODIFF_OPERATORS(TYPE)                                                                                 \
+    template <int N> inline TYPE<N> operator+(const TYPE<N>& _a) { return _a; }                                      \
+    template <int N> inline TYPE<N> operator-(const TYPE<N>& _a) { return affine(-1., _a, 0.); }                     \
+    template <int N> inline TYPE<N> operator+(const TYPE<N>& _a, const TYPE<N>& _b) { return combine(1., _a, 1., _b); }  \
+    template <int N> inline TYPE<N> operator-(const TYPE<N>& _a, const TYPE<N>& _b) { return combine(1., _a, -1., _b); } \
+    template <int N> inline TYPE<N> operator*(const TYPE<N>& _a, const TYPE<N>& _b) { return product(_a, _b); }      \
+    template <int N> inline TYPE<N> operator/(const TYPE<N>& _a, const TYPE<N>& _b) { return product(_a, inverse(_b)); } \
+    template <int N> inline TYPE<N> operator+(const TYPE<N>& _a, const double _b) { return affine(1., _a, _b); }     \
+    template <int N> inline TYPE<N> operator+(const double _a, const TYPE<N>& _b) { return affine(1., _b, _a); }     \
+    template <int N> inline TYPE<N> operator-(const TYPE<N>& _a, const double _b) { return affine(1., _a, -_b); }    \
+    template <int N> inline TYPE<N> operator-(const double _a, const TYPE<N>& _b) { return affine(-1., _b, _a); }    \
+    template <int N> inline TYPE<N> operator*(const TYPE<N>& _a, const double _b) { return affine(_b, _a, 0.); }     \
+    template <int N> inline TYPE<N> operator*(const double _a, const TYPE<N>& _b) { return affine(_a, _b, 0.); }     \
+    template <int N> inline TYPE<N> operator/(const TYPE<N>& _a, const double _b) { return affine(1. / _b, _a, 0.); } \
+    template <int N> inline TYPE<N> operator/(const double _a, const TYPE<N>& _b) { return affine(_a, inverse(_b), 0.); } \
+    template <int N> inline bool operator<(const TYPE<N>& _a, const TYPE<N>& _b) { return _a.v < _b.v; }             \
+    template <int N> inline bool operator>(const TYPE<N>& _a, const TYPE<N>& _b) { return _a.v > _b.v; }             \
+    template <int N> inline bool operator<(const TYPE<N>& _a, const double _b) { return _a.v < _b; }                 \
+    template <int N> inline bool operator>(const TYPE<N>& _a, const double _b) { return _a.v > _b; }                 \
+                                                                                                                     \
+    template <int N> inline TYPE<N> sqrt(const TYPE<N>& _a) {                                                        \
+        const double s = std::sqrt(_a.v);                                                                            \
+        return chain(_a, s, 0.5 / s, -0.25 / (s * _a.v));                                                            \
+    }                                                                                                                \
+    template <int N> inline TYPE<N> pow(const TYPE<N>& _a, const double _p) {                                        \
+        if(_p == 2.)                                                                                                 \
+            return chain(_a, _a.v * _a.v, 2. * _a.v, 2.);                                                            \
+        /* separate powers, so that e.g. pow(0, 1.5) stays finite, and zero factors */                               \
+        /* of the derivatives, so that e.g. the second derivative of pow(0, 1.) is 0 */                              \
+        const double df = _p == 0. ? 0. : _p * std::pow(_a.v, _p - 1.);                                              \
+        const double ddf = _p == 0. || _p == 1. ? 0. : _p * (_p - 1.) * std::pow(_a.v, _p - 2.);                     \
+        return chain(_a, std::pow(_a.v, _p), df, ddf);                                                               \
+    }                                                                                                                \
+    template <int N> inline TYPE<N> exp(const TYPE<N>& _a) {                                                         \
+        const double e = std::exp(_a.v);                                                                             \
+        return chain(_a, e, e, e);                                                                                   \
+    }                                                                                                                \
+    template <int N> inline TYPE<N> log(const TYPE<N>& _a) {                                                         \
+        return chain(_a, std::log(_a.v), 1. / _a.v, -1. / (_a.v * _a.v));                                            \
+    }                                                                                                                \
+    template <int N> inline TYPE<N> sin(const TYPE<N>& _a) {                                                         \
+        const double s = std::sin(_a.v);                                                                             \
+        return chain(_a, s, std::cos(_a.v), -s);                                                                     \
+    }                                                                                                                \
+    template <int N> inline TYPE<N> cos(const TYPE<N>& _a) {                                                         \
+        const double c = std::cos(_a.v);                                                                             \
+        return chain(_a, c, -std::sin(_a.v), -c);                                                                    \
+    }                                                                                                                \
+    template <int N> inline TYPE<N> abs(const TYPE<N>& _a) { return _a.v < 0. ? -_a : _a; }
+
+    AOPT_AUTODIFF_OPERATORS(Dual)
+    AOPT_AUTODIFF_OPERATORS(HyperDual)
+
+#undef AOPT_AUTODIFF_OPERATORS
+
+//=============================================================================
+}
@@ -0,0 +1,360 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <Utils/ParallelFor.hh>
+
+//== NAMESPACES ===============================================================
+
+namespace AOPT {
+
+    //== CLASS DEFINITION =========================================================
+
+    /* A small benchmark harness in the spirit of Google Benchmark, without the
+     * dependency.
+     *
+     * A benchmark is a function of a State, which repeats the timed part in a loop
+     * over state.keep_running(). It is registered with the sizes it should be run
+     * for, e.g. the number of nodes of a mass spring system:
+     *
+     *     Benchmark bench;
+     *     bench.add("assembly/eval_hessian", [](Benchmark::State& _state) {
+     *         // setup, not timed
+     *         while(_state.keep_running())
+     *             problem.eval_hessian(x, H);
+     *         _state.set_counter("nnz", H.nonZeros());
+     *     }, {100, 10000, 1000000});
+     *     return bench.run(_argc, _argv);
+     *
+     * Each (benchmark, size) runs until it took --min-time seconds and at least one
+     * iteration. The mean, min and median time of an iteration are printed as a table
+     * and, with --json=file, written as
+     *     {"context": {...}, "benchmarks": [{"name": "assembly/eval_hessian/size:100",
+     *      "group": ..., "size": ..., "iterations": ..., "real_time": ..., "min_time": ...,
+     *      "median_time": ..., "time_unit": "ns", "counters": {...}}, ...]}
+     * which Benchmarks/compare.py compares against a baseline. */
+    class Benchmark {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        // the loop of a benchmark and what it reports
+        class State {
+        public:
+            State(const long _size, const double _min_time, const std::int64_t _max_iterations)
+                    : size_(_size), min_time_ns_(1e9 * _min_time), max_iterations_(_max_iterations) {}
+
+            // the size the benchmark runs for, 0 if it has no sizes
+            long size() const { return size_; }
+
+            /** true as long as the timed part should be repeated, the time between two
+             * calls is one iteration */
+            bool keep_running() {
+                const auto now = Clock::now();
+                if(running_) {
+                    const double t = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(now - start_).count() - paused_ns_;
+                    times_.push_back(t);
+                    elapsed_ns_ += t;
+                }
+                if(!times_.empty() && ((std::int64_t)times_.size() >= max_iterations_ || elapsed_ns_ >= min_time_ns_)) {
+                    running_ = false;
+                    return false;
+                }
+                running_ = true;
+                paused_ns_ = 0.;
+                start_ = Clock::now();
+                return true;
+            }
+
+            // excludes the time until resume_timing() from the iteration, e.g. a reset
+            void pause_timing() { pause_start_ = Clock::now(); }
+
+            void resume_timing() {
+                paused_ns_ += (double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - pause_start_).count();
+            }
+
+            // reports a value along with the times, e.g. an objective or a number of nonzeros
+            void set_counter(const std::string& _name, const double _value) {
+                for(auto& c : counters_)
+                    if(c.first == _name) {
+                        c.second = _value;
+                        return;
+                    }
+                counters_.emplace_back(_name, _value);
+            }
+
+            // marks the benchmark as not run for this size, e.g. when it would not fit in memory
+            void skip(const std::string& _reason) { skip_reason_ = _reason; }
+
+        private:
+            friend class Benchmark;
+
+            long size_;
+            double min_time_ns_;
+            std::int64_t max_iterations_;
+
+            bool running_ = false;
+            Clock::time_point start_, pause_start_;
+            double paused_ns_ = 0.;
+            double elapsed_ns_ = 0.;
+            std::vector<double> times_;
+            std::vector<std::pair<std::string, double>> counters_;
+            std::string skip_reason_;
+        };
+
+        using Function = std::function<void(State&)>;
+
+        struct Result {
+            std::string name;
+            std::string group;
+            long size = 0;
+            std::int64_t iterations = 0;
+            // per iteration, in ns
+            double mean = 0., min = 0., median = 0.;
+            std::vector<std::pair<std::string, double>> counters;
+        };
+
+        struct Options {
+            // only the benchmarks whose name contains one of these strings, all if empty
+            std::vector<std::string> filters;
+            // minimum time in seconds and maximum number of iterations of a benchmark
+            double min_time = 0.2;
+            std::int64_t max_iterations = 1000000000;
+            // the sizes above this one are skipped
+            long max_size = 10000;
+            // output of the solvers and problems, hidden by default
+            bool verbose = false;
+            bool list = false;
+            std::string json_file;
+        };
+
+        /** registers a benchmark
+         * \param _sizes the sizes it runs for, nothing means a single run of size 0 */
+        void add(const std::string& _group, Function _f, const std::vector<long>& _sizes = {}) {
+            benchmarks_.push_back(Entry{_group, std::move(_f), _sizes.empty() ? std::vector<long>{0} : _sizes});
+        }
+
+        /** reads the options of the command line:
+         *   --filter=a,b      only the benchmarks whose name contains a or b
+         *   --min-time=s      minimum time of each benchmark in seconds (default 0.2)
+         *   --max-iterations=n
+         *   --max-size=n      skip the larger sizes (default 10000)
+         *   --json=file       also write the results to file
+         *   --verbose         keep the output of the solvers
+         *   --list            only print the names
+         * \return 0 if all went well, -1 if not */
+        static int parse_options(const int _argc, const char* const* _argv, Options& _options) {
+            for(int i = 1; i < _argc; ++i) {
+                const std::string arg(_argv[i]);
+                std::string value;
+                if(has_prefix(arg, "--filter=", value)) {
+                    std::size_t begin = 0;
+                    while(begin <= value.size()) {
+                        std::size_t end = value.find(',', begin);
+                        if(end == std::string::npos)
+                            end = value.size();
+                        if(end > begin)
+                            _options.filters.push_back(value.substr(begin, end - begin));
+                        begin = end + 1;
+                    }
+                } else if(has_prefix(arg, "--min-time=", value))
+                    _options.min_time = std::atof(value.c_str());
+                else if(has_prefix(arg, "--max-iterations=", value))
+                    _options.max_iterations = std::max(1ll, std::atoll(value.c_str()));
+                else if(has_prefix(arg, "--max-size=", value))
+                    _options.max_size = std::atol(value.c_str());
+                else if(has_prefix(arg, "--json=", value))
+                    _options.json_file = value;
+                else if(arg == "--verbose")
+                    _options.verbose = true;
+                else if(arg == "--list")
+                    _options.list = true;
+                else {
+                    std::cout << "Error: unknown option " << arg << std::endl;
+                    return -1;
+                }
+            }
+            return 0;
+        }
+
+        /** parses the command line and runs the benchmarks
+         * \return 0 if all went well, -1 if not */
+        int run(const int _argc, const char* const* _argv) {
+            Options options;
+            if(parse_options(_argc, _argv, options) != 0) {
+                std::cout << "Usage: " << _argv[0] << " [--filter=a,b] [--min-time=s] [--max-iterations=n] "
+                          << "[--max-size=n] [--json=file] [--verbose] [--list]" << std::endl;
+                return -1;
+            }
+            return run(options);
+        }
+
+        int run(const Options& _options) {
+            results_.clear();
+            print_header(std::cout);
+            for(const Entry& b : benchmarks_)
+                for(const long size : b.sizes) {
+                    const std::string name = b.sizes.size() == 1 && size == 0 ? b.group : b.group + "/size:" + std::to_string(size);
+                    if(size > _options.max_size || !selected(name, _options.filters))
+                        continue;
+                    if(_options.list) {
+                        std::cout << name << std::endl;
+                        continue;
+                    }
+
+                    State state(size, _options.min_time, _options.max_iterations);
+                    {
+                        // the solvers print every iteration
+                        std::streambuf* cout_buffer = std::cout.rdbuf();
+                        std::streambuf* cerr_buffer = std::cerr.rdbuf();
+                        if(!_options.verbose) {
+                            std::cout.rdbuf(nullptr);
+                            std::cerr.rdbuf(nullptr);
+                        }
+                        b.function(state);
+                        std::cout.rdbuf(cout_buffer);
+                        std::cerr.rdbuf(cerr_buffer);
+                        std::cout.clear();
+                        std::cerr.clear();
+                    }
+
+                    if(!state.skip_reason_.empty()) {
+                        std::cout << std::left << std::setw(name_width) << name << std::right
+                                  << " skipped: " << state.skip_reason_ << std::endl;
+                        continue;
+                    }
+                    if(state.times_.empty()) {
+                        std::cout << "Error: " << name << " did not call keep_running()" << std::endl;
+                        return -1;
+                    }
+
+                    results_.push_back(summarize(name, b.group, size, state));
+                    print_result(std::cout, results_.back());
+                }
+
+            if(!_options.json_file.empty() && !_options.list) {
+                std::ofstream file(_options.json_file);
+                if(!file) {
+                    std::cout << "Error: cannot open " << _options.json_file << std::endl;
+                    return -1;
+                }
+                write_json(file, _options);
+                if(!file) {
+                    std::cout << "Error: writing " << _options.json_file << " failed" << std::endl;
+                    return -1;
+                }
+                std::cout << "Results written to " << _options.json_file << std::endl;
+            }
+            return 0;
+        }
+
+        const std::vector<Result>& results() const { return results_; }
+
+        void write_json(std::ostream& _os, const Options& _options) const {
+            char date[32];
+            const std::time_t now = std::time(nullptr);
+            std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+            _os << std::setprecision(10) << "{\n  \"context\": {\"date\": \"" << date << "\", \"n_threads\": "
+                << default_n_threads() << ", \"min_time\": " << _options.min_time
+                << ", \"max_size\": " << _options.max_size << "},\n  \"benchmarks\": [";
+            for(std::size_t i = 0; i < results_.size(); ++i) {
+                const Result& r = results_[i];
+                _os << (i == 0 ? "\n" : ",\n") << "    {\"name\": \"" << r.name << "\", \"group\": \"" << r.group
+                    << "\", \"size\": " << r.size << ", \"iterations\": " << r.iterations
+                    << ", \"real_time\": " << r.mean << ", \"min_time\": " << r.min
+                    << ", \"median_time\": " << r.median << ", \"time_unit\": \"ns\", \"counters\": {";
+                for(std::size_t c = 0; c < r.counters.size(); ++c)
+                    _os << (c == 0 ? "\"" : ", \"") << r.counters[c].first << "\": " << r.counters[c].second;
+                _os << "}}";
+            }
+            _os << "\n  ]\n}\n";
+        }
+
+    private:
+        struct Entry {
+            std::string group;
+            Function function;
+            std::vector<long> sizes;
+        };
+
+        enum { name_width = 52 };
+
+        static bool has_prefix(const std::string& _arg, const std::string& _prefix, std::string& _value) {
+            if(_arg.compare(0, _prefix.size(), _prefix) != 0)
+                return false;
+            _value = _arg.substr(_prefix.size());
+            return true;
+        }
+
+        static bool selected(const std::string& _name, const std::vector<std::string>& _filters) {
+            if(_filters.empty())
+                return true;
+            for(const auto& f : _filters)
+                if(_name.find(f) != std::string::npos)
+                    return true;
+            return false;
+        }
+
+        static Result summarize(const std::string& _name, const std::string& _group, const long _size, const State& _state) {
+            Result r;
+            r.name = _name;
+            r.group = _group;
+            r.size = _size;
+            r.iterations = (std::int64_t)_state.times_.size();
+            std::vector<double> times = _state.times_;
+            std::sort(times.begin(), times.end());
+            double sum = 0.;
+            for(double t : times)
+                sum += t;
+            r.mean = sum / times.size();
+            r.min = times.front();
+            r.median = times.size() % 2 ? times[times.size() / 2] : 0.5 * (times[times.size() / 2 - 1] + times[times.size() / 2]);
+            r.counters = _state.counters_;
+            return r;
+        }
+
+        static void print_header(std::ostream& _os) {
+            _os << std::left << std::setw(name_width) << "benchmark" << std::right << std::setw(12) << "iterations"
+                << std::setw(14) << "mean" << std::setw(14) << "min" << std::setw(14) << "median" << "  counters" << std::endl;
+        }
+
+        static std::string format_time(const double _ns) {
+            std::ostringstream ss;
+            ss << std::fixed << std::setprecision(2);
+            if(_ns < 1e3)
+                ss << _ns << " ns";
+            else if(_ns < 1e6)
+                ss << 1e-3 * _ns << " us";
+            else if(_ns < 1e9)
+                ss << 1e-6 * _ns << " ms";
+            else
+                ss << 1e-9 * _ns << " s";
+            return ss.str();
+        }
+
+        static void print_result(std::ostream& _os, const Result& _r) {
+            _os << std::left << std::setw(name_width) << _r.name << std::right << std::setw(12) << _r.iterations
+                << std::setw(14) << format_time(_r.mean) << std::setw(14) << format_time(_r.min)
+                << std::setw(14) << format_time(_r.median) << " ";
+            for(const auto& c : _r.counters)
+                _os << " " << c.first << "=" << c.second;
+            _os << std::endl;
+        }
+
+        std::vector<Entry> benchmarks_;
+        std::vector<Result> results_;
+    };
+
+//=============================================================================
+}
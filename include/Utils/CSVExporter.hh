@@ -3,6 +3,7 @@
 #include <iostream>
 #include <fstream>
 #include <Eigen/Dense>
+#include <Utils/FieldExporter.hh>
 
 //== NAMESPACES ===============================================================
 
@@ -21,23 +22,14 @@ namespace AOPT {
         ~CSVExporter() {}
 
     public:
+        /** writes _mt(i, j) = f(_x[i], _y[j]) to _filename, see FieldExporter for the
+         * format. Use FieldExporter::export_function2d() directly to avoid sampling
+         * the whole field first. */
         void export_function2d(const Mat& _mt, const Vec& _x, const Vec& _y, const std::string& _filename) {
-            std::ofstream f_write(_filename);
-            //write x
-            for(size_t i=0 ; i<_x.size(); ++i)
-                f_write<<","<<_x[i];
-
-            f_write << std::endl;
-
-            for(size_t j = 0 ; j < _y.size(); ++j) {
-                f_write<<_y[j];
-                for (int i = 0; i < _x.size(); ++i) {
-                    f_write<<","<<_mt(i,j);
-                }
-                f_write << std::endl;
-            }
-
-            f_write.close();
+            FieldExporter exporter;
+            exporter.export_rows([&](const int _j, const int /*_thread*/, Vec& _f) {
+                _f = _mt.col(_j);
+            }, _x, _y, _filename, FieldExporter::CSV);
         }
     };
 
@@ -5,7 +5,11 @@
 #include <limits>
 #include <cfloat>
 #include <cmath>
+#include <cstdint>
+#include <vector>
 #include "RandomNumberGenerator.hh"
+#include "ParallelFor.hh"
+#include "SparseFiniteDifferences.hh"
 
 
 //== NAMESPACES ===============================================================
@@ -24,7 +28,8 @@ namespace AOPT {
 
         struct Config {
             Config() : x_min(-1.0), x_max(1.0), n_iters(1), dx(1e-5), eps(1e-3),
-                       relativeEps(std::numeric_limits<double>::quiet_NaN()) {}
+                       relativeEps(std::numeric_limits<double>::quiet_NaN()),
+                       n_probes(16), n_threads(0), seed(42) {}
 
             double x_min;
             double x_max;
@@ -32,6 +37,23 @@ namespace AOPT {
             double dx;
             double eps;
             double relativeEps;
+
+            // used by the sparse checks only
+            int n_probes;  ///< number of random directions per iteration
+            int n_threads; ///< 0 uses all hardware threads
+            unsigned int seed;
+        };
+
+        /** result of the sparse checks, the relative errors are the ones compared
+         * with the tolerance (relativeEps if set, eps otherwise) */
+        struct Report {
+            int n_checked = 0;
+            int n_errors = 0;
+            double max_relative_error = 0;
+            int worst_row = -1; ///< probe index, or row of the worst hessian nonzero
+            int worst_col = -1; ///< column of the worst hessian nonzero
+
+            bool ok() const { return n_errors == 0; }
         };
 
         template<class ProblemInterface>
@@ -151,6 +173,120 @@ namespace AOPT {
             return (n_errors == 0);
         }
 
+        /** Sparse checks, for problems too large for check_d1/check_d2, which
+         * need O(n) and O(n^2) function evaluations.
+         * The gradient is checked by directional derivatives along n_probes random
+         * directions, the hessian by hessian-vector products along random directions
+         * (which also catches entries missing from the pattern) and entry by entry on
+         * its nonzero pattern (see check_d2_pattern).
+         * The probes run in n_threads threads, each one with its own random stream, if
+         * the problem is_thread_safe(), and in one thread otherwise. */
+        template<class ProblemInterface>
+        bool check_all_sparse(ProblemInterface& _np) {
+            bool d1_ok = check_d1_directional(_np).ok();
+            bool hv_ok = check_d2_directional(_np).ok();
+            bool d2_ok = check_d2_pattern(_np).ok();
+
+            return d1_ok && hv_ok && d2_ok;
+        }
+
+        /** compares g^T v with (f(x + dx v) - f(x - dx v)) / 2dx for random unit vectors v,
+         * relative to max(||g||, 1) */
+        template<class ProblemInterface>
+        Report check_d1_directional(ProblemInterface& _np) {
+            const int n = _np.n_unknowns();
+            Vec x(n), g(n);
+            Report report;
+
+            for(int i = 0; i < conf_.n_iters; ++i) {
+                get_random_x(x, conf_.x_min, conf_.x_max);
+                _np.eval_gradient(x, g);
+                const double scale = std::max(g.norm(), 1.0);
+
+                std::vector<double> errors(conf_.n_probes);
+                for_each_probe(_np, [&](ProblemInterface& _p, const int _k, const Vec& v) {
+                    double fd = (_p.eval_f(x + conf_.dx * v) - _p.eval_f(x - conf_.dx * v)) / (2.0 * conf_.dx);
+                    errors[_k] = std::abs(fd - g.dot(v)) / scale;
+                });
+
+                for(int k = 0; k < conf_.n_probes; ++k)
+                    add_error(report, errors[k], k, -1);
+            }
+
+            print_report("Directional Gradient", report);
+            return report;
+        }
+
+        /** compares H v with (g(x + dx v) - g(x - dx v)) / 2dx for random unit vectors v,
+         * relative to max(||Hv||, 1) */
+        template<class ProblemInterface>
+        Report check_d2_directional(ProblemInterface& _np) {
+            const int n = _np.n_unknowns();
+            Vec x(n);
+            SMat H(n, n);
+            Report report;
+
+            for(int i = 0; i < conf_.n_iters; ++i) {
+                get_random_x(x, conf_.x_min, conf_.x_max);
+                _np.eval_hessian(x, H);
+
+                std::vector<double> errors(conf_.n_probes);
+                for_each_probe(_np, [&](ProblemInterface& _p, const int _k, const Vec& v) {
+                    Vec gp(n), gm(n);
+                    _p.eval_gradient(x + conf_.dx * v, gp);
+                    _p.eval_gradient(x - conf_.dx * v, gm);
+                    Vec hv = H * v;
+                    errors[_k] = ((gp - gm) / (2.0 * conf_.dx) - hv).norm() / std::max(hv.norm(), 1.0);
+                });
+
+                for(int k = 0; k < conf_.n_probes; ++k)
+                    add_error(report, errors[k], k, -1);
+            }
+
+            print_report("Hessian-Vector", report);
+            return report;
+        }
+
+        /** compares every nonzero h_ij of the hessian with its finite difference
+         * approximation, computed from 2 * (number of colors) gradients on the pattern
+         * of H (see SparseHessianFD), relative to max(|h_ij|, sqrt(|h_ii h_jj|), 1),
+         * i.e. to the scale of the entry's row and column, as the finite differences
+         * of a column with large entries cannot resolve tiny ones.
+         * Entries outside of the pattern are not seen, see check_d2_directional.
+         * \param _errors if not null, gets the relative error of every nonzero */
+        template<class ProblemInterface>
+        Report check_d2_pattern(ProblemInterface& _np, SMat* _errors = nullptr) {
+            const int n = _np.n_unknowns();
+            Vec x(n);
+            SMat H(n, n), H_fd;
+            Report report;
+
+            for(int i = 0; i < conf_.n_iters; ++i) {
+                get_random_x(x, conf_.x_min, conf_.x_max);
+                _np.eval_hessian(x, H);
+
+                SparseHessianFD fd(H);
+                fd.eval([&](const Vec& _x, Vec& _g) { _np.eval_gradient(_x, _g); }, x, H_fd);
+
+                // H_fd has the (symmetrized) pattern of H, H may be missing some of its entries
+                Vec diag = H.diagonal();
+                if(_errors)
+                    *_errors = H_fd;
+                for(int j = 0; j < n; ++j)
+                    for(SMat::InnerIterator it(H_fd, j); it; ++it) {
+                        double h = H.coeff(it.row(), j);
+                        double scale = std::max({std::abs(h), std::sqrt(std::abs(diag[it.row()] * diag[j])), 1.0});
+                        double e = std::abs(it.value() - h) / scale;
+                        if(_errors)
+                            _errors->coeffRef(it.row(), j) = e;
+                        add_error(report, e, it.row(), j);
+                    }
+            }
+
+            print_report("Sparse Hessian", report);
+            return report;
+        }
+
         Config& config() { return conf_; }
 
     protected:
@@ -163,9 +299,53 @@ namespace AOPT {
                 _x[i] = (((_x[i] + 1.0) / 2.0) * range + _xmin);
         }
 
+        /** calls _f(_np, k, v) for the probes k in [0, n_probes), in parallel if _np
+         * is_thread_safe(). A copy of the problem is not enough, as e.g. the copies of
+         * FiniteDifferenceHessianWrapper still evaluate the same wrapped function.
+         * The direction v of norm 1 of probe k only depends on the seed, the number of
+         * checks so far and k, so that the report is the same for any number of threads */
+        template<class ProblemInterface, class F>
+        void for_each_probe(ProblemInterface& _np, F&& _f) {
+            const int n = _np.n_unknowns();
+            const int n_threads = !_np.is_thread_safe() ? 1
+                                  : std::min(conf_.n_threads > 0 ? conf_.n_threads : default_n_threads(), conf_.n_probes);
+            const CounterRandomNumberGenerator rng(-1., 1., conf_.seed);
+            const std::uint64_t check = (std::uint64_t)n_sparse_checks_++ << 32;
+            parallel_for(0, conf_.n_probes, [&](const int _k, const int) {
+                Vec v(n);
+                rng.get_random_nd_vector(check | (std::uint64_t)_k, v);
+                v.normalize();
+                _f(_np, _k, v);
+            }, n_threads, 1);
+        }
+
+        void add_error(Report& _report, const double _error, const int _row, const int _col) const {
+            const double tol = std::isnan(conf_.relativeEps) ? conf_.eps : conf_.relativeEps;
+            ++_report.n_checked;
+            // !(<=) also counts NaNs
+            if(!(_error <= tol))
+                ++_report.n_errors;
+            if(!(_error <= _report.max_relative_error)) {
+                _report.max_relative_error = _error;
+                _report.worst_row = _row;
+                _report.worst_col = _col;
+            }
+        }
+
+        static void print_report(const char* _name, const Report& _report) {
+            std::cerr << "############## " << _name << " Checker Summary #############\n";
+            std::cerr << "#ok   : " << _report.n_checked - _report.n_errors << std::endl;
+            std::cerr << "#error: " << _report.n_errors << std::endl;
+            std::cerr << "max relative error: " << _report.max_relative_error << " at " << _report.worst_row;
+            if(_report.worst_col >= 0)
+                std::cerr << "," << _report.worst_col;
+            std::cerr << std::endl;
+        }
+
     private:
         Config conf_;
         RandomNumberGenerator rng_;
+        int n_sparse_checks_ = 0;
     };
 //=============================================================================
 }
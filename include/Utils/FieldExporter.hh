@@ -0,0 +1,221 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <FunctionBase/FunctionBase.hh>
+#include <Utils/ParallelFor.hh>
+
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+#endif
+
+//== NAMESPACES ===============================================================
+
+namespace AOPT {
+
+    //== CLASS DEFINITION =========================================================
+
+    /* Samples a 2D field f(x_i, y_j) on a grid and writes it to a file, without
+     * holding the whole field in memory.
+     *
+     * The rows of the field (one y_j each) are sampled by tiles of consecutive rows,
+     * with FunctionBase::eval_f_batch on one row at a time. A wave of tiles, one per
+     * thread, is sampled and formatted in parallel into per-tile buffers, which are
+     * then written in order with a single call each, so that the memory used is
+     * a few tiles whatever the size of the grid.
+     *
+     * Two formats are supported:
+     *  - CSV, the format of CSVExporter: a first line with the x coordinates, then
+     *    one line per y_j starting with y_j. Numbers are written with the shortest
+     *    representation that reads back to the same double (std::to_chars when
+     *    compiled as C++17, snprintf otherwise).
+     *  - NPY, the numpy format: a small header followed by the raw little-endian
+     *    doubles, row j holding f(x_i, y_j). It can be memory mapped with
+     *    numpy.load(filename, mmap_mode='r'), which gives an array of shape
+     *    (y.size(), x.size()). The coordinates are not stored. */
+    class FieldExporter {
+    public:
+        using Vec = FunctionBase::Vec;
+        using Mat = FunctionBase::Mat;
+
+        enum Format { CSV, NPY };
+
+        /**
+         * \param _n_threads number of threads, 0 uses all hardware threads
+         * \param _tile_rows number of rows sampled and written at once by a thread */
+        FieldExporter(const int _n_threads = 0, const int _tile_rows = 16)
+                : n_threads_(_n_threads > 0 ? _n_threads : default_n_threads()),
+                  tile_rows_(std::max(1, _tile_rows)) {}
+
+        /** NPY if the file name ends with .npy, CSV otherwise */
+        static Format format_of(const std::string& _filename) {
+            const std::string ext(".npy");
+            return _filename.size() >= ext.size() && _filename.compare(_filename.size() - ext.size(), ext.size(), ext) == 0 ? NPY : CSV;
+        }
+
+        /** samples _func at the points (_x[i], _y[j]) and writes the field to _filename,
+         * with one thread if the function is not thread safe
+         * \return 0 if all went well, -1 if not */
+        int export_function2d(FunctionBase* _func, const Vec& _x, const Vec& _y, const std::string& _filename,
+                              const Format _format = CSV) const {
+            if (_func->n_unknowns() != 2) {
+                std::cout << "Error: the function should have 2 unknowns!" << std::endl;
+                return -1;
+            }
+
+            const int n_threads = _func->is_thread_safe() ? n_threads_ : 1;
+
+            // per thread points of a row
+            std::vector<Mat> X(n_threads, Mat(2, _x.size()));
+            for (auto& x : X)
+                x.row(0) = _x.transpose();
+
+            return write_rows([&](const int _j, const int _thread, Vec& _f) {
+                X[_thread].row(1).setConstant(_y[_j]);
+                _func->eval_f_batch(X[_thread], _f);
+            }, n_threads, _x, _y, _filename, _format);
+        }
+
+        /** writes the field given row by row by _row(j, thread_id, f), which should
+         * set f[i] = f(_x[i], _y[j]). It is called from several threads at once,
+         * thread_id in [0, number of threads) allows to use per-thread buffers.
+         * \return 0 if all went well, -1 if not */
+        template <class RowFunction>
+        int export_rows(RowFunction&& _row, const Vec& _x, const Vec& _y, const std::string& _filename,
+                        const Format _format = CSV) const {
+            return write_rows(_row, n_threads_, _x, _y, _filename, _format);
+        }
+
+        /** writes the shortest text that reads back to _v, e.g. with strtod, at _p
+         * \return the end of the text, at most max_chars after _p */
+        static char* write_double(char* _p, const double _v) {
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+            return std::to_chars(_p, _p + max_chars, _v).ptr;
+#else
+            // the shortest of 15, 16 or 17 significant digits that round trips
+            char buf[max_chars + 8];
+            for (int precision = 15; precision <= 17; ++precision) {
+                const int n = std::snprintf(buf, sizeof(buf), "%.*g", precision, _v);
+                if (precision == 17 || std::strtod(buf, nullptr) == _v || _v != _v) {
+                    std::memcpy(_p, buf, n);
+                    return _p + n;
+                }
+            }
+            return _p;
+#endif
+        }
+
+        // longest text of write_double()
+        enum { max_chars = 32 };
+
+    private:
+        // export_rows() with _n_threads threads
+        template <class RowFunction>
+        int write_rows(RowFunction&& _row, const int _n_threads, const Vec& _x, const Vec& _y, const std::string& _filename,
+                       const Format _format) const {
+            std::ofstream file(_filename, std::ios::binary);
+            if (!file) {
+                std::cout << "Error: cannot open " << _filename << std::endl;
+                return -1;
+            }
+
+            const int nx = _x.size(), ny = _y.size();
+            std::vector<char> buffer;
+            if (_format == CSV) {
+                buffer.resize((nx + 1) * max_chars);
+                char* p = buffer.data();
+                for (int i = 0; i < nx; ++i) {
+                    *p++ = ',';
+                    p = write_double(p, _x[i]);
+                }
+                *p++ = '\n';
+                file.write(buffer.data(), p - buffer.data());
+            } else {
+                write_npy_header(file, ny, nx);
+            }
+
+            const int n_tiles = (ny + tile_rows_ - 1) / tile_rows_;
+            std::vector<std::vector<char>> tiles(_n_threads);
+            std::vector<Vec> f(_n_threads, Vec(nx));
+
+            // a wave of one tile per thread, then the tiles are written in order
+            for (int wave = 0; wave < n_tiles; wave += _n_threads) {
+                const int n_wave = std::min(_n_threads, n_tiles - wave);
+                parallel_for_chunks(n_wave, [&](const std::uint64_t _t, const int _thread) {
+                    const int begin = (wave + (int)_t) * tile_rows_;
+                    const int end = std::min(begin + tile_rows_, ny);
+                    std::vector<char>& tile = tiles[_t];
+
+                    if (_format == CSV) {
+                        tile.resize((std::size_t)(end - begin) * (nx + 2) * max_chars);
+                        char* p = tile.data();
+                        for (int j = begin; j < end; ++j) {
+                            _row(j, _thread, f[_thread]);
+                            p = write_double(p, _y[j]);
+                            for (int i = 0; i < nx; ++i) {
+                                *p++ = ',';
+                                p = write_double(p, f[_thread][i]);
+                            }
+                            *p++ = '\n';
+                        }
+                        tile.resize(p - tile.data());
+                    } else {
+                        tile.resize((std::size_t)(end - begin) * nx * sizeof(double));
+                        for (int j = begin; j < end; ++j) {
+                            _row(j, _thread, f[_thread]);
+                            write_little_endian(f[_thread].data(), nx, tile.data() + (std::size_t)(j - begin) * nx * sizeof(double));
+                        }
+                    }
+                }, n_wave);
+
+                for (int t = 0; t < n_wave; ++t)
+                    file.write(tiles[t].data(), tiles[t].size());
+            }
+
+            if (!file) {
+                std::cout << "Error: writing " << _filename << " failed" << std::endl;
+                return -1;
+            }
+            return 0;
+        }
+
+        static void write_npy_header(std::ofstream& _file, const int _rows, const int _cols) {
+            std::string header = "{'descr': '<f8', 'fortran_order': False, 'shape': ("
+                                 + std::to_string(_rows) + ", " + std::to_string(_cols) + "), }";
+            // the magic string, version and length take 10 bytes, the data is aligned on 64 bytes
+            while ((10 + header.size() + 1) % 64 != 0)
+                header += ' ';
+            header += '\n';
+
+            const std::uint16_t len = (std::uint16_t)header.size();
+            const char preamble[10] = {'\x93', 'N', 'U', 'M', 'P', 'Y', 1, 0, (char)(len & 0xff), (char)(len >> 8)};
+            _file.write(preamble, 10);
+            _file.write(header.data(), header.size());
+        }
+
+        static void write_little_endian(const double* _v, const int _n, char* _out) {
+            const std::uint16_t one = 1;
+            std::memcpy(_out, _v, _n * sizeof(double));
+            if (*(const char*)&one == 1)
+                return;
+            for (int i = 0; i < _n; ++i)
+                for (int b = 0; b < 4; ++b)
+                    std::swap(_out[8 * i + b], _out[8 * i + 7 - b]);
+        }
+
+        int n_threads_;
+        int tile_rows_;
+    };
+
+//=============================================================================
+}
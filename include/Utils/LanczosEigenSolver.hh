@@ -0,0 +1,102 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <Eigen/Dense>
+#include <Utils/RandomNumberGenerator.hh>
+
+//== NAMESPACES ===============================================================
+
+namespace AOPT {
+
+    //== CLASS DEFINITION =========================================================
+
+    /* Smallest eigenvalue of a symmetric n x n matrix A by the Lanczos method, which
+     * only needs products A v, e.g. with a sparse Hessian, and usually converges in
+     * far fewer than n products for the extreme eigenvalues.
+     *
+     * The Lanczos vectors are fully reorthogonalized, which costs O(n k^2) for k
+     * iterations but avoids the spurious copies of eigenvalues of the plain three-term
+     * recurrence. The smallest Ritz value is an upper bound of the smallest eigenvalue,
+     * so a negative value always comes with a direction of negative curvature.
+     *
+     * The n dimensional buffers are kept between calls to solve many problems of the
+     * same size, e.g. the Hessians at many points. */
+    class LanczosEigenSolver {
+    public:
+        using Vec = Eigen::VectorXd;
+        using Mat = Eigen::MatrixXd;
+
+        /**
+         * \param _max_iters maximum number of products A v per solve
+         * \param _tolerance relative residual |A v - lambda v| / |lambda| at convergence */
+        LanczosEigenSolver(const int _max_iters = 100, const double _tolerance = 1e-10)
+                : max_iters_(_max_iters), tolerance_(_tolerance) {}
+
+        /** smallest eigenvalue of A
+         * \param _Av the product with A, called as _Av(v, w) to compute w = A v
+         * \param _n the size of A
+         * \param _v output eigenvector of unit length
+         * \param _seed seed of the random start vector
+         * \return the smallest Ritz value */
+        template <class MatVec>
+        double smallest_eigenvalue(MatVec&& _Av, const int _n, Vec& _v, const std::uint64_t _seed = 0) {
+            const int m = std::min(_n, max_iters_);
+            Q_.resize(_n, m);
+            alpha_.resize(m);
+            beta_.resize(m);
+            w_.resize(_n);
+            q_.resize(_n);
+            _v.resize(_n);
+
+            CounterRandomNumberGenerator rng(-1., 1., _seed);
+            rng.get_random_nd_vector(0, w_);
+            Q_.col(0) = w_ / w_.norm();
+
+            double lambda = 0.;
+            int k = 0;
+            while (k < m) {
+                q_ = Q_.col(k);
+                _Av(q_, w_);
+                alpha_[k] = q_.dot(w_);
+
+                // orthogonalize against all the previous vectors, twice is enough
+                for (int pass = 0; pass < 2; ++pass)
+                    w_.noalias() -= Q_.leftCols(k + 1) * (Q_.leftCols(k + 1).transpose() * w_);
+                beta_[k] = w_.norm();
+                ++k;
+
+                // Ritz values of the k x k tridiagonal matrix
+                tridiagonal_.computeFromTridiagonal(alpha_.head(k), beta_.head(k - 1), Eigen::ComputeEigenvectors);
+                lambda = tridiagonal_.eigenvalues()[0];
+
+                // the residual of the Ritz pair is beta_k times the last coefficient of its vector
+                const double residual = beta_[k - 1] * std::abs(tridiagonal_.eigenvectors()(k - 1, 0));
+                if (residual <= tolerance_ * std::max(1., std::abs(lambda)) || k == m)
+                    break;
+
+                Q_.col(k) = w_ / beta_[k - 1];
+            }
+
+            n_iters_ = k;
+            _v.noalias() = Q_.leftCols(k) * tridiagonal_.eigenvectors().col(0);
+            _v.normalize();
+            return lambda;
+        }
+
+        // number of products A v of the last solve
+        int n_iterations() const { return n_iters_; }
+
+    private:
+        int max_iters_;
+        double tolerance_;
+        int n_iters_ = 0;
+
+        Mat Q_;
+        Vec alpha_, beta_, w_, q_;
+        Eigen::SelfAdjointEigenSolver<Mat> tridiagonal_;
+    };
+
+//=============================================================================
+}
@@ -0,0 +1,228 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include <Eigen/Sparse>
+#include <Eigen/SparseCholesky>
+#include <Eigen/SparseLU>
+#include <FunctionBase/TripletAssembler.hh>
+#include <Utils/Profiler.hh>
+#include <Utils/RefactorizableLLT.hh>
+
+//== NAMESPACES ===============================================================
+
+namespace AOPT {
+
+    //== CLASS DEFINITION =========================================================
+
+    /* The memory taken by the data structures of the solvers: vectors, sparse matrices,
+     * triplet buffers and sparse factorizations, e.g.
+     *
+     *     MemoryFootprint::Size s = MemoryFootprint::of(H);
+     *     std::cout << s.bytes << " bytes for " << s.nnz << " nonzeros" << std::endl;
+     *
+     * The solvers report the sizes of their structures to the Profiler with
+     * AOPT_PROFILE_MEMORY("hessian", H), which keeps the current and the peak size of each
+     * structure per scope, and the fill of their factorizations with
+     * AOPT_PROFILE_VALUE("factor_fill", MemoryFootprint::fill_ratio(solver, H)).
+     *
+     * estimate() predicts the sizes before anything is allocated from the dimensions
+     * of a problem, see MassSpringSystemT::estimate_memory() for a dry run of a mass
+     * spring system. */
+    class MemoryFootprint {
+    public:
+        struct Size {
+            // allocated bytes
+            std::int64_t bytes = 0;
+            // stored entries, e.g. the nonzeros of a sparse matrix
+            std::int64_t nnz = 0;
+
+            Size() {}
+            Size(const std::int64_t _bytes, const std::int64_t _nnz) : bytes(_bytes), nnz(_nnz) {}
+
+            Size operator+(const Size& _s) const { return Size(bytes + _s.bytes, nnz + _s.nnz); }
+        };
+
+        // a size already summed over several structures
+        static Size of(const Size& _s) { return _s; }
+
+        template <class Derived>
+        static Size of(const Eigen::PlainObjectBase<Derived>& _m) {
+            return Size((std::int64_t)(_m.size() * sizeof(typename Derived::Scalar)), _m.size());
+        }
+
+        // the reserved entries count, not only the used ones
+        template <class Scalar, int Options, class StorageIndex>
+        static Size of(const Eigen::SparseMatrix<Scalar, Options, StorageIndex>& _M) {
+            std::int64_t bytes = (std::int64_t)_M.data().allocatedSize() * (sizeof(Scalar) + sizeof(StorageIndex))
+                                 + (_M.outerSize() + 1) * (std::int64_t)sizeof(StorageIndex);
+            if(!_M.isCompressed())
+                bytes += _M.outerSize() * (std::int64_t)sizeof(StorageIndex);
+            return Size(bytes, _M.nonZeros());
+        }
+
+        template <class T>
+        static Size of(const std::vector<T>& _v) {
+            return Size((std::int64_t)(_v.capacity() * sizeof(T)), (std::int64_t)_v.size());
+        }
+
+        // the recorded positions of the triplets and pattern of the matrix
+        static Size of(const TripletAssembler& _assembler) {
+            return Size((std::int64_t)_assembler.pattern_bytes(), 0);
+        }
+
+        /** the factor L, the elimination tree and the permutations of a computed
+         * factorization */
+        template <class SMat, int UpLo, class Ordering>
+        static Size of(const Eigen::SimplicialLLT<SMat, UpLo, Ordering>& _llt) {
+            return of(_llt.matrixL().nestedExpression()) + analysis_size(_llt.rows(), sizeof(typename SMat::StorageIndex));
+        }
+
+        // the unit diagonal of L is not stored, D is
+        template <class SMat, int UpLo, class Ordering>
+        static Size of(const Eigen::SimplicialLDLT<SMat, UpLo, Ordering>& _ldlt) {
+            return of(_ldlt.matrixL().nestedExpression()) + of(_ldlt.vectorD())
+                   + analysis_size(_ldlt.rows(), sizeof(typename SMat::StorageIndex));
+        }
+
+        // also counts the pattern kept to refactorize, see RefactorizableLLT
+        template <class SMat>
+        static Size of(const RefactorizableLLT<SMat>& _llt) {
+            return of(static_cast<const Eigen::SimplicialLLT<SMat>&>(_llt)) + Size((std::int64_t)_llt.pattern_bytes(), 0);
+        }
+
+        /** the supernodes of L and the columns of U, as counted by Eigen (nnzL() and
+         * nnzU()), the bytes are about 12 per entry */
+        template <class SMat, class Ordering>
+        static Size of(const Eigen::SparseLU<SMat, Ordering>& _lu) {
+            using StorageIndex = typename SMat::StorageIndex;
+            const std::int64_t nnz = _lu.nnzL() + _lu.nnzU();
+            return Size(nnz * (std::int64_t)(sizeof(typename SMat::Scalar) + sizeof(StorageIndex))
+                        + 4 * _lu.cols() * (std::int64_t)sizeof(StorageIndex), nnz);
+        }
+
+        /** entries of the factor per entry of the factorized matrix, i.e. of its lower
+         * triangle for a Cholesky factorization */
+        template <class Derived, class SMat>
+        static double fill_ratio(const Eigen::SimplicialCholeskyBase<Derived>& _solver, const SMat& _A) {
+            return ratio(of(_solver.derived()).nnz, lower_nonzeros(_A));
+        }
+
+        template <class SMat, class Ordering>
+        static double fill_ratio(const Eigen::SparseLU<SMat, Ordering>& _lu, const SMat& _A) {
+            return ratio(of(_lu).nnz, _A.nonZeros());
+        }
+
+        template <class SMat>
+        static std::int64_t lower_nonzeros(const SMat& _A) {
+            std::int64_t nnz = 0;
+            for(int k = 0; k < _A.outerSize(); ++k)
+                for(typename SMat::InnerIterator it(_A, k); it; ++it)
+                    if(it.row() >= it.col())
+                        ++nnz;
+            return nnz;
+        }
+
+        // the sizes of the structures of a sparse problem and its solvers, see estimate()
+        struct Estimate {
+            std::int64_t n_unknowns = 0;
+            // hessian of the problem, its triplets and the TripletAssembler that sums them
+            Size hessian, triplets, assembler;
+            // Cholesky factor of the hessian and the pattern RefactorizableLLT keeps
+            Size factor, factor_pattern;
+            // the history of LBFGS
+            Size lbfgs_history;
+            // the vectors of Newton's method and of LBFGS
+            Size newton_vectors, lbfgs_vectors;
+
+            // the structures that are alive at once in NewtonMethods::solve and in LBFGS::solve
+            std::int64_t newton_bytes() const {
+                return (hessian + triplets + assembler + factor + factor_pattern + newton_vectors).bytes;
+            }
+
+            std::int64_t lbfgs_bytes() const { return (lbfgs_history + lbfgs_vectors).bytes; }
+
+            void print(std::ostream& _os) const {
+                _os << "Estimated memory for " << n_unknowns << " unknowns:\n";
+                print_row(_os, "hessian", hessian);
+                print_row(_os, "triplets", triplets);
+                print_row(_os, "triplet assembler", assembler);
+                print_row(_os, "Cholesky factor (*)", factor);
+                print_row(_os, "factor pattern", factor_pattern);
+                print_row(_os, "Newton vectors", newton_vectors);
+                print_row(_os, "LBFGS history", lbfgs_history);
+                print_row(_os, "LBFGS vectors", lbfgs_vectors);
+                _os << "  (*) estimated, the fill depends on the ordering\n";
+                _os << "  Newton's method: " << std::fixed << std::setprecision(1) << 1e-6 * newton_bytes() << " MB\n"
+                    << "  LBFGS:           " << 1e-6 * lbfgs_bytes() << " MB" << std::endl;
+                _os.unsetf(std::ios::floatfield);
+            }
+
+        private:
+            static void print_row(std::ostream& _os, const char* _name, const Size& _s) {
+                _os << "  " << std::left << std::setw(20) << _name << std::right << std::setw(14) << _s.nnz << " entries "
+                    << std::fixed << std::setprecision(1) << std::setw(12) << 1e-6 * _s.bytes << " MB\n";
+                _os.unsetf(std::ios::floatfield);
+            }
+        };
+
+        /** the sizes of the structures of NewtonMethods::solve and LBFGS::solve on a problem
+         * that assembles its hessian from triplets, e.g. MassSpringProblem2DSparse, without
+         * allocating any of them
+         * \param _n_unknowns number of unknowns
+         * \param _hessian_nnz nonzeros of the (full, symmetric) hessian
+         * \param _n_triplets triplets of the hessian, before they are summed
+         * \param _factor_nnz nonzeros of the Cholesky factor L, which depend on the fill of the
+         *        ordering, e.g. fitted to the symbolic factorizations of smaller problems
+         * \param _lbfgs_m history size of LBFGS */
+        static Estimate estimate(const std::int64_t _n_unknowns, const std::int64_t _hessian_nnz, const std::int64_t _n_triplets,
+                                 const std::int64_t _factor_nnz, const int _lbfgs_m = 10) {
+            const std::int64_t n = _n_unknowns;
+            const std::int64_t index = sizeof(int), scalar = sizeof(double);
+            // the lower triangle, the diagonal is full
+            const std::int64_t lower_nnz = (_hessian_nnz + n) / 2;
+
+            Estimate e;
+            e.n_unknowns = n;
+            e.hessian = Size(_hessian_nnz * (scalar + index) + (n + 1) * index, _hessian_nnz);
+            e.triplets = Size(_n_triplets * (std::int64_t)sizeof(Eigen::Triplet<double>), _n_triplets);
+            // row, column and position of each triplet, and the pattern of the matrix
+            e.assembler = Size(3 * _n_triplets * index + (n + 1 + _hessian_nnz) * index, 0);
+            e.factor = Size(_factor_nnz * (scalar + index) + (n + 1) * index, _factor_nnz) + analysis_size(n, index);
+            // the permuted upper triangle, the map of its values and the pattern of the hessian
+            e.factor_pattern = Size(lower_nnz * (scalar + 2 * index) + (n + 1) * index + (n + 1 + _hessian_nnz) * index, 0);
+            // x, g, the step, the trial point of the line search and the work vector of the solve
+            e.newton_vectors = Size(5 * n * scalar, 5 * n);
+            e.lbfgs_history = Size(2 * n * _lbfgs_m * scalar, 2 * n * _lbfgs_m);
+            // x, g, s_k, y_k, the previous x and g, r, the step and the trial point
+            e.lbfgs_vectors = Size(9 * n * scalar, 9 * n);
+            return e;
+        }
+
+    private:
+        // elimination tree, column counts and the two permutations of a simplicial factorization
+        static Size analysis_size(const std::int64_t _n, const std::size_t _index_size) {
+            return Size(4 * _n * (std::int64_t)_index_size, 0);
+        }
+
+        static double ratio(const std::int64_t _a, const std::int64_t _b) { return _b > 0 ? double(_a) / double(_b) : 0.; }
+    };
+
+//=============================================================================
+}
+
+#ifdef AOPT_NO_PROFILING
+#define AOPT_PROFILE_MEMORY(name, structure) do {} while(0)
+#else
+// records the size of a data structure in the innermost scope, see MemoryFootprint::of()
+#define AOPT_PROFILE_MEMORY(name, structure) \
+    do { \
+        if(::AOPT::Profiler::enabled()) { \
+            const ::AOPT::MemoryFootprint::Size aopt_memory_size = ::AOPT::MemoryFootprint::of(structure); \
+            ::AOPT::Profiler::instance().record_memory(name, aopt_memory_size.bytes, aopt_memory_size.nnz); \
+        } \
+    } while(0)
+#endif
@@ -2,8 +2,10 @@
 
 #include <iostream>
 #include <iomanip>
+#include <memory>
 #include <FunctionBase/FunctionBaseSparse.hh>
 
+#include "PerfCounters.hh"
 #include "StopWatch.hh"
 
 //== NAMESPACES ===============================================================
@@ -23,29 +25,63 @@ namespace AOPT {
             return base_->n_unknowns();
         }
 
+        virtual bool is_quadratic() override {
+            return base_->is_quadratic();
+        }
+
+        virtual bool has_constant_hessian() override {
+            return base_->has_constant_hessian();
+        }
+
         virtual double eval_f(const Vec &_x) override {
             ++n_eval_f_;
+            start_counters();
             sw_.start();
             double f = base_->eval_f(_x);
             timing_eval_f_ += sw_.stop();
+            stop_counters(counters_eval_f_);
 
             return f;
         }
 
         virtual void eval_gradient(const Vec &_x, Vec &_g) override {
             ++n_eval_gradient_;
+            start_counters();
             sw_.start();
             base_->eval_gradient(_x, _g);
             timing_eval_gradient_ += sw_.stop();
+            stop_counters(counters_eval_gradient_);
         }
 
         virtual void eval_hessian(const Vec &_x, SMat &_H) override {
             ++n_eval_hessian_;
+            start_counters();
             sw_.start();
             base_->eval_hessian(_x, _H);
             timing_eval_hessian_ += sw_.stop();
+            stop_counters(counters_eval_hessian_);
         }
 
+        /** also counts cycles, instructions, cache and branch misses of the evaluations
+         * with the hardware counters of the calling thread, see PerfCounters. They are
+         * printed as IPC and miss rates by print_statistics().
+         * \return false if no counter is available, e.g. inside a container, the
+         *         statistics are then recorded without them */
+        bool enable_hardware_counters() {
+            if(!perf_)
+                perf_ = std::make_unique<PerfCounters>();
+            if(!perf_->available()) {
+                std::cerr << "Warning: hardware counters are not available (" << perf_->error() << ")" << std::endl;
+                return false;
+            }
+            return true;
+        }
+
+        // hardware counts of the evaluations since start_recording()
+        const PerfCounters::Values& counters_eval_f() const { return counters_eval_f_; }
+        const PerfCounters::Values& counters_eval_gradient() const { return counters_eval_gradient_; }
+        const PerfCounters::Values& counters_eval_hessian() const { return counters_eval_hessian_; }
+
         void start_recording() {
             swg_.start();
 
@@ -56,8 +92,16 @@ namespace AOPT {
             n_eval_f_ = 0;
             n_eval_gradient_ = 0;
             n_eval_hessian_ = 0;
+
+            counters_eval_f_ = PerfCounters::Values();
+            counters_eval_gradient_ = PerfCounters::Values();
+            counters_eval_hessian_ = PerfCounters::Values();
         }
 
+        int n_eval_f() const { return n_eval_f_; }
+        int n_eval_gradient() const { return n_eval_gradient_; }
+        int n_eval_hessian() const { return n_eval_hessian_; }
+
         void print_statistics() {
             double time_total = swg_.stop();
 
@@ -84,9 +128,33 @@ namespace AOPT {
                       << "s  ( #evals: " << n_eval_hessian_ << " -> avg "
                       << timing_eval_hessian_avg / 1000000.0 << "s, factor: "
                       << timing_eval_hessian_avg / timing_eval_f_avg << ")\n";
+
+            if(perf_) {
+                if(!perf_->available()) {
+                    std::cerr << "hardware counters not available (" << perf_->error() << ")\n";
+                } else {
+                    std::cerr << "eval_f counters   : ";
+                    counters_eval_f_.print(std::cerr);
+                    std::cerr << "\neval_grad counters: ";
+                    counters_eval_gradient_.print(std::cerr);
+                    std::cerr << "\neval_hess counters: ";
+                    counters_eval_hessian_.print(std::cerr);
+                    std::cerr << "\n";
+                }
+            }
         }
 
     private:
+        void start_counters() {
+            if(perf_)
+                perf_->read(counters_start_);
+        }
+
+        void stop_counters(PerfCounters::Values& _counters) {
+            if(perf_ && perf_->read(counters_stop_))
+                _counters += counters_stop_ - counters_start_;
+        }
+
         FunctionBaseSparse *base_;
         AOPT::StopWatch<std::chrono::microseconds> swg_;
         AOPT::StopWatch<std::chrono::microseconds> sw_;
@@ -100,6 +168,13 @@ namespace AOPT {
         int n_eval_f_;
         int n_eval_gradient_;
         int n_eval_hessian_;
+
+        // hardware counters, null if not enabled
+        std::unique_ptr<PerfCounters> perf_;
+        PerfCounters::Values counters_start_, counters_stop_;
+        PerfCounters::Values counters_eval_f_;
+        PerfCounters::Values counters_eval_gradient_;
+        PerfCounters::Values counters_eval_hessian_;
     };
 
 //=============================================================================
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <algorithm>
+
+//== NAMESPACES ===============================================================
+
+namespace AOPT {
+
+    /** number of threads used when none is given, i.e. the number of hardware threads */
+    inline int default_n_threads() {
+        return std::max(1, (int)std::thread::hardware_concurrency());
+    }
+
+    /** Calls _f(i, thread_id) for all i in [_begin, _end). The range is split into
+     * one contiguous chunk per thread, thread_id in [0, _n_threads) identifies the chunk
+     * so that _f can write into per-thread buffers.
+     * Ranges shorter than _grain run on the calling thread only, with thread_id 0.
+     *
+     * \param _n_threads number of threads, 0 uses default_n_threads()
+     * \param _grain minimum number of iterations per thread */
+    template <class F>
+    void parallel_for(const int _begin, const int _end, F&& _f, const int _n_threads = 0, const int _grain = 1024) {
+        const int n = _end - _begin;
+        if(n <= 0)
+            return;
+
+        int n_threads = _n_threads > 0 ? _n_threads : default_n_threads();
+        n_threads = std::max(1, std::min(n_threads, n / std::max(1, _grain)));
+
+        if(n_threads == 1) {
+            for(int i = _begin; i < _end; ++i)
+                _f(i, 0);
+            return;
+        }
+
+        std::vector<std::thread> threads;
+        threads.reserve(n_threads - 1);
+        auto chunk = [&](const int _t) {
+            const int b = _begin + (int)((long)n * _t / n_threads);
+            const int e = _begin + (int)((long)n * (_t + 1) / n_threads);
+            for(int i = b; i < e; ++i)
+                _f(i, _t);
+        };
+        for(int t = 1; t < n_threads; ++t)
+            threads.emplace_back(chunk, t);
+        chunk(0);
+        for(auto& th : threads)
+            th.join();
+    }
+
+    /** Calls _f(c, thread_id) for all chunks c in [0, _n_chunks). Unlike parallel_for(),
+     * the threads take the next chunk from a shared counter when they are done with
+     * the previous one, which balances chunks of uneven cost, and the number of
+     * chunks is 64 bits.
+     *
+     * \param _n_threads number of threads, 0 uses default_n_threads()
+     * \return the number of threads used, thread_id is in [0, return value) */
+    template <class F>
+    int parallel_for_chunks(const std::uint64_t _n_chunks, F&& _f, const int _n_threads = 0) {
+        int n_threads = _n_threads > 0 ? _n_threads : default_n_threads();
+        if((std::uint64_t)n_threads > _n_chunks)
+            n_threads = std::max<int>(1, (int)_n_chunks);
+
+        std::atomic<std::uint64_t> next(0);
+        auto work = [&](const int _t) {
+            for(std::uint64_t c = next++; c < _n_chunks; c = next++)
+                _f(c, _t);
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(n_threads - 1);
+        for(int t = 1; t < n_threads; ++t)
+            threads.emplace_back(work, t);
+        work(0);
+        for(auto& th : threads)
+            th.join();
+
+        return n_threads;
+    }
+
+//=============================================================================
+}
@@ -0,0 +1,244 @@
+#pragma once
+
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+//== NAMESPACES ===============================================================
+
+namespace AOPT {
+
+    //== CLASS DEFINITION =========================================================
+
+    /* Hardware performance counters of the calling thread, read with perf_event_open
+     * on Linux: cycles, instructions, last level cache references and misses, branches
+     * and branch misses, in user space only.
+     *
+     * The counters run from the construction, and the counts of a phase are the
+     * difference of two read(), which costs a system call per group. The events are
+     * opened as three groups, the events of a ratio together: cycles and instructions,
+     * the cache references and misses, the branches and branch misses. A group of two
+     * fits on any PMU with two free counters, whereas a group of all six events is
+     * never scheduled on a PMU with fewer counters. When the hardware cannot count all
+     * the groups at once, the kernel multiplexes them and the counts of a group are
+     * scaled by the fraction of the time it was counted.
+     *
+     * Counters that cannot be opened, e.g. inside a container or a virtual machine
+     * without a PMU, or with a restrictive /proc/sys/kernel/perf_event_paranoid, are
+     * reported as not available instead of failing, see available() and error(). */
+    class PerfCounters {
+    public:
+        enum Event { CYCLES, INSTRUCTIONS, LLC_REFERENCES, LLC_MISSES, BRANCHES, BRANCH_MISSES, N_EVENTS };
+
+        static const char* name(const Event _e) {
+            static const char* names[N_EVENTS] = {"cycles", "instructions", "llc_references", "llc_misses",
+                                                  "branches", "branch_misses"};
+            return names[_e];
+        }
+
+        // counts of the events, those of the unavailable ones are 0
+        struct Values {
+            std::array<double, N_EVENTS> counts{};
+            // bit e is set if event e was counted
+            unsigned int mask = 0;
+
+            bool has(const Event _e) const { return (mask >> _e) & 1u; }
+
+            double operator[](const Event _e) const { return counts[_e]; }
+
+            Values operator-(const Values& _v) const {
+                Values d;
+                for(int e = 0; e < N_EVENTS; ++e)
+                    d.counts[e] = counts[e] - _v.counts[e];
+                d.mask = mask & _v.mask;
+                return d;
+            }
+
+            Values& operator+=(const Values& _v) {
+                for(int e = 0; e < N_EVENTS; ++e)
+                    counts[e] += _v.counts[e];
+                mask = mask == 0 ? _v.mask : (mask & _v.mask);
+                return *this;
+            }
+
+            // instructions per cycle, NaN if not counted
+            double ipc() const { return ratio(INSTRUCTIONS, CYCLES); }
+
+            // fraction of the last level cache references that missed
+            double llc_miss_rate() const { return ratio(LLC_MISSES, LLC_REFERENCES); }
+
+            // fraction of the branches that were mispredicted
+            double branch_miss_rate() const { return ratio(BRANCH_MISSES, BRANCHES); }
+
+            // last level cache misses per 1000 instructions
+            double llc_mpki() const { return 1000. * ratio(LLC_MISSES, INSTRUCTIONS); }
+
+            /** prints e.g. "IPC 1.52, LLC misses 12.3 % (4.1 per 1k instr.), branch misses 0.8 %",
+             * with n/a for what was not counted */
+            void print(std::ostream& _os) const {
+                const auto flags = _os.flags();
+                const auto precision = _os.precision();
+                _os << std::fixed << std::setprecision(2) << "IPC ";
+                print_value(_os, ipc(), 1.);
+                _os << ", LLC misses ";
+                print_value(_os, llc_miss_rate(), 100., " %");
+                _os << " (";
+                print_value(_os, llc_mpki(), 1.);
+                _os << " per 1k instr.), branch misses ";
+                print_value(_os, branch_miss_rate(), 100., " %");
+                _os.flags(flags);
+                _os.precision(precision);
+            }
+
+        private:
+            double ratio(const Event _a, const Event _b) const {
+                if(!has(_a) || !has(_b) || counts[_b] <= 0.)
+                    return std::numeric_limits<double>::quiet_NaN();
+                return counts[_a] / counts[_b];
+            }
+
+            static void print_value(std::ostream& _os, const double _v, const double _scale, const char* _unit = "") {
+                if(_v != _v)
+                    _os << "n/a";
+                else
+                    _os << _scale * _v << _unit;
+            }
+        };
+
+        PerfCounters() {
+            fds_.fill(-1);
+            leaders_.fill(-1);
+            n_open_.fill(0);
+#if defined(__linux__)
+            static const std::uint64_t configs[N_EVENTS] = {
+                    PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_REFERENCES,
+                    PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_MISSES};
+
+            for(int g = 0; g < N_GROUPS; ++g) {
+                for(int e = GROUP_SIZE * g; e < GROUP_SIZE * (g + 1); ++e) {
+                    perf_event_attr attr;
+                    std::memset(&attr, 0, sizeof(attr));
+                    attr.size = sizeof(attr);
+                    attr.type = PERF_TYPE_HARDWARE;
+                    attr.config = configs[e];
+                    attr.exclude_kernel = 1;
+                    attr.exclude_hv = 1;
+                    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+                    // the leader starts the whole group
+                    attr.disabled = leaders_[g] < 0 ? 1 : 0;
+
+                    const int fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, leaders_[g], 0);
+                    if(fd < 0) {
+                        if(error_.empty())
+                            error_ = std::string("perf_event_open(") + name((Event)e) + "): " + std::strerror(errno);
+                        continue;
+                    }
+                    fds_[e] = fd;
+                    if(leaders_[g] < 0)
+                        leaders_[g] = fd;
+                    order_[GROUP_SIZE * g + n_open_[g]++] = e;
+                }
+
+                if(leaders_[g] < 0)
+                    continue;
+                if(ioctl(leaders_[g], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP) != 0) {
+                    if(error_.empty())
+                        error_ = std::string("enabling the counters: ") + std::strerror(errno);
+                    close_group(g);
+                    continue;
+                }
+                for(int i = 0; i < n_open_[g]; ++i)
+                    mask_ |= 1u << order_[GROUP_SIZE * g + i];
+            }
+#else
+            error_ = "hardware counters are only supported on Linux";
+#endif
+        }
+
+        ~PerfCounters() { close_all(); }
+
+        PerfCounters(const PerfCounters&) = delete;
+        PerfCounters& operator=(const PerfCounters&) = delete;
+
+        // true if at least one event is counted
+        bool available() const { return mask_ != 0; }
+
+        bool available(const Event _e) const { return (mask_ >> _e) & 1u; }
+
+        // why the first event that is not available could not be opened, empty if all are
+        const std::string& error() const { return error_; }
+
+        /** the counts since the construction, scaled if the events were multiplexed.
+         * A group that has not been counted yet, e.g. while the counters are taken by
+         * other groups, is left out of the mask of _v
+         * \return false if no counter could be read */
+        bool read(Values& _v) const {
+            _v = Values();
+#if defined(__linux__)
+            for(int g = 0; g < N_GROUPS; ++g) {
+                if(leaders_[g] < 0)
+                    continue;
+                // nr, time enabled, time running, then one value per event
+                std::uint64_t buf[3 + GROUP_SIZE];
+                const ssize_t size = ::read(leaders_[g], buf, sizeof(buf));
+                if(size < (ssize_t)(3 * sizeof(std::uint64_t)) || buf[0] != (std::uint64_t)n_open_[g] || buf[2] == 0)
+                    continue;
+                const double scale = (double)buf[1] / (double)buf[2];
+                for(int i = 0; i < n_open_[g]; ++i) {
+                    const int e = order_[GROUP_SIZE * g + i];
+                    _v.counts[e] = scale * (double)buf[3 + i];
+                    _v.mask |= 1u << e;
+                }
+            }
+            return _v.mask != 0;
+#else
+            return false;
+#endif
+        }
+
+    private:
+        // the events GROUP_SIZE * g, ..., GROUP_SIZE * (g + 1) - 1 form the group g
+        enum { GROUP_SIZE = 2, N_GROUPS = N_EVENTS / GROUP_SIZE };
+
+        void close_group(const int _g) {
+#if defined(__linux__)
+            for(int e = GROUP_SIZE * _g; e < GROUP_SIZE * (_g + 1); ++e)
+                if(fds_[e] >= 0) {
+                    close(fds_[e]);
+                    fds_[e] = -1;
+                    mask_ &= ~(1u << e);
+                }
+#endif
+            leaders_[_g] = -1;
+            n_open_[_g] = 0;
+        }
+
+        void close_all() {
+            for(int g = 0; g < N_GROUPS; ++g)
+                close_group(g);
+            mask_ = 0;
+        }
+
+        std::array<int, N_EVENTS> fds_;
+        // the events of group g in the order they were opened, from GROUP_SIZE * g on
+        std::array<int, N_EVENTS> order_{};
+        std::array<int, N_GROUPS> n_open_;
+        std::array<int, N_GROUPS> leaders_;
+        unsigned int mask_ = 0;
+        std::string error_;
+    };
+
+//=============================================================================
+}
@@ -0,0 +1,623 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <Utils/AllocationTracker.hh>
+#include <Utils/PerfCounters.hh>
+
+//== NAMESPACES ===============================================================
+
+namespace AOPT {
+
+    //== CLASS DEFINITION =========================================================
+
+    /* Hierarchical timers and counters of the phases of a solve, e.g. the
+     * factorizations of a Newton method and the backtracking steps of its line
+     * searches, which OptimizationStatistic does not see.
+     *
+     * The solvers mark their phases with AOPT_PROFILE_SCOPE("name"), which times the
+     * enclosing block, and count events with AOPT_PROFILE_COUNT("name"), which adds to
+     * a counter of the innermost open scope. Scopes opened inside a scope are its
+     * children, so that a phase is reported under the solve that ran it, e.g.
+     * InteriorPoint::solve/NewtonMethods::solve_with_projected_hessian/factorization.
+     *
+     * Recording is off by default. A disabled scope costs a test of a thread local
+     * flag, and defining AOPT_NO_PROFILING removes the macros altogether. Each thread
+     * has its own profiler, given by Profiler::instance().
+     *
+     * A solve is typically recorded and exported with
+     *
+     *     Profiler::instance().start();
+     *     x = NewtonMethods::solve(...);
+     *     Profiler::instance().stop();
+     *     Profiler::instance().save_json("solve.json");
+     *
+     * The CSV output has one (path, name, value) row per value, which is easy to
+     * concatenate and aggregate over many runs. With start(true) the timeline is also
+     * recorded and save_chrome_trace() writes it in the trace event format, which can
+     * be opened in chrome://tracing or https://ui.perfetto.dev.
+     *
+     * With enable_hardware_counters(), the scopes also accumulate the hardware counters
+     * of PerfCounters, e.g. to tell whether a phase is bound by cache misses, which
+     * print_hardware_counters() shows as IPC and miss rates per scope.
+     *
+     * When the AllocationTracker is installed in the program, the scopes also count
+     * the heap allocations made while they are open, see allocations(). The first
+     * visit of a scope allocates its record, which is counted in its parent.
+     *
+     * The solvers also record the current and peak size of their data structures and
+     * the fill of their factorizations in their scopes, see MemoryFootprint. */
+    class Profiler {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        // the profiler of the calling thread
+        static Profiler& instance() {
+            thread_local Profiler profiler;
+            return profiler;
+        }
+
+        // true if the calling thread is recording
+        static bool enabled() { return enabled_flag(); }
+
+        /** clears the previous records and starts recording on the calling thread
+         * \param _trace if true, every scope and counter change is also kept for save_chrome_trace()
+         * \param _max_events the trace events beyond this number are dropped */
+        void start(const bool _trace = false, const std::size_t _max_events = 1000000) {
+            reset();
+            trace_ = _trace;
+            max_events_ = _max_events;
+            enabled_flag() = true;
+        }
+
+        // stops recording, the records are kept until the next start()
+        void stop() {
+            if(enabled_flag())
+                elapsed_ns_ = ns_since_start(Clock::now());
+            enabled_flag() = false;
+        }
+
+        /** counts cycles, instructions, cache and branch misses in the scopes, which
+         * costs a system call at each begin() and end()
+         * \return false if no hardware counter is available, e.g. inside a container,
+         *         the scopes are then timed without them */
+        bool enable_hardware_counters(const bool _enable = true) {
+            if(!_enable) {
+                perf_.reset();
+                return true;
+            }
+            if(!perf_)
+                perf_ = std::make_unique<PerfCounters>();
+            if(!perf_->available()) {
+                std::cerr << "Warning: hardware counters are not available (" << perf_->error() << ")" << std::endl;
+                perf_.reset();
+                return false;
+            }
+            return true;
+        }
+
+        bool has_hardware_counters() const { return perf_ != nullptr; }
+
+        void reset() {
+            nodes_.assign(1, Node{"total", -1});
+            stack_.assign(1, Open{0, Clock::time_point(), PerfCounters::Values(), AllocationTracker::Counts()});
+            events_.clear();
+            n_dropped_events_ = 0;
+            start_time_ = Clock::now();
+            elapsed_ns_ = 0;
+        }
+
+        // opens the scope _name, a string that lives until the export (e.g. a literal)
+        void begin(const char* _name) {
+            const int parent = stack_.back().node;
+            int node = -1;
+            for(int child : nodes_[parent].children)
+                if(std::strcmp(nodes_[child].name, _name) == 0) {
+                    node = child;
+                    break;
+                }
+            if(node < 0) {
+                node = (int)nodes_.size();
+                nodes_.push_back(Node{_name, parent});
+                nodes_[parent].children.push_back(node);
+            }
+            stack_.push_back(Open{node, Clock::time_point(), PerfCounters::Values(), AllocationTracker::Counts()});
+            stack_.back().heap = AllocationTracker::counts();
+            if(perf_)
+                perf_->read(stack_.back().counts);
+            stack_.back().start = Clock::now();
+        }
+
+        // closes the innermost scope
+        void end() {
+            if(stack_.size() < 2)
+                return;
+            const auto now = Clock::now();
+            const auto heap = AllocationTracker::counts();
+            const Open& open = stack_.back();
+            Node& node = nodes_[open.node];
+            const std::int64_t duration = std::chrono::duration_cast<std::chrono::nanoseconds>(now - open.start).count();
+            ++node.calls;
+            node.total_ns += duration;
+            // nothing was read at begin() if the mask is 0, the difference would be the
+            // counts since the construction of the counters
+            if(perf_ && open.counts.mask != 0 && perf_->read(counts_))
+                node.counts += counts_ - open.counts;
+            node.heap += heap - open.heap;
+            if(trace_)
+                add_event(Event{open.node, nullptr, ns_since_start(open.start), duration});
+            stack_.pop_back();
+        }
+
+        // adds _n to the counter _name of the innermost scope
+        void count(const char* _name, const std::int64_t _n = 1) {
+            Node& node = nodes_[stack_.back().node];
+            auto it = std::find_if(node.counters.begin(), node.counters.end(),
+                                   [&](const std::pair<const char*, std::int64_t>& _c) { return std::strcmp(_c.first, _name) == 0; });
+            if(it == node.counters.end()) {
+                node.counters.emplace_back(_name, 0);
+                it = node.counters.end() - 1;
+            }
+            it->second += _n;
+            if(trace_)
+                add_event(Event{stack_.back().node, _name, ns_since_start(Clock::now()), it->second});
+        }
+
+        /** number of closed calls of the scope given by its path, e.g.
+         * "NewtonMethods::solve/factorization", 0 if it was never opened */
+        std::int64_t calls(const std::string& _path) const {
+            const int node = find(_path);
+            return node < 0 ? 0 : nodes_[node].calls;
+        }
+
+        // total time in ms of the scope given by its path
+        double total_ms(const std::string& _path) const {
+            const int node = find(_path);
+            return node < 0 ? 0. : 1e-6 * nodes_[node].total_ns;
+        }
+
+        // value of the counter _name of the scope given by its path
+        std::int64_t counter(const std::string& _path, const std::string& _name) const {
+            const int node = find(_path);
+            if(node < 0)
+                return 0;
+            for(const auto& c : nodes_[node].counters)
+                if(_name == c.first)
+                    return c.second;
+            return 0;
+        }
+
+        // hardware counts of the scope given by its path, see enable_hardware_counters()
+        PerfCounters::Values hardware_counters(const std::string& _path) const {
+            const int node = find(_path);
+            return node < 0 ? PerfCounters::Values() : nodes_[node].counts;
+        }
+
+        /** prints one line per scope with its IPC and miss rates, e.g.
+         * "NewtonMethods::solve/factorization: IPC 1.52, LLC misses 12.3 % ...",
+         * the counts of a scope include those of the scopes nested in it */
+        void print_hardware_counters(std::ostream& _os) const {
+            for(int i = 1; i < (int)nodes_.size(); ++i) {
+                _os << path(i) << ": ";
+                nodes_[i].counts.print(_os);
+                _os << "\n";
+            }
+        }
+
+        /** heap allocations made in the scope given by its path, including those of
+         * the scopes nested in it, all 0 if the AllocationTracker is not installed */
+        AllocationTracker::Counts allocations(const std::string& _path) const {
+            const int node = find(_path);
+            return node < 0 ? AllocationTracker::Counts() : nodes_[node].heap;
+        }
+
+        // size of a data structure, see record_memory()
+        struct Memory {
+            const char* name;
+            std::int64_t bytes = 0;
+            std::int64_t peak_bytes = 0;
+            std::int64_t nnz = 0;
+
+            Memory(const char* _name = "") : name(_name) {}
+        };
+
+        /** sets the size of the data structure _name of the innermost scope, e.g. the
+         * Hessian of a Newton method, and raises its peak size if needed, see
+         * AOPT_PROFILE_MEMORY and MemoryFootprint
+         * \param _bytes its allocated bytes
+         * \param _nnz its number of entries, e.g. nonzeros */
+        void record_memory(const char* _name, const std::int64_t _bytes, const std::int64_t _nnz = 0) {
+            Node& node = nodes_[stack_.back().node];
+            auto it = std::find_if(node.memory.begin(), node.memory.end(),
+                                   [&](const Memory& _m) { return std::strcmp(_m.name, _name) == 0; });
+            if(it == node.memory.end()) {
+                node.memory.push_back(Memory{_name});
+                it = node.memory.end() - 1;
+            }
+            it->bytes = _bytes;
+            it->peak_bytes = std::max(it->peak_bytes, _bytes);
+            it->nnz = _nnz;
+            if(trace_)
+                add_event(Event{stack_.back().node, _name, ns_since_start(Clock::now()), _bytes});
+        }
+
+        // sets the value _name of the innermost scope, e.g. the fill ratio of a factorization
+        void record_value(const char* _name, const double _value) {
+            Node& node = nodes_[stack_.back().node];
+            auto it = std::find_if(node.values.begin(), node.values.end(),
+                                   [&](const std::pair<const char*, double>& _v) { return std::strcmp(_v.first, _name) == 0; });
+            if(it == node.values.end())
+                node.values.emplace_back(_name, _value);
+            else
+                it->second = _value;
+        }
+
+        /** last recorded size of the data structure _name of the scope given by its path,
+         * all 0 if it was not recorded */
+        Memory memory(const std::string& _path, const std::string& _name) const {
+            const int node = find(_path);
+            if(node >= 0)
+                for(const auto& m : nodes_[node].memory)
+                    if(_name == m.name)
+                        return m;
+            return Memory();
+        }
+
+        // last recorded value _name of the scope given by its path, 0 if not recorded
+        double value(const std::string& _path, const std::string& _name) const {
+            const int node = find(_path);
+            if(node >= 0)
+                for(const auto& v : nodes_[node].values)
+                    if(_name == v.first)
+                        return v.second;
+            return 0.;
+        }
+
+        // number of trace events dropped because of the _max_events of start()
+        std::size_t n_dropped_events() const { return n_dropped_events_; }
+
+        /** writes the tree of scopes as
+         * {"total_ms": ..., "scopes": [{"name": ..., "calls": ..., "total_ms": ..., "self_ms": ...,
+         *   "counters": {...}, "children": [...]}, ...]}
+         * with "hardware" and "heap" ({"allocations": ..., "bytes": ...}) entries when counted,
+         * and "memory" ({"hessian": {"bytes": ..., "peak_bytes": ..., "nnz": ...}, ...}) and
+         * "values" entries when recorded */
+        void write_json(std::ostream& _os) const {
+            _os << std::setprecision(9) << "{\"total_ms\": " << 1e-6 * total_ns() << ", \"scopes\": ";
+            write_json_children(_os, 0, 1);
+            if(!nodes_[0].counters.empty()) {
+                _os << ", \"counters\": ";
+                write_json_counters(_os, 0);
+            }
+            write_json_memory(_os, 0);
+            _os << "}\n";
+        }
+
+        /** writes "path,name,value" rows: calls, total_ms and self_ms of each scope, then its
+         * counters, hardware counts, allocations (allocations, allocated_bytes), memory
+         * (<name>_bytes, <name>_peak_bytes, <name>_nnz) and values */
+        void write_csv(std::ostream& _os) const {
+            _os << std::setprecision(9) << "path,name,value\n";
+            _os << "total,total_ms," << 1e-6 * total_ns() << "\n";
+            for(const auto& c : nodes_[0].counters)
+                _os << "total," << c.first << "," << c.second << "\n";
+            write_csv_memory(_os, "total", 0);
+            for(int i = 1; i < (int)nodes_.size(); ++i) {
+                const std::string p = path(i);
+                _os << p << ",calls," << nodes_[i].calls << "\n"
+                    << p << ",total_ms," << 1e-6 * nodes_[i].total_ns << "\n"
+                    << p << ",self_ms," << 1e-6 * self_ns(i) << "\n";
+                for(const auto& c : nodes_[i].counters)
+                    _os << p << "," << c.first << "," << c.second << "\n";
+                for(int e = 0; e < PerfCounters::N_EVENTS; ++e)
+                    if(nodes_[i].counts.has((PerfCounters::Event)e))
+                        _os << p << "," << PerfCounters::name((PerfCounters::Event)e) << ","
+                            << nodes_[i].counts[(PerfCounters::Event)e] << "\n";
+                if(AllocationTracker::installed())
+                    _os << p << ",allocations," << nodes_[i].heap.allocations << "\n"
+                        << p << ",allocated_bytes," << nodes_[i].heap.bytes << "\n";
+                write_csv_memory(_os, p, i);
+            }
+        }
+
+        /** writes the timeline recorded with start(true) in the trace event format:
+         * one complete event ("ph": "X") per closed scope and one counter event ("ph": "C")
+         * per counter change, with times in microseconds */
+        void write_chrome_trace(std::ostream& _os) const {
+            _os << std::fixed << std::setprecision(3) << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+            for(std::size_t i = 0; i < events_.size(); ++i) {
+                const Event& e = events_[i];
+                _os << (i == 0 ? "\n" : ",\n");
+                if(e.counter == nullptr) {
+                    _os << "{\"name\": ";
+                    write_json_string(_os, nodes_[e.node].name);
+                    _os << ", \"cat\": \"aopt\", \"ph\": \"X\", \"pid\": 1, \"tid\": 1, \"ts\": " << 1e-3 * e.time_ns
+                        << ", \"dur\": " << 1e-3 * e.value << "}";
+                } else {
+                    _os << "{\"name\": ";
+                    write_json_string(_os, (path(e.node) + "/" + e.counter).c_str());
+                    _os << ", \"cat\": \"aopt\", \"ph\": \"C\", \"pid\": 1, \"tid\": 1, \"ts\": " << 1e-3 * e.time_ns
+                        << ", \"args\": {\"value\": " << e.value << "}}";
+                }
+            }
+            _os << "\n]}\n";
+            _os.unsetf(std::ios::floatfield);
+        }
+
+        /** write_json(), write_csv() and write_chrome_trace() to a file
+         * \return 0 if all went well, -1 if not */
+        int save_json(const std::string& _filename) const {
+            return save(_filename, [this](std::ostream& _os) { write_json(_os); });
+        }
+
+        int save_csv(const std::string& _filename) const {
+            return save(_filename, [this](std::ostream& _os) { write_csv(_os); });
+        }
+
+        int save_chrome_trace(const std::string& _filename) const {
+            return save(_filename, [this](std::ostream& _os) { write_chrome_trace(_os); });
+        }
+
+    private:
+        struct Node {
+            const char* name;
+            int parent;
+            std::int64_t calls = 0;
+            std::int64_t total_ns = 0;
+            std::vector<int> children;
+            std::vector<std::pair<const char*, std::int64_t>> counters;
+            PerfCounters::Values counts;
+            AllocationTracker::Counts heap;
+            std::vector<Memory> memory;
+            std::vector<std::pair<const char*, double>> values;
+
+            Node(const char* _name, const int _parent) : name(_name), parent(_parent) {}
+        };
+
+        struct Open {
+            int node;
+            Clock::time_point start;
+            PerfCounters::Values counts;
+            AllocationTracker::Counts heap;
+        };
+
+        // a closed scope if counter is null, a counter change (or recorded size) otherwise
+        struct Event {
+            int node;
+            const char* counter;
+            std::int64_t time_ns;
+            // duration of a scope, value of a counter
+            std::int64_t value;
+        };
+
+        Profiler() { reset(); }
+
+        // trivially initialized, so that testing it does not need a guard
+        static bool& enabled_flag() {
+            thread_local bool enabled = false;
+            return enabled;
+        }
+
+        std::int64_t ns_since_start(const Clock::time_point _t) const {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(_t - start_time_).count();
+        }
+
+        // time since start() while recording, until stop() otherwise
+        std::int64_t total_ns() const {
+            return enabled_flag() ? ns_since_start(Clock::now()) : elapsed_ns_;
+        }
+
+        std::int64_t self_ns(const int _node) const {
+            std::int64_t t = nodes_[_node].total_ns;
+            for(int child : nodes_[_node].children)
+                t -= nodes_[child].total_ns;
+            return t;
+        }
+
+        void add_event(const Event& _e) {
+            if(events_.size() < max_events_)
+                events_.push_back(_e);
+            else
+                ++n_dropped_events_;
+        }
+
+        std::string path(const int _node) const {
+            std::string p = nodes_[_node].name;
+            for(int n = nodes_[_node].parent; n > 0; n = nodes_[n].parent)
+                p = std::string(nodes_[n].name) + "/" + p;
+            return p;
+        }
+
+        int find(const std::string& _path) const {
+            int node = 0;
+            std::size_t begin = 0;
+            while(begin <= _path.size()) {
+                std::size_t end = _path.find('/', begin);
+                if(end == std::string::npos)
+                    end = _path.size();
+                const std::string name = _path.substr(begin, end - begin);
+                int next = -1;
+                for(int child : nodes_[node].children)
+                    if(name == nodes_[child].name) {
+                        next = child;
+                        break;
+                    }
+                if(next < 0)
+                    return -1;
+                node = next;
+                begin = end + 1;
+            }
+            return node;
+        }
+
+        static void write_json_string(std::ostream& _os, const char* _s) {
+            _os << '"';
+            for(; *_s; ++_s) {
+                if(*_s == '"' || *_s == '\\')
+                    _os << '\\';
+                _os << *_s;
+            }
+            _os << '"';
+        }
+
+        void write_json_counters(std::ostream& _os, const int _node) const {
+            _os << "{";
+            for(std::size_t i = 0; i < nodes_[_node].counters.size(); ++i) {
+                _os << (i == 0 ? "" : ", ");
+                write_json_string(_os, nodes_[_node].counters[i].first);
+                _os << ": " << nodes_[_node].counters[i].second;
+            }
+            _os << "}";
+        }
+
+        // the "memory" and "values" entries of a scope, if any
+        void write_json_memory(std::ostream& _os, const int _node) const {
+            const Node& node = nodes_[_node];
+            if(!node.memory.empty()) {
+                _os << ", \"memory\": {";
+                for(std::size_t i = 0; i < node.memory.size(); ++i) {
+                    _os << (i == 0 ? "" : ", ");
+                    write_json_string(_os, node.memory[i].name);
+                    _os << ": {\"bytes\": " << node.memory[i].bytes << ", \"peak_bytes\": " << node.memory[i].peak_bytes
+                        << ", \"nnz\": " << node.memory[i].nnz << "}";
+                }
+                _os << "}";
+            }
+            if(!node.values.empty()) {
+                _os << ", \"values\": {";
+                for(std::size_t i = 0; i < node.values.size(); ++i) {
+                    _os << (i == 0 ? "" : ", ");
+                    write_json_string(_os, node.values[i].first);
+                    _os << ": " << node.values[i].second;
+                }
+                _os << "}";
+            }
+        }
+
+        void write_csv_memory(std::ostream& _os, const std::string& _path, const int _node) const {
+            for(const auto& m : nodes_[_node].memory)
+                _os << _path << "," << m.name << "_bytes," << m.bytes << "\n"
+                    << _path << "," << m.name << "_peak_bytes," << m.peak_bytes << "\n"
+                    << _path << "," << m.name << "_nnz," << m.nnz << "\n";
+            for(const auto& v : nodes_[_node].values)
+                _os << _path << "," << v.first << "," << v.second << "\n";
+        }
+
+        void write_json_children(std::ostream& _os, const int _node, const int _depth) const {
+            const std::string indent(2 * _depth, ' ');
+            _os << "[";
+            for(std::size_t i = 0; i < nodes_[_node].children.size(); ++i) {
+                const int c = nodes_[_node].children[i];
+                _os << (i == 0 ? "\n" : ",\n") << indent << "{\"name\": ";
+                write_json_string(_os, nodes_[c].name);
+                _os << ", \"calls\": " << nodes_[c].calls
+                    << ", \"total_ms\": " << 1e-6 * nodes_[c].total_ns
+                    << ", \"self_ms\": " << 1e-6 * self_ns(c)
+                    << ", \"counters\": ";
+                write_json_counters(_os, c);
+                if(nodes_[c].counts.mask != 0) {
+                    _os << ", \"hardware\": {";
+                    bool first = true;
+                    for(int e = 0; e < PerfCounters::N_EVENTS; ++e)
+                        if(nodes_[c].counts.has((PerfCounters::Event)e)) {
+                            _os << (first ? "\"" : ", \"") << PerfCounters::name((PerfCounters::Event)e) << "\": "
+                                << nodes_[c].counts[(PerfCounters::Event)e];
+                            first = false;
+                        }
+                    _os << "}";
+                }
+                if(AllocationTracker::installed())
+                    _os << ", \"heap\": {\"allocations\": " << nodes_[c].heap.allocations
+                        << ", \"bytes\": " << nodes_[c].heap.bytes << "}";
+                write_json_memory(_os, c);
+                _os << ", \"children\": ";
+                write_json_children(_os, c, _depth + 1);
+                _os << "}";
+            }
+            if(!nodes_[_node].children.empty())
+                _os << "\n" << std::string(2 * (_depth - 1), ' ');
+            _os << "]";
+        }
+
+        template <class Writer>
+        static int save(const std::string& _filename, Writer&& _write) {
+            std::ofstream file(_filename);
+            if(!file) {
+                std::cout << "Error: cannot open " << _filename << std::endl;
+                return -1;
+            }
+            _write(file);
+            if(!file) {
+                std::cout << "Error: writing " << _filename << " failed" << std::endl;
+                return -1;
+            }
+            return 0;
+        }
+
+        std::vector<Node> nodes_;
+        std::vector<Open> stack_;
+        std::vector<Event> events_;
+        bool trace_ = false;
+        std::size_t max_events_ = 0;
+        std::size_t n_dropped_events_ = 0;
+        Clock::time_point start_time_;
+        std::int64_t elapsed_ns_ = 0;
+
+        // hardware counters, null if not enabled
+        std::unique_ptr<PerfCounters> perf_;
+        PerfCounters::Values counts_;
+    };
+
+
+    /** times the scope _name from its construction to its destruction when the
+     * profiler of the thread is recording, see AOPT_PROFILE_SCOPE */
+    class ProfileScope {
+    public:
+        explicit ProfileScope(const char* _name) : active_(Profiler::enabled()) {
+            if(active_)
+                Profiler::instance().begin(_name);
+        }
+
+        ~ProfileScope() {
+            if(active_)
+                Profiler::instance().end();
+        }
+
+        ProfileScope(const ProfileScope&) = delete;
+        ProfileScope& operator=(const ProfileScope&) = delete;
+
+    private:
+        bool active_;
+    };
+
+//=============================================================================
+}
+
+#define AOPT_PROFILE_CONCAT_(a, b) a##b
+#define AOPT_PROFILE_CONCAT(a, b) AOPT_PROFILE_CONCAT_(a, b)
+
+#ifdef AOPT_NO_PROFILING
+#define AOPT_PROFILE_SCOPE(name) do {} while(0)
+#define AOPT_PROFILE_COUNT(name) do {} while(0)
+#define AOPT_PROFILE_COUNT_N(name, n) do {} while(0)
+#define AOPT_PROFILE_VALUE(name, value) do {} while(0)
+#else
+// times the enclosing block as the scope name
+#define AOPT_PROFILE_SCOPE(name) ::AOPT::ProfileScope AOPT_PROFILE_CONCAT(aopt_profile_scope_, __LINE__)(name)
+// adds 1, or n, to the counter name of the innermost scope
+#define AOPT_PROFILE_COUNT(name) AOPT_PROFILE_COUNT_N(name, 1)
+#define AOPT_PROFILE_COUNT_N(name, n) \
+    do { if(::AOPT::Profiler::enabled()) ::AOPT::Profiler::instance().count(name, n); } while(0)
+// sets the value name of the innermost scope, value is only evaluated when recording
+#define AOPT_PROFILE_VALUE(name, value) \
+    do { if(::AOPT::Profiler::enabled()) ::AOPT::Profiler::instance().record_value(name, value); } while(0)
+#endif
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <random>
+#include <vector>
+#include <cstdint>
 #include <FunctionBase/FunctionBase.hh>
 
 //== NAMESPACES ===============================================================
@@ -41,4 +43,106 @@ private:
     std::uniform_real_distribution<> dis_;
 };
 
+
+/* Uniform random numbers in [vmin, vmax) that are a pure function of (seed, stream,
+ * counter), so that any thread can generate the numbers of any stream, e.g. the
+ * i-th sample, without shared state and independently of the thread count.
+ * The counter is mixed with the splitmix64 finalizer. */
+class CounterRandomNumberGenerator
+{
+public:
+    CounterRandomNumberGenerator(double _vmin = -1000.0, double _vmax = 1000.0, std::uint64_t _seed = 0)
+        : vmin_{_vmin}, vmax_{_vmax}, seed_{mix(_seed)}
+    {}
+
+    /// the _counter-th number of the stream _stream
+    double get(std::uint64_t _stream, std::uint64_t _counter) const
+    {
+        const std::uint64_t z = mix(seed_ ^ mix(_stream + 0x9e3779b97f4a7c15ull)) + _counter * 0x9e3779b97f4a7c15ull;
+        return vmin_ + (vmax_ - vmin_) * (double)(mix(z) >> 11) * 0x1.0p-53;
+    }
+
+    /**
+     * @brief get_random_nd_vector fills _v with the numbers [_offset, _offset + _v.size())
+     * of the stream _stream, without allocating
+     */
+    void get_random_nd_vector(std::uint64_t _stream, FunctionBase::Vec& _v, std::uint64_t _offset = 0) const
+    {
+        for (int i = 0; i < _v.size(); i++) {
+            _v[i] = get(_stream, _offset + i);
+        }
+    }
+
+private:
+    static std::uint64_t mix(std::uint64_t _z)
+    {
+        _z = (_z ^ (_z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        _z = (_z ^ (_z >> 27)) * 0x94d049bb133111ebull;
+        return _z ^ (_z >> 31);
+    }
+
+    double vmin_;
+    double vmax_;
+    std::uint64_t seed_;
+};
+
+
+/* Halton low-discrepancy sequence in [vmin, vmax)^dim, the i-th point is given by the
+ * radical inverses of i in the first dim prime bases. The points fill the box more
+ * evenly than random ones, which is better coverage per sample in low dimension.
+ * Each coordinate is shifted by a random offset modulo 1 (Cranley-Patterson rotation),
+ * so that different seeds give different sequences and point 0 is not the corner. */
+class HaltonSequence
+{
+public:
+    HaltonSequence(int _dim, double _vmin = -1000.0, double _vmax = 1000.0, std::uint64_t _seed = 0)
+        : vmin_{_vmin}, vmax_{_vmax}, bases_(_dim), shifts_(_dim)
+    {
+        CounterRandomNumberGenerator rng(0., 1., _seed);
+        int p = 2;
+        for (int i = 0; i < _dim; i++) {
+            while (!is_prime(p)) p++;
+            bases_[i] = p++;
+            shifts_[i] = rng.get(~std::uint64_t(0), i); // a stream no sampler uses
+        }
+    }
+
+    int dim() const { return (int)bases_.size(); }
+
+    /**
+     * @brief get_nd_vector fills _v with the coordinates [_offset, _offset + _v.size())
+     * of the _i-th point, without allocating
+     */
+    void get_nd_vector(std::uint64_t _i, FunctionBase::Vec& _v, int _offset = 0) const
+    {
+        for (int j = 0; j < _v.size(); j++) {
+            double u = radical_inverse(_i, bases_[_offset + j]) + shifts_[_offset + j];
+            if (u >= 1.) u -= 1.;
+            _v[j] = vmin_ + (vmax_ - vmin_) * u;
+        }
+    }
+
+private:
+    static double radical_inverse(std::uint64_t _i, int _base)
+    {
+        const double inv_base = 1. / _base;
+        double r = 0., f = inv_base;
+        for (; _i > 0; _i /= _base, f *= inv_base)
+            r += f * (double)(_i % _base);
+        return r;
+    }
+
+    static bool is_prime(int _p)
+    {
+        for (int d = 2; d * d <= _p; d++)
+            if (_p % d == 0) return false;
+        return true;
+    }
+
+    double vmin_;
+    double vmax_;
+    std::vector<int> bases_;
+    std::vector<double> shifts_;
+};
+
 }
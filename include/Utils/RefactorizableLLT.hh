@@ -0,0 +1,127 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+#include <Eigen/Sparse>
+
+//== NAMESPACES ===============================================================
+
+namespace AOPT {
+
+    //== CLASS DEFINITION =========================================================
+
+    /* A sparse Cholesky factorization for a sequence of matrices with the same
+     * pattern, e.g. the Hessians of the iterations of Newton's method.
+     *
+     * Eigen::SimplicialLLT::factorize() reuses the ordering and the symbolic
+     * analysis, but still copies the permuted matrix into a new one, and solve()
+     * permutes the solution in place, which allocates a mask. Here, the first
+     * compute() and a compute() on a matrix with a new pattern do the full
+     * analysis, and record where each entry of the lower triangle goes in the
+     * permuted upper triangle. The next compute() calls only copy the values and run
+     * the numeric factorization, and solve(_b, _x) uses a stored work vector.
+     *
+     * Up to EIGEN_STACK_ALLOCATION_LIMIT (16384 unknowns by default), Eigen keeps
+     * the work arrays of the numeric factorization on the stack, so that neither
+     * compute() nor solve() allocate once the pattern is known. */
+    template <class SMat>
+    class RefactorizableLLT : public Eigen::SimplicialLLT<SMat> {
+    public:
+        using Base = Eigen::SimplicialLLT<SMat>;
+        using Vec = Eigen::Matrix<typename SMat::Scalar, Eigen::Dynamic, 1>;
+        using StorageIndex = typename SMat::StorageIndex;
+
+        RefactorizableLLT() : Base() {}
+
+        /** factorizes the lower triangle of _A, reusing the analysis of the previous
+         * call if _A has the same (compressed) pattern */
+        RefactorizableLLT& compute(const SMat& _A) {
+            if(!same_pattern(_A)) {
+                Base::compute(_A);
+                record_pattern(_A);
+                return *this;
+            }
+
+            const typename SMat::Scalar* values = _A.valuePtr();
+            typename SMat::Scalar* permuted = permuted_.valuePtr();
+            for(size_t k = 0; k < map_.size(); ++k)
+                permuted[k] = values[map_[k]];
+            this->template factorize_preordered<false>(permuted_);
+            return *this;
+        }
+
+        using Base::solve;
+
+        /** solves A _x = _b with the last factorization, _x and _b can be the same */
+        void solve(const Vec& _b, Vec& _x) const {
+            eigen_assert(this->m_factorizationIsOk && "The factorization should be computed first");
+            if(this->m_P.size() > 0)
+                tmp_ = this->m_P * _b;
+            else
+                tmp_ = _b;
+            if(this->m_matrix.nonZeros() > 0) {
+                this->matrixL().solveInPlace(tmp_);
+                this->matrixU().solveInPlace(tmp_);
+            }
+            if(this->m_P.size() > 0)
+                _x = this->m_Pinv * tmp_;
+            else
+                _x = tmp_;
+        }
+
+        /** bytes of what is kept to refactorize: the pattern of A, the permuted upper
+         * triangle with the map of its values and the work vector, see MemoryFootprint */
+        std::size_t pattern_bytes() const {
+            const std::size_t index = sizeof(StorageIndex);
+            return (outer_.capacity() + inner_.capacity() + map_.capacity()) * index
+                   + (std::size_t)permuted_.data().allocatedSize() * (sizeof(typename SMat::Scalar) + index)
+                   + (std::size_t)(permuted_.outerSize() + 1) * index
+                   + (std::size_t)tmp_.size() * sizeof(typename SMat::Scalar);
+        }
+
+    private:
+        bool same_pattern(const SMat& _A) const {
+            if(!this->m_analysisIsOk || !_A.isCompressed() || _A.rows() != _A.cols()
+               || (Eigen::Index)outer_.size() != _A.cols() + 1 || (Eigen::Index)inner_.size() != _A.nonZeros())
+                return false;
+            return std::equal(outer_.begin(), outer_.end(), _A.outerIndexPtr())
+                   && std::equal(inner_.begin(), inner_.end(), _A.innerIndexPtr());
+        }
+
+        void record_pattern(const SMat& _A) {
+            outer_.clear();
+            inner_.clear();
+            map_.clear();
+            if(!this->m_analysisIsOk || !_A.isCompressed())
+                return;
+
+            // permutes the indices of the entries the same way as compute() permutes
+            // the values, which gives the source of each entry of the permuted matrix
+            SMat indices = _A;
+            for(Eigen::Index k = 0; k < indices.nonZeros(); ++k)
+                indices.valuePtr()[k] = typename SMat::Scalar(k + 1);
+            SMat permuted_indices(_A.rows(), _A.cols());
+            permuted_indices.template selfadjointView<Eigen::Upper>() =
+                    indices.template selfadjointView<Eigen::Lower>().twistedBy(this->m_P);
+
+            permuted_ = permuted_indices;
+            map_.resize(permuted_indices.nonZeros());
+            for(size_t k = 0; k < map_.size(); ++k)
+                map_[k] = (StorageIndex)permuted_indices.valuePtr()[k] - 1;
+
+            outer_.assign(_A.outerIndexPtr(), _A.outerIndexPtr() + _A.cols() + 1);
+            inner_.assign(_A.innerIndexPtr(), _A.innerIndexPtr() + _A.nonZeros());
+            tmp_.resize(_A.rows());
+        }
+
+        // pattern of the last analyzed matrix
+        std::vector<StorageIndex> outer_;
+        std::vector<StorageIndex> inner_;
+        // permuted upper triangle and the index in A of each of its values
+        SMat permuted_;
+        std::vector<StorageIndex> map_;
+        mutable Vec tmp_;
+    };
+
+//=============================================================================
+}
@@ -0,0 +1,312 @@
+#pragma once
+
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <cassert>
+#include <algorithm>
+#include <Eigen/Sparse>
+
+//== NAMESPACES ===============================================================
+
+namespace AOPT {
+
+    //== CLASS DEFINITION =========================================================
+
+    /* Colorings of sparsity patterns used to compute sparse derivatives with few
+     * finite differences: all columns of one color are perturbed at once.
+     * See Gebremedhin, Manne, Pothen, "What color is your Jacobian? Graph coloring
+     * for computing derivatives", SIAM Review, 2005. */
+    class GraphColoring {
+    public:
+        using SMat = Eigen::SparseMatrix<double>;
+
+        /** Curtis-Powell-Reid coloring: greedy distance-2 coloring of the columns,
+         * i.e. two columns with a nonzero in the same row get different colors.
+         * \return the number of colors */
+        static int column_coloring(const SMat& _pattern, std::vector<int>& _colors) {
+            const int n = (int)_pattern.cols();
+            Eigen::SparseMatrix<double, Eigen::RowMajor> rows = _pattern;
+
+            _colors.assign(n, -1);
+            std::vector<int> forbidden(n + 1, -1);
+            int n_colors(0);
+
+            for(int j = 0; j < n; ++j) {
+                for(SMat::InnerIterator it(_pattern, j); it; ++it)
+                    for(decltype(rows)::InnerIterator jt(rows, it.row()); jt; ++jt)
+                        if(_colors[jt.col()] >= 0)
+                            forbidden[_colors[jt.col()]] = j;
+
+                int c(0);
+                while(forbidden[c] == j)
+                    ++c;
+                _colors[j] = c;
+                n_colors = std::max(n_colors, c + 1);
+            }
+
+            return n_colors;
+        }
+
+        /** Star coloring of the adjacency graph of a symmetric pattern: a distance-1
+         * coloring in which every path on four vertices uses at least three colors
+         * (greedy algorithm 4.1 of Gebremedhin et al.). It is a symmetrically
+         * orthogonal partition as required by the direct method of Powell and Toint,
+         * so that every h_ij can be read from the group of column j or of column i.
+         * \return the number of colors */
+        static int star_coloring(const SMat& _pattern, std::vector<int>& _colors) {
+            const int n = (int)_pattern.cols();
+
+            _colors.assign(n, -1);
+            std::vector<int> forbidden(n + 1, -1);
+            int n_colors(0);
+
+            for(int v = 0; v < n; ++v) {
+                for(SMat::InnerIterator w(_pattern, v); w; ++w) {
+                    if(w.row() == v)
+                        continue;
+                    if(_colors[w.row()] < 0) {
+                        // w uncolored: v must differ from the colored neighbors of w
+                        for(SMat::InnerIterator x(_pattern, w.row()); x; ++x)
+                            if(x.row() != v && x.row() != w.row() && _colors[x.row()] >= 0)
+                                forbidden[_colors[x.row()]] = v;
+                    } else {
+                        forbidden[_colors[w.row()]] = v;
+                        // w colored: avoid a bicolored path v - w - x - y
+                        for(SMat::InnerIterator x(_pattern, w.row()); x; ++x) {
+                            if(x.row() == v || x.row() == w.row() || _colors[x.row()] < 0)
+                                continue;
+                            for(SMat::InnerIterator y(_pattern, x.row()); y; ++y)
+                                if(y.row() != w.row() && y.row() != x.row() && _colors[y.row()] == _colors[w.row()]) {
+                                    forbidden[_colors[x.row()]] = v;
+                                    break;
+                                }
+                        }
+                    }
+                }
+
+                int c(0);
+                while(forbidden[c] == v)
+                    ++c;
+                _colors[v] = c;
+                n_colors = std::max(n_colors, c + 1);
+            }
+
+            return n_colors;
+        }
+    };
+
+
+
+    /* Finite difference Jacobian with a known sparsity pattern.
+     * With a column coloring, J d_c for d_c = sum of h_j e_j over the columns j of
+     * color c is approximated by one difference of r, and since no two columns of a
+     * color share a row, every J_ij is read directly from it.
+     * This costs n_colors() (+1) evaluations of r instead of n (+1). */
+    class SparseJacobianFD {
+    public:
+        using Vec = Eigen::VectorXd;
+        using SMat = Eigen::SparseMatrix<double>;
+
+        /**
+         * \param _pattern sparsity pattern of J (the values are ignored)
+         * \param _central central differences, twice the evaluations but O(h^2) */
+        SparseJacobianFD(const SMat& _pattern, const bool _central = false) :
+                pattern_(_pattern), central_(_central) {
+            pattern_.makeCompressed();
+            n_colors_ = GraphColoring::column_coloring(pattern_, colors_);
+        }
+
+        int n_colors() const { return n_colors_; }
+
+        const std::vector<int>& colors() const { return colors_; }
+
+        /** \param _eval_r callable as _eval_r(x, r)
+         * \param _J output, gets the pattern given to the constructor */
+        template <class F>
+        void eval(F&& _eval_r, const Vec& _x, SMat& _J) {
+            _J = pattern_;
+            const int n = (int)_x.size();
+
+            fd_step(_x, central_, h_);
+            if(!central_)
+                _eval_r(_x, r0_);
+
+            xp_ = _x;
+            for(int c = 0; c < n_colors_; ++c) {
+                perturb(_x, c, 1., xp_);
+                _eval_r(xp_, rp_);
+                if(central_) {
+                    perturb(_x, c, -1., xp_);
+                    _eval_r(xp_, r0_);
+                }
+                restore(_x, c, xp_);
+
+                const double s = central_ ? 0.5 : 1.;
+                for(int j = 0; j < n; ++j)
+                    if(colors_[j] == c)
+                        for(SMat::InnerIterator it(_J, j); it; ++it)
+                            it.valueRef() = s * (rp_[it.row()] - r0_[it.row()]) / h_[j];
+            }
+        }
+
+        /** step h_j = eps^(1/2) max(1, |x_j|) for forward, eps^(1/3) max(1, |x_j|) for central differences */
+        static void fd_step(const Vec& _x, const bool _central, Vec& _h) {
+            const double eps = std::numeric_limits<double>::epsilon();
+            const double s = _central ? std::cbrt(eps) : std::sqrt(eps);
+            _h = s * _x.cwiseAbs().cwiseMax(1.);
+            // make x + h - x exactly representable
+            for(int i = 0; i < _x.size(); ++i)
+                _h[i] = (_x[i] + _h[i]) - _x[i];
+        }
+
+    private:
+        void perturb(const Vec& _x, const int _c, const double _sign, Vec& _xp) const {
+            for(int j = 0; j < (int)_x.size(); ++j)
+                if(colors_[j] == _c)
+                    _xp[j] = _x[j] + _sign * h_[j];
+        }
+
+        void restore(const Vec& _x, const int _c, Vec& _xp) const {
+            for(int j = 0; j < (int)_x.size(); ++j)
+                if(colors_[j] == _c)
+                    _xp[j] = _x[j];
+        }
+
+    private:
+        SMat pattern_;
+        bool central_;
+        std::vector<int> colors_;
+        int n_colors_;
+
+        Vec h_, xp_, r0_, rp_;
+    };
+
+
+
+    /* Finite difference Hessian, from gradient evaluations only, with a known
+     * symmetric sparsity pattern (Powell-Toint direct method on a star coloring, or
+     * on a column coloring if that one needs fewer colors).
+     * For each color c, H d_c is approximated by a difference of gradients and
+     * h_ij is read from row i of H d_color(j) if j is the only column of its color
+     * with a nonzero in row i, else from row j of H d_color(i).
+     * This costs n_colors() (+1) gradients, 2 n_colors() with central differences. */
+    class SparseHessianFD {
+    public:
+        using Vec = Eigen::VectorXd;
+        using Mat = Eigen::MatrixXd;
+        using SMat = Eigen::SparseMatrix<double>;
+
+        /**
+         * \param _pattern sparsity pattern of the hessian, it is symmetrized and
+         *        the diagonal is added (the values are ignored)
+         * \param _central central differences, twice the evaluations but O(h^2) */
+        SparseHessianFD(const SMat& _pattern, const bool _central = true) : central_(_central) {
+            const int n = (int)_pattern.cols();
+            SMat eye(n, n);
+            eye.setIdentity();
+            SMat p = _pattern.cwiseAbs();
+            pattern_ = SMat(p + SMat(p.transpose()) + eye);
+            pattern_.makeCompressed();
+            std::fill(pattern_.valuePtr(), pattern_.valuePtr() + pattern_.nonZeros(), 0.);
+
+            // a distance-2 coloring is symmetrically orthogonal as well, and the
+            // greedy star coloring does not always need fewer colors
+            n_colors_ = GraphColoring::star_coloring(pattern_, colors_);
+            std::vector<int> cpr;
+            int n_cpr = GraphColoring::column_coloring(pattern_, cpr);
+            if(n_cpr < n_colors_) {
+                n_colors_ = n_cpr;
+                colors_.swap(cpr);
+            }
+            init_recovery();
+        }
+
+        int n_colors() const { return n_colors_; }
+
+        const std::vector<int>& colors() const { return colors_; }
+
+        /** \param _eval_g callable as _eval_g(x, g), g is sized by the caller
+         * \param _H output, gets the symmetrized pattern */
+        template <class F>
+        void eval(F&& _eval_g, const Vec& _x, SMat& _H) {
+            const int n = (int)_x.size();
+            SparseJacobianFD::fd_step(_x, central_, h_);
+
+            g0_.resize(n);
+            gp_.resize(n);
+            if(!central_)
+                _eval_g(_x, g0_);
+
+            // columns: H d_c for all colors
+            hd_.resize(n, n_colors_);
+            xp_ = _x;
+            for(int c = 0; c < n_colors_; ++c) {
+                for(int j = 0; j < n; ++j)
+                    if(colors_[j] == c)
+                        xp_[j] = _x[j] + h_[j];
+                _eval_g(xp_, gp_);
+                if(central_) {
+                    for(int j = 0; j < n; ++j)
+                        if(colors_[j] == c)
+                            xp_[j] = _x[j] - h_[j];
+                    _eval_g(xp_, g0_);
+                }
+                for(int j = 0; j < n; ++j)
+                    if(colors_[j] == c)
+                        xp_[j] = _x[j];
+
+                hd_.col(c) = central_ ? Vec(0.5 * (gp_ - g0_)) : Vec(gp_ - g0_);
+            }
+
+            _H = pattern_;
+            double* values = _H.valuePtr();
+            for(size_t k = 0; k < read_.size(); ++k)
+                values[k] = hd_(read_[k].row, colors_[read_[k].col]) / h_[read_[k].col];
+        }
+
+    private:
+        /** for every nonzero (i, j), chooses whether it is read from the group of j or of i */
+        void init_recovery() {
+            const int n = (int)pattern_.cols();
+
+            read_.resize(pattern_.nonZeros());
+
+            for(int i = 0; i < n; ++i)
+                for(int k = pattern_.outerIndexPtr()[i]; k < pattern_.outerIndexPtr()[i+1]; ++k) {
+                    const int r = pattern_.innerIndexPtr()[k];
+                    // entry (r, i): from row r of H d_color(i) if i is the only column of its
+                    // color in row r (= column r, the pattern is symmetric), else by symmetry
+                    if(unique_in_column(r, colors_[i]))
+                        read_[k] = {r, i};
+                    else {
+                        assert(unique_in_column(i, colors_[r]));
+                        read_[k] = {i, r};
+                    }
+                }
+        }
+
+        bool unique_in_column(const int _col, const int _color) const {
+            int n(0);
+            for(SMat::InnerIterator it(pattern_, _col); it; ++it)
+                if(colors_[it.row()] == _color)
+                    ++n;
+            return n == 1;
+        }
+
+    private:
+        struct Read { int row, col; };
+
+        SMat pattern_;
+        bool central_;
+        std::vector<int> colors_;
+        int n_colors_;
+        // h_k = (H d_color(col))[row] / h[col]
+        std::vector<Read> read_;
+
+        Vec h_, xp_, g0_, gp_;
+        Mat hd_;
+    };
+
+//=============================================================================
+}
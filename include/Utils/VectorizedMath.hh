@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+//== NAMESPACES ===============================================================
+
+namespace AOPT {
+
+    /** _y[i] = cos(_x[i]) for i in [0, _n), written without branches so that the
+     * compiler vectorizes the loop (std::cos is a library call per element, and Eigen
+     * only vectorizes cos for floats).
+     * The argument is reduced to r in [-pi/4, pi/4] with x = r + k pi/2, pi/2 being
+     * split in three parts (Cody-Waite) so that the reduction is exact, and cos(x) is
+     * +-cos(r) or +-sin(r) depending on k mod 4, with the polynomials of Cephes.
+     * The error is within 1 ulp of std::cos. Arguments larger than 1e8, where the
+     * reduction would lose precision, use std::cos. */
+    inline void cos_batch(const double* __restrict _x, double* __restrict _y, const int _n) {
+        for(int i = 0; i < _n; ++i) {
+            const double x = _x[i];
+
+            // nearest integer k to x / (pi/2): adding 1.5 * 2^52 rounds to an integer and
+            // leaves k in the low bits of the mantissa, where k mod 4 is read
+            const double t = x * 0.63661977236758134308 + 6755399441055744.0;
+            const double kd = t - 6755399441055744.0;
+            std::uint64_t bits;
+            std::memcpy(&bits, &t, sizeof(bits));
+            const int k = (int)(bits & 3);
+            const double r = ((x - kd * 1.57079625129699707031) - kd * 7.54978941586159635335e-8)
+                             - kd * 5.39030285815811905290e-15;
+            const double z = r * r;
+
+            const double s = r + r * z * (((((1.58962301576546568060e-10 * z - 2.50507477628578072866e-8) * z
+                                             + 2.75573136213857245213e-6) * z - 1.98412698295895385996e-4) * z
+                                           + 8.33333333332211858878e-3) * z - 1.66666666666666307295e-1);
+            const double c = 1. - 0.5 * z + z * z * (((((-1.13585365213876817300e-11 * z + 2.08757008419747316778e-9) * z
+                                                        - 2.75573141792967388112e-7) * z + 2.48015872888517045348e-5) * z
+                                                      - 1.38888888888730564116e-3) * z + 4.16666666666665929218e-2);
+
+            // k mod 4 = 0: cos(r), 1: -sin(r), 2: -cos(r), 3: sin(r), selected without branches
+            const double odd = (double)(k & 1);
+            const double sign = 1. - (double)((k + 1) & 2);
+            _y[i] = sign * (odd * s + (1. - odd) * c);
+        }
+
+        for(int i = 0; i < _n; ++i)
+            if(std::abs(_x[i]) > 1e8)
+                _y[i] = std::cos(_x[i]);
+    }
+
+//=============================================================================
+}